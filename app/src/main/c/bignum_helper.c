@@ -0,0 +1,304 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include "bignum_helper.h"
+
+/*Montgomery arithmetic
+*A number x modulo n is kept as x * R mod n, R = 2^(BIGNUM_HELPER_LIMB_BITS * limbs). The product of two is
+*reduced by bignumHelperMontMul() without a division: (a * b + m * n) / R with m chosen to clear the low limbs.
+*Everything lives on the stack, the largest frame is the window table of bignumHelperModExp(), 16 numbers.
+*Verification works on public data only, nothing here runs in constant time.
+*/
+
+static inline bignumHelperLimb bignumHelperAdd(const bignumHelperLimb *a, const bignumHelperLimb *b, bignumHelperLimb *out,
+                                        size_t limbs) {
+    bignumHelperWide carry = 0;
+    for (size_t i = 0; i < limbs; i++) {
+        carry += (bignumHelperWide) a[i] + b[i];
+        out[i] = (bignumHelperLimb) carry;
+        carry >>= BIGNUM_HELPER_LIMB_BITS;
+    }
+    return (bignumHelperLimb) carry;
+}
+
+static inline bignumHelperLimb bignumHelperSub(const bignumHelperLimb *a, const bignumHelperLimb *b, bignumHelperLimb *out,
+                                        size_t limbs) {
+    bignumHelperLimb borrow = 0;
+    for (size_t i = 0; i < limbs; i++) {
+        bignumHelperWide diff = (bignumHelperWide) a[i] - b[i] - borrow;
+        out[i] = (bignumHelperLimb) diff;
+        borrow = (bignumHelperLimb) (diff >> BIGNUM_HELPER_LIMB_BITS) & 1;
+    }
+    return borrow;
+}
+
+static inline int bignumHelperCompareLimbs(const bignumHelperLimb *a, const bignumHelperLimb *b, size_t limbs) {
+    for (size_t i = limbs; i > 0; i--) {
+        if (a[i - 1] != b[i - 1]) {
+            return a[i - 1] > b[i - 1] ? 1 : -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Reads a big-endian unsigned number into limbs, false if it does not fit.
+ */
+static bool bignumHelperReadLimbs(const unsigned char *in, size_t len, bignumHelperLimb *out, size_t limbs) {
+    while (len > 0 && in[0] == 0) {
+        in++;
+        len--;
+    }
+    if (len > limbs * sizeof(bignumHelperLimb)) {
+        return false;
+    }
+    memset(out, 0, limbs * sizeof(bignumHelperLimb));
+    for (size_t i = 0; i < len; i++) {
+        out[i / sizeof(bignumHelperLimb)] |= (bignumHelperLimb) in[len - 1 - i] << (8 * (i % sizeof(bignumHelperLimb)));
+    }
+    return true;
+}
+
+/**
+ * Prepares an odd modulus given as big-endian bytes, false if it is even, 1 or longer than BIGNUM_HELPER_MAX_BITS.
+ */
+bool bignumHelperInitModulus(bignumHelperModulus *mod, const unsigned char *n, size_t len) {
+    bignumHelperLimb x[BIGNUM_HELPER_MAX_LIMBS];
+
+    while (len > 0 && n[0] == 0) {
+        n++;
+        len--;
+    }
+    memset(mod, 0, sizeof(bignumHelperModulus));
+    mod->bytes = len;
+    mod->limbs = (len + sizeof(bignumHelperLimb) - 1) / sizeof(bignumHelperLimb);
+    if (len == 0 || (n[len - 1] & 1) == 0 || (len == 1 && n[0] == 1)
+        || !bignumHelperReadLimbs(n, len, mod->n, BIGNUM_HELPER_MAX_LIMBS)) {
+        return false;
+    }
+
+    // Newton's iteration doubles the correct low bits of n^-1, n * n = 1 mod 8 gives the first three
+    bignumHelperLimb inverse = mod->n[0];
+    for (int i = 0; i < BIGNUM_HELPER_LIMB_SHIFT - 1; i++) {
+        inverse *= 2 - mod->n[0] * inverse;
+    }
+    mod->n0 = (bignumHelperLimb) 0 - inverse;
+
+    // 2^(bits - 1) < n, doubled up to 2^(BIGNUM_HELPER_LIMB_BITS * limbs + limbs) mod n, that is 2^limbs in the
+    // Montgomery domain. BIGNUM_HELPER_LIMB_SHIFT squarings make it R in the Montgomery domain: R^2 mod n
+    size_t top = mod->limbs - 1;
+    size_t bits = top * BIGNUM_HELPER_LIMB_BITS;
+    for (bignumHelperLimb v = mod->n[top]; v != 0; v >>= 1) {
+        bits++;
+    }
+    memset(x, 0, sizeof(x));
+    x[(bits - 1) / BIGNUM_HELPER_LIMB_BITS] = (bignumHelperLimb) 1 << ((bits - 1) % BIGNUM_HELPER_LIMB_BITS);
+    for (size_t i = bits - 1; i < mod->limbs * BIGNUM_HELPER_LIMB_BITS + mod->limbs; i++) {
+        bignumHelperLimb carry = bignumHelperAdd(x, x, x, mod->limbs);
+        if (carry || bignumHelperCompareLimbs(x, mod->n, mod->limbs) >= 0) {
+            bignumHelperSub(x, mod->n, x, mod->limbs);
+        }
+    }
+    memcpy(mod->rr, x, mod->limbs * sizeof(bignumHelperLimb));
+    for (int i = 0; i < BIGNUM_HELPER_LIMB_SHIFT; i++) {
+        bignumHelperMontMul(mod, mod->rr, mod->rr, mod->rr);
+    }
+    return true;
+}
+
+/**
+ * Reads a big-endian number of at most mod->limbs limbs, false if it is longer. It is not reduced.
+ */
+bool bignumHelperFromBytes(const bignumHelperModulus *mod, const unsigned char *in, size_t len, bignumHelperLimb *out) {
+    return bignumHelperReadLimbs(in, len, out, mod->limbs);
+}
+
+/**
+ * Writes a number as mod->bytes big-endian bytes, the length of the modulus.
+ */
+void bignumHelperToBytes(const bignumHelperModulus *mod, const bignumHelperLimb *in, unsigned char *out) {
+    for (size_t i = 0; i < mod->bytes; i++) {
+        out[mod->bytes - 1 - i] = (unsigned char) (in[i / sizeof(bignumHelperLimb)]
+                >> (8 * (i % sizeof(bignumHelperLimb))));
+    }
+}
+
+int bignumHelperCompare(const bignumHelperModulus *mod, const bignumHelperLimb *a, const bignumHelperLimb *b) {
+    return bignumHelperCompareLimbs(a, b, mod->limbs);
+}
+
+bool bignumHelperIsZero(const bignumHelperModulus *mod, const bignumHelperLimb *a) {
+    bignumHelperLimb bits = 0;
+    for (size_t i = 0; i < mod->limbs; i++) {
+        bits |= a[i];
+    }
+    return bits == 0;
+}
+
+/**
+ * out = a + b mod n, a and b reduced. out may be a or b.
+ */
+void bignumHelperModAdd(const bignumHelperModulus *mod, const bignumHelperLimb *a, const bignumHelperLimb *b,
+                        bignumHelperLimb *out) {
+    bignumHelperLimb carry = bignumHelperAdd(a, b, out, mod->limbs);
+    if (carry || bignumHelperCompareLimbs(out, mod->n, mod->limbs) >= 0) {
+        bignumHelperSub(out, mod->n, out, mod->limbs);
+    }
+}
+
+/**
+ * out = a - b mod n, a and b reduced. out may be a or b.
+ */
+void bignumHelperModSub(const bignumHelperModulus *mod, const bignumHelperLimb *a, const bignumHelperLimb *b,
+                        bignumHelperLimb *out) {
+    if (bignumHelperSub(a, b, out, mod->limbs)) {
+        bignumHelperAdd(out, mod->n, out, mod->limbs);
+    }
+}
+
+/**
+ * Coarsely integrated operand scanning, inlined for a constant limb count the compiler unrolls.
+ */
+static inline __attribute__((always_inline)) void bignumHelperMontMulLimbs(const bignumHelperModulus *mod,
+                                                                           const bignumHelperLimb *a,
+                                                                           const bignumHelperLimb *b,
+                                                                           bignumHelperLimb *out, size_t limbs) {
+    bignumHelperLimb t[BIGNUM_HELPER_MAX_LIMBS + 2];
+
+    memset(t, 0, (limbs + 2) * sizeof(bignumHelperLimb));
+    for (size_t i = 0; i < limbs; i++) {
+        bignumHelperWide carry = 0;
+        for (size_t j = 0; j < limbs; j++) {
+            carry += (bignumHelperWide) a[j] * b[i] + t[j];
+            t[j] = (bignumHelperLimb) carry;
+            carry >>= BIGNUM_HELPER_LIMB_BITS;
+        }
+        carry += t[limbs];
+        t[limbs] = (bignumHelperLimb) carry;
+        t[limbs + 1] = (bignumHelperLimb) (carry >> BIGNUM_HELPER_LIMB_BITS);
+
+        // t + m * n is divisible by 2^BIGNUM_HELPER_LIMB_BITS, drop its low limb while adding
+        bignumHelperLimb m = t[0] * mod->n0;
+        carry = ((bignumHelperWide) m * mod->n[0] + t[0]) >> BIGNUM_HELPER_LIMB_BITS;
+        for (size_t j = 1; j < limbs; j++) {
+            carry += (bignumHelperWide) m * mod->n[j] + t[j];
+            t[j - 1] = (bignumHelperLimb) carry;
+            carry >>= BIGNUM_HELPER_LIMB_BITS;
+        }
+        carry += t[limbs];
+        t[limbs - 1] = (bignumHelperLimb) carry;
+        t[limbs] = t[limbs + 1] + (bignumHelperLimb) (carry >> BIGNUM_HELPER_LIMB_BITS);
+    }
+    // t < 2n
+    if (t[limbs] || bignumHelperCompareLimbs(t, mod->n, limbs) >= 0) {
+        bignumHelperSub(t, mod->n, t, limbs);
+    }
+    memcpy(out, t, limbs * sizeof(bignumHelperLimb));
+}
+
+/**
+ * out = a * b / R mod n. b must be reduced, a only has to fit in mod->limbs limbs, the result is reduced.
+ * out may be a or b.
+ */
+void bignumHelperMontMul(const bignumHelperModulus *mod, const bignumHelperLimb *a, const bignumHelperLimb *b,
+                         bignumHelperLimb *out) {
+    // the field and the order of P-256, thousands of products per ECDSA signature
+    if (mod->limbs == BIGNUM_HELPER_P256_LIMBS) {
+        bignumHelperMontMulLimbs(mod, a, b, out, BIGNUM_HELPER_P256_LIMBS);
+    } else {
+        bignumHelperMontMulLimbs(mod, a, b, out, mod->limbs);
+    }
+}
+
+/**
+ * Takes a into the Montgomery domain, reducing it: a may be any number of mod->limbs limbs.
+ */
+void bignumHelperToMont(const bignumHelperModulus *mod, const bignumHelperLimb *a, bignumHelperLimb *out) {
+    bignumHelperMontMul(mod, a, mod->rr, out);
+}
+
+void bignumHelperFromMont(const bignumHelperModulus *mod, const bignumHelperLimb *a, bignumHelperLimb *out) {
+    bignumHelperLimb one[BIGNUM_HELPER_MAX_LIMBS];
+
+    memset(one, 0, mod->limbs * sizeof(bignumHelperLimb));
+    one[0] = 1;
+    bignumHelperMontMul(mod, a, one, out);
+}
+
+/**
+ * out = base^exp mod n, exp given as big-endian bytes, base and out outside the Montgomery domain.
+ * The exponent is taken BIGNUM_HELPER_WINDOW bits at a time, the powers of base it needs are computed
+ * as they are first used: an RSA public exponent like 65537 only needs base itself.
+ */
+void bignumHelperModExp(const bignumHelperModulus *mod, const bignumHelperLimb *base, const unsigned char *exp,
+                        size_t exp_len, bignumHelperLimb *out) {
+    bignumHelperLimb table[1 << BIGNUM_HELPER_WINDOW][BIGNUM_HELPER_MAX_LIMBS];
+    bignumHelperLimb acc[BIGNUM_HELPER_MAX_LIMBS];
+    size_t built = 1;
+    bool started = false;
+
+    bignumHelperToMont(mod, base, table[1]);
+    for (size_t i = 0; i < exp_len * 8 / BIGNUM_HELPER_WINDOW; i++) {
+        size_t bit = i * BIGNUM_HELPER_WINDOW;
+        unsigned window = (exp[bit / 8] >> (8 - BIGNUM_HELPER_WINDOW - bit % 8)) & ((1 << BIGNUM_HELPER_WINDOW) - 1);
+        if (started) {
+            for (int k = 0; k < BIGNUM_HELPER_WINDOW; k++) {
+                bignumHelperMontMul(mod, acc, acc, acc);
+            }
+        }
+        if (window == 0) {
+            continue;
+        }
+        for (; built < window; built++) {
+            bignumHelperMontMul(mod, table[built], table[1], table[built + 1]);
+        }
+        if (started) {
+            bignumHelperMontMul(mod, acc, table[window], acc);
+        } else {
+            memcpy(acc, table[window], mod->limbs * sizeof(bignumHelperLimb));
+            started = true;
+        }
+    }
+    if (!started) {
+        // base^0
+        memset(out, 0, mod->limbs * sizeof(bignumHelperLimb));
+        out[0] = 1;
+        return;
+    }
+    bignumHelperFromMont(mod, acc, out);
+}
+
+/**
+ * out = a^-1 mod n for a prime n and a not 0, by Fermat: a^(n - 2).
+ */
+void bignumHelperModInverse(const bignumHelperModulus *mod, const bignumHelperLimb *a, bignumHelperLimb *out) {
+    bignumHelperLimb two[BIGNUM_HELPER_MAX_LIMBS];
+    bignumHelperLimb exp[BIGNUM_HELPER_MAX_LIMBS];
+    unsigned char exp_bytes[BIGNUM_HELPER_MAX_BITS / 8];
+
+    memset(two, 0, mod->limbs * sizeof(bignumHelperLimb));
+    two[0] = 2;
+    bignumHelperSub(mod->n, two, exp, mod->limbs);
+    bignumHelperToBytes(mod, exp, exp_bytes);
+    bignumHelperModExp(mod, a, exp_bytes, mod->bytes, out);
+}
@@ -0,0 +1,98 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef NATIVESIGNATUREVERIFICATION_BIGNUM_HELPER_H
+#define NATIVESIGNATUREVERIFICATION_BIGNUM_HELPER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "def.h"
+
+// the longest modulus accepted, RSA keys of APK signers are 1024 to 4096 bits
+#define BIGNUM_HELPER_MAX_BITS      4096
+// bits of the exponent taken at once by bignumHelperModExp()
+#define BIGNUM_HELPER_WINDOW        4
+
+// 64-bit limbs where the compiler has a 128-bit product (arm64, x86_64), a quarter of the multiplications
+#if defined(__SIZEOF_INT128__)
+#define BIGNUM_HELPER_LIMB_BITS     64
+#define BIGNUM_HELPER_LIMB_SHIFT    6
+typedef uint64_t bignumHelperLimb;
+typedef unsigned __int128 bignumHelperWide;
+#else
+#define BIGNUM_HELPER_LIMB_BITS     32
+#define BIGNUM_HELPER_LIMB_SHIFT    5
+typedef uint32_t bignumHelperLimb;
+typedef uint64_t bignumHelperWide;
+#endif
+
+#define BIGNUM_HELPER_MAX_LIMBS     (BIGNUM_HELPER_MAX_BITS / BIGNUM_HELPER_LIMB_BITS)
+#define BIGNUM_HELPER_P256_LIMBS    (256 / BIGNUM_HELPER_LIMB_BITS)
+
+/**
+ * An odd modulus prepared for Montgomery multiplication, R being 2^(BIGNUM_HELPER_LIMB_BITS * limbs).
+ * Numbers modulo it are arrays of limbs, the least significant limb first.
+ */
+typedef struct bignumHelperModulus {
+    bignumHelperLimb n[BIGNUM_HELPER_MAX_LIMBS];
+    // R^2 mod n, takes a number into the Montgomery domain
+    bignumHelperLimb rr[BIGNUM_HELPER_MAX_LIMBS];
+    // -n^-1 mod 2^BIGNUM_HELPER_LIMB_BITS
+    bignumHelperLimb n0;
+    size_t limbs;
+    size_t bytes;
+} bignumHelperModulus;
+
+
+bool bignumHelperInitModulus(bignumHelperModulus *mod, const unsigned char *n, size_t len);
+
+bool bignumHelperFromBytes(const bignumHelperModulus *mod, const unsigned char *in, size_t len, bignumHelperLimb *out);
+
+void bignumHelperToBytes(const bignumHelperModulus *mod, const bignumHelperLimb *in, unsigned char *out);
+
+int bignumHelperCompare(const bignumHelperModulus *mod, const bignumHelperLimb *a, const bignumHelperLimb *b);
+
+bool bignumHelperIsZero(const bignumHelperModulus *mod, const bignumHelperLimb *a);
+
+void bignumHelperModAdd(const bignumHelperModulus *mod, const bignumHelperLimb *a, const bignumHelperLimb *b,
+                        bignumHelperLimb *out);
+
+void bignumHelperModSub(const bignumHelperModulus *mod, const bignumHelperLimb *a, const bignumHelperLimb *b,
+                        bignumHelperLimb *out);
+
+void bignumHelperMontMul(const bignumHelperModulus *mod, const bignumHelperLimb *a, const bignumHelperLimb *b,
+                         bignumHelperLimb *out);
+
+void bignumHelperToMont(const bignumHelperModulus *mod, const bignumHelperLimb *a, bignumHelperLimb *out);
+
+void bignumHelperFromMont(const bignumHelperModulus *mod, const bignumHelperLimb *a, bignumHelperLimb *out);
+
+void bignumHelperModExp(const bignumHelperModulus *mod, const bignumHelperLimb *base, const unsigned char *exp,
+                        size_t exp_len, bignumHelperLimb *out);
+
+void bignumHelperModInverse(const bignumHelperModulus *mod, const bignumHelperLimb *a, bignumHelperLimb *out);
+
+#endif //NATIVESIGNATUREVERIFICATION_BIGNUM_HELPER_H
@@ -0,0 +1,180 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include "cache_helper.h"
+
+
+/**
+ * The APK is kept open, so checking that it is still the same file takes one fstat.
+ */
+typedef struct cacheHelperEntry {
+    int fd;
+    cacheHelperKey key;
+    unsigned char *certificate;
+    size_t certificate_len;
+    bool has_content_result;
+    int32_t content_result;
+} cacheHelperEntry;
+
+static pthread_mutex_t cacheLock = PTHREAD_MUTEX_INITIALIZER;
+static cacheHelperEntry cache = {.fd = -1};
+
+
+static void cacheHelperKeyOf(const struct stat *st, cacheHelperKey *key) {
+    memset(key, 0, sizeof(cacheHelperKey));
+    key->dev = st->st_dev;
+    key->ino = st->st_ino;
+    key->size = st->st_size;
+    key->mtime = st->st_mtim.tv_sec;
+    key->mtime_nsec = st->st_mtim.tv_nsec;
+}
+
+/**
+ * The identity of the file open at fd. Taken before the APK is parsed, the results are cached under
+ * the very file they were computed from, whatever happens to the path meanwhile.
+ */
+bool cacheHelperGetKey(int fd, cacheHelperKey *key) {
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        return false;
+    }
+    cacheHelperKeyOf(&st, key);
+    return true;
+}
+
+/**
+ * Drops everything cached. cacheLock is held.
+ */
+static void cacheHelperDrop() {
+    if (cache.fd >= 0) {
+        close(cache.fd);
+    }
+    free(cache.certificate);
+    memset(&cache, 0, sizeof(cache));
+    cache.fd = -1;
+}
+
+/**
+ * Whether the cached results still belong to the APK, drops them otherwise. cacheLock is held.
+ */
+static bool cacheHelperIsValid() {
+    struct stat st;
+    cacheHelperKey key;
+
+    if (cache.fd < 0) {
+        return false;
+    }
+    if (fstat(cache.fd, &st) != 0 || st.st_nlink == 0) {
+        NSV_LOGI("cached APK is gone\n");
+        cacheHelperDrop();
+        return false;
+    }
+    cacheHelperKeyOf(&st, &key);
+    if (memcmp(&key, &cache.key, sizeof(cacheHelperKey)) != 0) {
+        NSV_LOGI("cached APK has changed\n");
+        cacheHelperDrop();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Makes the cache refer to the APK open at fd, keeping what is cached if it already does. The descriptor
+ * is duplicated, it keeps the file the key was taken from. cacheLock is held.
+ */
+static bool cacheHelperAttach(int fd, const cacheHelperKey *key) {
+    if (fd < 0 || NULL == key) {
+        return false;
+    }
+    if (cacheHelperIsValid() && memcmp(key, &cache.key, sizeof(cacheHelperKey)) == 0) {
+        return true;
+    }
+    cacheHelperDrop();
+    cache.fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (cache.fd < 0) {
+        return false;
+    }
+    cache.key = *key;
+    return true;
+}
+
+/**
+ * Returns a copy of the cached certificate, the caller frees it.
+ */
+bool cacheHelperGetCertificate(unsigned char **certificate, size_t *len) {
+    bool found = false;
+    pthread_mutex_lock(&cacheLock);
+    if (cacheHelperIsValid() && NULL != cache.certificate) {
+        *certificate = statsHelperMalloc(cache.certificate_len);
+        if (NULL != *certificate) {
+            memcpy(*certificate, cache.certificate, cache.certificate_len);
+            *len = cache.certificate_len;
+            found = true;
+        }
+    }
+    pthread_mutex_unlock(&cacheLock);
+    return found;
+}
+
+void cacheHelperPutCertificate(int fd, const cacheHelperKey *key, const unsigned char *certificate, size_t len) {
+    pthread_mutex_lock(&cacheLock);
+    if (cacheHelperAttach(fd, key)) {
+        unsigned char *copy = statsHelperMalloc(len);
+        if (NULL != copy) {
+            memcpy(copy, certificate, len);
+            free(cache.certificate);
+            cache.certificate = copy;
+            cache.certificate_len = len;
+        }
+    }
+    pthread_mutex_unlock(&cacheLock);
+}
+
+/**
+ * Returns the cached result of signBlockHelperVerify.
+ */
+bool cacheHelperGetContentResult(int32_t *result) {
+    bool found = false;
+    pthread_mutex_lock(&cacheLock);
+    if (cacheHelperIsValid() && cache.has_content_result) {
+        *result = cache.content_result;
+        found = true;
+    }
+    pthread_mutex_unlock(&cacheLock);
+    return found;
+}
+
+void cacheHelperPutContentResult(int fd, const cacheHelperKey *key, int32_t result) {
+    pthread_mutex_lock(&cacheLock);
+    if (cacheHelperAttach(fd, key)) {
+        cache.has_content_result = true;
+        cache.content_result = result;
+    }
+    pthread_mutex_unlock(&cacheLock);
+}
+
+void cacheHelperClear() {
+    pthread_mutex_lock(&cacheLock);
+    cacheHelperDrop();
+    pthread_mutex_unlock(&cacheLock);
+}
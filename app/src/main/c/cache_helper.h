@@ -0,0 +1,64 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef NATIVESIGNATUREVERIFICATION_CACHE_HELPER_H
+#define NATIVESIGNATUREVERIFICATION_CACHE_HELPER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "stats_helper.h"
+#include "def.h"
+
+/**
+ * Identity of the APK the cached results were computed from.
+ * A file that got unlinked (nlink == 0), e.g. replaced by an update, is never a match.
+ */
+typedef struct cacheHelperKey {
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    time_t mtime;
+    long mtime_nsec;
+} cacheHelperKey;
+
+
+bool cacheHelperGetKey(int fd, cacheHelperKey *key);
+
+bool cacheHelperGetCertificate(unsigned char **certificate, size_t *len);
+
+void cacheHelperPutCertificate(int fd, const cacheHelperKey *key, const unsigned char *certificate, size_t len);
+
+bool cacheHelperGetContentResult(int32_t *result);
+
+void cacheHelperPutContentResult(int fd, const cacheHelperKey *key, int32_t result);
+
+void cacheHelperClear();
+
+#endif //NATIVESIGNATUREVERIFICATION_CACHE_HELPER_H
@@ -3,8 +3,11 @@
 #ifndef NATIVESIGNATUREVERIFICATION_DEF_H
 #define NATIVESIGNATUREVERIFICATION_DEF_H
 
+#ifdef __ANDROID__
 #include <android/log.h>
-#include <jni.h>
+#else
+#include <stdio.h>
+#endif //__ANDROID__
 
 #define NSV_LOG_TAG "SignVerification"
 
@@ -12,12 +15,26 @@
 
 #ifndef NDEBUG
 
+#ifdef __ANDROID__
+
 #define NSV_LOGI(...)  __android_log_print(ANDROID_LOG_INFO,NSV_LOG_TAG,__VA_ARGS__)
 #define NSV_LOGE(...)  __android_log_print(ANDROID_LOG_ERROR,NSV_LOG_TAG,__VA_ARGS__)
 #define NSV_LOGW(...)  __android_log_print(ANDROID_LOG_WARN,NSV_LOG_TAG,__VA_ARGS__)
 #define NSV_LOGD(...)  __android_log_print(ANDROID_LOG_DEBUG,NSV_LOG_TAG,__VA_ARGS__)
 #define NSV_LOGV(...)  __android_log_print(ANDROID_LOG_VERBOSE,NSV_LOG_TAG,__VA_ARGS__)
 
+#else //__ANDROID__
+
+#define NSV_LOG_PRINT(level, ...)  (fprintf(stderr, "%s/" NSV_LOG_TAG ": ", level), fprintf(stderr, __VA_ARGS__))
+
+#define NSV_LOGI(...)  NSV_LOG_PRINT("I", __VA_ARGS__)
+#define NSV_LOGE(...)  NSV_LOG_PRINT("E", __VA_ARGS__)
+#define NSV_LOGW(...)  NSV_LOG_PRINT("W", __VA_ARGS__)
+#define NSV_LOGD(...)  NSV_LOG_PRINT("D", __VA_ARGS__)
+#define NSV_LOGV(...)  NSV_LOG_PRINT("V", __VA_ARGS__)
+
+#endif //__ANDROID__
+
 #else //NDEBUG
 
 #define NSV_LOGI(...)
@@ -0,0 +1,185 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include "der_helper.h"
+
+
+/**
+ * Reads the tag and the length of the triple at the beginning of data, its content may not be there yet.
+ * Only single byte tags and definite lengths of up to 4 bytes are accepted, as DER allows nothing else
+ * in the structures we read.
+ * Returns the size of the header, 0 if data ends inside the header and -1 if the header is malformed.
+ */
+int derHelperReadPartialHeader(const unsigned char *data, size_t len, uint8_t *tag, uint32_t *content_len) {
+    uint32_t value = 0;
+    size_t pos = 0;
+
+    if (len > 0 && (data[0] & 0x1f) == 0x1f) {
+        return -1;
+    }
+    if (len < 2) {
+        return 0;
+    }
+    *tag = data[pos++];
+    unsigned char lenbyte = data[pos++];
+    if (lenbyte & 0x80) {
+        size_t num = lenbyte & 0x7f;
+        if (num == 0 || num > 4) {
+            NSV_LOGW("unsupported length 0x%02x\n", lenbyte);
+            return -1;
+        }
+        if (num > len - pos) {
+            return 0;
+        }
+        while (num--) {
+            value = (value << 8) | data[pos++];
+        }
+    } else {
+        value = lenbyte;
+    }
+    *content_len = value;
+    return (int) pos;
+}
+
+/**
+ * Reads the tag and the length of the triple at the beginning of data, see derHelperReadPartialHeader().
+ * The content has to fit in len.
+ */
+bool derHelperReadHeader(const unsigned char *data, size_t len, uint8_t *tag, uint8_t *header, uint32_t *content_len) {
+    uint32_t value = 0;
+    int pos = derHelperReadPartialHeader(data, len, tag, &value);
+
+    if (pos <= 0 || value > len - (size_t) pos) {
+        return false;
+    }
+    *header = (uint8_t) pos;
+    *content_len = value;
+    return true;
+}
+
+static bool derHelperSplit(const unsigned char *data, size_t len, uint8_t max_depth,
+                           derHelperToken *tokens, size_t capacity, size_t *count) {
+    size_t ends[DER_HELPER_MAX_DEPTH + 1];
+    uint8_t last[DER_HELPER_MAX_DEPTH + 1];
+    size_t pos = 0;
+    uint8_t depth = 0;
+
+    *count = 0;
+    if (len > UINT32_MAX) {
+        return false;
+    }
+    if (max_depth > DER_HELPER_MAX_DEPTH) {
+        max_depth = DER_HELPER_MAX_DEPTH;
+    }
+    if (capacity > DER_HELPER_MAX_TOKENS) {
+        capacity = DER_HELPER_MAX_TOKENS;
+    }
+    ends[0] = len;
+    last[0] = DER_HELPER_NONE;
+
+    for (;;) {
+        while (depth > 0 && pos == ends[depth]) {
+            depth--;
+        }
+        if (pos == ends[depth]) {
+            return true;
+        }
+        if (*count == capacity) {
+            NSV_LOGE("more than %zu DER tokens\n", capacity);
+            return false;
+        }
+        derHelperToken *token = &tokens[*count];
+        if (!derHelperReadHeader(data + pos, ends[depth] - pos, &token->tag, &token->header, &token->len)) {
+            NSV_LOGE("malformed DER at %zu\n", pos);
+            return false;
+        }
+        token->offset = (uint32_t) pos;
+        token->depth = depth;
+        token->next = DER_HELPER_NONE;
+        if (last[depth] != DER_HELPER_NONE) {
+            tokens[last[depth]].next = (uint8_t) *count;
+        }
+        last[depth] = (uint8_t) *count;
+        (*count)++;
+
+        pos += token->header;
+        if ((token->tag & TAG_CONSTRUCTED) && depth < max_depth && token->len > 0) {
+            depth++;
+            ends[depth] = pos + token->len;
+            last[depth] = DER_HELPER_NONE;
+        } else {
+            pos += token->len;
+        }
+    }
+}
+
+/**
+ * Splits data into tokens in document order. Constructed triples are entered down to max_depth,
+ * deeper ones are kept as a single token. Every child has to fit exactly into its parent.
+ * Returns false if data is malformed or does not fit in capacity tokens.
+ */
+bool derHelperTokenize(const unsigned char *data, size_t len, uint8_t max_depth,
+                       derHelperToken *tokens, size_t capacity, size_t *count) {
+    statsHelperTimer timer;
+    statsHelperStart(&timer, STATS_HELPER_ASN1_PARSE);
+    bool parsed = derHelperSplit(data, len, max_depth, tokens, capacity, count);
+    statsHelperStop(&timer, len);
+    return parsed;
+}
+
+/**
+ * Returns the index of the first child of the token at index, -1 if it has none or was not entered.
+ */
+int derHelperFirstChild(const derHelperToken *tokens, size_t count, int index) {
+    if (index < 0 || (size_t) index + 1 >= count || tokens[index + 1].depth != tokens[index].depth + 1) {
+        return -1;
+    }
+    return index + 1;
+}
+
+/**
+ * Follows path from the children of parent, the top level tokens if parent is -1.
+ * Returns the index of the token the last step lands on, -1 if there is none.
+ */
+int derHelperFind(const derHelperToken *tokens, size_t count, int parent, const derHelperStep *path, size_t steps) {
+    int index = parent < 0 ? (count > 0 ? 0 : -1) : derHelperFirstChild(tokens, count, parent);
+
+    for (size_t i = 0; i < steps; i++) {
+        uint8_t seen = 0;
+        while (index >= 0) {
+            if (path[i].tag == DER_HELPER_ANY || tokens[index].tag == path[i].tag) {
+                if (seen++ == path[i].index) {
+                    break;
+                }
+            }
+            index = tokens[index].next == DER_HELPER_NONE ? -1 : tokens[index].next;
+        }
+        if (index < 0) {
+            return -1;
+        }
+        if (i + 1 < steps) {
+            index = derHelperFirstChild(tokens, count, index);
+        }
+    }
+    return index;
+}
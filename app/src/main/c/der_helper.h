@@ -0,0 +1,95 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef NATIVESIGNATUREVERIFICATION_DER_HELPER_H
+#define NATIVESIGNATUREVERIFICATION_DER_HELPER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "stats_helper.h"
+#include "def.h"
+
+// Tags:
+// https://en.wikipedia.org/wiki/X.690
+#define TAG_INTEGER         0x02
+#define TAG_BITSTRING       0x03
+#define TAG_OCTETSTRING     0x04
+#define TAG_NULL            0x05
+#define TAG_OBJECTID        0x06
+#define TAG_UTCTIME         0x17
+#define TAG_GENERALIZEDTIME 0x18
+#define TAG_SEQUENCE        0x30
+#define TAG_SET             0x31
+
+#define TAG_OPTIONAL    0xA0
+
+#define TAG_CONSTRUCTED     0x20
+#define TAG_CONTEXT(n)      (TAG_OPTIONAL | (n))
+
+// the index of a token is kept in uint8_t, DER_HELPER_NONE marks the missing sibling
+#define DER_HELPER_NONE         0xff
+#define DER_HELPER_MAX_TOKENS   DER_HELPER_NONE
+#define DER_HELPER_MAX_DEPTH    15
+
+// tag, 0x84 and four length bytes
+#define DER_HELPER_MAX_HEADER   6
+
+// a step with this tag matches any tag
+#define DER_HELPER_ANY          0x00
+
+/**
+ * One {tag, length, data} triple. offset points to the tag, the data starts at offset + header.
+ * Children follow their parent right away with depth + 1, next is the index of the next sibling.
+ */
+typedef struct derHelperToken {
+    uint32_t offset;
+    uint32_t len;
+    uint8_t tag;
+    uint8_t header;
+    uint8_t depth;
+    uint8_t next;
+} derHelperToken;
+
+/**
+ * One step of a tag path: the index-th child carrying tag.
+ */
+typedef struct derHelperStep {
+    uint8_t tag;
+    uint8_t index;
+} derHelperStep;
+
+
+int derHelperReadPartialHeader(const unsigned char *data, size_t len, uint8_t *tag, uint32_t *content_len);
+
+bool derHelperReadHeader(const unsigned char *data, size_t len, uint8_t *tag, uint8_t *header, uint32_t *content_len);
+
+bool derHelperTokenize(const unsigned char *data, size_t len, uint8_t max_depth,
+                       derHelperToken *tokens, size_t capacity, size_t *count);
+
+int derHelperFind(const derHelperToken *tokens, size_t count, int parent, const derHelperStep *path, size_t steps);
+
+int derHelperFirstChild(const derHelperToken *tokens, size_t count, int index);
+
+#endif //NATIVESIGNATUREVERIFICATION_DER_HELPER_H
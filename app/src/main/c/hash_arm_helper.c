@@ -0,0 +1,147 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+/*
+ * SHA-1 and SHA-256 compression functions on the ARMv8 cryptography extensions, for arm64-v8a and for
+ * armeabi-v7a running on an ARMv8 core. This file is built with the crypto extensions enabled on ARM only.
+ */
+
+#include "hash_helper.h"
+
+#if defined(__aarch64__) || defined(__arm__)
+
+#include <arm_neon.h>
+
+static uint32x4_t loadBe32x4(const unsigned char *p) {
+    return vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(p)));
+}
+
+// four rounds of SHA-256: w[i & 3] holds the words of i - 4, the others those of i - 3, i - 2 and i - 1
+#define SHA256_ARMV8_ROUNDS(i) \
+    do { \
+        if ((i) < 4) { \
+            w[(i) & 3] = loadBe32x4(data + (i) * 16); \
+        } else { \
+            w[(i) & 3] = vsha256su1q_u32(vsha256su0q_u32(w[(i) & 3], w[((i) + 1) & 3]), w[((i) + 2) & 3], \
+                                         w[((i) + 3) & 3]); \
+        } \
+        uint32x4_t wk = vaddq_u32(w[(i) & 3], vld1q_u32(hashHelperSha256K + (i) * 4)); \
+        uint32x4_t abcd_before = abcd; \
+        abcd = vsha256hq_u32(abcd, efgh, wk); \
+        efgh = vsha256h2q_u32(efgh, abcd_before, wk); \
+    } while (0)
+
+/**
+ * SHA-256 over the given number of 64-byte blocks, four rounds per instruction pair.
+ * The rounds are unrolled, the message words then stay in registers.
+ */
+void hashHelperSha256BlocksArmv8(uint32_t *state, const unsigned char *data, size_t blocks) {
+    uint32x4_t abcd = vld1q_u32(state);
+    uint32x4_t efgh = vld1q_u32(state + 4);
+
+    while (blocks--) {
+        uint32x4_t abcd_saved = abcd;
+        uint32x4_t efgh_saved = efgh;
+        uint32x4_t w[4];
+        SHA256_ARMV8_ROUNDS(0);
+        SHA256_ARMV8_ROUNDS(1);
+        SHA256_ARMV8_ROUNDS(2);
+        SHA256_ARMV8_ROUNDS(3);
+        SHA256_ARMV8_ROUNDS(4);
+        SHA256_ARMV8_ROUNDS(5);
+        SHA256_ARMV8_ROUNDS(6);
+        SHA256_ARMV8_ROUNDS(7);
+        SHA256_ARMV8_ROUNDS(8);
+        SHA256_ARMV8_ROUNDS(9);
+        SHA256_ARMV8_ROUNDS(10);
+        SHA256_ARMV8_ROUNDS(11);
+        SHA256_ARMV8_ROUNDS(12);
+        SHA256_ARMV8_ROUNDS(13);
+        SHA256_ARMV8_ROUNDS(14);
+        SHA256_ARMV8_ROUNDS(15);
+        abcd = vaddq_u32(abcd, abcd_saved);
+        efgh = vaddq_u32(efgh, efgh_saved);
+        data += 64;
+    }
+
+    vst1q_u32(state, abcd);
+    vst1q_u32(state + 4, efgh);
+}
+
+// four rounds of SHA-1, op is the instruction of their function: c(hoose), p(arity) or m(ajority)
+#define SHA1_ARMV8_ROUNDS(i, op, k) \
+    do { \
+        if ((i) < 4) { \
+            w[(i) & 3] = loadBe32x4(data + (i) * 16); \
+        } else { \
+            w[(i) & 3] = vsha1su1q_u32(vsha1su0q_u32(w[(i) & 3], w[((i) + 1) & 3], w[((i) + 2) & 3]), \
+                                       w[((i) + 3) & 3]); \
+        } \
+        uint32x4_t wk = vaddq_u32(w[(i) & 3], vdupq_n_u32(k)); \
+        uint32_t e_next = vsha1h_u32(vgetq_lane_u32(abcd, 0)); \
+        abcd = op(abcd, e, wk); \
+        e = e_next; \
+    } while (0)
+
+/**
+ * SHA-1 over the given number of 64-byte blocks, four rounds per instruction.
+ * The rounds are unrolled like the SHA-256 ones.
+ */
+void hashHelperSha1BlocksArmv8(uint32_t *state, const unsigned char *data, size_t blocks) {
+    uint32x4_t abcd = vld1q_u32(state);
+    uint32_t e0 = state[4];
+
+    while (blocks--) {
+        uint32x4_t abcd_saved = abcd;
+        uint32_t e = e0;
+        uint32x4_t w[4];
+        SHA1_ARMV8_ROUNDS(0, vsha1cq_u32, 0x5a827999);
+        SHA1_ARMV8_ROUNDS(1, vsha1cq_u32, 0x5a827999);
+        SHA1_ARMV8_ROUNDS(2, vsha1cq_u32, 0x5a827999);
+        SHA1_ARMV8_ROUNDS(3, vsha1cq_u32, 0x5a827999);
+        SHA1_ARMV8_ROUNDS(4, vsha1cq_u32, 0x5a827999);
+        SHA1_ARMV8_ROUNDS(5, vsha1pq_u32, 0x6ed9eba1);
+        SHA1_ARMV8_ROUNDS(6, vsha1pq_u32, 0x6ed9eba1);
+        SHA1_ARMV8_ROUNDS(7, vsha1pq_u32, 0x6ed9eba1);
+        SHA1_ARMV8_ROUNDS(8, vsha1pq_u32, 0x6ed9eba1);
+        SHA1_ARMV8_ROUNDS(9, vsha1pq_u32, 0x6ed9eba1);
+        SHA1_ARMV8_ROUNDS(10, vsha1mq_u32, 0x8f1bbcdc);
+        SHA1_ARMV8_ROUNDS(11, vsha1mq_u32, 0x8f1bbcdc);
+        SHA1_ARMV8_ROUNDS(12, vsha1mq_u32, 0x8f1bbcdc);
+        SHA1_ARMV8_ROUNDS(13, vsha1mq_u32, 0x8f1bbcdc);
+        SHA1_ARMV8_ROUNDS(14, vsha1mq_u32, 0x8f1bbcdc);
+        SHA1_ARMV8_ROUNDS(15, vsha1pq_u32, 0xca62c1d6);
+        SHA1_ARMV8_ROUNDS(16, vsha1pq_u32, 0xca62c1d6);
+        SHA1_ARMV8_ROUNDS(17, vsha1pq_u32, 0xca62c1d6);
+        SHA1_ARMV8_ROUNDS(18, vsha1pq_u32, 0xca62c1d6);
+        SHA1_ARMV8_ROUNDS(19, vsha1pq_u32, 0xca62c1d6);
+        abcd = vaddq_u32(abcd, abcd_saved);
+        e0 += e;
+        data += 64;
+    }
+
+    vst1q_u32(state, abcd);
+    state[4] = e0;
+}
+
+#endif
@@ -0,0 +1,744 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include <pthread.h>
+
+#include "hash_helper.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#elif defined(__aarch64__) || defined(__arm__)
+#include <sys/auxv.h>
+#endif
+
+#ifndef bit_SHA
+#define bit_SHA         (1 << 29)
+#endif
+
+// getauxval() bits of the crypto extensions, arm64 reports them in AT_HWCAP and arm in AT_HWCAP2
+#ifndef AT_HWCAP2
+#define AT_HWCAP2       26
+#endif
+#define ARM64_HWCAP_SHA1    (1 << 5)
+#define ARM64_HWCAP_SHA2    (1 << 6)
+#define ARM_HWCAP2_SHA1     (1 << 2)
+#define ARM_HWCAP2_SHA2     (1 << 3)
+
+#define ROR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define ROR64(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+#define ROL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+typedef void (*hashHelperBlocks)(uint32_t *state, const unsigned char *data, size_t blocks);
+
+static const uint32_t MD5_K[64] = {
+        0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+        0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+        0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+        0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+        0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+        0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+        0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+        0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+static const unsigned char MD5_R[64] = {
+        7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+        5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+        4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+        6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+const uint32_t hashHelperSha256K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint64_t SHA512_K[80] = {
+        0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+        0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+        0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+        0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+        0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+        0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+        0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+        0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+        0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+        0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+        0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+        0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+        0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+        0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+        0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+        0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+        0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+        0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+        0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+        0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+static uint32_t loadBe32(const unsigned char *p) {
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+static uint64_t loadBe64(const unsigned char *p) {
+    return ((uint64_t) loadBe32(p) << 32) | loadBe32(p + 4);
+}
+
+static uint32_t loadLe32(const unsigned char *p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static void storeLe32(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char) v;
+    p[1] = (unsigned char) (v >> 8);
+    p[2] = (unsigned char) (v >> 16);
+    p[3] = (unsigned char) (v >> 24);
+}
+
+static void storeBe32(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char) (v >> 24);
+    p[1] = (unsigned char) (v >> 16);
+    p[2] = (unsigned char) (v >> 8);
+    p[3] = (unsigned char) v;
+}
+
+static void storeBe64(unsigned char *p, uint64_t v) {
+    storeBe32(p, (uint32_t) (v >> 32));
+    storeBe32(p + 4, (uint32_t) v);
+}
+
+#define SHA256_SIGMA0(x)    (ROR32(x, 2) ^ ROR32(x, 13) ^ ROR32(x, 22))
+#define SHA256_SIGMA1(x)    (ROR32(x, 6) ^ ROR32(x, 11) ^ ROR32(x, 25))
+#define SHA256_GAMMA0(x)    (ROR32(x, 7) ^ ROR32(x, 18) ^ ((x) >> 3))
+#define SHA256_GAMMA1(x)    (ROR32(x, 17) ^ ROR32(x, 19) ^ ((x) >> 10))
+#define SHA_CH(x, y, z)     ((z) ^ ((x) & ((y) ^ (z))))
+#define SHA_MAJ(x, y, z)    (((x) & (y)) | ((z) & ((x) | (y))))
+
+// round i + j of SHA-256, the 16 schedule words are kept in w and replaced as the rounds go
+#define SHA256_ROUND(a, b, c, d, e, f, g, h, i, j) \
+    do { \
+        if ((i) > 0) { \
+            w[j] += SHA256_GAMMA1(w[((j) + 14) & 15]) + w[((j) + 9) & 15] + SHA256_GAMMA0(w[((j) + 1) & 15]); \
+        } \
+        uint32_t t = (h) + SHA256_SIGMA1(e) + SHA_CH(e, f, g) + hashHelperSha256K[(i) + (j)] + w[j]; \
+        (d) += t; \
+        (h) = t + SHA256_SIGMA0(a) + SHA_MAJ(a, b, c); \
+    } while (0)
+
+/**
+ * Runs the SHA-256 compression function over the given number of consecutive 64-byte blocks.
+ * The rounds are unrolled so the eight working variables rotate by name instead of being moved.
+ */
+static void sha256Blocks(uint32_t *state, const unsigned char *data, size_t blocks) {
+    uint32_t w[16];
+    while (blocks--) {
+        for (int i = 0; i < 16; i++) {
+            w[i] = loadBe32(data + i * 4);
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i += 16) {
+            SHA256_ROUND(a, b, c, d, e, f, g, h, i, 0);
+            SHA256_ROUND(h, a, b, c, d, e, f, g, i, 1);
+            SHA256_ROUND(g, h, a, b, c, d, e, f, i, 2);
+            SHA256_ROUND(f, g, h, a, b, c, d, e, i, 3);
+            SHA256_ROUND(e, f, g, h, a, b, c, d, i, 4);
+            SHA256_ROUND(d, e, f, g, h, a, b, c, i, 5);
+            SHA256_ROUND(c, d, e, f, g, h, a, b, i, 6);
+            SHA256_ROUND(b, c, d, e, f, g, h, a, i, 7);
+            SHA256_ROUND(a, b, c, d, e, f, g, h, i, 8);
+            SHA256_ROUND(h, a, b, c, d, e, f, g, i, 9);
+            SHA256_ROUND(g, h, a, b, c, d, e, f, i, 10);
+            SHA256_ROUND(f, g, h, a, b, c, d, e, i, 11);
+            SHA256_ROUND(e, f, g, h, a, b, c, d, i, 12);
+            SHA256_ROUND(d, e, f, g, h, a, b, c, i, 13);
+            SHA256_ROUND(c, d, e, f, g, h, a, b, i, 14);
+            SHA256_ROUND(b, c, d, e, f, g, h, a, i, 15);
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+        data += 64;
+    }
+}
+
+/**
+ * Runs the SHA-512 compression function over the given number of consecutive 128-byte blocks.
+ */
+static void sha512Blocks(uint64_t *state, const unsigned char *data, size_t blocks) {
+    uint64_t w[80];
+    while (blocks--) {
+        for (int i = 0; i < 16; i++) {
+            w[i] = loadBe64(data + i * 8);
+        }
+        for (int i = 16; i < 80; i++) {
+            uint64_t s0 = ROR64(w[i - 15], 1) ^ ROR64(w[i - 15], 8) ^ (w[i - 15] >> 7);
+            uint64_t s1 = ROR64(w[i - 2], 19) ^ ROR64(w[i - 2], 61) ^ (w[i - 2] >> 6);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint64_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint64_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 80; i++) {
+            uint64_t t1 = h + (ROR64(e, 14) ^ ROR64(e, 18) ^ ROR64(e, 41)) + ((e & f) ^ (~e & g))
+                          + SHA512_K[i] + w[i];
+            uint64_t t2 = (ROR64(a, 28) ^ ROR64(a, 34) ^ ROR64(a, 39)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+        data += 128;
+    }
+}
+
+/**
+ * Runs the MD5 compression function over the given number of consecutive 64-byte blocks.
+ */
+static void md5Blocks(uint32_t *state, const unsigned char *data, size_t blocks) {
+    uint32_t w[16];
+    while (blocks--) {
+        for (int i = 0; i < 16; i++) {
+            w[i] = loadLe32(data + i * 4);
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        for (int i = 0; i < 64; i++) {
+            uint32_t f;
+            int g;
+            if (i < 16) {
+                f = (b & c) | (~b & d);
+                g = i;
+            } else if (i < 32) {
+                f = (d & b) | (~d & c);
+                g = (5 * i + 1) & 15;
+            } else if (i < 48) {
+                f = b ^ c ^ d;
+                g = (3 * i + 5) & 15;
+            } else {
+                f = c ^ (b | ~d);
+                g = (7 * i) & 15;
+            }
+            uint32_t t = d;
+            d = c;
+            c = b;
+            b = b + ROL32(a + f + MD5_K[i] + w[g], MD5_R[i]);
+            a = t;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        data += 64;
+    }
+}
+
+// word i of the SHA-1 schedule, from the 16 previous ones kept in w
+#define SHA1_W(i) \
+    ((i) < 16 ? w[i] : (w[(i) & 15] = ROL32(w[((i) + 13) & 15] ^ w[((i) + 8) & 15] ^ w[((i) + 2) & 15] \
+                                            ^ w[(i) & 15], 1)))
+
+#define SHA1_ROUND(a, b, c, d, e, f, k, i) \
+    do { \
+        (e) += ROL32(a, 5) + (f) + (k) + SHA1_W(i); \
+        (b) = ROL32(b, 30); \
+    } while (0)
+
+#define SHA1_FIVE_ROUNDS(F, k, i) \
+    do { \
+        SHA1_ROUND(a, b, c, d, e, F(b, c, d), k, (i)); \
+        SHA1_ROUND(e, a, b, c, d, F(a, b, c), k, (i) + 1); \
+        SHA1_ROUND(d, e, a, b, c, F(e, a, b), k, (i) + 2); \
+        SHA1_ROUND(c, d, e, a, b, F(d, e, a), k, (i) + 3); \
+        SHA1_ROUND(b, c, d, e, a, F(c, d, e), k, (i) + 4); \
+    } while (0)
+
+#define SHA1_PARITY(x, y, z) ((x) ^ (y) ^ (z))
+
+/**
+ * Runs the SHA-1 compression function over the given number of consecutive 64-byte blocks.
+ * The rounds are unrolled by five so the working variables rotate by name instead of being moved.
+ */
+static void sha1Blocks(uint32_t *state, const unsigned char *data, size_t blocks) {
+    uint32_t w[16];
+    while (blocks--) {
+        for (int i = 0; i < 16; i++) {
+            w[i] = loadBe32(data + i * 4);
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        for (int i = 0; i < 20; i += 5) {
+            SHA1_FIVE_ROUNDS(SHA_CH, 0x5a827999, i);
+        }
+        for (int i = 20; i < 40; i += 5) {
+            SHA1_FIVE_ROUNDS(SHA1_PARITY, 0x6ed9eba1, i);
+        }
+        for (int i = 40; i < 60; i += 5) {
+            SHA1_FIVE_ROUNDS(SHA_MAJ, 0x8f1bbcdc, i);
+        }
+        for (int i = 60; i < 80; i += 5) {
+            SHA1_FIVE_ROUNDS(SHA1_PARITY, 0xca62c1d6, i);
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        data += 64;
+    }
+}
+
+/**
+ * Buffers data for the hashes working on 64-byte blocks (MD5, SHA-1, SHA-256)
+ * and compresses every complete block.
+ */
+static void hashHelperUpdate64(uint32_t *state, uint64_t *count, unsigned char *buffer,
+                               hashHelperBlocks blocks, const void *data, size_t len) {
+    const unsigned char *p = data;
+    size_t used = (size_t) (*count & 63);
+    *count += len;
+    if (used) {
+        size_t fill = 64 - used;
+        if (len < fill) {
+            memcpy(buffer + used, p, len);
+            return;
+        }
+        memcpy(buffer + used, p, fill);
+        blocks(state, buffer, 1);
+        p += fill;
+        len -= fill;
+    }
+    if (len >= 64) {
+        blocks(state, p, len / 64);
+        p += len & ~(size_t) 63;
+        len &= 63;
+    }
+    if (len) {
+        memcpy(buffer, p, len);
+    }
+}
+
+/**
+ * Appends 0x80, zeros and the bit count, big-endian for SHA and little-endian for MD5.
+ */
+static void hashHelperPad64(uint32_t *state, uint64_t count, unsigned char *buffer,
+                            hashHelperBlocks blocks, bool big_endian) {
+    size_t used = (size_t) (count & 63);
+    buffer[used++] = 0x80;
+    if (used > 56) {
+        memset(buffer + used, 0, 64 - used);
+        blocks(state, buffer, 1);
+        used = 0;
+    }
+    memset(buffer + used, 0, 56 - used);
+    if (big_endian) {
+        storeBe64(buffer + 56, count << 3);
+    } else {
+        storeLe32(buffer + 56, (uint32_t) (count << 3));
+        storeLe32(buffer + 60, (uint32_t) (count >> 29));
+    }
+    blocks(state, buffer, 1);
+}
+
+static const char *IMPLEMENTATION_NAMES[HASH_HELPER_IMPLEMENTATION_COUNT] = {"portable", "sha-ni", "armv8"};
+
+static void sha256BlocksFirst(uint32_t *state, const unsigned char *data, size_t blocks);
+
+static void sha1BlocksFirst(uint32_t *state, const unsigned char *data, size_t blocks);
+
+static pthread_once_t implementationOnce = PTHREAD_ONCE_INIT;
+static hashHelperImplementation implementationInUse = HASH_HELPER_PORTABLE;
+
+// the SHA-256 and SHA-1 compression functions in use, the first call picks them from what the CPU supports
+static hashHelperBlocks sha256BlocksInUse = sha256BlocksFirst;
+static hashHelperBlocks sha1BlocksInUse = sha1BlocksFirst;
+
+/**
+ * Switches the SHA-256 and SHA-1 compression functions; they all keep the state in the same layout,
+ * so a hash which is in progress can go on with the others.
+ */
+static void hashHelperUse(hashHelperImplementation use) {
+    hashHelperBlocks sha256 = sha256Blocks;
+    hashHelperBlocks sha1 = sha1Blocks;
+#if defined(__x86_64__) || defined(__i386__)
+    if (use == HASH_HELPER_SHA_NI) {
+        sha256 = hashHelperSha256BlocksShaNi;
+        sha1 = hashHelperSha1BlocksShaNi;
+    }
+#elif defined(__aarch64__) || defined(__arm__)
+    if (use == HASH_HELPER_ARMV8) {
+        sha256 = hashHelperSha256BlocksArmv8;
+        sha1 = hashHelperSha1BlocksArmv8;
+    }
+#endif
+    __atomic_store_n(&sha256BlocksInUse, sha256, __ATOMIC_RELAXED);
+    __atomic_store_n(&sha1BlocksInUse, sha1, __ATOMIC_RELAXED);
+    __atomic_store_n(&implementationInUse, use, __ATOMIC_RELAXED);
+}
+
+static void hashHelperSelectImplementation() {
+    hashHelperImplementation use = HASH_HELPER_PORTABLE;
+    if (hashHelperIsImplementationSupported(HASH_HELPER_SHA_NI)) {
+        use = HASH_HELPER_SHA_NI;
+    } else if (hashHelperIsImplementationSupported(HASH_HELPER_ARMV8)) {
+        use = HASH_HELPER_ARMV8;
+    }
+    NSV_LOGI("hash: %s\n", IMPLEMENTATION_NAMES[use]);
+    hashHelperUse(use);
+}
+
+static void sha256BlocksFirst(uint32_t *state, const unsigned char *data, size_t blocks) {
+    pthread_once(&implementationOnce, hashHelperSelectImplementation);
+    __atomic_load_n(&sha256BlocksInUse, __ATOMIC_RELAXED)(state, data, blocks);
+}
+
+static void sha1BlocksFirst(uint32_t *state, const unsigned char *data, size_t blocks) {
+    pthread_once(&implementationOnce, hashHelperSelectImplementation);
+    __atomic_load_n(&sha1BlocksInUse, __ATOMIC_RELAXED)(state, data, blocks);
+}
+
+static hashHelperBlocks sha256BlocksCurrent() {
+    return __atomic_load_n(&sha256BlocksInUse, __ATOMIC_RELAXED);
+}
+
+static hashHelperBlocks sha1BlocksCurrent() {
+    return __atomic_load_n(&sha1BlocksInUse, __ATOMIC_RELAXED);
+}
+
+/**
+ * Whether the CPU can run implementation: cpuid on x86, the hwcaps the kernel reports on ARM.
+ */
+bool hashHelperIsImplementationSupported(hashHelperImplementation implementation) {
+    switch (implementation) {
+        case HASH_HELPER_PORTABLE:
+            return true;
+        case HASH_HELPER_SHA_NI: {
+#if defined(__x86_64__) || defined(__i386__)
+            unsigned int eax, ebx, ecx, edx;
+            if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSSE3) || !(ecx & bit_SSE4_1)) {
+                return false;
+            }
+            if (__get_cpuid_max(0, NULL) < 7) {
+                return false;
+            }
+            __cpuid_count(7, 0, eax, ebx, ecx, edx);
+            return (ebx & bit_SHA) != 0;
+#else
+            return false;
+#endif
+        }
+        case HASH_HELPER_ARMV8: {
+#if defined(__aarch64__)
+            unsigned long hwcap = getauxval(AT_HWCAP);
+            return (hwcap & ARM64_HWCAP_SHA1) && (hwcap & ARM64_HWCAP_SHA2);
+#elif defined(__arm__)
+            unsigned long hwcap2 = getauxval(AT_HWCAP2);
+            return (hwcap2 & ARM_HWCAP2_SHA1) && (hwcap2 & ARM_HWCAP2_SHA2);
+#else
+            return false;
+#endif
+        }
+        default:
+            return false;
+    }
+}
+
+/**
+ * The implementation SHA-256 and SHA-1 run on, picking it if no hash has been started yet.
+ */
+hashHelperImplementation hashHelperGetImplementation() {
+    pthread_once(&implementationOnce, hashHelperSelectImplementation);
+    return __atomic_load_n(&implementationInUse, __ATOMIC_RELAXED);
+}
+
+/**
+ * Makes SHA-256 and SHA-1 run on implementation from now on, e.g. to compare them; false if the CPU can't run it.
+ */
+bool hashHelperSetImplementation(hashHelperImplementation use) {
+    pthread_once(&implementationOnce, hashHelperSelectImplementation);
+    if (!hashHelperIsImplementationSupported(use)) {
+        return false;
+    }
+    hashHelperUse(use);
+    return true;
+}
+
+const char *hashHelperGetImplementationName(hashHelperImplementation implementation) {
+    if ((unsigned) implementation >= HASH_HELPER_IMPLEMENTATION_COUNT) {
+        return "unknown";
+    }
+    return IMPLEMENTATION_NAMES[implementation];
+}
+
+void hashHelperSha256Init(hashHelperSha256 *ctx) {
+    static const uint32_t iv[8] = {
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+            0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(ctx->state, iv, sizeof(iv));
+    ctx->count = 0;
+}
+
+void hashHelperSha256Update(hashHelperSha256 *ctx, const void *data, size_t len) {
+    hashHelperUpdate64(ctx->state, &ctx->count, ctx->buffer, sha256BlocksCurrent(), data, len);
+}
+
+void hashHelperSha256Final(hashHelperSha256 *ctx, unsigned char *digest) {
+    hashHelperPad64(ctx->state, ctx->count, ctx->buffer, sha256BlocksCurrent(), true);
+    for (int i = 0; i < 8; i++) {
+        storeBe32(digest + i * 4, ctx->state[i]);
+    }
+}
+
+void hashHelperSha1Init(hashHelperSha1 *ctx) {
+    static const uint32_t iv[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+    memcpy(ctx->state, iv, sizeof(iv));
+    ctx->count = 0;
+}
+
+void hashHelperSha1Update(hashHelperSha1 *ctx, const void *data, size_t len) {
+    hashHelperUpdate64(ctx->state, &ctx->count, ctx->buffer, sha1BlocksCurrent(), data, len);
+}
+
+void hashHelperSha1Final(hashHelperSha1 *ctx, unsigned char *digest) {
+    hashHelperPad64(ctx->state, ctx->count, ctx->buffer, sha1BlocksCurrent(), true);
+    for (int i = 0; i < 5; i++) {
+        storeBe32(digest + i * 4, ctx->state[i]);
+    }
+}
+
+void hashHelperMd5Init(hashHelperMd5 *ctx) {
+    static const uint32_t iv[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+    memcpy(ctx->state, iv, sizeof(iv));
+    ctx->count = 0;
+}
+
+void hashHelperMd5Update(hashHelperMd5 *ctx, const void *data, size_t len) {
+    hashHelperUpdate64(ctx->state, &ctx->count, ctx->buffer, md5Blocks, data, len);
+}
+
+void hashHelperMd5Final(hashHelperMd5 *ctx, unsigned char *digest) {
+    hashHelperPad64(ctx->state, ctx->count, ctx->buffer, md5Blocks, false);
+    for (int i = 0; i < 4; i++) {
+        storeLe32(digest + i * 4, ctx->state[i]);
+    }
+}
+
+void hashHelperSha512Init(hashHelperSha512 *ctx) {
+    static const uint64_t iv[8] = {
+            0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+            0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+    };
+    memcpy(ctx->state, iv, sizeof(iv));
+    ctx->count = 0;
+}
+
+void hashHelperSha512Update(hashHelperSha512 *ctx, const void *data, size_t len) {
+    const unsigned char *p = data;
+    size_t used = (size_t) (ctx->count & 127);
+    ctx->count += len;
+    if (used) {
+        size_t fill = 128 - used;
+        if (len < fill) {
+            memcpy(ctx->buffer + used, p, len);
+            return;
+        }
+        memcpy(ctx->buffer + used, p, fill);
+        sha512Blocks(ctx->state, ctx->buffer, 1);
+        p += fill;
+        len -= fill;
+    }
+    if (len >= 128) {
+        sha512Blocks(ctx->state, p, len / 128);
+        p += len & ~(size_t) 127;
+        len &= 127;
+    }
+    if (len) {
+        memcpy(ctx->buffer, p, len);
+    }
+}
+
+void hashHelperSha512Final(hashHelperSha512 *ctx, unsigned char *digest) {
+    size_t used = (size_t) (ctx->count & 127);
+    uint64_t bits = ctx->count << 3;
+    ctx->buffer[used++] = 0x80;
+    if (used > 112) {
+        memset(ctx->buffer + used, 0, 128 - used);
+        sha512Blocks(ctx->state, ctx->buffer, 1);
+        used = 0;
+    }
+    // the upper half of the 128-bit length is always zero for inputs we can address
+    memset(ctx->buffer + used, 0, 120 - used);
+    storeBe64(ctx->buffer + 120, bits);
+    sha512Blocks(ctx->state, ctx->buffer, 1);
+    for (int i = 0; i < 8; i++) {
+        storeBe64(digest + i * 8, ctx->state[i]);
+    }
+}
+
+size_t hashHelperGetSize(hashHelperAlgorithm algorithm) {
+    switch (algorithm) {
+        case HASH_HELPER_SHA256:
+            return HASH_HELPER_SHA256_SIZE;
+        case HASH_HELPER_SHA512:
+            return HASH_HELPER_SHA512_SIZE;
+        case HASH_HELPER_SHA1:
+            return HASH_HELPER_SHA1_SIZE;
+        case HASH_HELPER_MD5:
+            return HASH_HELPER_MD5_SIZE;
+    }
+    return 0;
+}
+
+void hashHelperInit(hashHelperContext *ctx, hashHelperAlgorithm algorithm) {
+    ctx->algorithm = algorithm;
+    switch (algorithm) {
+        case HASH_HELPER_SHA256:
+            hashHelperSha256Init(&ctx->u.sha256);
+            break;
+        case HASH_HELPER_SHA512:
+            hashHelperSha512Init(&ctx->u.sha512);
+            break;
+        case HASH_HELPER_SHA1:
+            hashHelperSha1Init(&ctx->u.sha1);
+            break;
+        case HASH_HELPER_MD5:
+            hashHelperMd5Init(&ctx->u.md5);
+            break;
+    }
+}
+
+void hashHelperUpdate(hashHelperContext *ctx, const void *data, size_t len) {
+    switch (ctx->algorithm) {
+        case HASH_HELPER_SHA256:
+            hashHelperSha256Update(&ctx->u.sha256, data, len);
+            break;
+        case HASH_HELPER_SHA512:
+            hashHelperSha512Update(&ctx->u.sha512, data, len);
+            break;
+        case HASH_HELPER_SHA1:
+            hashHelperSha1Update(&ctx->u.sha1, data, len);
+            break;
+        case HASH_HELPER_MD5:
+            hashHelperMd5Update(&ctx->u.md5, data, len);
+            break;
+    }
+}
+
+void hashHelperFinal(hashHelperContext *ctx, unsigned char *digest) {
+    switch (ctx->algorithm) {
+        case HASH_HELPER_SHA256:
+            hashHelperSha256Final(&ctx->u.sha256, digest);
+            break;
+        case HASH_HELPER_SHA512:
+            hashHelperSha512Final(&ctx->u.sha512, digest);
+            break;
+        case HASH_HELPER_SHA1:
+            hashHelperSha1Final(&ctx->u.sha1, digest);
+            break;
+        case HASH_HELPER_MD5:
+            hashHelperMd5Final(&ctx->u.md5, digest);
+            break;
+    }
+}
+
+/**
+ * Computes the fingerprints selected by mask in one pass: every 64-byte block of data is fed to
+ * SHA-256, SHA-1 and MD5 while it is in cache, the padded tail is built once.
+ * out receives HASH_HELPER_FINGERPRINTS_SIZE bytes: SHA-256, SHA-1, MD5, unselected ones are zeroed.
+ */
+void hashHelperFingerprints(const void *data, size_t len, unsigned int mask, unsigned char *out) {
+    hashHelperSha256 sha256;
+    hashHelperSha1 sha1;
+    hashHelperMd5 md5;
+    unsigned char tail[128];
+    const unsigned char *p = data;
+    size_t full = len & ~(size_t) 63;
+
+    hashHelperSha256Init(&sha256);
+    hashHelperSha1Init(&sha1);
+    hashHelperMd5Init(&md5);
+    hashHelperBlocks sha256_blocks = sha256BlocksCurrent();
+    hashHelperBlocks sha1_blocks = sha1BlocksCurrent();
+    for (size_t pos = 0; pos < full; pos += 64) {
+        if (mask & HASH_HELPER_FINGERPRINT_SHA256) {
+            sha256_blocks(sha256.state, p + pos, 1);
+        }
+        if (mask & HASH_HELPER_FINGERPRINT_SHA1) {
+            sha1_blocks(sha1.state, p + pos, 1);
+        }
+        if (mask & HASH_HELPER_FINGERPRINT_MD5) {
+            md5Blocks(md5.state, p + pos, 1);
+        }
+    }
+
+    size_t rest = len - full;
+    size_t tail_len = rest < 56 ? 64 : 128;
+    memset(tail, 0, sizeof(tail));
+    memcpy(tail, p + full, rest);
+    tail[rest] = 0x80;
+
+    memset(out, 0, HASH_HELPER_FINGERPRINTS_SIZE);
+    if (mask & HASH_HELPER_FINGERPRINT_SHA256) {
+        storeBe64(tail + tail_len - 8, (uint64_t) len << 3);
+        sha256_blocks(sha256.state, tail, tail_len / 64);
+        for (int i = 0; i < 8; i++) {
+            storeBe32(out + i * 4, sha256.state[i]);
+        }
+    }
+    if (mask & HASH_HELPER_FINGERPRINT_SHA1) {
+        storeBe64(tail + tail_len - 8, (uint64_t) len << 3);
+        sha1_blocks(sha1.state, tail, tail_len / 64);
+        for (int i = 0; i < 5; i++) {
+            storeBe32(out + HASH_HELPER_SHA256_SIZE + i * 4, sha1.state[i]);
+        }
+    }
+    if (mask & HASH_HELPER_FINGERPRINT_MD5) {
+        storeLe32(tail + tail_len - 8, (uint32_t) ((uint64_t) len << 3));
+        storeLe32(tail + tail_len - 4, (uint32_t) ((uint64_t) len >> 29));
+        md5Blocks(md5.state, tail, tail_len / 64);
+        for (int i = 0; i < 4; i++) {
+            storeLe32(out + HASH_HELPER_SHA256_SIZE + HASH_HELPER_SHA1_SIZE + i * 4, md5.state[i]);
+        }
+    }
+}
@@ -0,0 +1,155 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef NATIVESIGNATUREVERIFICATION_HASH_HELPER_H
+#define NATIVESIGNATUREVERIFICATION_HASH_HELPER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "def.h"
+
+#define HASH_HELPER_SHA256_SIZE     32
+#define HASH_HELPER_SHA512_SIZE     64
+#define HASH_HELPER_SHA1_SIZE       20
+#define HASH_HELPER_MD5_SIZE        16
+#define HASH_HELPER_MAX_SIZE        HASH_HELPER_SHA512_SIZE
+
+// fingerprints of a certificate, see hashHelperFingerprints
+#define HASH_HELPER_FINGERPRINT_SHA256  0x01
+#define HASH_HELPER_FINGERPRINT_SHA1    0x02
+#define HASH_HELPER_FINGERPRINT_MD5     0x04
+#define HASH_HELPER_FINGERPRINTS_SIZE   (HASH_HELPER_SHA256_SIZE + HASH_HELPER_SHA1_SIZE + HASH_HELPER_MD5_SIZE)
+
+typedef enum hashHelperAlgorithm {
+    HASH_HELPER_SHA256,
+    HASH_HELPER_SHA512,
+    HASH_HELPER_SHA1,
+    HASH_HELPER_MD5
+} hashHelperAlgorithm;
+
+/**
+ * The code running the SHA-1 and SHA-256 compression functions, picked from what the CPU supports
+ * the first time a hash is started. SHA-512 and MD5 always run the portable code.
+ */
+typedef enum hashHelperImplementation {
+    HASH_HELPER_PORTABLE,
+    HASH_HELPER_SHA_NI,
+    HASH_HELPER_ARMV8,
+    HASH_HELPER_IMPLEMENTATION_COUNT
+} hashHelperImplementation;
+
+typedef struct hashHelperSha256 {
+    uint32_t state[8];
+    uint64_t count;
+    unsigned char buffer[64];
+} hashHelperSha256;
+
+typedef struct hashHelperSha512 {
+    uint64_t state[8];
+    uint64_t count;
+    unsigned char buffer[128];
+} hashHelperSha512;
+
+typedef struct hashHelperSha1 {
+    uint32_t state[5];
+    uint64_t count;
+    unsigned char buffer[64];
+} hashHelperSha1;
+
+typedef struct hashHelperMd5 {
+    uint32_t state[4];
+    uint64_t count;
+    unsigned char buffer[64];
+} hashHelperMd5;
+
+typedef struct hashHelperContext {
+    hashHelperAlgorithm algorithm;
+    union {
+        hashHelperSha256 sha256;
+        hashHelperSha512 sha512;
+        hashHelperSha1 sha1;
+        hashHelperMd5 md5;
+    } u;
+} hashHelperContext;
+
+
+void hashHelperSha256Init(hashHelperSha256 *ctx);
+
+void hashHelperSha256Update(hashHelperSha256 *ctx, const void *data, size_t len);
+
+void hashHelperSha256Final(hashHelperSha256 *ctx, unsigned char *digest);
+
+void hashHelperSha512Init(hashHelperSha512 *ctx);
+
+void hashHelperSha512Update(hashHelperSha512 *ctx, const void *data, size_t len);
+
+void hashHelperSha512Final(hashHelperSha512 *ctx, unsigned char *digest);
+
+void hashHelperSha1Init(hashHelperSha1 *ctx);
+
+void hashHelperSha1Update(hashHelperSha1 *ctx, const void *data, size_t len);
+
+void hashHelperSha1Final(hashHelperSha1 *ctx, unsigned char *digest);
+
+void hashHelperMd5Init(hashHelperMd5 *ctx);
+
+void hashHelperMd5Update(hashHelperMd5 *ctx, const void *data, size_t len);
+
+void hashHelperMd5Final(hashHelperMd5 *ctx, unsigned char *digest);
+
+size_t hashHelperGetSize(hashHelperAlgorithm algorithm);
+
+void hashHelperInit(hashHelperContext *ctx, hashHelperAlgorithm algorithm);
+
+void hashHelperUpdate(hashHelperContext *ctx, const void *data, size_t len);
+
+void hashHelperFinal(hashHelperContext *ctx, unsigned char *digest);
+
+void hashHelperFingerprints(const void *data, size_t len, unsigned int mask, unsigned char *out);
+
+hashHelperImplementation hashHelperGetImplementation();
+
+bool hashHelperIsImplementationSupported(hashHelperImplementation implementation);
+
+bool hashHelperSetImplementation(hashHelperImplementation implementation);
+
+const char *hashHelperGetImplementationName(hashHelperImplementation implementation);
+
+// compression functions using the SHA instructions of the CPU, built with their own flags (CMakeLists.txt),
+// hash_helper.c calls them only once it has checked the CPU has them
+extern const uint32_t hashHelperSha256K[64];
+
+#if defined(__x86_64__) || defined(__i386__)
+void hashHelperSha256BlocksShaNi(uint32_t *state, const unsigned char *data, size_t blocks);
+
+void hashHelperSha1BlocksShaNi(uint32_t *state, const unsigned char *data, size_t blocks);
+#elif defined(__aarch64__) || defined(__arm__)
+void hashHelperSha256BlocksArmv8(uint32_t *state, const unsigned char *data, size_t blocks);
+
+void hashHelperSha1BlocksArmv8(uint32_t *state, const unsigned char *data, size_t blocks);
+#endif
+
+#endif //NATIVESIGNATUREVERIFICATION_HASH_HELPER_H
@@ -0,0 +1,152 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+/*
+ * SHA-1 and SHA-256 compression functions on the x86 SHA extensions (SHA-NI), with SSSE3 and SSE4.1
+ * for the byte swap and the state layout. This file is built with -msha -msse4.1 on x86 only.
+ */
+
+#include "hash_helper.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+// four rounds of SHA-256: w[i & 3] holds the words of i - 4, the others those of i - 3, i - 2 and i - 1
+#define SHA256_NI_ROUNDS(i) \
+    do { \
+        if ((i) < 4) { \
+            w[(i) & 3] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + (i) * 16)), swap); \
+        } else { \
+            __m128i t = _mm_sha256msg1_epu32(w[(i) & 3], w[((i) + 1) & 3]); \
+            t = _mm_add_epi32(t, _mm_alignr_epi8(w[((i) + 3) & 3], w[((i) + 2) & 3], 4)); \
+            w[(i) & 3] = _mm_sha256msg2_epu32(t, w[((i) + 3) & 3]); \
+        } \
+        __m128i wk = _mm_add_epi32(w[(i) & 3], _mm_loadu_si128((const __m128i *) (hashHelperSha256K + (i) * 4))); \
+        cdgh = _mm_sha256rnds2_epu32(cdgh, abef, wk); \
+        abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(wk, 0x0e)); \
+    } while (0)
+
+/**
+ * SHA-256 over the given number of 64-byte blocks; the instructions work on the state as ABEF and CDGH.
+ * The rounds are unrolled, the message words then stay in registers.
+ */
+void hashHelperSha256BlocksShaNi(uint32_t *state, const unsigned char *data, size_t blocks) {
+    const __m128i swap = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+    __m128i dcba = _mm_loadu_si128((const __m128i *) state);
+    __m128i hgfe = _mm_loadu_si128((const __m128i *) (state + 4));
+    __m128i cdab = _mm_shuffle_epi32(dcba, 0xb1);
+    __m128i efgh = _mm_shuffle_epi32(hgfe, 0x1b);
+    __m128i abef = _mm_alignr_epi8(cdab, efgh, 8);
+    __m128i cdgh = _mm_blend_epi16(efgh, cdab, 0xf0);
+
+    while (blocks--) {
+        __m128i abef_saved = abef;
+        __m128i cdgh_saved = cdgh;
+        __m128i w[4];
+        SHA256_NI_ROUNDS(0);
+        SHA256_NI_ROUNDS(1);
+        SHA256_NI_ROUNDS(2);
+        SHA256_NI_ROUNDS(3);
+        SHA256_NI_ROUNDS(4);
+        SHA256_NI_ROUNDS(5);
+        SHA256_NI_ROUNDS(6);
+        SHA256_NI_ROUNDS(7);
+        SHA256_NI_ROUNDS(8);
+        SHA256_NI_ROUNDS(9);
+        SHA256_NI_ROUNDS(10);
+        SHA256_NI_ROUNDS(11);
+        SHA256_NI_ROUNDS(12);
+        SHA256_NI_ROUNDS(13);
+        SHA256_NI_ROUNDS(14);
+        SHA256_NI_ROUNDS(15);
+        abef = _mm_add_epi32(abef, abef_saved);
+        cdgh = _mm_add_epi32(cdgh, cdgh_saved);
+        data += 64;
+    }
+
+    __m128i feba = _mm_shuffle_epi32(abef, 0x1b);
+    __m128i dchg = _mm_shuffle_epi32(cdgh, 0xb1);
+    _mm_storeu_si128((__m128i *) state, _mm_blend_epi16(feba, dchg, 0xf0));
+    _mm_storeu_si128((__m128i *) (state + 4), _mm_alignr_epi8(dchg, feba, 8));
+}
+
+// four rounds of SHA-1, f selects their function and constant
+#define SHA1_NI_ROUNDS(i, f) \
+    do { \
+        if ((i) < 4) { \
+            w[(i) & 3] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + (i) * 16)), swap); \
+        } else { \
+            w[(i) & 3] = _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(w[(i) & 3], w[((i) + 1) & 3]), \
+                                                          w[((i) + 2) & 3]), w[((i) + 3) & 3]); \
+        } \
+        __m128i e_next = abcd; \
+        e = (i) == 0 ? _mm_add_epi32(e, w[0]) : _mm_sha1nexte_epu32(e, w[(i) & 3]); \
+        abcd = _mm_sha1rnds4_epu32(abcd, e, f); \
+        e = e_next; \
+    } while (0)
+
+/**
+ * SHA-1 over the given number of 64-byte blocks, four rounds per instruction; e lives in the top word of a register.
+ * The rounds are unrolled like the SHA-256 ones.
+ */
+void hashHelperSha1BlocksShaNi(uint32_t *state, const unsigned char *data, size_t blocks) {
+    const __m128i swap = _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) state), 0x1b);
+    __m128i e0 = _mm_set_epi32((int) state[4], 0, 0, 0);
+
+    while (blocks--) {
+        __m128i abcd_saved = abcd;
+        __m128i e = e0;
+        __m128i w[4];
+        SHA1_NI_ROUNDS(0, 0);
+        SHA1_NI_ROUNDS(1, 0);
+        SHA1_NI_ROUNDS(2, 0);
+        SHA1_NI_ROUNDS(3, 0);
+        SHA1_NI_ROUNDS(4, 0);
+        SHA1_NI_ROUNDS(5, 1);
+        SHA1_NI_ROUNDS(6, 1);
+        SHA1_NI_ROUNDS(7, 1);
+        SHA1_NI_ROUNDS(8, 1);
+        SHA1_NI_ROUNDS(9, 1);
+        SHA1_NI_ROUNDS(10, 2);
+        SHA1_NI_ROUNDS(11, 2);
+        SHA1_NI_ROUNDS(12, 2);
+        SHA1_NI_ROUNDS(13, 2);
+        SHA1_NI_ROUNDS(14, 2);
+        SHA1_NI_ROUNDS(15, 3);
+        SHA1_NI_ROUNDS(16, 3);
+        SHA1_NI_ROUNDS(17, 3);
+        SHA1_NI_ROUNDS(18, 3);
+        SHA1_NI_ROUNDS(19, 3);
+        // e now holds a before the last four rounds, e of the next block is derived from it
+        e0 = _mm_sha1nexte_epu32(e, e0);
+        abcd = _mm_add_epi32(abcd, abcd_saved);
+        data += 64;
+    }
+
+    _mm_storeu_si128((__m128i *) state, _mm_shuffle_epi32(abcd, 0x1b));
+    state[4] = (uint32_t) _mm_extract_epi32(e0, 3);
+}
+
+#endif
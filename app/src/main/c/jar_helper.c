@@ -0,0 +1,758 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include "jar_helper.h"
+
+/*v1 (JAR) signature
+*META-INF/MANIFEST.MF : a main section, then a section per entry
+*	Name: res/layout/main.xml
+*	SHA-256-Digest: <base64 of the digest of the inflated entry>
+*META-INF/CERT.SF : a main section with the digest of the whole manifest, then a section per manifest section
+*	SHA-256-Digest-Manifest: <base64>
+*	Name: res/layout/main.xml
+*	SHA-256-Digest: <base64 of the digest of the bytes of that section of MANIFEST.MF>
+*META-INF/CERT.RSA : PKCS#7 signature of CERT.SF
+*An APK signed by several keys has a .SF and a .RSA, .DSA or .EC per signer, every one is checked.
+*
+*Lines end with CRLF, LF or CR, a line starting with a space continues the previous one,
+*sections end with a blank line.
+*/
+
+#define JAR_HELPER_MAX_KEY      72
+
+/**
+ * One entry of the central directory: its name in the names buffer and where mz_zip_goto_entry() finds it.
+ */
+typedef struct jarHelperZipEntry {
+    const char *name;
+    uint64_t cd_pos;
+} jarHelperZipEntry;
+
+/**
+ * One section of MANIFEST.MF: the entry it names, the strongest digest it has and where its bytes are.
+ */
+typedef struct jarHelperSection {
+    const char *name;
+    size_t start;
+    size_t end;
+    hashHelperAlgorithm algorithm;
+    unsigned char digest[HASH_HELPER_MAX_SIZE];
+    size_t digest_len;
+    bool signed_section;
+    const jarHelperZipEntry *entry;
+} jarHelperSection;
+
+typedef struct jarHelperList {
+    void *items;
+    size_t count;
+    size_t capacity;
+    char *names;
+    size_t names_len;
+} jarHelperList;
+
+/**
+ * The entries hashed concurrently. Worker 0 reads through the caller's archive, the others through clones of it.
+ */
+typedef struct jarHelperJob {
+    unzipHelperArchive *archive;
+    unzipHelperArchive archives[THREAD_HELPER_MAX_WORKERS];
+    unsigned char *buffers[THREAD_HELPER_MAX_WORKERS];
+    jarHelperSection **sections;
+    size_t mismatches;
+    size_t first_mismatch;
+    uint64_t bytes;
+    int32_t err;
+} jarHelperJob;
+
+/**
+ * Digests we know, the strongest first. The attribute is the prefix followed by -Digest or -Digest-Manifest.
+ */
+static const struct {
+    const char *prefix;
+    hashHelperAlgorithm algorithm;
+} DIGESTS[] = {
+        {"SHA-512", HASH_HELPER_SHA512},
+        {"SHA-256", HASH_HELPER_SHA256},
+        {"SHA1",    HASH_HELPER_SHA1},
+        {"SHA-1",   HASH_HELPER_SHA1}
+};
+
+
+static uint64_t jarHelperNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static bool jarHelperGrow(jarHelperList *list, size_t item_size) {
+    if (list->count < list->capacity) {
+        return true;
+    }
+    size_t capacity = list->capacity ? list->capacity * 2 : 256;
+    void *items = statsHelperRealloc(list->items, capacity * item_size);
+    if (NULL == items) {
+        return false;
+    }
+    list->items = items;
+    list->capacity = capacity;
+    return true;
+}
+
+static void jarHelperFreeList(jarHelperList *list) {
+    free(list->items);
+    free(list->names);
+    memset(list, 0, sizeof(jarHelperList));
+}
+
+static int jarHelperCompareEntries(const void *a, const void *b) {
+    return strcmp(((const jarHelperZipEntry *) a)->name, ((const jarHelperZipEntry *) b)->name);
+}
+
+static int jarHelperCompareSections(const void *a, const void *b) {
+    return strcmp(((const jarHelperSection *) a)->name, ((const jarHelperSection *) b)->name);
+}
+
+/**
+ * Sorts a list and returns the name of its first duplicate, NULL when every name is unique. Names of a
+ * signed APK must be unique, otherwise a lookup could find a copy other than the one that was verified.
+ */
+static const char *jarHelperSort(jarHelperList *list, size_t item_size, int (*compare)(const void *, const void *)) {
+    qsort(list->items, list->count, item_size, compare);
+    for (size_t i = 1; i < list->count; i++) {
+        const char *item = (const char *) list->items + i * item_size;
+        if (compare(item - item_size, item) == 0) {
+            return *(const char *const *) item;
+        }
+    }
+    return NULL;
+}
+
+static const jarHelperZipEntry *jarHelperFindEntry(const jarHelperList *entries, const char *name) {
+    jarHelperZipEntry key = {name, 0};
+    return bsearch(&key, entries->items, entries->count, sizeof(jarHelperZipEntry), jarHelperCompareEntries);
+}
+
+static jarHelperSection *jarHelperFindSection(const jarHelperList *sections, const char *name) {
+    jarHelperSection key;
+    key.name = name;
+    return bsearch(&key, sections->items, sections->count, sizeof(jarHelperSection), jarHelperCompareSections);
+}
+
+/**
+ * Whether name is one of the files of the v1 signature itself, the only entries MANIFEST.MF does not list.
+ */
+static bool jarHelperIsSignatureFile(const char *name) {
+    size_t prefix = strlen(JAR_HELPER_META_INF);
+    if (strncasecmp(name, JAR_HELPER_META_INF, prefix) != 0 || NULL != strchr(name + prefix, '/')) {
+        return false;
+    }
+    const char *dot = strrchr(name + prefix, '.');
+    return strncasecmp(name + prefix, "SIG-", 4) == 0
+           || (NULL != dot && (strcasecmp(dot, ".MF") == 0 || strcasecmp(dot, ".SF") == 0
+                               || strcasecmp(dot, ".RSA") == 0 || strcasecmp(dot, ".DSA") == 0
+                               || strcasecmp(dot, ".EC") == 0));
+}
+
+/**
+ * Whether name is a signature block, e.g. META-INF/CERT.RSA, the PKCS#7 signature of the .SF file of the same name.
+ */
+static bool jarHelperIsSignatureBlock(const char *name) {
+    const char *ext = strrchr(name, '.');
+    return jarHelperIsSignatureFile(name) && NULL != ext
+           && (strcasecmp(ext, ".RSA") == 0 || strcasecmp(ext, ".DSA") == 0 || strcasecmp(ext, ".EC") == 0);
+}
+
+/**
+ * Lists the central directory sorted by name, directories left out.
+ */
+static int32_t jarHelperListEntries(void *handle, jarHelperList *entries) {
+    mz_zip_file *file_info = NULL;
+    uint64_t cd_size = 0;
+    int64_t number_entry = 0;
+
+    if (mz_zip_get_cd_size(handle, &cd_size) != MZ_OK || mz_zip_get_number_entry(handle, &number_entry) != MZ_OK) {
+        return MZ_FORMAT_ERROR;
+    }
+    // the names take less than the central directory they are stored in, their terminators included
+    entries->names = statsHelperMalloc((size_t) cd_size + 1);
+    if (NULL == entries->names) {
+        return MZ_MEM_ERROR;
+    }
+    int32_t err = mz_zip_goto_first_entry(handle);
+    while (err == MZ_OK) {
+        err = mz_zip_entry_get_info(handle, &file_info);
+        if (err != MZ_OK) {
+            break;
+        }
+        size_t len = strlen(file_info->filename);
+        if (entries->names_len + len + 1 > cd_size + 1) {
+            return MZ_FORMAT_ERROR;
+        }
+        if (len > 0 && file_info->filename[len - 1] != '/') {
+            if (!jarHelperGrow(entries, sizeof(jarHelperZipEntry))) {
+                return MZ_MEM_ERROR;
+            }
+            jarHelperZipEntry *entry = (jarHelperZipEntry *) entries->items + entries->count++;
+            entry->name = entries->names + entries->names_len;
+            entry->cd_pos = (uint64_t) mz_zip_get_entry(handle);
+            memcpy(entries->names + entries->names_len, file_info->filename, len + 1);
+            entries->names_len += len + 1;
+        }
+        err = mz_zip_goto_next_entry(handle);
+    }
+    if (err != MZ_END_OF_LIST) {
+        return err;
+    }
+    const char *duplicate = jarHelperSort(entries, sizeof(jarHelperZipEntry), jarHelperCompareEntries);
+    if (NULL != duplicate) {
+        NSV_LOGW("duplicate entry %s\n", duplicate);
+        return MZ_FORMAT_ERROR;
+    }
+    return MZ_OK;
+}
+
+/**
+ * Inflates a whole entry of at most JAR_HELPER_MAX_FILE_SIZE bytes, the result is NUL-terminated.
+ */
+static char *jarHelperReadEntry(void *handle, const jarHelperZipEntry *entry, size_t *len) {
+    mz_zip_file *file_info = NULL;
+    char *result = NULL;
+    statsHelperTimer timer;
+
+    statsHelperStart(&timer, STATS_HELPER_INFLATE);
+    if (NULL == entry || mz_zip_goto_entry(handle, entry->cd_pos) != MZ_OK
+        || mz_zip_entry_get_info(handle, &file_info) != MZ_OK
+        || file_info->uncompressed_size > JAR_HELPER_MAX_FILE_SIZE
+        || mz_zip_entry_read_open(handle, 0, NULL) != MZ_OK) {
+        statsHelperStop(&timer, 0);
+        return NULL;
+    }
+    result = statsHelperMalloc((size_t) file_info->uncompressed_size + 1);
+    if (NULL != result) {
+        size_t total = 0;
+        int32_t read = 0;
+        while (total < file_info->uncompressed_size
+               && (read = mz_zip_entry_read(handle, result + total,
+                                            (uint32_t) (file_info->uncompressed_size - total))) > 0) {
+            total += (size_t) read;
+        }
+        if (read < 0 || total != file_info->uncompressed_size) {
+            free(result);
+            result = NULL;
+        } else {
+            result[total] = '\0';
+            *len = total;
+        }
+    }
+    mz_zip_entry_close(handle);
+    statsHelperStop(&timer, NULL != result ? *len : 0);
+    return result;
+}
+
+static int jarHelperBase64Value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+/**
+ * Decodes padded base64 into at most size bytes, returns the decoded length or 0 if it is malformed.
+ */
+static size_t jarHelperBase64Decode(const char *in, unsigned char *out, size_t size) {
+    size_t len = strlen(in);
+    size_t n = 0;
+
+    if (len == 0 || len % 4 != 0) {
+        return 0;
+    }
+    for (size_t i = 0; i < len; i += 4) {
+        int v[4];
+        int pad = 0;
+        for (int k = 0; k < 4; k++) {
+            if (in[i + k] == '=' && i + 4 == len && k >= 2) {
+                v[k] = 0;
+                pad++;
+            } else if (pad > 0 || (v[k] = jarHelperBase64Value(in[i + k])) < 0) {
+                return 0;
+            }
+        }
+        uint32_t triple = ((uint32_t) v[0] << 18) | ((uint32_t) v[1] << 12) | ((uint32_t) v[2] << 6) | (uint32_t) v[3];
+        if (n + 3 - pad > size) {
+            return 0;
+        }
+        out[n++] = (unsigned char) (triple >> 16);
+        if (pad < 2) out[n++] = (unsigned char) (triple >> 8);
+        if (pad < 1) out[n++] = (unsigned char) triple;
+    }
+    return n;
+}
+
+/**
+ * Finds the end of the line starting at pos, next receives the start of the following line.
+ */
+static size_t jarHelperLineEnd(const char *data, size_t len, size_t pos, size_t *next) {
+    while (pos < len && data[pos] != '\r' && data[pos] != '\n') {
+        pos++;
+    }
+    *next = pos;
+    if (*next < len && data[*next] == '\r') {
+        (*next)++;
+    }
+    if (*next < len && data[*next] == '\n' && (*next == pos || data[pos] == '\r')) {
+        (*next)++;
+    }
+    return pos;
+}
+
+/**
+ * Reads the attribute at *pos, its continuation lines joined, and moves *pos past it.
+ * Returns 1 for an attribute, 0 for the blank line ending a section or the end of data, -1 if it is malformed.
+ */
+static int jarHelperNextAttribute(const char *data, size_t len, size_t *pos, char *key, char *value) {
+    size_t next;
+    size_t end = jarHelperLineEnd(data, len, *pos, &next);
+
+    if (end == *pos) {
+        *pos = next;
+        return 0;
+    }
+    const char *colon = memchr(data + *pos, ':', end - *pos);
+    if (NULL == colon || (size_t) (colon - (data + *pos)) >= JAR_HELPER_MAX_KEY
+        || colon + 1 >= data + end || colon[1] != ' ') {
+        return -1;
+    }
+    size_t key_len = (size_t) (colon - (data + *pos));
+    memcpy(key, data + *pos, key_len);
+    key[key_len] = '\0';
+
+    size_t value_len = 0;
+    size_t start = (size_t) (colon - data) + 2;
+    for (;;) {
+        if (end - start >= JAR_HELPER_MAX_VALUE - value_len) {
+            return -1;
+        }
+        memcpy(value + value_len, data + start, end - start);
+        value_len += end - start;
+        if (next >= len || data[next] != ' ') {
+            break;
+        }
+        start = next + 1;
+        end = jarHelperLineEnd(data, len, start, &next);
+    }
+    value[value_len] = '\0';
+    *pos = next;
+    return 1;
+}
+
+/**
+ * Whether key is <digest>suffix for a digest we know; rank is its place in DIGESTS, the strongest is 0.
+ */
+static bool jarHelperDigestAttribute(const char *key, const char *suffix, size_t *rank) {
+    for (size_t i = 0; i < sizeof(DIGESTS) / sizeof(DIGESTS[0]); i++) {
+        size_t prefix = strlen(DIGESTS[i].prefix);
+        if (strncasecmp(key, DIGESTS[i].prefix, prefix) == 0 && strcasecmp(key + prefix, suffix) == 0) {
+            *rank = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Reads the attributes of the section at *pos. name receives the Name attribute, empty if there is none,
+ * and the strongest digest attribute ending with suffix is decoded into section.
+ * Returns 1 for a section, 0 at the end of data and -1 if the section is malformed.
+ */
+static int jarHelperReadSection(const char *data, size_t len, size_t *pos, const char *suffix, char *name,
+                                jarHelperSection *section) {
+    char key[JAR_HELPER_MAX_KEY];
+    char value[JAR_HELPER_MAX_VALUE];
+    size_t best = SIZE_MAX;
+    size_t rank;
+    int attributes = 0;
+    int r;
+
+    name[0] = '\0';
+    section->digest_len = 0;
+    section->start = *pos;
+    while ((r = jarHelperNextAttribute(data, len, pos, key, value)) > 0) {
+        attributes++;
+        if (strcasecmp(key, "Name") == 0) {
+            memcpy(name, value, strlen(value) + 1);
+        } else if (jarHelperDigestAttribute(key, suffix, &rank) && rank < best) {
+            section->digest_len = jarHelperBase64Decode(value, section->digest, sizeof(section->digest));
+            section->algorithm = DIGESTS[rank].algorithm;
+            if (section->digest_len != hashHelperGetSize(section->algorithm)) {
+                return -1;
+            }
+            best = rank;
+        }
+    }
+    section->end = *pos;
+    if (r < 0) {
+        NSV_LOGW("malformed manifest at %zu\n", *pos);
+        return -1;
+    }
+    // blank lines between sections are tolerated
+    return attributes > 0 || *pos < len ? 1 : 0;
+}
+
+static void jarHelperDigest(hashHelperAlgorithm algorithm, const void *data, size_t len, unsigned char *digest) {
+    hashHelperContext ctx;
+    hashHelperInit(&ctx, algorithm);
+    hashHelperUpdate(&ctx, data, len);
+    hashHelperFinal(&ctx, digest);
+}
+
+/**
+ * Splits MANIFEST.MF into its entry sections, sorted by name. The main section is skipped.
+ */
+static int32_t jarHelperParseManifest(const char *mf, size_t len, jarHelperList *sections) {
+    char name[JAR_HELPER_MAX_VALUE];
+    jarHelperSection section;
+    size_t pos = 0;
+    int r;
+
+    memset(&section, 0, sizeof(section));
+    sections->names = statsHelperMalloc(len + 1);
+    if (NULL == sections->names || jarHelperReadSection(mf, len, &pos, "-Digest", name, &section) < 0) {
+        return NULL == sections->names ? MZ_MEM_ERROR : MZ_FORMAT_ERROR;
+    }
+    while ((r = jarHelperReadSection(mf, len, &pos, "-Digest", name, &section)) > 0) {
+        if (name[0] == '\0') {
+            continue;
+        }
+        if (section.digest_len == 0) {
+            NSV_LOGW("no known digest for %s\n", name);
+            return MZ_FORMAT_ERROR;
+        }
+        size_t name_len = strlen(name);
+        if (!jarHelperGrow(sections, sizeof(jarHelperSection)) || sections->names_len + name_len + 1 > len + 1) {
+            return MZ_MEM_ERROR;
+        }
+        section.name = sections->names + sections->names_len;
+        memcpy(sections->names + sections->names_len, name, name_len + 1);
+        sections->names_len += name_len + 1;
+        ((jarHelperSection *) sections->items)[sections->count++] = section;
+    }
+    if (r < 0) {
+        return MZ_FORMAT_ERROR;
+    }
+    const char *duplicate = jarHelperSort(sections, sizeof(jarHelperSection), jarHelperCompareSections);
+    if (NULL != duplicate) {
+        NSV_LOGW("duplicate manifest section %s\n", duplicate);
+        return MZ_FORMAT_ERROR;
+    }
+    return MZ_OK;
+}
+
+/**
+ * Checks the .SF file against MANIFEST.MF: the digest of the whole manifest when it matches,
+ * the digest of every manifest section otherwise.
+ */
+static int32_t jarHelperVerifySignatureFile(const char *sf, size_t sf_len, const char *mf, size_t mf_len,
+                                            jarHelperList *sections) {
+    unsigned char digest[HASH_HELPER_MAX_SIZE];
+    char name[JAR_HELPER_MAX_VALUE];
+    jarHelperSection sf_section;
+    size_t pos = 0;
+    int r;
+
+    memset(&sf_section, 0, sizeof(sf_section));
+    // the sections a previous signer's .SF covered don't count for this one
+    for (size_t i = 0; i < sections->count; i++) {
+        ((jarHelperSection *) sections->items)[i].signed_section = false;
+    }
+    if (jarHelperReadSection(sf, sf_len, &pos, "-Digest-Manifest", name, &sf_section) < 0) {
+        return MZ_FORMAT_ERROR;
+    }
+    if (sf_section.digest_len > 0) {
+        jarHelperDigest(sf_section.algorithm, mf, mf_len, digest);
+        if (memcmp(digest, sf_section.digest, sf_section.digest_len) == 0) {
+            return MZ_OK;
+        }
+        NSV_LOGW("the manifest digest does not match, checking its sections\n");
+    }
+    while ((r = jarHelperReadSection(sf, sf_len, &pos, "-Digest", name, &sf_section)) > 0) {
+        if (name[0] == '\0') {
+            continue;
+        }
+        jarHelperSection *section = jarHelperFindSection(sections, name);
+        if (NULL == section || sf_section.digest_len == 0) {
+            NSV_LOGW("%s is not in the manifest\n", name);
+            return MZ_CRC_ERROR;
+        }
+        jarHelperDigest(sf_section.algorithm, mf + section->start, section->end - section->start, digest);
+        if (memcmp(digest, sf_section.digest, sf_section.digest_len) != 0) {
+            NSV_LOGW("the manifest section of %s does not match\n", name);
+            return MZ_CRC_ERROR;
+        }
+        section->signed_section = true;
+    }
+    if (r < 0) {
+        return MZ_FORMAT_ERROR;
+    }
+    for (size_t i = 0; i < sections->count; i++) {
+        if (!((jarHelperSection *) sections->items)[i].signed_section) {
+            NSV_LOGW("%s is not signed\n", ((jarHelperSection *) sections->items)[i].name);
+            return MZ_CRC_ERROR;
+        }
+    }
+    return MZ_OK;
+}
+
+/**
+ * Checks one signer: its signature block over its .SF file, then the .SF file against MANIFEST.MF.
+ * signer receives the SHA-256 of the certificate the block was checked with.
+ */
+static int32_t jarHelperVerifySigner(void *handle, const jarHelperList *entries, const char *signature_block,
+                                     const char *mf, size_t mf_len, jarHelperList *sections, unsigned char *signer) {
+    char signature_file[JAR_HELPER_NAME_SIZE];
+    const char *ext = strrchr(signature_block, '.');
+    size_t base_len = (size_t) (ext - signature_block);
+    size_t sf_len = 0;
+    size_t block_len = 0;
+    int32_t err;
+
+    if (base_len + sizeof(".SF") > sizeof(signature_file)) {
+        return MZ_FORMAT_ERROR;
+    }
+    // CERT.RSA signs CERT.SF
+    memcpy(signature_file, signature_block, base_len);
+    memcpy(signature_file + base_len, ".SF", sizeof(".SF"));
+    char *sf = jarHelperReadEntry(handle, jarHelperFindEntry(entries, signature_file), &sf_len);
+    char *block = jarHelperReadEntry(handle, jarHelperFindEntry(entries, signature_block), &block_len);
+    if (NULL == sf || NULL == block) {
+        NSV_LOGW("%s has no %s\n", signature_block, signature_file);
+        err = MZ_CRYPT_ERROR;
+    } else {
+        pkcs7HelperSpan span;
+        err = signatureHelperVerifySignedData((unsigned char *) block, block_len, (unsigned char *) sf, sf_len,
+                                              &span);
+        NSV_LOGI("signatureHelperVerifySignedData %s: %d\n", signature_block, err);
+        if (err != MZ_OK) {
+            err = MZ_CRYPT_ERROR;
+        } else {
+            hashHelperSha256 sha256;
+            hashHelperSha256Init(&sha256);
+            hashHelperSha256Update(&sha256, block + span.offset, span.len);
+            hashHelperSha256Final(&sha256, signer);
+            err = jarHelperVerifySignatureFile(sf, sf_len, mf, mf_len, sections);
+        }
+    }
+    free(sf);
+    free(block);
+    return err;
+}
+
+/**
+ * Counts a mismatch, the one of the lowest index is reported.
+ */
+static void jarHelperMismatch(jarHelperJob *job, size_t index) {
+    size_t first = __atomic_load_n(&job->first_mismatch, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&job->mismatches, 1, __ATOMIC_RELAXED);
+    while (index < first && !__atomic_compare_exchange_n(&job->first_mismatch, &first, index, false,
+                                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/**
+ * Inflates and hashes one entry listed in MANIFEST.MF, the task of worker on the job.
+ */
+static void jarHelperDigestEntry(void *ctx, size_t index, size_t worker) {
+    jarHelperJob *job = ctx;
+    jarHelperSection *section = job->sections[index];
+    unzipHelperArchive *archive = worker == 0 ? job->archive : &job->archives[worker];
+    unsigned char digest[HASH_HELPER_MAX_SIZE];
+    hashHelperContext hash;
+    statsHelperTimer timer;
+    uint64_t total = 0;
+    int32_t read = 0;
+
+    if (NULL == archive->handle) {
+        int32_t err = unzipHelperClone(job->archive, archive);
+        if (err != MZ_OK) {
+            __atomic_store_n(&job->err, err, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+    if (NULL == job->buffers[worker]) {
+        job->buffers[worker] = statsHelperMalloc(JAR_HELPER_CHUNK_SIZE);
+        if (NULL == job->buffers[worker]) {
+            __atomic_store_n(&job->err, MZ_MEM_ERROR, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+    // the entry is hashed while it is inflated, the time of both goes to the inflate stage
+    statsHelperStart(&timer, STATS_HELPER_INFLATE);
+    hashHelperInit(&hash, section->algorithm);
+    if (mz_zip_goto_entry(archive->handle, section->entry->cd_pos) != MZ_OK
+        || mz_zip_entry_read_open(archive->handle, 0, NULL) != MZ_OK) {
+        statsHelperStop(&timer, 0);
+        jarHelperMismatch(job, index);
+        return;
+    }
+    while ((read = mz_zip_entry_read(archive->handle, job->buffers[worker], JAR_HELPER_CHUNK_SIZE)) > 0) {
+        hashHelperUpdate(&hash, job->buffers[worker], (size_t) read);
+        total += (uint64_t) read;
+    }
+    mz_zip_entry_close(archive->handle);
+    hashHelperFinal(&hash, digest);
+    statsHelperStop(&timer, total);
+    __atomic_fetch_add(&job->bytes, total, __ATOMIC_RELAXED);
+    if (read < 0 || memcmp(digest, section->digest, section->digest_len) != 0) {
+        NSV_LOGW("digest mismatch: %s\n", section->name);
+        jarHelperMismatch(job, index);
+    }
+}
+
+static void jarHelperSetFirstMismatch(jarHelperReport *report, const char *name) {
+    if (report->first_mismatch[0] == '\0') {
+        snprintf(report->first_mismatch, sizeof(report->first_mismatch), "%s", name);
+    }
+}
+
+/**
+ * Verifies the v1 signature files of an opened APK: the .SF file of every signer against MANIFEST.MF and every
+ * entry against its digest in MANIFEST.MF, the entries inflated and hashed concurrently, each worker through
+ * a clone of the zip handle sharing its central directory. Each signature block, e.g. CERT.RSA, is checked
+ * over its .SF file first. Returns MZ_OK if everything matches, MZ_CRYPT_ERROR if a signature does not or a block
+ * has no .SF file, MZ_CRC_ERROR on a digest mismatch (see report), MZ_FORMAT_ERROR for more than
+ * JAR_HELPER_MAX_SIGNERS blocks and MZ_EXIST_ERROR if the APK has no v1 signature.
+ */
+int32_t jarHelperVerify(unzipHelperArchive *archive, jarHelperReport *report) {
+    const char *signature_blocks[JAR_HELPER_MAX_SIGNERS];
+    size_t signers = 0;
+    jarHelperList entries;
+    jarHelperList sections;
+    jarHelperJob *job = NULL;
+    char *mf = NULL;
+    size_t mf_len = 0;
+    uint64_t cd_size = 0;
+    statsHelperTimer timer;
+    uint64_t start = jarHelperNow();
+
+    memset(report, 0, sizeof(jarHelperReport));
+    memset(&entries, 0, sizeof(entries));
+    memset(&sections, 0, sizeof(sections));
+
+    statsHelperStart(&timer, STATS_HELPER_CD_SCAN);
+    int32_t err = jarHelperListEntries(archive->handle, &entries);
+    mz_zip_get_cd_size(archive->handle, &cd_size);
+    statsHelperStop(&timer, cd_size);
+    // the entries are sorted, so are the signers
+    for (size_t i = 0; err == MZ_OK && i < entries.count; i++) {
+        const char *name = ((jarHelperZipEntry *) entries.items)[i].name;
+        if (!jarHelperIsSignatureBlock(name)) {
+            continue;
+        }
+        if (signers == JAR_HELPER_MAX_SIGNERS) {
+            NSV_LOGW("more than %d signature blocks\n", JAR_HELPER_MAX_SIGNERS);
+            err = MZ_FORMAT_ERROR;
+        } else {
+            signature_blocks[signers++] = name;
+        }
+    }
+    if (err == MZ_OK && signers > 0) {
+        mf = jarHelperReadEntry(archive->handle, jarHelperFindEntry(&entries, JAR_HELPER_MANIFEST), &mf_len);
+    }
+    if (err == MZ_OK) {
+        err = NULL == mf ? MZ_EXIST_ERROR : jarHelperParseManifest(mf, mf_len, &sections);
+    }
+    for (size_t i = 0; err == MZ_OK && i < signers; i++) {
+        unsigned char signer[HASH_HELPER_SHA256_SIZE];
+        err = jarHelperVerifySigner(archive->handle, &entries, signature_blocks[i], mf, mf_len, &sections, signer);
+        if (err == MZ_OK && i == 0) {
+            memcpy(report->signer, signer, sizeof(signer));
+        }
+    }
+    if (err == MZ_OK) {
+        report->signers = signers;
+    } else {
+        memset(report->signer, 0, sizeof(report->signer));
+    }
+    if (err == MZ_OK) {
+        job = statsHelperCalloc(1, sizeof(jarHelperJob));
+        if (NULL != job) {
+            job->sections = statsHelperMalloc((sections.count + 1) * sizeof(jarHelperSection *));
+        }
+        err = NULL == job || NULL == job->sections ? MZ_MEM_ERROR : MZ_OK;
+    }
+    if (err == MZ_OK) {
+        size_t count = 0;
+        jarHelperSection *items = sections.items;
+        for (size_t i = 0; i < sections.count; i++) {
+            items[i].entry = jarHelperFindEntry(&entries, items[i].name);
+            if (NULL == items[i].entry) {
+                NSV_LOGW("%s is listed but missing\n", items[i].name);
+                report->mismatches++;
+                jarHelperSetFirstMismatch(report, items[i].name);
+            } else {
+                job->sections[count++] = &items[i];
+            }
+        }
+        for (size_t i = 0; i < entries.count; i++) {
+            const char *name = ((jarHelperZipEntry *) entries.items)[i].name;
+            if (!jarHelperIsSignatureFile(name) && NULL == jarHelperFindSection(&sections, name)) {
+                NSV_LOGW("%s is not in the manifest\n", name);
+                report->mismatches++;
+                jarHelperSetFirstMismatch(report, name);
+            }
+        }
+
+        job->archive = archive;
+        job->first_mismatch = SIZE_MAX;
+        report->entries = count;
+        report->workers = threadHelperGetWorkerCount(count);
+        threadHelperRun(jarHelperDigestEntry, job, count, report->workers);
+
+        report->mismatches += job->mismatches;
+        report->bytes = job->bytes;
+        if (job->first_mismatch != SIZE_MAX) {
+            jarHelperSetFirstMismatch(report, job->sections[job->first_mismatch]->name);
+        }
+        for (size_t i = 1; i < THREAD_HELPER_MAX_WORKERS; i++) {
+            if (NULL != job->archives[i].handle) {
+                unzipHelperClose(&job->archives[i]);
+            }
+        }
+        for (size_t i = 0; i < THREAD_HELPER_MAX_WORKERS; i++) {
+            free(job->buffers[i]);
+        }
+        err = job->err != MZ_OK ? job->err : report->mismatches > 0 ? MZ_CRC_ERROR : MZ_OK;
+    }
+    if (NULL != job) {
+        free(job->sections);
+        free(job);
+    }
+    free(mf);
+    jarHelperFreeList(&entries);
+    jarHelperFreeList(&sections);
+    report->nanos = jarHelperNow() - start;
+    NSV_LOGI("v1: %zu entries, %zu mismatches, %" PRIu64 " bytes in %" PRIu64 " ns on %zu workers\n",
+             report->entries, report->mismatches, report->bytes, report->nanos, report->workers);
+    return err;
+}
@@ -0,0 +1,74 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef NATIVESIGNATUREVERIFICATION_JAR_HELPER_H
+#define NATIVESIGNATUREVERIFICATION_JAR_HELPER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include "unzip_helper.h"
+#include "hash_helper.h"
+#include "thread_helper.h"
+#include "signature_helper.h"
+#include "stats_helper.h"
+#include "def.h"
+
+// https://docs.oracle.com/javase/8/docs/technotes/guides/jar/jar.html#Signed_JAR_File
+#define JAR_HELPER_MANIFEST         "META-INF/MANIFEST.MF"
+#define JAR_HELPER_META_INF         "META-INF/"
+// MANIFEST.MF and the .SF file are read whole, bigger ones are refused
+#define JAR_HELPER_MAX_FILE_SIZE    (64 * 1024 * 1024)
+// entries are inflated and hashed in pieces of this size
+#define JAR_HELPER_CHUNK_SIZE       (64 * 1024)
+// the longest attribute value (e.g. a Name: joined from its continuation lines) accepted
+#define JAR_HELPER_MAX_VALUE        4096
+#define JAR_HELPER_NAME_SIZE        256
+// signature blocks accepted in META-INF, the limit of Android's v1 verifier
+#define JAR_HELPER_MAX_SIGNERS      10
+
+/**
+ * What jarHelperVerify() has checked. mismatches counts entries whose digest does not match,
+ * entries missing from MANIFEST.MF and entries MANIFEST.MF lists that are not in the APK.
+ * signers counts the signature blocks checked, signer is the SHA-256 of the certificate the first of them
+ * in name order was checked with, all zero unless every signature matched.
+ */
+typedef struct jarHelperReport {
+    size_t entries;
+    size_t mismatches;
+    size_t workers;
+    size_t signers;
+    uint64_t bytes;
+    uint64_t nanos;
+    char first_mismatch[JAR_HELPER_NAME_SIZE];
+    unsigned char signer[HASH_HELPER_SHA256_SIZE];
+} jarHelperReport;
+
+
+int32_t jarHelperVerify(unzipHelperArchive *archive, jarHelperReport *report);
+
+#endif //NATIVESIGNATUREVERIFICATION_JAR_HELPER_H
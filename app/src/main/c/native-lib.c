@@ -23,44 +23,629 @@ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 
 #include <jni.h>
 #include <malloc.h>
+#include <pthread.h>
+#include <time.h>
 
 #include "path_helper.h"
 #include "unzip_helper.h"
 #include "pkcs7_helper.h"
+#include "sign_block_helper.h"
+#include "x509_helper.h"
+#include "jar_helper.h"
+#include "split_helper.h"
+#include "hash_helper.h"
+#include "trust_helper.h"
+#include "cache_helper.h"
+#include "stats_helper.h"
 
 
-JNIEXPORT jbyteArray JNICALL
-Java_com_kozhevin_signverification_MainActivity_bytesFromJNI(JNIEnv *env, jobject this) {
+static pthread_once_t trustedSignerOnce = PTHREAD_ONCE_INIT;
+static bool trustedSigner = false;
+
+/**
+ * A VerificationCallback waiting for the background verification.
+ */
+typedef struct pendingCallback {
+    jobject callback;
+    jmethodID method;
+    struct pendingCallback *next;
+} pendingCallback;
+
+static JavaVM *javaVm = NULL;
+static pthread_mutex_t backgroundLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t backgroundDone = PTHREAD_COND_INITIALIZER;
+static bool backgroundFinished = false;
+static pendingCallback *pendingCallbacks = NULL;
+
+
+/**
+ * The APK being read. The archive reads the file open at fd, through /proc/self/fd, and key is the identity
+ * of that file taken before anything is parsed: the results are cached under the file they come from even if
+ * the path gets another file meanwhile.
+ */
+typedef struct openedApk {
+    pathHelperMapping mapping;
+    unzipHelperArchive archive;
+    int fd;
+    cacheHelperKey key;
+    char fd_path[32];
+} openedApk;
+
+static void closeApk(openedApk *apk) {
+    unzipHelperClose(&apk->archive);
+    pathHelperFreeMapping(&apk->mapping);
+    if (apk->fd >= 0) {
+        close(apk->fd);
+    }
+    apk->fd = -1;
+}
+
+/**
+ * Opens the APK through the mapping the runtime has made if it covers the whole file open at fd,
+ * through that file otherwise.
+ */
+static bool openApk(openedApk *apk) {
+    NSV_LOGI("pathHelperGetMapping starts\n");
+    bool found = pathHelperGetMapping(&apk->mapping);
+    NSV_LOGI("pathHelperGetMapping finishes\n");
+
+    memset(&apk->archive, 0, sizeof(unzipHelperArchive));
+    apk->fd = -1;
+    if (!found) {
+        return false;
+    }
+    NSV_LOGI("pathHelperGetMapping result[%s]\n", apk->mapping.path);
+    apk->fd = open(apk->mapping.path, O_RDONLY | O_CLOEXEC);
+    if (apk->fd >= 0 && cacheHelperGetKey(apk->fd, &apk->key)) {
+        if (NULL != apk->mapping.base && apk->mapping.inode == (uint64_t) apk->key.ino
+            && apk->mapping.size == (size_t) apk->key.size
+            && unzipHelperOpenMemory(&apk->archive, apk->mapping.base, apk->mapping.size) == MZ_OK) {
+            return true;
+        }
+        snprintf(apk->fd_path, sizeof(apk->fd_path), "/proc/self/fd/%d", apk->fd);
+        if (unzipHelperOpen(&apk->archive, apk->fd_path) == MZ_OK) {
+            return true;
+        }
+    }
+    closeApk(apk);
+    return false;
+}
 
-    NSV_LOGI("pathHelperGetPath starts\n");
-    char *path = pathHelperGetPath();
-    NSV_LOGI("pathHelperGetPath finishes\n");
+/**
+ * Finds the certificate of the signer: in the APK Signing Block, in the v1 signature otherwise.
+ * The result points into *content, which the caller frees.
+ * While the APK stays the same file the certificate found first is reused.
+ */
+static unsigned char *getCertificate(unsigned char **content, size_t *len_out) {
 
-    if (!path) {
+    openedApk apk;
+    *content = NULL;
+    if (cacheHelperGetCertificate(content, len_out)) {
+        NSV_LOGI("certificate is cached\n");
+        return *content;
+    }
+    if (!openApk(&apk)) {
         return NULL;
     }
-    NSV_LOGI("pathHelperGetPath result[%s]\n", path);
-    NSV_LOGI("unzipHelperGetCertificateDetails starts\n");
     size_t len_in = 0;
-    size_t len_out = 0;
-    unsigned char *content = unzipHelperGetCertificateDetails(path, &len_in);
-    NSV_LOGI("unzipHelperGetCertificateDetails finishes\n");
-    if (!content) {
-        free(path);
-        return NULL;
+    unsigned char *res = NULL;
+
+    NSV_LOGI("signBlockHelperGetCertificate starts\n");
+    *content = signBlockHelperGetCertificate(&apk.archive, len_out, NULL);
+    NSV_LOGI("signBlockHelperGetCertificate finishes\n");
+    if (*content) {
+        res = *content;
+    } else {
+        NSV_LOGI("unzipHelperReadCertificates starts\n");
+        *content = unzipHelperReadCertificates(&apk.archive, &len_in);
+        NSV_LOGI("unzipHelperReadCertificates finishes\n");
+        if (*content) {
+            res = pkcs7HelperGetSignerCertificate(*content, len_in, len_out);
+        }
+    }
+    if (NULL != res) {
+        cacheHelperPutCertificate(apk.fd, &apk.key, res, *len_out);
     }
-    NSV_LOGI("pkcs7HelperGetSignature starts\n");
+    closeApk(&apk);
+    return res;
+}
+
+JNIEXPORT jbyteArray JNICALL
+Java_com_kozhevin_signverification_MainActivity_bytesFromJNI(JNIEnv *env, jobject this) {
+
+    size_t len_out = 0;
+    unsigned char *content = NULL;
+    unsigned char *res = getCertificate(&content, &len_out);
 
-    unsigned char *res = pkcs7HelperGetSignature(content, len_in, &len_out);
-    NSV_LOGI("pkcs7HelperGetSignature finishes\n");
     jbyteArray jbArray = NULL;
     if (NULL != res || len_out != 0) {
         jbArray = (*env)->NewByteArray(env, len_out);
         (*env)->SetByteArrayRegion(env, jbArray, 0, len_out, (jbyte *) res);
     }
     free(content);
-    free(path);
-    pkcs7HelperFree();
     return jbArray;
 }
 
+/**
+ * Returns SHA-256, SHA-1 and MD5 of the certificate of the signer, HASH_HELPER_FINGERPRINTS_SIZE bytes
+ * in this order. Only the fingerprints selected by mask are computed, the others are zeroed.
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_com_kozhevin_signverification_MainActivity_fingerprintsFromJNI(JNIEnv *env, jobject this, jint mask) {
+
+    size_t len_out = 0;
+    unsigned char *content = NULL;
+    unsigned char fingerprints[HASH_HELPER_FINGERPRINTS_SIZE];
+    unsigned char *res = getCertificate(&content, &len_out);
+
+    if (NULL == res) {
+        free(content);
+        return NULL;
+    }
+    hashHelperFingerprints(res, len_out, (unsigned int) mask, fingerprints);
+    free(content);
+
+    jbyteArray jbArray = (*env)->NewByteArray(env, HASH_HELPER_FINGERPRINTS_SIZE);
+    (*env)->SetByteArrayRegion(env, jbArray, 0, HASH_HELPER_FINGERPRINTS_SIZE, (jbyte *) fingerprints);
+    return jbArray;
+}
+
+/**
+ * Copies the certificates into a byte[][], spans are offsets into data.
+ */
+static jobjectArray newCertificateArray(JNIEnv *env, const unsigned char *data, const size_t *offsets,
+                                        const size_t *lens, size_t count) {
+    jclass byteArrayClass = (*env)->FindClass(env, "[B");
+    if (NULL == byteArrayClass) {
+        return NULL;
+    }
+    jobjectArray result = (*env)->NewObjectArray(env, (jsize) count, byteArrayClass, NULL);
+    (*env)->DeleteLocalRef(env, byteArrayClass);
+    for (size_t i = 0; NULL != result && i < count; i++) {
+        jbyteArray jbArray = (*env)->NewByteArray(env, (jsize) lens[i]);
+        if (NULL == jbArray) {
+            return NULL;
+        }
+        (*env)->SetByteArrayRegion(env, jbArray, 0, (jsize) lens[i], (jbyte *) (data + offsets[i]));
+        (*env)->SetObjectArrayElement(env, result, (jsize) i, jbArray);
+        (*env)->DeleteLocalRef(env, jbArray);
+    }
+    return result;
+}
+
+/**
+ * Returns every certificate of every signer, the rotated and the chain certificates included:
+ * from the v3/v2 scheme block, from the v1 signature file otherwise. Both are parsed only once.
+ */
+JNIEXPORT jobjectArray JNICALL
+Java_com_kozhevin_signverification_MainActivity_certificatesFromJNI(JNIEnv *env, jobject this) {
+
+    const uint32_t ids[] = {SIGN_BLOCK_ID_V3, SIGN_BLOCK_ID_V2};
+    openedApk apk;
+    signBlock block;
+    signBlockSpan spans[PKCS7_HELPER_MAX_SPANS];
+    size_t offsets[PKCS7_HELPER_MAX_SPANS];
+    size_t lens[PKCS7_HELPER_MAX_SPANS];
+    size_t count = 0;
+    jobjectArray result = NULL;
+
+    if (!openApk(&apk)) {
+        return NULL;
+    }
+    if (signBlockHelperRead(&apk.archive, &block) == MZ_OK) {
+        for (size_t i = 0; i < sizeof(ids) / sizeof(ids[0]) && count == 0; i++) {
+            signBlockHelperGetCertificates(&block, ids[i], spans, PKCS7_HELPER_MAX_SPANS, &count);
+        }
+        for (size_t i = 0; i < count; i++) {
+            offsets[i] = spans[i].offset;
+            lens[i] = spans[i].len;
+        }
+        if (count > 0) {
+            result = newCertificateArray(env, block.data, offsets, lens, count);
+        }
+        signBlockHelperFree(&block);
+    }
+    if (count == 0) {
+        derHelperToken tokens[PKCS7_HELPER_MAX_TOKENS];
+        pkcs7HelperContext pkcs7;
+        pkcs7HelperContents contents;
+        size_t len_in = 0;
+        unsigned char *content = unzipHelperReadCertificate(&apk.archive, &len_in);
+        pkcs7HelperInit(&pkcs7, tokens, PKCS7_HELPER_MAX_TOKENS);
+        if (NULL != content && pkcs7HelperGetContents(&pkcs7, content, len_in, &contents)) {
+            for (size_t i = 0; i < contents.certificate_count; i++) {
+                offsets[i] = contents.certificates[i].offset;
+                lens[i] = contents.certificates[i].len;
+            }
+            result = newCertificateArray(env, content, offsets, lens, contents.certificate_count);
+        }
+        free(content);
+    }
+    closeApk(&apk);
+    return result;
+}
+
+static jbyteArray newUtf8Array(JNIEnv *env, const char *s) {
+    jsize len = (jsize) strlen(s);
+    jbyteArray jbArray = (*env)->NewByteArray(env, len);
+    if (NULL != jbArray) {
+        (*env)->SetByteArrayRegion(env, jbArray, 0, len, (const jbyte *) s);
+    }
+    return jbArray;
+}
+
+/**
+ * Decodes subject, issuer, serial number and validity of a DER certificate into a CertificateInfo,
+ * null if it can't be parsed.
+ */
+JNIEXPORT jobject JNICALL
+Java_com_kozhevin_signverification_MainActivity_certificateInfoFromJNI(JNIEnv *env, jclass clazz,
+                                                                       jbyteArray certificate) {
+    x509HelperCertificate cert;
+    char subject[X509_HELPER_NAME_SIZE];
+    char issuer[X509_HELPER_NAME_SIZE];
+    char serial[X509_HELPER_SERIAL_SIZE];
+    int64_t not_before = 0;
+    int64_t not_after = 0;
+    jobject result = NULL;
+
+    if (NULL == certificate) {
+        return NULL;
+    }
+    jsize len = (*env)->GetArrayLength(env, certificate);
+    jbyte *der = (*env)->GetByteArrayElements(env, certificate, NULL);
+    if (NULL == der) {
+        return NULL;
+    }
+    bool parsed = x509HelperParse((const unsigned char *) der, (size_t) len, &cert)
+                  && x509HelperGetName((const unsigned char *) der, &cert.subject, subject, sizeof(subject))
+                  && x509HelperGetName((const unsigned char *) der, &cert.issuer, issuer, sizeof(issuer))
+                  && x509HelperGetSerial((const unsigned char *) der, &cert.serial, serial, sizeof(serial))
+                  && x509HelperGetTime((const unsigned char *) der, &cert.not_before, &not_before)
+                  && x509HelperGetTime((const unsigned char *) der, &cert.not_after, &not_after);
+    (*env)->ReleaseByteArrayElements(env, certificate, der, JNI_ABORT);
+    if (!parsed) {
+        return NULL;
+    }
+
+    jclass infoClass = (*env)->FindClass(env, "com/kozhevin/signverification/CertificateInfo");
+    if (NULL == infoClass) {
+        return NULL;
+    }
+    jmethodID constructor = (*env)->GetMethodID(env, infoClass, "<init>", "([B[BLjava/lang/String;JJ)V");
+    jbyteArray jSubject = newUtf8Array(env, subject);
+    jbyteArray jIssuer = newUtf8Array(env, issuer);
+    jstring jSerial = (*env)->NewStringUTF(env, serial);
+    if (NULL != constructor && NULL != jSubject && NULL != jIssuer && NULL != jSerial) {
+        result = (*env)->NewObject(env, infoClass, constructor, jSubject, jIssuer, jSerial,
+                                   (jlong) not_before, (jlong) not_after);
+    }
+    (*env)->DeleteLocalRef(env, infoClass);
+    return result;
+}
+
+/**
+ * Checks the v3/v2 signers and the APK contents against their content digest.
+ * False when they do not match or the APK has no APK Signing Block.
+ */
+static bool verifyContent() {
+
+    openedApk apk;
+    int32_t err = MZ_OK;
+    if (cacheHelperGetContentResult(&err)) {
+        NSV_LOGI("signBlockHelperVerify result is cached %d\n", err);
+        return err == MZ_OK;
+    }
+    if (!openApk(&apk)) {
+        return false;
+    }
+    NSV_LOGI("signBlockHelperVerify starts\n");
+    err = signBlockHelperVerify(&apk.archive, NULL);
+    NSV_LOGI("signBlockHelperVerify finishes %d\n", err);
+    cacheHelperPutContentResult(apk.fd, &apk.key, err);
+    closeApk(&apk);
+    return err == MZ_OK;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_kozhevin_signverification_MainActivity_verifyContentFromJNI(JNIEnv *env, jobject this) {
+    return verifyContent() ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Verifies the v1 signature, CERT.RSA over CERT.SF, then every entry against it, entries digested on all cores.
+ * Returns {result, entries, mismatches, bytes, nanos}, result being MZ_OK when everything matches.
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_kozhevin_signverification_MainActivity_verifyJarFromJNI(JNIEnv *env, jobject this) {
+
+    openedApk apk;
+    jarHelperReport report;
+    memset(&report, 0, sizeof(report));
+    int32_t err = MZ_STREAM_ERROR;
+    if (openApk(&apk)) {
+        NSV_LOGI("jarHelperVerify starts\n");
+        err = jarHelperVerify(&apk.archive, &report);
+        NSV_LOGI("jarHelperVerify finishes %d %s\n", err, report.first_mismatch);
+        closeApk(&apk);
+    }
+    jlong values[] = {err, (jlong) report.entries, (jlong) report.mismatches, (jlong) report.bytes,
+                      (jlong) report.nanos};
+    jlongArray result = (*env)->NewLongArray(env, sizeof(values) / sizeof(values[0]));
+    if (NULL != result) {
+        (*env)->SetLongArrayRegion(env, result, 0, sizeof(values) / sizeof(values[0]), values);
+    }
+    return result;
+}
+
+// verifySplitsFromJNI: result, APKs, nanos, then result, scheme, bytes, nanos of every APK
+#define SPLITS_HEADER_FIELDS    3
+#define SPLITS_APK_FIELDS       4
+
+/**
+ * Verifies base.apk and every split APK of the package at once, one thread each, see splitHelperVerify().
+ * Returns {result, apks, nanos, then result, scheme, bytes, nanos of every APK}, base.apk first,
+ * result being MZ_OK when every APK matches its signature and is signed by the signer of base.apk.
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_kozhevin_signverification_MainActivity_verifySplitsFromJNI(JNIEnv *env, jobject this) {
+
+    pathHelperMapping *mappings = NULL;
+    splitHelperReport report;
+    size_t count = pathHelperGetMappings(&mappings);
+    NSV_LOGI("splitHelperVerify starts, %zu apks\n", count);
+    int32_t err = splitHelperVerify(mappings, count, &report);
+    NSV_LOGI("splitHelperVerify finishes %d\n", err);
+
+    jsize len = (jsize) (SPLITS_HEADER_FIELDS + report.count * SPLITS_APK_FIELDS);
+    jlongArray result = NULL;
+    jlong *values = statsHelperCalloc((size_t) len, sizeof(jlong));
+    if (NULL != values) {
+        values[0] = err;
+        values[1] = (jlong) report.count;
+        values[2] = (jlong) report.nanos;
+        for (size_t i = 0; i < report.count; i++) {
+            jlong *apk = values + SPLITS_HEADER_FIELDS + i * SPLITS_APK_FIELDS;
+            apk[0] = report.results[i].err;
+            apk[1] = report.results[i].scheme;
+            apk[2] = (jlong) report.results[i].bytes;
+            apk[3] = (jlong) report.results[i].nanos;
+        }
+        result = (*env)->NewLongArray(env, len);
+        if (NULL != result) {
+            (*env)->SetLongArrayRegion(env, result, 0, len, values);
+        }
+        free(values);
+    }
+    splitHelperFreeReport(&report);
+    pathHelperFreeMappings(mappings, count);
+    return result;
+}
+
+/**
+ * Snapshot of the always-on stage metrics, see statsHelperSnapshot() for the layout: per stage the count,
+ * the total and the longest nanoseconds, bytes, allocations, bytes allocated and a log2 latency histogram.
+ * With reset the counters start over, so that every snapshot covers what happened since the previous one.
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_kozhevin_signverification_MainActivity_statsFromJNI(JNIEnv *env, jclass clazz, jboolean reset) {
+
+    int64_t values[STATS_HELPER_SNAPSHOT_SIZE];
+    jsize len = (jsize) statsHelperSnapshot(values, STATS_HELPER_SNAPSHOT_SIZE, reset == JNI_TRUE);
+    jlongArray result = (*env)->NewLongArray(env, len);
+    if (NULL != result) {
+        (*env)->SetLongArrayRegion(env, result, 0, len, (const jlong *) values);
+    }
+    return result;
+}
+
+/**
+ * Verifies the APK, through the APK Signing Block or the v1 signature if it has none, and compares the
+ * certificate the signature was checked with. Hashing the certificate alone would trust any APK carrying
+ * a copy of it. The v2/v3 result is cached for verifyContent().
+ */
+static void checkTrustedSigner() {
+    openedApk apk;
+    jarHelperReport report;
+    unsigned char signer[HASH_HELPER_SHA256_SIZE];
+
+    if (!openApk(&apk)) {
+        return;
+    }
+    int32_t err = signBlockHelperVerify(&apk.archive, signer);
+    cacheHelperPutContentResult(apk.fd, &apk.key, err);
+    if (err == MZ_EXIST_ERROR) {
+        err = jarHelperVerify(&apk.archive, &report);
+        memcpy(signer, report.signer, sizeof(signer));
+    }
+    trustedSigner = err == MZ_OK && trustHelperIsTrustedDigest(signer);
+    NSV_LOGI("trusted signer: %d of %zu (%d)\n", trustedSigner, trustHelperGetCount(), err);
+    closeApk(&apk);
+}
+
+/**
+ * Whether the APK is signed with one of the certificates built in with NSV_TRUSTED_SIGNERS and its
+ * signature and contents verify with that certificate, see checkTrustedSigner().
+ * The APK is read on the first call only, the answer is kept for the life of the process.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_kozhevin_signverification_MainActivity_isTrustedSigner(JNIEnv *env, jobject this) {
+    pthread_once(&trustedSignerOnce, checkTrustedSigner);
+    return trustedSigner ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Calls VerificationCallback.onVerified(byte[] certificate, boolean contentVerified).
+ * The results come from the cache the background verification has filled.
+ */
+static void notifyCallback(JNIEnv *env, jobject callback, jmethodID method) {
+    size_t len_out = 0;
+    unsigned char *content = NULL;
+    unsigned char *res = getCertificate(&content, &len_out);
+    jboolean verified = verifyContent() ? JNI_TRUE : JNI_FALSE;
+
+    jbyteArray jbArray = NULL;
+    if (NULL != res) {
+        jbArray = (*env)->NewByteArray(env, len_out);
+        (*env)->SetByteArrayRegion(env, jbArray, 0, len_out, (jbyte *) res);
+    }
+    free(content);
+    (*env)->CallVoidMethod(env, callback, method, jbArray, verified);
+    if ((*env)->ExceptionCheck(env)) {
+        NSV_LOGE("VerificationCallback has thrown\n");
+        (*env)->ExceptionClear(env);
+    }
+    if (NULL != jbArray) {
+        (*env)->DeleteLocalRef(env, jbArray);
+    }
+}
+
+/**
+ * Calls the callbacks of the list arg, then frees it, on the current thread, which it attaches to the VM
+ * for the time being.
+ */
+static void *deliverCallbacks(void *arg) {
+    pendingCallback *callbacks = arg;
+    JNIEnv *env = NULL;
+
+    if ((*javaVm)->AttachCurrentThread(javaVm, &env, NULL) != JNI_OK) {
+        NSV_LOGE("can't attach the callback thread\n");
+        return NULL;
+    }
+    while (NULL != callbacks) {
+        pendingCallback *p = callbacks;
+        callbacks = p->next;
+        notifyCallback(env, p->callback, p->method);
+        (*env)->DeleteGlobalRef(env, p->callback);
+        free(p);
+    }
+    (*javaVm)->DetachCurrentThread(javaVm);
+    return NULL;
+}
+
+/**
+ * Runs the whole verification once so that later calls are answered from the cache,
+ * then wakes up the waiting threads and calls the registered callbacks.
+ */
+static void *backgroundVerification(void *arg) {
+    size_t len_out = 0;
+    unsigned char *content = NULL;
+
+    NSV_LOGI("background verification starts\n");
+    getCertificate(&content, &len_out);
+    free(content);
+    pthread_once(&trustedSignerOnce, checkTrustedSigner);
+    verifyContent();
+    NSV_LOGI("background verification finishes\n");
+
+    pthread_mutex_lock(&backgroundLock);
+    backgroundFinished = true;
+    pendingCallback *callbacks = pendingCallbacks;
+    pendingCallbacks = NULL;
+    pthread_cond_broadcast(&backgroundDone);
+    pthread_mutex_unlock(&backgroundLock);
+
+    if (NULL != callbacks) {
+        deliverCallbacks(callbacks);
+    }
+    return NULL;
+}
+
+/**
+ * Starts the verification as soon as the library is loaded, on a thread of its own.
+ */
+JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved) {
+    pthread_t thread;
+    pthread_attr_t attr;
+
+    javaVm = vm;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, backgroundVerification, NULL) != 0) {
+        // every call verifies on its own thread then
+        NSV_LOGE("can't start the background verification\n");
+        backgroundFinished = true;
+    }
+    pthread_attr_destroy(&attr);
+    return JNI_VERSION_1_6;
+}
+
+/**
+ * Waits for the background verification for at most timeoutMillis, forever if it is negative.
+ * Returns whether it has finished, the other calls are answered from the cache from then on.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_kozhevin_signverification_MainActivity_awaitVerificationFromJNI(JNIEnv *env, jclass clazz,
+                                                                         jlong timeoutMillis) {
+    struct timespec deadline;
+    int err = 0;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeoutMillis / 1000;
+    deadline.tv_nsec += (timeoutMillis % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    pthread_mutex_lock(&backgroundLock);
+    while (!backgroundFinished && err == 0) {
+        if (timeoutMillis < 0) {
+            err = pthread_cond_wait(&backgroundDone, &backgroundLock);
+        } else {
+            err = pthread_cond_timedwait(&backgroundDone, &backgroundLock, &deadline);
+        }
+    }
+    bool finished = backgroundFinished;
+    pthread_mutex_unlock(&backgroundLock);
+    return finished ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Calls callback.onVerified once the background verification has finished, never on the calling thread,
+ * which is often the UI thread while onVerified may call into the slower checks: on the background thread,
+ * or on a thread of its own if the verification has already finished. Only if that thread can't be started
+ * the callback is called right away.
+ */
+JNIEXPORT void JNICALL
+Java_com_kozhevin_signverification_MainActivity_registerVerificationCallback(JNIEnv *env, jclass clazz,
+                                                                             jobject callback) {
+    pthread_t thread;
+    pthread_attr_t attr;
+
+    jclass callbackClass = (*env)->GetObjectClass(env, callback);
+    jmethodID method = (*env)->GetMethodID(env, callbackClass, "onVerified", "([BZ)V");
+    (*env)->DeleteLocalRef(env, callbackClass);
+    if (NULL == method) {
+        return;
+    }
+    pendingCallback *p = statsHelperMalloc(sizeof(pendingCallback));
+    if (NULL == p) {
+        return;
+    }
+    p->callback = (*env)->NewGlobalRef(env, callback);
+    p->method = method;
+    p->next = NULL;
+
+    pthread_mutex_lock(&backgroundLock);
+    if (!backgroundFinished) {
+        pendingCallback **tail = &pendingCallbacks;
+        while (NULL != *tail) {
+            tail = &(*tail)->next;
+        }
+        *tail = p;
+        pthread_mutex_unlock(&backgroundLock);
+        return;
+    }
+    pthread_mutex_unlock(&backgroundLock);
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, deliverCallbacks, p) != 0) {
+        // late rather than never
+        NSV_LOGE("can't start the callback thread\n");
+        notifyCallback(env, p->callback, p->method);
+        (*env)->DeleteGlobalRef(env, p->callback);
+        free(p);
+    }
+    pthread_attr_destroy(&attr);
+}
@@ -24,60 +24,402 @@ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 #include "path_helper.h"
 
 
+/**
+ * One line of /proc/self/maps, path is NUL-terminated in the buffer of the scan.
+ */
+typedef struct pathHelperMapsLine {
+    uintptr_t start;
+    uintptr_t end;
+    uint64_t offset;
+    uint64_t inode;
+    bool readable;
+    const char *path;
+} pathHelperMapsLine;
+
+/**
+ * Called for every line of an APK of the package, returns false to stop the scan.
+ */
+typedef bool (*pathHelperLineCallback)(void *ctx, const pathHelperMapsLine *line);
+
+/**
+ * The run of contiguous readable mappings of one APK being merged, see pathHelperGetMappings().
+ */
+typedef struct pathHelperRun {
+    uintptr_t start;
+    uintptr_t end;
+    uint64_t offset;
+    bool valid;
+} pathHelperRun;
+
+typedef struct pathHelperMappingsScan {
+    pathHelperMapping *found;
+    pathHelperRun *runs;
+    size_t count;
+    size_t capacity;
+    // the lines of one file follow each other, the APK of the previous line is checked first
+    size_t last;
+    bool failed;
+} pathHelperMappingsScan;
+
+static pthread_mutex_t cachedMappingsLock = PTHREAD_MUTEX_INITIALIZER;
+static pathHelperMapping *cachedMappings = NULL;
+static size_t cachedCount = 0;
+
+
+/**
+ * The package name is the process name, without the ":name" of a component running in a process of its own.
+ */
 static char *getPackageName() {
-    const size_t BUFFER_SIZE = 256;
-    char buffer[BUFFER_SIZE] = "";
-    int fd = open("/proc/self/cmdline", O_RDONLY);
-    if (fd > 0) {
-        ssize_t r = read(fd, buffer, BUFFER_SIZE - 1);
+    char buffer[PATH_HELPER_BUFFER_SIZE] = "";
+    int fd = open("/proc/self/cmdline", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ssize_t r = read(fd, buffer, PATH_HELPER_BUFFER_SIZE - 1);
         close(fd);
         if (r > 0) {
-            return strdup(buffer);
+            buffer[strcspn(buffer, ":")] = '\0';
+            return buffer[0] != '\0' ? strdup(buffer) : NULL;
         }
     }
     return NULL;
 }
 
-static const char *getFilenameExt(const char *filename) {
-    const char *dot = strrchr(filename, '.');
-    if (!dot || dot == filename) return "";
-    return dot + 1;
+/**
+ * Whether path names an .apk file, without splitting it up: its name has to be more than the extension.
+ */
+static bool isApkPath(const char *path, size_t len) {
+    return len > 5 && path[len - 5] != '/' && strcasecmp(path + len - 4, ".apk") == 0;
+}
+
+static const char *parseHex(const char *p, const char *end, uint64_t *value) {
+    uint64_t v = 0;
+    const char *digits = p;
+    for (; p < end; p++) {
+        unsigned c = (unsigned char) *p;
+        if (c - '0' < 10) {
+            v = (v << 4) | (c - '0');
+        } else if ((c | 0x20) - 'a' < 6) {
+            v = (v << 4) | ((c | 0x20) - 'a' + 10);
+        } else {
+            break;
+        }
+    }
+    *value = v;
+    return p > digits ? p : NULL;
 }
 
-char *pathHelperGetPath() {
+static const char *skipField(const char *p, const char *end) {
+    while (p < end && *p == ' ') {
+        p++;
+    }
+    while (p < end && *p != ' ') {
+        p++;
+    }
+    return p;
+}
 
-    char *package = getPackageName();
-    if (NULL == package) {
-        return NULL;
-    }
-
-    FILE *fp = fopen("/proc/self/maps", "r");
-    if (NULL == fp) {
-        free(package);
-        return NULL;
-    }
-    const size_t BUFFER_SIZE = 256;
-    char buffer[BUFFER_SIZE] = "";
-    char path[BUFFER_SIZE] = "";
-
-    bool find = false;
-    while (fgets(buffer, BUFFER_SIZE, fp)) {
-        if (sscanf(buffer, "%*llx-%*llx %*s %*s %*s %*s %s", path) == 1) {
-            if (strstr(path, package)) {
-                char *bname = basename(path);
-                NSV_LOGI("check basename[%s]", bname);
-                if (strcasecmp(getFilenameExt(bname), "apk") == 0) {
-                    find = true;
-                    break;
+/**
+ * Parses "start-end perms offset dev inode path" in [p, end), the path may hold spaces.
+ * The newline at end is replaced by the NUL terminating the path.
+ */
+static bool parseMapsLine(char *p, char *end, pathHelperMapsLine *line) {
+    uint64_t start, stop, offset;
+    const char *q = parseHex(p, end, &start);
+    if (NULL == q || q == end || *q != '-' || NULL == (q = parseHex(q + 1, end, &stop)) || q == end || *q != ' ') {
+        return false;
+    }
+    line->readable = q + 1 < end && q[1] == 'r';
+    q = skipField(q, end);
+    while (q < end && *q == ' ') {
+        q++;
+    }
+    if (NULL == (q = parseHex(q, end, &offset))) {
+        return false;
+    }
+    q = skipField(q, end);
+    while (q < end && *q == ' ') {
+        q++;
+    }
+    uint64_t inode = 0;
+    for (; q < end && *q >= '0' && *q <= '9'; q++) {
+        inode = inode * 10 + (uint64_t) (*q - '0');
+    }
+    while (q < end && *q == ' ') {
+        q++;
+    }
+    if (q == end) {
+        return false;
+    }
+    *end = '\0';
+    line->start = (uintptr_t) start;
+    line->end = (uintptr_t) stop;
+    line->offset = offset;
+    line->inode = inode;
+    line->path = q;
+    return true;
+}
+
+/**
+ * Reads the maps at fd in blocks of PATH_HELPER_READ_SIZE and looks for package with memmem() over
+ * the whole block, only the lines it is found in are parsed. Lines of APKs are passed to callback.
+ * Lines longer than PATH_HELPER_MAX_LINE are skipped.
+ */
+static bool scanMaps(int fd, const char *package, pathHelperLineCallback callback, void *ctx) {
+    char *buffer = statsHelperMalloc(PATH_HELPER_READ_SIZE + PATH_HELPER_MAX_LINE);
+    if (NULL == buffer) {
+        return false;
+    }
+    size_t package_len = strlen(package);
+    size_t kept = 0;
+    bool skipping = false;
+    bool more = true;
+
+    while (more) {
+        ssize_t r = read(fd, buffer + kept, PATH_HELPER_READ_SIZE + PATH_HELPER_MAX_LINE - kept);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r <= 0) {
+            break;
+        }
+        char *p = buffer;
+        char *filled = buffer + kept + r;
+        char *last_newline = memrchr(buffer + kept, '\n', (size_t) r);
+        if (NULL == last_newline) {
+            // no complete line yet: keep reading, unless this line can't fit anymore
+            kept += (size_t) r;
+            if (kept == PATH_HELPER_READ_SIZE + PATH_HELPER_MAX_LINE) {
+                skipping = true;
+                kept = 0;
+            }
+            continue;
+        }
+        char *end = last_newline + 1;
+        if (skipping) {
+            // the rest of a line that was too long
+            p = (char *) memchr(p, '\n', (size_t) (end - p)) + 1;
+            skipping = false;
+        }
+        while (more && p < end) {
+            char *hit = memmem(p, (size_t) (end - p), package, package_len);
+            if (NULL == hit) {
+                break;
+            }
+            char *line_start = memrchr(p, '\n', (size_t) (hit - p));
+            line_start = NULL != line_start ? line_start + 1 : p;
+            char *line_end = memchr(hit, '\n', (size_t) (end - hit));
+            pathHelperMapsLine line;
+            if (parseMapsLine(line_start, line_end, &line) && line.path <= hit
+                && isApkPath(line.path, (size_t) (line_end - line.path))) {
+                more = callback(ctx, &line);
+            }
+            p = line_end + 1;
+        }
+        kept = (size_t) (filled - end);
+        memmove(buffer, end, kept);
+    }
+    free(buffer);
+    return true;
+}
+
+/**
+ * Sets base/size if the longest run of the APK covers the whole file.
+ */
+static void setBase(pathHelperMapping *mapping) {
+    struct stat st;
+    if (mapping->end > mapping->start && stat(mapping->path, &st) == 0 && st.st_size > 0
+        && (uint64_t) st.st_size <= mapping->end - mapping->start) {
+        // Clamp to the file size: pages of the mapping past EOF fault with SIGBUS
+        mapping->base = (const unsigned char *) mapping->start;
+        mapping->size = (size_t) st.st_size;
+        NSV_LOGI("%s is mapped at %p, %zu bytes\n", mapping->path, mapping->base, mapping->size);
+    } else {
+        NSV_LOGI("%s is not mapped entirely\n", mapping->path);
+    }
+}
+
+/**
+ * Merges one line into the run of its APK, adding the APK when it is new.
+ */
+static bool addMappingLine(void *ctx, const pathHelperMapsLine *line) {
+    pathHelperMappingsScan *scan = ctx;
+    size_t i = scan->last;
+    if (i == SIZE_MAX || strcmp(scan->found[i].path, line->path) != 0) {
+        for (i = 0; i < scan->count && strcmp(scan->found[i].path, line->path) != 0; i++);
+        if (i == scan->count) {
+            if (scan->count == scan->capacity) {
+                size_t grown = scan->capacity ? scan->capacity * 2 : 4;
+                pathHelperMapping *more_found = statsHelperRealloc(scan->found, grown * sizeof(pathHelperMapping));
+                if (NULL != more_found) {
+                    scan->found = more_found;
+                }
+                pathHelperRun *more_runs = statsHelperRealloc(scan->runs, grown * sizeof(pathHelperRun));
+                if (NULL != more_runs) {
+                    scan->runs = more_runs;
                 }
+                if (NULL == more_found || NULL == more_runs) {
+                    scan->failed = true;
+                    return false;
+                }
+                scan->capacity = grown;
+            }
+            memset(&scan->found[i], 0, sizeof(pathHelperMapping));
+            memset(&scan->runs[i], 0, sizeof(pathHelperRun));
+            scan->found[i].path = strdup(line->path);
+            if (NULL == scan->found[i].path) {
+                scan->failed = true;
+                return false;
             }
+            scan->count++;
         }
     }
-    fclose(fp);
+    scan->last = i;
+
+    pathHelperMapping *mapping = &scan->found[i];
+    pathHelperRun *run = &scan->runs[i];
+    if (!line->readable) {
+        run->valid = false;
+        return true;
+    }
+    if (run->valid && line->start == run->end && line->offset == run->offset + (run->end - run->start)) {
+        run->end = line->end;
+    } else {
+        run->valid = line->offset == 0;
+        run->start = line->start;
+        run->end = line->end;
+        run->offset = line->offset;
+    }
+    if (run->valid && run->end - run->start > mapping->end - mapping->start) {
+        mapping->start = run->start;
+        mapping->end = run->end;
+        mapping->inode = line->inode;
+    }
+    return true;
+}
+
+/**
+ * The scan of pathHelperFindMappings() over the maps at fd, in the format of /proc/self/maps, for the APKs
+ * of package. Returns how many APKs *mappings holds, free them with pathHelperFreeMappings().
+ */
+size_t pathHelperReadMappings(int fd, const char *package, pathHelperMapping **mappings) {
+    *mappings = NULL;
+
+    pathHelperMappingsScan scan;
+    memset(&scan, 0, sizeof(scan));
+    scan.last = SIZE_MAX;
+    bool read = scanMaps(fd, package, addMappingLine, &scan);
+    free(scan.runs);
+
+    if (!read || scan.failed) {
+        pathHelperFreeMappings(scan.found, scan.count);
+        return 0;
+    }
+    for (size_t i = 1; i < scan.count; i++) {
+        char *name = strrchr(scan.found[i].path, '/');
+        if (strcmp(NULL != name ? name + 1 : scan.found[i].path, "base.apk") == 0) {
+            pathHelperMapping base = scan.found[i];
+            memmove(&scan.found[1], &scan.found[0], i * sizeof(pathHelperMapping));
+            scan.found[0] = base;
+            break;
+        }
+    }
+    for (size_t i = 0; i < scan.count; i++) {
+        setBase(&scan.found[i]);
+    }
+    *mappings = scan.found;
+    return scan.count;
+}
+
+static size_t getMappings(pathHelperMapping **mappings) {
+    *mappings = NULL;
+
+    char *package = getPackageName();
+    if (NULL == package) {
+        return 0;
+    }
+    size_t count = 0;
+    int fd = open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        count = pathHelperReadMappings(fd, package, mappings);
+        close(fd);
+    }
     free(package);
-    if (find) {
-        return strdup(path);
+    return count;
+}
+
+/**
+ * Finds every APK of the package in one pass over /proc/self/maps: base.apk and the split APKs
+ * of an App Bundle install. For each of them it keeps the longest readable run of mappings that
+ * starts at file offset 0; adjacent lines are merged when both their addresses and their file
+ * offsets are contiguous. If that run covers the whole file, base/size describe the APK in memory
+ * and no file needs to be opened.
+ * base.apk comes first, the splits follow in the order they are mapped.
+ * Every call scans again, see pathHelperGetMappings().
+ * Returns how many APKs *mappings holds, free them with pathHelperFreeMappings().
+ */
+size_t pathHelperFindMappings(pathHelperMapping **mappings) {
+    statsHelperTimer timer;
+    statsHelperStart(&timer, STATS_HELPER_PATH);
+    size_t count = getMappings(mappings);
+    statsHelperStop(&timer, 0);
+    return count;
+}
+
+static size_t copyMappings(const pathHelperMapping *source, size_t count, pathHelperMapping **mappings) {
+    *mappings = statsHelperMalloc(count * sizeof(pathHelperMapping));
+    if (NULL == *mappings) {
+        return 0;
     }
-    return NULL;
+    for (size_t i = 0; i < count; i++) {
+        (*mappings)[i] = source[i];
+        (*mappings)[i].path = strdup(source[i].path);
+        if (NULL == (*mappings)[i].path) {
+            pathHelperFreeMappings(*mappings, i);
+            *mappings = NULL;
+            return 0;
+        }
+    }
+    return count;
 }
 
+/**
+ * pathHelperFindMappings() scanned once, the runtime keeps the APKs mapped while the process lives.
+ * A scan that finds nothing is not kept. Returns a copy the caller frees with pathHelperFreeMappings().
+ */
+size_t pathHelperGetMappings(pathHelperMapping **mappings) {
+    *mappings = NULL;
+    pthread_mutex_lock(&cachedMappingsLock);
+    if (cachedCount == 0) {
+        cachedCount = pathHelperFindMappings(&cachedMappings);
+    }
+    size_t count = cachedCount > 0 ? copyMappings(cachedMappings, cachedCount, mappings) : 0;
+    pthread_mutex_unlock(&cachedMappingsLock);
+    return count;
+}
+
+void pathHelperFreeMappings(pathHelperMapping *mappings, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        free(mappings[i].path);
+    }
+    free(mappings);
+}
+
+/**
+ * The APK the signer is read from: base.apk if the package is split, see pathHelperGetMappings().
+ */
+bool pathHelperGetMapping(pathHelperMapping *mapping) {
+    memset(mapping, 0, sizeof(pathHelperMapping));
+
+    pathHelperMapping *mappings = NULL;
+    size_t count = pathHelperGetMappings(&mappings);
+    if (count == 0) {
+        return false;
+    }
+    *mapping = mappings[0];
+    mappings[0].path = NULL;
+    pathHelperFreeMappings(mappings, count);
+    return true;
+}
+void pathHelperFreeMapping(pathHelperMapping *mapping) {
+    free(mapping->path);
+    memset(mapping, 0, sizeof(pathHelperMapping));
+}
@@ -29,11 +29,47 @@ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 #include <string.h>
 #include <stdio.h>
 #include <malloc.h>
+#include <stdlib.h>
 #include <libgen.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "stats_helper.h"
 #include "def.h"
 
+#define PATH_HELPER_BUFFER_SIZE 256
+// /proc/self/maps is read in blocks of this size, a line may be up to PATH_HELPER_MAX_LINE long
+#define PATH_HELPER_READ_SIZE   (64 * 1024)
+#define PATH_HELPER_MAX_LINE    (4096 + 128)
 
-char * pathHelperGetPath();
+/**
+ * A region of our address space where the runtime has already mapped the APK.
+ * base is NULL when the APK is not mapped readable from offset 0 to its end,
+ * path is always set when the APK was found, inode is the one of the file mapped at start.
+ */
+typedef struct pathHelperMapping {
+    char *path;
+    uintptr_t start;
+    uintptr_t end;
+    uint64_t inode;
+    const unsigned char *base;
+    size_t size;
+} pathHelperMapping;
+
+
+bool pathHelperGetMapping(pathHelperMapping *mapping);
+
+size_t pathHelperReadMappings(int fd, const char *package, pathHelperMapping **mappings);
+
+size_t pathHelperFindMappings(pathHelperMapping **mappings);
+
+size_t pathHelperGetMappings(pathHelperMapping **mappings);
+
+void pathHelperFreeMappings(pathHelperMapping *mappings, size_t count);
+
+void pathHelperFreeMapping(pathHelperMapping *mapping);
 
 #endif //NATIVESIGNATUREVERIFICATION_PATH_HELPER_H
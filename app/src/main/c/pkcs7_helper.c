@@ -66,439 +66,488 @@ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 *Each item is saved in the form of{tag，length，content}
 */
 
-static uint32_t m_pos = 0;
-static size_t m_length = 0;
-static struct element *head = NULL;
-static struct element *tail = NULL;
+// 1.2.840.113549.1.7.2
+static const unsigned char PKCS7_SIGNED_DATA_OID[] = {0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x07, 0x02};
+
+static const derHelperStep PATH_CONTENT_TYPE[] = {
+        {TAG_SEQUENCE, 0},
+        {TAG_OBJECTID, 0}
+};
+
+static const derHelperStep PATH_CERTIFICATES[] = {
+        {TAG_SEQUENCE, 0},  // contentInfo
+        {TAG_OPTIONAL, 0},  // content-[optional]
+        {TAG_SEQUENCE, 0},  // signedData
+        {TAG_OPTIONAL, 0}   // certificates-[optional]
+};
+
+static const derHelperStep PATH_ISSUER[] = {
+        {TAG_SEQUENCE, 0},  // signerInfo
+        {TAG_SEQUENCE, 0},  // issuerAndSerialNumber
+        {TAG_SEQUENCE, 0}   // issuer
+};
+
+static const derHelperStep PATH_SERIAL[] = {
+        {TAG_SEQUENCE, 0},  // signerInfo
+        {TAG_SEQUENCE, 0},  // issuerAndSerialNumber
+        {TAG_INTEGER,  0}   // serialNumber
+};
+
+static const derHelperStep PATH_DIGEST_ALGORITHM[] = {
+        {TAG_SEQUENCE, 0},  // signerInfo
+        {TAG_SEQUENCE, 1}   // digestAlgorithmId
+};
+
+static const derHelperStep PATH_AUTHENTICATED_ATTRIBUTES[] = {
+        {TAG_SEQUENCE, 0},  // signerInfo
+        {TAG_OPTIONAL, 0}   // authenticatedAttributes-[optional]
+};
+
+static const derHelperStep PATH_DIGEST_ENCRYPTION_ALGORITHM[] = {
+        {TAG_SEQUENCE, 0},  // signerInfo
+        {TAG_SEQUENCE, 2}   // digestEncryptionAlgorithmId, issuerAndSerialNumber and digestAlgorithmId come first
+};
+
+static const derHelperStep PATH_ENCRYPTED_DIGEST[] = {
+        {TAG_SEQUENCE,    0},   // signerInfo
+        {TAG_OCTETSTRING, 0}    // encryptedDigest
+};
+
+static const derHelperStep PATH_SIGNER_INFOS[] = {
+        {TAG_SEQUENCE, 0},  // contentInfo
+        {TAG_OPTIONAL, 0},  // content-[optional]
+        {TAG_SEQUENCE, 0},  // signedData
+        {TAG_SET,      1}   // signerInfos, digestAlgorithms is the first SET
+};
+
+#define PKCS7_HELPER_ENTER      0
+#define PKCS7_HELPER_CHECK      1
+#define PKCS7_HELPER_SKIP       2
+#define PKCS7_HELPER_CAPTURE    3
+#define PKCS7_HELPER_OPTIONAL   4
+
+/**
+ * What the stream does with each element on its way to the certificates and, behind a chain, the signerInfos.
+ * An optional element is skipped if it is there.
+ */
+static const struct {
+    uint8_t tag;
+    uint8_t action;
+} STREAM_STEPS[] = {
+        {TAG_SEQUENCE, PKCS7_HELPER_ENTER},   // contentInfo
+        {TAG_OBJECTID, PKCS7_HELPER_CHECK},   // contentType, signedData
+        {TAG_OPTIONAL, PKCS7_HELPER_ENTER},   // content-[optional]
+        {TAG_SEQUENCE, PKCS7_HELPER_ENTER},   // signedData
+        {TAG_INTEGER,  PKCS7_HELPER_SKIP},    // version
+        {TAG_SET,      PKCS7_HELPER_SKIP},    // digestAlgorithms
+        {TAG_SEQUENCE, PKCS7_HELPER_SKIP},    // contentInfo
+        {TAG_OPTIONAL, PKCS7_HELPER_CAPTURE}, // certificates-[optional]
+        {TAG_CONTEXT(1), PKCS7_HELPER_OPTIONAL}, // crls-[optional]
+        {TAG_SET,      PKCS7_HELPER_CAPTURE}  // signerInfos
+};
 
 
 /**
- * Calculate the number of bytes occupied by length according to lenbyte.
- * 1) The most significant bit of the byte is 1, then the length of the low 7-bit number of bytes;
- * 2) The highest bit is 0, then lenbyte represents the length
+ * Tokenizes the first DER triple of certrsa, trailing bytes are ignored.
+ * Only the levels down to the certificates are entered, certificates themselves stay single tokens.
  */
-static uint32_t pkcs7HelperLenNum(unsigned char lenbyte) {
-    uint32_t num = 1;
-    if (lenbyte & 0x80) {
-        num += lenbyte & 0x7f;
+static bool pkcs7HelperParse(pkcs7HelperContext *ctx, const unsigned char *certrsa, size_t length) {
+    uint8_t tag, header;
+    uint32_t len;
+
+    pkcs7HelperReset(ctx);
+    if (!derHelperReadHeader(certrsa, length, &tag, &header, &len) || tag != TAG_SEQUENCE) {
+        NSV_LOGE("the Tag indicated an ASN.1 not found!\n");
+        return false;
+    }
+    if (!derHelperTokenize(certrsa, (size_t) header + len, PKCS7_HELPER_DEPTH,
+                           ctx->tokens, ctx->capacity, &ctx->count)) {
+        return false;
     }
-    return num;
+    int index = derHelperFind(ctx->tokens, ctx->count, -1, PATH_CONTENT_TYPE,
+                              sizeof(PATH_CONTENT_TYPE) / sizeof(PATH_CONTENT_TYPE[0]));
+    if (index < 0 || ctx->tokens[index].len != sizeof(PKCS7_SIGNED_DATA_OID)
+        || memcmp(certrsa + ctx->tokens[index].offset + ctx->tokens[index].header, PKCS7_SIGNED_DATA_OID,
+                  sizeof(PKCS7_SIGNED_DATA_OID)) != 0) {
+        NSV_LOGE("not found the ContentType!\n");
+        return false;
+    }
+    return true;
 }
 
+#ifndef NDEBUG
 
-/**
- * Calculate length information based on lenbyte，
- * The algorithm is lenbyte the highest bit is 1，
- * Then lenbyte & 0x7F represent the length of the byte length,
- * Subsequent bytes are stored in big-endian mode. The highest bit is 0， Lenbyte directly represents the length
- *
- * 1) If 0x82 0x34 0x45 0x22 .... 0x82 is lenbyte,
- * The high level is 1, 0x82 & 0x7F == 2,
- * Then the following two bytes are the length information stored at the high end. The length information is 0x3445
-   2)If lenbyte == 0x34, the highest bit is 0, then the length information is 0x34
-*/
-static uint32_t pkcs7HelperGetLength(unsigned char *certrsa, unsigned char lenbyte, int offset) {
-    int32_t len = 0, num;
-    unsigned char tmp;
-    if (lenbyte & 0x80) {
-        num = lenbyte & 0x7f;
-        if (num < 0 || num > 4) {
-            NSV_LOGW("its too long !\n");
-            return 0;
-        }
-        while (num) {
-            len <<= 8;
-            tmp = certrsa[offset++];
-            len += (tmp & 0xff);
-            num--;
-        }
-    } else {
-        len = lenbyte & 0xff;
+static void pkcs7HelperPrint(pkcs7HelperContext *ctx) {
+    NSV_LOGI("-----------------------------------------------------------------------\n");
+    NSV_LOGI(" tag                                           offset        length\n");
+    NSV_LOGI(" ======================================== =============== =============\n");
+    for (size_t i = 0; i < ctx->count; i++) {
+        derHelperToken *p = &ctx->tokens[i];
+        int indent = 4 * p->depth;
+        NSV_LOGI("%*s 0x%02x%*s%6u(0x%02x)  %6u(0x%02x)", indent, "", p->tag, indent < 36 ? 36 - indent : 0, "",
+                 p->offset, p->offset, p->len, p->len);
     }
-    assert(len >= 0);
-    return (uint32_t) len;
+    NSV_LOGI("-----------------------------------------------------------------------\n");
 }
 
+
+#endif //NDEBUG
+
 /**
- * Each element has a corresponding element.
+ * Picks the certificate of the first signerInfo of contents out of der. Without signerInfos, as the stream
+ * leaves them out behind a single certificate, that certificate is taken.
  */
-int32_t pkcs7HelperCreateElement(unsigned char *certrsa, unsigned char tag, char *name, int level) {
-    unsigned char get_tag = certrsa[m_pos++];
-    if (get_tag != tag) {
-        m_pos--;
-        return -1;
+static unsigned char *pkcs7HelperPickSigner(unsigned char *der, const pkcs7HelperContents *contents,
+                                            size_t *len_out) {
+    const pkcs7HelperSpan *span = NULL;
+    pkcs7HelperSignerInfo info;
+    x509HelperCertificate cert;
+
+    if (contents->signer_info_count == 0) {
+        span = contents->certificate_count == 1 ? &contents->certificates[0] : NULL;
+    } else if (pkcs7HelperParseSignerInfo(der + contents->signer_infos[0].offset, contents->signer_infos[0].len,
+                                          &info)) {
+        span = pkcs7HelperFindSigner(der, contents, der + contents->signer_infos[0].offset, &info, &cert);
     }
-    unsigned char lenbyte = certrsa[m_pos];
-    int len = pkcs7HelperGetLength(certrsa, lenbyte, m_pos + 1);
-    m_pos += pkcs7HelperLenNum(lenbyte);
-
-    element *node = (element *) calloc(1, sizeof(element));
-    node->tag = get_tag;
-    strcpy(node->name, name);
-    node->begin = m_pos;
-    node->len = len;
-    node->level = level;
-    node->next = NULL;
-
-    if (head == NULL) {
-        head = tail = node;
-    } else {
-        tail->next = node;
-        tail = node;
+    if (NULL == span) {
+        NSV_LOGW("not found the certificate of the signer\n");
+        return NULL;
     }
-    return len;
+    *len_out = span->len;
+    return der + span->offset;
 }
 
 /**
- * Parse certificate information
+ * Finds the certificate of the signer in certrsa, the one the first signerInfo names, which need not be the
+ * first one of a chain. The result points into certrsa.
  */
-bool pkcs7HelperParseCertificate(unsigned char *certrsa, int level) {
-    char *names[] = {
-            "tbsCertificate",
-            "version",
-            "serialNumber",
-            "signature",
-            "issuer",
-            "validity",
-            "subject",
-            "subjectPublicKeyInfo",
-            "issuerUniqueID-[optional]",
-            "subjectUniqueID-[optional]",
-            "extensions-[optional]",
-            "signatureAlgorithm",
-            "signatureValue"};
-    int len = 0;
-    unsigned char tag;
-
-    len = pkcs7HelperCreateElement(certrsa, TAG_SEQUENCE, names[0], level);
-    if (len == -1 || m_pos + len > m_length) {
-        return false;
+unsigned char *pkcs7HelperGetSignature(pkcs7HelperContext *ctx, unsigned char *certrsa, size_t len_in,
+                                       size_t *len_out) {
+    pkcs7HelperContents contents;
+
+    if (!pkcs7HelperGetContents(ctx, certrsa, len_in, &contents)) {
+        return NULL;
     }
-    //version
-    tag = certrsa[m_pos];
-    if (((tag & 0xc0) == 0x80) && ((tag & 0x1f) == 0)) {
-        m_pos += 1;
-        m_pos += pkcs7HelperLenNum(certrsa[m_pos]);
-        len = pkcs7HelperCreateElement(certrsa, TAG_INTEGER, names[1], level + 1);
-        if (len == -1 || m_pos + len > m_length) {
-            return false;
+    return pkcs7HelperPickSigner(certrsa, &contents, len_out);
+}
+
+/**
+ * Appends the spans of the children of the token at index, at most PKCS7_HELPER_MAX_SPANS of them.
+ */
+static void pkcs7HelperCollect(const pkcs7HelperContext *ctx, int index, pkcs7HelperSpan *spans, size_t *count) {
+    *count = 0;
+    for (int i = derHelperFirstChild(ctx->tokens, ctx->count, index); i >= 0;
+         i = ctx->tokens[i].next == DER_HELPER_NONE ? -1 : ctx->tokens[i].next) {
+        if (*count == PKCS7_HELPER_MAX_SPANS) {
+            NSV_LOGW("more than %d elements, the rest is left out\n", PKCS7_HELPER_MAX_SPANS);
+            break;
         }
-        m_pos += len;
+        spans[*count].offset = ctx->tokens[i].offset;
+        spans[*count].len = (size_t) ctx->tokens[i].header + ctx->tokens[i].len;
+        (*count)++;
     }
+}
 
-    for (int i = 2; i < 11; i++) {
-        switch (i) {
-            case 2:
-                tag = TAG_INTEGER;
-                break;
-            case 8:
-                tag = 0xA1;
-                break;
-            case 9:
-                tag = 0xA2;
-                break;
-            case 10:
-                tag = 0xA3;
-                break;
-            default:
-                tag = TAG_SEQUENCE;
-        }
-        len = pkcs7HelperCreateElement(certrsa, tag, names[i], level + 1);
-        if (i < 8 && len == -1) {
-            return false;
-        }
-        if (len != -1)
-            m_pos += len;
+/**
+ * Finds every certificate and every signerInfo of certrsa in one parse.
+ * The spans point into certrsa, nothing is copied. A long chain needs more tokens than PKCS7_HELPER_MAX_TOKENS,
+ * one per certificate and signerInfo.
+ */
+bool pkcs7HelperGetContents(pkcs7HelperContext *ctx, const unsigned char *certrsa, size_t len_in,
+                            pkcs7HelperContents *contents) {
+    contents->certificate_count = 0;
+    contents->signer_info_count = 0;
+    if (!pkcs7HelperParse(ctx, certrsa, len_in)) {
+        NSV_LOGE("Can't parse\n");
+        return false;
     }
-    //signatureAlgorithm
-    len = pkcs7HelperCreateElement(certrsa, TAG_SEQUENCE, names[11], level);
-    if (len == -1 || m_pos + len > m_length) {
+#ifndef NDEBUG
+    pkcs7HelperPrint(ctx);
+#endif //NDEBUG
+    int certificates = derHelperFind(ctx->tokens, ctx->count, -1, PATH_CERTIFICATES,
+                                     sizeof(PATH_CERTIFICATES) / sizeof(PATH_CERTIFICATES[0]));
+    int signer_infos = derHelperFind(ctx->tokens, ctx->count, -1, PATH_SIGNER_INFOS,
+                                     sizeof(PATH_SIGNER_INFOS) / sizeof(PATH_SIGNER_INFOS[0]));
+    pkcs7HelperCollect(ctx, certificates, contents->certificates, &contents->certificate_count);
+    pkcs7HelperCollect(ctx, signer_infos, contents->signer_infos, &contents->signer_info_count);
+    NSV_LOGI("%zu certificate(s), %zu signerInfo(s)\n", contents->certificate_count, contents->signer_info_count);
+    return true;
+}
+
+/**
+ * Picks the fields out of one signerInfo, e.g. a span of pkcs7HelperGetContents(). Nothing is copied,
+ * the tokens point into der.
+ */
+bool pkcs7HelperParseSignerInfo(const unsigned char *der, size_t len, pkcs7HelperSignerInfo *info) {
+    derHelperToken tokens[PKCS7_HELPER_SIGNER_TOKENS];
+    size_t count = 0;
+
+    memset(info, 0, sizeof(pkcs7HelperSignerInfo));
+    if (!derHelperTokenize(der, len, PKCS7_HELPER_SIGNER_INFO_DEPTH, tokens, PKCS7_HELPER_SIGNER_TOKENS, &count)
+        || count == 0 || tokens[0].tag != TAG_SEQUENCE) {
+        NSV_LOGE("not a signerInfo\n");
         return false;
     }
-    m_pos += len;
-    //signatureValue
-    len = pkcs7HelperCreateElement(certrsa, TAG_BITSTRING, names[12], level);
-    if (len == -1 || m_pos + len > m_length) {
+    int issuer = derHelperFind(tokens, count, -1, PATH_ISSUER, sizeof(PATH_ISSUER) / sizeof(PATH_ISSUER[0]));
+    int serial = derHelperFind(tokens, count, -1, PATH_SERIAL, sizeof(PATH_SERIAL) / sizeof(PATH_SERIAL[0]));
+    int digest_algorithm = derHelperFind(tokens, count, -1, PATH_DIGEST_ALGORITHM,
+                                         sizeof(PATH_DIGEST_ALGORITHM) / sizeof(PATH_DIGEST_ALGORITHM[0]));
+    int attributes = derHelperFind(tokens, count, -1, PATH_AUTHENTICATED_ATTRIBUTES,
+                                   sizeof(PATH_AUTHENTICATED_ATTRIBUTES) / sizeof(PATH_AUTHENTICATED_ATTRIBUTES[0]));
+    int encryption_algorithm = derHelperFind(tokens, count, -1, PATH_DIGEST_ENCRYPTION_ALGORITHM,
+                                             sizeof(PATH_DIGEST_ENCRYPTION_ALGORITHM)
+                                             / sizeof(PATH_DIGEST_ENCRYPTION_ALGORITHM[0]));
+    int encrypted_digest = derHelperFind(tokens, count, -1, PATH_ENCRYPTED_DIGEST,
+                                         sizeof(PATH_ENCRYPTED_DIGEST) / sizeof(PATH_ENCRYPTED_DIGEST[0]));
+    if (issuer < 0 || serial < 0 || digest_algorithm < 0 || encryption_algorithm < 0 || encrypted_digest < 0) {
+        NSV_LOGE("not a signerInfo\n");
         return false;
     }
-    m_pos += len;
+    info->issuer = tokens[issuer];
+    info->serial = tokens[serial];
+    info->digest_algorithm = tokens[digest_algorithm];
+    info->digest_encryption_algorithm = tokens[encryption_algorithm];
+    info->encrypted_digest = tokens[encrypted_digest];
+    if (attributes >= 0) {
+        info->authenticated_attributes = tokens[attributes];
+    }
     return true;
 }
 
 /**
- * Resolve signer information
+ * Finds the first value of the attribute of type oid (encoded, without tag and length) among attributes,
+ * the authenticatedAttributes of a signerInfo der. The value token points into der.
  */
-bool pkcs7HelperParseSignerInfo(unsigned char *certrsa, int level) {
-    char *names[] = {
-            "version",
-            "issuerAndSerialNumber",
-            "digestAlgorithmId",
-            "authenticatedAttributes-[optional]",
-            "digestEncryptionAlgorithmId",
-            "encryptedDigest",
-            "unauthenticatedAttributes-[optional]"};
-    int len;
-    unsigned char tag;
-    for (int i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
-        switch (i) {
-            case 0:
-                tag = TAG_INTEGER;
-                break;
-            case 3:
-                tag = 0xA0;
-                break;
-            case 5:
-                tag = TAG_OCTETSTRING;
-                break;
-            case 6:
-                tag = 0xA1;
-                break;
-            default:
-                tag = TAG_SEQUENCE;
+bool pkcs7HelperFindAttribute(const unsigned char *der, const derHelperToken *attributes, const unsigned char *oid,
+                              size_t oid_len, derHelperToken *value) {
+    derHelperToken tokens[PKCS7_HELPER_SIGNER_TOKENS];
+    size_t count = 0;
 
+    if (!derHelperTokenize(der + attributes->offset, (size_t) attributes->header + attributes->len,
+                           PKCS7_HELPER_ATTRIBUTES_DEPTH, tokens, PKCS7_HELPER_SIGNER_TOKENS, &count)) {
+        return false;
+    }
+    for (int i = derHelperFirstChild(tokens, count, 0); i >= 0;
+         i = tokens[i].next == DER_HELPER_NONE ? -1 : tokens[i].next) {
+        const derHelperStep type_step = {TAG_OBJECTID, 0};
+        const derHelperStep value_steps[] = {{TAG_SET, 0}, {DER_HELPER_ANY, 0}};
+        int type = derHelperFind(tokens, count, i, &type_step, 1);
+        if (type < 0 || tokens[type].len != oid_len
+            || memcmp(der + attributes->offset + tokens[type].offset + tokens[type].header, oid, oid_len) != 0) {
+            continue;
         }
-        len = pkcs7HelperCreateElement(certrsa, tag, names[i], level);
-        if (len == -1 || m_pos + len > m_length) {
-            if (i == 3 || i == 6)
-                continue;
+        int found = derHelperFind(tokens, count, i, value_steps, 2);
+        if (found < 0) {
             return false;
         }
-        m_pos += len;
+        *value = tokens[found];
+        value->offset += attributes->offset;
+        return true;
     }
-    return m_pos == m_length ? true : false;
+    return false;
 }
 
-bool pkcs7HelperParseContent(unsigned char *certrsa, int level) {
-
-    char *names[] = {"version",
-                     "DigestAlgorithms",
-                     "contentInfo",
-                     "certificates-[optional]",
-                     "crls-[optional]",
-                     "signerInfos",
-                     "signerInfo"};
-
-    unsigned char tag;
-    int len = 0;
-    //version
-    len = pkcs7HelperCreateElement(certrsa, TAG_INTEGER, names[0], level);
-    if (len == -1 || m_pos + len > m_length) {
-        return false;
-    }
-    m_pos += len;
-    //DigestAlgorithms
-    len = pkcs7HelperCreateElement(certrsa, TAG_SET, names[1], level);
-    if (len == -1 || m_pos + len > m_length) {
-        return false;
-    }
-    m_pos += len;
-    //contentInfo
-    len = pkcs7HelperCreateElement(certrsa, TAG_SEQUENCE, names[2], level);
-    if (len == -1 || m_pos + len > m_length) {
-        return false;
-    }
-    m_pos += len;
-    //certificates-[optional]
-    tag = certrsa[m_pos];
-    if (tag == TAG_OPTIONAL) {
-        m_pos++;
-        m_pos += pkcs7HelperLenNum(certrsa[m_pos]);
-        len = pkcs7HelperCreateElement(certrsa, TAG_SEQUENCE, names[3], level);
-        if (len == -1 || m_pos + len > m_length) {
-            return false;
-        }
-        bool ret = pkcs7HelperParseCertificate(certrsa, level + 1);
-        if (ret == false) {
-            return ret;
-        }
-    }
-    //crls-[optional]
-    tag = certrsa[m_pos];
-    if (tag == 0xA1) {
-        m_pos++;
-        m_pos += pkcs7HelperLenNum(certrsa[m_pos]);
-        len = pkcs7HelperCreateElement(certrsa, TAG_SEQUENCE, names[4], level);
-        if (len == -1 || m_pos + len > m_length) {
-            return false;
+/**
+ * Finds the certificate issuerAndSerialNumber of info names among the certificates of contents, which point
+ * into certrsa. Returns its span, NULL if there is none. cert is left parsed.
+ */
+const pkcs7HelperSpan *pkcs7HelperFindSigner(const unsigned char *certrsa, const pkcs7HelperContents *contents,
+                                             const unsigned char *signer_info, const pkcs7HelperSignerInfo *info,
+                                             x509HelperCertificate *cert) {
+    size_t issuer_len = (size_t) info->issuer.header + info->issuer.len;
+    size_t serial_len = (size_t) info->serial.header + info->serial.len;
+
+    for (size_t i = 0; i < contents->certificate_count; i++) {
+        const unsigned char *certificate = certrsa + contents->certificates[i].offset;
+        if (x509HelperParse(certificate, contents->certificates[i].len, cert)
+            && (size_t) cert->issuer.header + cert->issuer.len == issuer_len
+            && (size_t) cert->serial.header + cert->serial.len == serial_len
+            && memcmp(certificate + cert->issuer.offset, signer_info + info->issuer.offset, issuer_len) == 0
+            && memcmp(certificate + cert->serial.offset, signer_info + info->serial.offset, serial_len) == 0) {
+            return &contents->certificates[i];
         }
-        m_pos += len;
     }
-    //signerInfos
-    tag = certrsa[m_pos];
-    if (tag != TAG_SET) {
-        return false;
-    }
-    len = pkcs7HelperCreateElement(certrsa, TAG_SET, names[5], level);
-    if (len == -1 || m_pos + len > m_length) {
-        return false;
+    return NULL;
+}
+
+/**
+ * Takes the certificate of the signer out of what pkcs7HelperStreamTake() returns: a certificates-[optional]
+ * element, followed by the signerInfos if there is a chain. The result points into certificates.
+ */
+unsigned char *pkcs7HelperGetSignerCertificate(unsigned char *certificates, size_t len_in, size_t *len_out) {
+    derHelperToken tokens[PKCS7_HELPER_MAX_TOKENS];
+    pkcs7HelperContext ctx;
+    pkcs7HelperContents contents;
+    const derHelperStep certificates_step = {TAG_OPTIONAL, 0};
+    const derHelperStep signer_infos_step = {TAG_SET, 0};
+
+    pkcs7HelperInit(&ctx, tokens, PKCS7_HELPER_MAX_TOKENS);
+    int index = -1;
+    if (derHelperTokenize(certificates, len_in, 1, ctx.tokens, ctx.capacity, &ctx.count)) {
+        index = derHelperFind(ctx.tokens, ctx.count, -1, &certificates_step, 1);
     }
-    //signerInfo
-    len = pkcs7HelperCreateElement(certrsa, TAG_SEQUENCE, names[6], level + 1);
-    if (len == -1 || m_pos + len > m_length) {
-        return false;
+    if (index != 0) {
+        NSV_LOGW("not found the certificate\n");
+        return NULL;
     }
-    return pkcs7HelperParseSignerInfo(certrsa, level + 2);
+    pkcs7HelperCollect(&ctx, index, contents.certificates, &contents.certificate_count);
+    pkcs7HelperCollect(&ctx, derHelperFind(ctx.tokens, ctx.count, -1, &signer_infos_step, 1),
+                       contents.signer_infos, &contents.signer_info_count);
+    return pkcs7HelperPickSigner(certificates, &contents, len_out);
 }
 
 /**
- *Finds the element in pkcs7 by name, returns NULL if it is not found.
- *name:
- *begin: beginning of the search
+ * Starts reading a PKCS#7 blob, certificates elements bigger than limit are refused.
  */
-static element *pkcs7HelperGetElement(const char *name, element *begin) {
-    if (begin == NULL)
-        begin = head;
-    element *p = begin;
-    while (p != NULL) {
-        if (strncmp(p->name, name, strlen(name)) == 0) {
-            return p;
-        }
-
-        p = p->next;
-    }
-    NSV_LOGW("not found the \"%s\"\n", name);
-    return p;
+void pkcs7HelperStreamInit(pkcs7HelperStream *stream, size_t limit) {
+    memset(stream, 0, sizeof(pkcs7HelperStream));
+    stream->end = UINT64_MAX;
+    stream->limit = limit;
 }
 
-static bool pkcs7HelperParse(unsigned char *certrsa, size_t length) {
-    unsigned char tag, lenbyte;
-    int len = 0;
-    int level = 0;
-    m_pos = 0;
-    m_length = length;
+/**
+ * Acts on the header of size header just completed in stream->header.
+ */
+static bool pkcs7HelperStreamHeader(pkcs7HelperStream *stream, uint8_t tag, int header, uint32_t len) {
+    uint8_t action = STREAM_STEPS[stream->step].action;
 
-    tag = certrsa[m_pos++];
-    if (tag != TAG_SEQUENCE) {
-        NSV_LOGE("the Tag indicated an ASN.1 not found!\n");
-        return false;
+    stream->header_len = 0;
+    stream->pos += (uint64_t) header;
+    if (action == PKCS7_HELPER_OPTIONAL && tag != STREAM_STEPS[stream->step].tag) {
+        action = STREAM_STEPS[++stream->step].action;
     }
-    lenbyte = certrsa[m_pos];
-    len = pkcs7HelperGetLength(certrsa, lenbyte, m_pos + 1);
-    m_pos += pkcs7HelperLenNum(lenbyte);
-    if (m_pos + len > m_length)
+    if (tag != STREAM_STEPS[stream->step].tag || stream->pos > stream->end || len > stream->end - stream->pos) {
+        NSV_LOGE("unexpected tag 0x%02x at %" PRIu64 "\n", tag, stream->pos);
         return false;
-    //contentType
-    len = pkcs7HelperCreateElement(certrsa, TAG_OBJECTID, "contentType", level);
-    if (len == -1) {
+    }
+    if (action == PKCS7_HELPER_ENTER) {
+        stream->end = stream->pos + len;
+        stream->step++;
+        return true;
+    }
+    if (action == PKCS7_HELPER_CHECK && len != sizeof(PKCS7_SIGNED_DATA_OID)) {
         NSV_LOGE("not found the ContentType!\n");
         return false;
     }
-    m_pos += len;
-    //optional
-    tag = certrsa[m_pos++];
-    lenbyte = certrsa[m_pos];
-    m_pos += pkcs7HelperLenNum(lenbyte);
-    //content-[optional]
-    len = pkcs7HelperCreateElement(certrsa, TAG_SEQUENCE, "content-[optional]", level);
-    if (len == -1) {
-        NSV_LOGI("not found the content!\n");
-        return false;
+    if (action == PKCS7_HELPER_CAPTURE) {
+        if ((size_t) header + len > stream->limit - stream->len) {
+            NSV_LOGE("certificates are too big: %u\n", len);
+            return false;
+        }
+        unsigned char *certificates = statsHelperRealloc(stream->certificates, stream->len + header + len);
+        if (NULL == certificates) {
+            return false;
+        }
+        stream->certificates = certificates;
+        memcpy(stream->certificates + stream->len, stream->header, (size_t) header);
+        stream->filled = stream->len + header;
+        stream->len += (size_t) header + len;
     }
-    return pkcs7HelperParseContent(certrsa, level + 1);
+    stream->in_content = true;
+    stream->remaining = len;
+    return true;
 }
 
-#ifndef NDEBUG
+/**
+ * Whether everything kept is complete once a captured element is: the signerInfos, or certificates holding
+ * a single certificate, which then has to be the signer.
+ */
+static bool pkcs7HelperStreamKept(const pkcs7HelperStream *stream) {
+    uint8_t tag, header, cert_header;
+    uint32_t len, cert_len;
 
-static void pkcs7HelperPrint() {
-    NSV_LOGI("-----------------------------------------------------------------------\n");
-    NSV_LOGI(" name                                          offset        length\n");
-    NSV_LOGI(" ======================================== =============== =============\n");
-    element *p = head;
-    const size_t PRINT_BUF_SIZE = 256;
-    char buf[PRINT_BUF_SIZE] = "";
-    while (p != NULL) {
-        for (int i = 0; i < p->level; i++) {
-            sprintf(buf, "%s    ", buf);
-        }
-        sprintf(buf, "%s %s", buf, p->name);
+    if (STREAM_STEPS[stream->step].tag == TAG_SET) {
+        return true;
+    }
+    return derHelperReadHeader(stream->certificates, stream->len, &tag, &header, &len)
+           && derHelperReadHeader(stream->certificates + header, len, &tag, &cert_header, &cert_len)
+           && (size_t) cert_header + cert_len == len;
+}
 
-        for (int i = 0; i < 40 - strlen(p->name) - 4 * p->level; i++) {
-            sprintf(buf, "%s ", buf);
+/**
+ * Feeds the next len bytes of the blob. Bytes after the elements kept are ignored.
+ * Returns false if the blob is not a signedData with certificates.
+ */
+bool pkcs7HelperStreamWrite(pkcs7HelperStream *stream, const unsigned char *data, size_t len) {
+    size_t i = 0;
+
+    while (!stream->done) {
+        if (!stream->in_content) {
+            uint8_t tag = 0;
+            uint32_t content_len = 0;
+            int header = 0;
+            while (header == 0 && i < len) {
+                stream->header[stream->header_len++] = data[i++];
+                header = derHelperReadPartialHeader(stream->header, stream->header_len, &tag, &content_len);
+            }
+            if (header == 0) {
+                return true;
+            }
+            if (header < 0 || !pkcs7HelperStreamHeader(stream, tag, header, content_len)) {
+                return false;
+            }
+            continue;
         }
-        sprintf(buf, "%s%6d(0x%02x)", buf, p->begin, p->begin);
-        int num = 0;
-        int size = p->begin;
-        while (size) {
-            num += 1;
-            size >>= 4;
+        if (stream->remaining > 0) {
+            if (i == len) {
+                return true;
+            }
+            size_t n = len - i < stream->remaining ? len - i : stream->remaining;
+            uint8_t action = STREAM_STEPS[stream->step].action;
+            if (action == PKCS7_HELPER_CHECK) {
+                size_t offset = sizeof(PKCS7_SIGNED_DATA_OID) - stream->remaining;
+                if (memcmp(data + i, PKCS7_SIGNED_DATA_OID + offset, n) != 0) {
+                    NSV_LOGE("not found the ContentType!\n");
+                    return false;
+                }
+            } else if (action == PKCS7_HELPER_CAPTURE) {
+                memcpy(stream->certificates + stream->filled, data + i, n);
+                stream->filled += n;
+            }
+            i += n;
+            stream->pos += n;
+            stream->remaining -= (uint32_t) n;
         }
-        if (num < 2) num = 2;
-        for (int i = 0; i < 8 - num; i++) {
-            sprintf(buf, "%s ", buf);
+        if (stream->remaining == 0) {
+            stream->in_content = false;
+            stream->done = STREAM_STEPS[stream->step].action == PKCS7_HELPER_CAPTURE && pkcs7HelperStreamKept(stream);
+            stream->step++;
         }
-        sprintf(buf, "%s%4d(0x%02x)", buf, (int) p->len, (unsigned int) p->len);
-        NSV_LOGI("%s", buf);
-        memset(buf, 0, PRINT_BUF_SIZE);
-        p = p->next;
     }
-    NSV_LOGI("-----------------------------------------------------------------------\n");
+    return true;
 }
 
-
-#endif //NDEBUG
-
 /**
- * Convert length information to ASN.1 length format
- * len <= 0x7f       1
- * len >= 0x80       1 + Non-zero bytes
+ * Hands the elements kept over to the caller, who frees them. NULL until the stream is done.
  */
-static size_t pkcs7HelperGetNumFromLen(size_t len) {
-    size_t num = 0;
-    size_t tmp = len;
-    while (tmp) {
-        num++;
-        tmp >>= 8;
+unsigned char *pkcs7HelperStreamTake(pkcs7HelperStream *stream, size_t *len) {
+    unsigned char *certificates = NULL;
+    if (stream->done) {
+        certificates = stream->certificates;
+        *len = stream->len;
+        stream->certificates = NULL;
     }
-    if ((num == 1 && len >= 0x80) || (num > 1))
-        num += 1;
-    return num;
+    return certificates;
 }
 
+void pkcs7HelperStreamFree(pkcs7HelperStream *stream) {
+    free(stream->certificates);
+    stream->certificates = NULL;
+}
 
 /**
- *Each element element is a {tag, length, data} triple, tag and length are saved by tag and len, and data is saved by [begin, begin+len].
- *
- *This function calculates the offset from the data position to the tag position
+ * Sets up a parser over a caller-owned array of capacity tokens, e.g. an array on the stack.
+ * Nothing is allocated: the context can be dropped or reused without freeing anything.
  */
-size_t pkcs7HelperGetTagOffset(element *p, unsigned char *certrsa) {
-    if (p == NULL)
-        return 0;
-    size_t offset = pkcs7HelperGetNumFromLen(p->len);
-    if (certrsa[p->begin - offset - 1] == p->tag)
-        return offset + 1;
-    else
-        return 0;
+void pkcs7HelperInit(pkcs7HelperContext *ctx, derHelperToken *tokens, size_t capacity) {
+    ctx->tokens = tokens;
+    ctx->capacity = capacity;
+    pkcs7HelperReset(ctx);
 }
 
-unsigned char *pkcs7HelperGetSignature(unsigned char *certrsa, size_t len_in, size_t *len_out) {
-    if (!pkcs7HelperParse(certrsa, len_in)) {
-        NSV_LOGE("Can't parse\n");
-    } else {
-#ifndef NDEBUG
-        pkcs7HelperPrint();
-#endif //NDEBUG
-        element *p_cert = pkcs7HelperGetElement("certificates-[optional]", head);
-        if (!p_cert) {
-            return NULL;
-        }
-        size_t offset = pkcs7HelperGetTagOffset(p_cert, certrsa);
-        if (offset == 0) {
-            printf("get offset error!\n");
-            return NULL;
-        }
-        *len_out = p_cert->len + offset;
-        return certrsa + p_cert->begin - offset;
-    }
-
-    return NULL;
+/**
+ * Releases every token of the previous parse at once.
+ */
+void pkcs7HelperReset(pkcs7HelperContext *ctx) {
+    ctx->count = 0;
 }
-
-void pkcs7HelperFree() {
-    element *p = head;
-    while (p != NULL) {
-        head = p->next;
-        free(p);
-        p = head;
-    }
-    head = NULL;
-}
\ No newline at end of file
@@ -25,43 +25,124 @@ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 #define NATIVESIGNATUREVERIFICATION_PKCS7_HELPER_H
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
 #include <assert.h>
 #include <malloc.h>
 #include <string.h>
 #include <unistd.h>
 
+#include "der_helper.h"
+#include "x509_helper.h"
+#include "stats_helper.h"
 #include "def.h"
 
-// Tags:
-// https://en.wikipedia.org/wiki/X.690
-#define TAG_INTEGER         0x02
-#define TAG_BITSTRING       0x03
-#define TAG_OCTETSTRING     0x04
-#define TAG_NULL            0x05
-#define TAG_OBJECTID        0x06
-#define TAG_UTCTIME         0x17
-#define TAG_GENERALIZEDTIME 0x18
-#define TAG_SEQUENCE        0x30
-#define TAG_SET             0x31
+// contentInfo/content/signedData/certificates/certificate
+#define PKCS7_HELPER_DEPTH          4
+// A CERT.RSA with one signer takes 13 tokens at that depth, every extra certificate adds one
+#define PKCS7_HELPER_MAX_TOKENS     32
 
-#define TAG_OPTIONAL    0xA0
+// certificates and signerInfos kept by one pkcs7HelperGetContents()
+#define PKCS7_HELPER_MAX_SPANS      16
 
+// signerInfo/issuerAndSerialNumber/serialNumber
+#define PKCS7_HELPER_SIGNER_INFO_DEPTH  2
+// authenticatedAttributes/attribute/values/value
+#define PKCS7_HELPER_ATTRIBUTES_DEPTH   3
+// a signerInfo takes about 12 tokens, attributes 4 tokens each
+#define PKCS7_HELPER_SIGNER_TOKENS      48
 
-#define NAME_LEN    63
+/**
+ * Parse state of one PKCS#7 blob: the tokens in document order.
+ * Each thread uses its own context, so parses can run concurrently.
+ */
+typedef struct pkcs7HelperContext {
+    derHelperToken *tokens;
+    size_t capacity;
+    size_t count;
+} pkcs7HelperContext;
+
+/**
+ * A DER triple of the parsed blob, the header included.
+ */
+typedef struct pkcs7HelperSpan {
+    size_t offset;
+    size_t len;
+} pkcs7HelperSpan;
 
-typedef struct element {
-    unsigned char tag;
-    char name[NAME_LEN];
-    int begin;
+/**
+ * The certificates and the signerInfos of one blob in document order, at most PKCS7_HELPER_MAX_SPANS of each.
+ */
+typedef struct pkcs7HelperContents {
+    pkcs7HelperSpan certificates[PKCS7_HELPER_MAX_SPANS];
+    size_t certificate_count;
+    pkcs7HelperSpan signer_infos[PKCS7_HELPER_MAX_SPANS];
+    size_t signer_info_count;
+} pkcs7HelperContents;
+
+/**
+ * The fields of one signerInfo, as tokens of the signerInfo. authenticated_attributes has tag 0 if there are none.
+ */
+typedef struct pkcs7HelperSignerInfo {
+    derHelperToken issuer;
+    derHelperToken serial;
+    derHelperToken digest_algorithm;
+    derHelperToken authenticated_attributes;
+    derHelperToken digest_encryption_algorithm;
+    derHelperToken encrypted_digest;
+} pkcs7HelperSignerInfo;
+
+/**
+ * Incremental reader of a PKCS#7 blob that keeps nothing but its certificates element and, if that holds
+ * more than one certificate, the signerInfos element right behind it in the same buffer.
+ * The blob is written in pieces of any size, done is set as soon as the elements kept are complete.
+ * end is the offset where the innermost entered element ends, pos the offset of the next byte written.
+ */
+typedef struct pkcs7HelperStream {
+    unsigned char header[DER_HELPER_MAX_HEADER];
+    uint8_t header_len;
+    uint8_t step;
+    bool in_content;
+    bool done;
+    uint32_t remaining;
+    uint64_t pos;
+    uint64_t end;
+    unsigned char *certificates;
     size_t len;
-    int level;
-    struct element *next;
-} element;
+    size_t filled;
+    size_t limit;
+} pkcs7HelperStream;
+
+
+void pkcs7HelperInit(pkcs7HelperContext *ctx, derHelperToken *tokens, size_t capacity);
+
+void pkcs7HelperReset(pkcs7HelperContext *ctx);
+
+unsigned char * pkcs7HelperGetSignature(pkcs7HelperContext *ctx, unsigned char * certrsa, size_t len_in,
+                                        size_t *len_out);
+
+bool pkcs7HelperGetContents(pkcs7HelperContext *ctx, const unsigned char *certrsa, size_t len_in,
+                            pkcs7HelperContents *contents);
+
+bool pkcs7HelperParseSignerInfo(const unsigned char *der, size_t len, pkcs7HelperSignerInfo *info);
+
+bool pkcs7HelperFindAttribute(const unsigned char *der, const derHelperToken *attributes, const unsigned char *oid,
+                              size_t oid_len, derHelperToken *value);
+
+const pkcs7HelperSpan * pkcs7HelperFindSigner(const unsigned char *certrsa, const pkcs7HelperContents *contents,
+                                              const unsigned char *signer_info, const pkcs7HelperSignerInfo *info,
+                                              x509HelperCertificate *cert);
+
+unsigned char * pkcs7HelperGetSignerCertificate(unsigned char * certificates, size_t len_in, size_t *len_out);
+
+void pkcs7HelperStreamInit(pkcs7HelperStream *stream, size_t limit);
 
+bool pkcs7HelperStreamWrite(pkcs7HelperStream *stream, const unsigned char *data, size_t len);
 
-unsigned char * pkcs7HelperGetSignature(unsigned char * certrsa, size_t len_in, size_t *len_out);
+unsigned char * pkcs7HelperStreamTake(pkcs7HelperStream *stream, size_t *len);
 
-void pkcs7HelperFree();
+void pkcs7HelperStreamFree(pkcs7HelperStream *stream);
 
 
 #endif //NATIVESIGNATUREVERIFICATION_PKCS7_HELPER_H
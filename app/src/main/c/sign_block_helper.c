@@ -0,0 +1,681 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include "sign_block_helper.h"
+
+/*APK Signing Block (v2/v3)
+*  size of block in bytes (excluding this field) : uint64
+*  Sequence of uint64-length-prefixed ID-value pairs:
+*      ID : uint32
+*      value : (pair size - 4) bytes
+*  size of block in bytes—same as the very first field : uint64
+*  magic “APK Sig Block 42” : 16 bytes
+*
+*v2 (0x7109871a) and v3 (0xf05368c0) values:
+*  length-prefixed sequence of length-prefixed signer:
+*      length-prefixed signed data:
+*          length-prefixed sequence of length-prefixed digests:
+*              signature algorithm ID : uint32
+*              length-prefixed digest
+*          length-prefixed sequence of X.509 certificates:
+*              length-prefixed X.509 certificate (ASN.1 DER form)
+*          [v3 only] minSDK : uint32, maxSDK : uint32
+*          length-prefixed sequence of length-prefixed additional attributes
+*      [v3 only] minSDK : uint32, maxSDK : uint32
+*      length-prefixed sequence of length-prefixed signatures
+*      length-prefixed public key (SubjectPublicKeyInfo, ASN.1 DER form)
+*
+*All lengths and integers are little-endian uint32 unless specified.
+*/
+
+static uint32_t signBlockHelperGetUint32(const unsigned char *p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint64_t signBlockHelperGetUint64(const unsigned char *p) {
+    return (uint64_t) signBlockHelperGetUint32(p) | ((uint64_t) signBlockHelperGetUint32(p + 4) << 32);
+}
+
+static int32_t signBlockHelperReadAt(unzipHelperArchive *archive, uint64_t offset, void *buf, int32_t len) {
+    int32_t err = mz_stream_seek(archive->stream, (int64_t) offset, MZ_SEEK_SET);
+    if (err != MZ_OK) {
+        return err;
+    }
+    if (mz_stream_read(archive->stream, buf, len) != len) {
+        return MZ_STREAM_ERROR;
+    }
+    return MZ_OK;
+}
+
+/**
+ * Locates the APK Signing Block in front of the central directory.
+ * When the APK is in memory the block is not copied.
+ * Returns MZ_EXIST_ERROR if the APK has no block, e.g. it is signed with v1 scheme only.
+ */
+int32_t signBlockHelperRead(unzipHelperArchive *archive, signBlock *block) {
+    unsigned char footer[SIGN_BLOCK_FOOTER_LEN];
+    uint64_t size = 0;
+    int32_t err = MZ_OK;
+
+    memset(block, 0, sizeof(signBlock));
+
+    err = mz_zip_get_cd_offset(archive->handle, &block->cd_offset);
+    if (err == MZ_OK) {
+        err = mz_zip_get_cd_size(archive->handle, &block->cd_size);
+    }
+    if (err != MZ_OK) {
+        return err;
+    }
+    if (block->cd_offset < SIGN_BLOCK_FOOTER_LEN + 8) {
+        return MZ_EXIST_ERROR;
+    }
+
+    err = signBlockHelperReadAt(archive, block->cd_offset - SIGN_BLOCK_FOOTER_LEN, footer, sizeof(footer));
+    if (err != MZ_OK) {
+        return err;
+    }
+    if (memcmp(footer + 8, SIGN_BLOCK_MAGIC, SIGN_BLOCK_MAGIC_LEN) != 0) {
+        NSV_LOGI("APK Signing Block not found\n");
+        return MZ_EXIST_ERROR;
+    }
+    size = signBlockHelperGetUint64(footer);
+    if (size < SIGN_BLOCK_FOOTER_LEN || size > INT32_MAX - 8 || size + 8 > block->cd_offset) {
+        NSV_LOGE("APK Signing Block size %llu is out of range\n", (unsigned long long) size);
+        return MZ_FORMAT_ERROR;
+    }
+    block->offset = block->cd_offset - size - 8;
+    block->size = (size_t) size + 8;
+
+    if (NULL != archive->base) {
+        block->data = archive->base + block->offset;
+    } else {
+        block->buffer = statsHelperMalloc(block->size);
+        if (NULL == block->buffer) {
+            return MZ_MEM_ERROR;
+        }
+        err = signBlockHelperReadAt(archive, block->offset, block->buffer, (int32_t) block->size);
+        if (err != MZ_OK) {
+            signBlockHelperFree(block);
+            return err;
+        }
+        block->data = block->buffer;
+    }
+
+    if (signBlockHelperGetUint64(block->data) != size) {
+        NSV_LOGE("APK Signing Block sizes in header and footer are different\n");
+        signBlockHelperFree(block);
+        return MZ_FORMAT_ERROR;
+    }
+    NSV_LOGI("APK Signing Block at %llu, %zu bytes\n", (unsigned long long) block->offset, block->size);
+    return MZ_OK;
+}
+
+void signBlockHelperFree(signBlock *block) {
+    free(block->buffer);
+    memset(block, 0, sizeof(signBlock));
+}
+
+/**
+ * Finds the value of the ID-value pair with the given id.
+ */
+int32_t signBlockHelperFindScheme(const signBlock *block, uint32_t id, signBlockSpan *value) {
+    size_t pos = 8;
+    size_t end = block->size - SIGN_BLOCK_FOOTER_LEN;
+
+    while (pos + 8 <= end) {
+        uint64_t len = signBlockHelperGetUint64(block->data + pos);
+        pos += 8;
+        if (len < 4 || len > end - pos) {
+            NSV_LOGE("APK Signing Block pair is out of range\n");
+            return MZ_FORMAT_ERROR;
+        }
+        if (signBlockHelperGetUint32(block->data + pos) == id) {
+            value->offset = pos + 4;
+            value->len = (size_t) len - 4;
+            return MZ_OK;
+        }
+        pos += (size_t) len;
+    }
+    return MZ_EXIST_ERROR;
+}
+
+/**
+ * Takes the next uint32-length-prefixed item from the beginning of sequence.
+ * Returns false at the end of sequence or if the item does not fit in it.
+ */
+bool signBlockHelperNextItem(const signBlock *block, signBlockSpan *sequence, signBlockSpan *item) {
+    if (sequence->len < 4) {
+        return false;
+    }
+    uint32_t len = signBlockHelperGetUint32(block->data + sequence->offset);
+    if (len > sequence->len - 4) {
+        return false;
+    }
+    item->offset = sequence->offset + 4;
+    item->len = len;
+    sequence->offset += 4 + len;
+    sequence->len -= 4 + len;
+    return true;
+}
+
+/**
+ * Splits the signers of v2 or v3 scheme into their parts.
+ * At most capacity signers are returned.
+ */
+int32_t signBlockHelperGetSigners(const signBlock *block, uint32_t id,
+                                  signBlockSigner *signers, size_t capacity, size_t *count) {
+    signBlockSpan value;
+    signBlockSpan sequence;
+    signBlockSpan signer;
+    signBlockSpan signed_data;
+    int32_t err = MZ_OK;
+
+    *count = 0;
+    err = signBlockHelperFindScheme(block, id, &value);
+    if (err != MZ_OK) {
+        return err;
+    }
+    if (!signBlockHelperNextItem(block, &value, &sequence)) {
+        return MZ_FORMAT_ERROR;
+    }
+    while (sequence.len > 0 && *count < capacity) {
+        signBlockSigner *s = &signers[*count];
+        if (!signBlockHelperNextItem(block, &sequence, &signer)
+            || !signBlockHelperNextItem(block, &signer, &s->signed_data)) {
+            return MZ_FORMAT_ERROR;
+        }
+        if (id == SIGN_BLOCK_ID_V3) {
+            //minSDK, maxSDK
+            if (signer.len < 8) {
+                return MZ_FORMAT_ERROR;
+            }
+            signer.offset += 8;
+            signer.len -= 8;
+        }
+        if (!signBlockHelperNextItem(block, &signer, &s->signatures)
+            || !signBlockHelperNextItem(block, &signer, &s->public_key)) {
+            return MZ_FORMAT_ERROR;
+        }
+        signed_data = s->signed_data;
+        if (!signBlockHelperNextItem(block, &signed_data, &s->digests)
+            || !signBlockHelperNextItem(block, &signed_data, &s->certificates)) {
+            return MZ_FORMAT_ERROR;
+        }
+        (*count)++;
+    }
+    return *count > 0 ? MZ_OK : MZ_FORMAT_ERROR;
+}
+
+/**
+ * Lists the certificates of every signer of v2 or v3 scheme, signer by signer in the order they are stored.
+ * At most capacity certificates are returned, the spans point into block->data.
+ */
+int32_t signBlockHelperGetCertificates(const signBlock *block, uint32_t id,
+                                       signBlockSpan *certificates, size_t capacity, size_t *count) {
+    signBlockSigner signers[SIGN_BLOCK_MAX_SIGNERS];
+    size_t signer_count = 0;
+
+    *count = 0;
+    int32_t err = signBlockHelperGetSigners(block, id, signers, SIGN_BLOCK_MAX_SIGNERS, &signer_count);
+    for (size_t i = 0; err == MZ_OK && i < signer_count; i++) {
+        while (*count < capacity && signBlockHelperNextItem(block, &signers[i].certificates, &certificates[*count])) {
+            (*count)++;
+        }
+    }
+    return err;
+}
+
+/**
+ * Returns a copy of the first certificate of the first signer, v3 scheme is preferred over v2.
+ * Nothing is inflated: only the APK Signing Block in front of the central directory is read.
+ * id, if not NULL, receives the ID of the scheme the certificate was taken from.
+ */
+unsigned char *signBlockHelperGetCertificate(unzipHelperArchive *archive, size_t *len, uint32_t *id) {
+    const uint32_t ids[] = {SIGN_BLOCK_ID_V3, SIGN_BLOCK_ID_V2};
+    signBlockSigner signers[SIGN_BLOCK_MAX_SIGNERS];
+    signBlockSpan certificate;
+    signBlock block;
+    size_t count = 0;
+    unsigned char *result = NULL;
+
+    if (signBlockHelperRead(archive, &block) != MZ_OK) {
+        return NULL;
+    }
+    for (size_t i = 0; i < sizeof(ids) / sizeof(ids[0]) && NULL == result; i++) {
+        if (signBlockHelperGetSigners(&block, ids[i], signers, SIGN_BLOCK_MAX_SIGNERS, &count) != MZ_OK) {
+            continue;
+        }
+        NSV_LOGI("scheme 0x%08x has %zu signer(s)\n", ids[i], count);
+        if (!signBlockHelperNextItem(&block, &signers[0].certificates, &certificate)
+            || certificate.len == 0) {
+            continue;
+        }
+        result = statsHelperMalloc(certificate.len);
+        if (NULL != result) {
+            memcpy(result, block.data + certificate.offset, certificate.len);
+            *len = certificate.len;
+            if (NULL != id) {
+                *id = ids[i];
+            }
+        }
+    }
+    signBlockHelperFree(&block);
+    return result;
+}
+
+/**
+ * The three sections the content digest covers, see SIGN_BLOCK_CHUNK_SIZE.
+ * A section is either in memory or read from fd.
+ */
+typedef struct signBlockDigestJob {
+    hashHelperAlgorithm algorithm;
+    size_t digest_size;
+    int fd;
+    const unsigned char *data[3];
+    uint64_t offset[3];
+    uint64_t len[3];
+    size_t first_chunk[4];
+    unsigned char *digests;
+    int failed;
+} signBlockDigestJob;
+
+/**
+ * Maps a signature algorithm ID onto the digest used for the contents.
+ * Verity based algorithms are not supported.
+ */
+static bool signBlockHelperGetDigestAlgorithm(uint32_t signature_algorithm, hashHelperAlgorithm *algorithm) {
+    switch (signature_algorithm) {
+        case 0x0101: // RSASSA-PSS with SHA2-256
+        case 0x0103: // RSASSA-PKCS1-v1_5 with SHA2-256
+        case 0x0201: // ECDSA with SHA2-256
+        case 0x0301: // DSA with SHA2-256
+            *algorithm = HASH_HELPER_SHA256;
+            return true;
+        case 0x0102: // RSASSA-PSS with SHA2-512
+        case 0x0104: // RSASSA-PKCS1-v1_5 with SHA2-512
+        case 0x0202: // ECDSA with SHA2-512
+            *algorithm = HASH_HELPER_SHA512;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Finds the digest of the signer made with the given digest algorithm.
+ */
+static bool signBlockHelperFindDigest(const signBlock *block, const signBlockSigner *signer,
+                                      hashHelperAlgorithm algorithm, signBlockSpan *digest) {
+    signBlockSpan digests = signer->digests;
+    signBlockSpan item;
+    hashHelperAlgorithm item_algorithm;
+
+    while (signBlockHelperNextItem(block, &digests, &item)) {
+        if (item.len < 4
+            || !signBlockHelperGetDigestAlgorithm(signBlockHelperGetUint32(block->data + item.offset), &item_algorithm)
+            || item_algorithm != algorithm) {
+            continue;
+        }
+        item.offset += 4;
+        item.len -= 4;
+        return signBlockHelperNextItem(block, &item, digest);
+    }
+    return false;
+}
+
+/**
+ * Hashes one chunk: 0xa5 || uint32 chunk length || chunk.
+ * Chunks that are not in memory are read with pread, so workers do not share a file position.
+ */
+static void signBlockHelperDigestChunk(void *ctx, size_t index, size_t worker) {
+    signBlockDigestJob *job = ctx;
+    unsigned char buf[64 * 1024];
+    unsigned char prefix[5];
+    hashHelperContext hash;
+    size_t section = 0;
+    (void) worker;
+
+    while (index >= job->first_chunk[section + 1]) {
+        section++;
+    }
+    uint64_t pos = (uint64_t) (index - job->first_chunk[section]) * SIGN_BLOCK_CHUNK_SIZE;
+    uint64_t left = job->len[section] - pos;
+    size_t len = left < SIGN_BLOCK_CHUNK_SIZE ? (size_t) left : SIGN_BLOCK_CHUNK_SIZE;
+
+    prefix[0] = SIGN_BLOCK_CHUNK_PREFIX;
+    prefix[1] = (unsigned char) len;
+    prefix[2] = (unsigned char) (len >> 8);
+    prefix[3] = (unsigned char) (len >> 16);
+    prefix[4] = (unsigned char) (len >> 24);
+    hashHelperInit(&hash, job->algorithm);
+    hashHelperUpdate(&hash, prefix, sizeof(prefix));
+
+    if (NULL != job->data[section]) {
+        hashHelperUpdate(&hash, job->data[section] + pos, len);
+    } else {
+        off64_t offset = (off64_t) (job->offset[section] + pos);
+        while (len > 0) {
+            ssize_t read = pread64(job->fd, buf, len < sizeof(buf) ? len : sizeof(buf), offset);
+            if (read <= 0) {
+                __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+                return;
+            }
+            hashHelperUpdate(&hash, buf, (size_t) read);
+            offset += read;
+            len -= (size_t) read;
+        }
+    }
+    hashHelperFinal(&hash, job->digests + index * job->digest_size);
+}
+
+/**
+ * Computes the content digest: ZIP entries, central directory and EOCD are split into
+ * 1 MiB chunks which are hashed on all online cores, the top level digest is
+ * 0x5a || uint32 chunk count || chunk digests.
+ * In the EOCD the central directory offset is replaced by the offset of the APK Signing Block.
+ */
+static int32_t signBlockHelperComputeDigest(unzipHelperArchive *archive, const signBlock *block,
+                                            hashHelperAlgorithm algorithm, unsigned char *digest) {
+    signBlockDigestJob job;
+    unsigned char *eocd = NULL;
+    uint64_t file_size = 0;
+    uint64_t eocd_offset = block->cd_offset + block->cd_size;
+    unsigned char prefix[5];
+    hashHelperContext hash;
+    size_t count = 0;
+    size_t workers = 0;
+    statsHelperTimer timer;
+    int32_t err = MZ_OK;
+
+    statsHelperStart(&timer, STATS_HELPER_DIGEST);
+    memset(&job, 0, sizeof(job));
+    job.algorithm = algorithm;
+    job.digest_size = hashHelperGetSize(algorithm);
+    job.fd = -1;
+
+    if (NULL != archive->base) {
+        file_size = archive->size;
+    } else {
+        struct stat st;
+        job.fd = open(archive->name, O_RDONLY | O_CLOEXEC);
+        if (job.fd < 0 || fstat(job.fd, &st) != 0) {
+            NSV_LOGE("Could not open %s\n", archive->name);
+            err = MZ_STREAM_ERROR;
+            goto cleanup;
+        }
+        file_size = (uint64_t) st.st_size;
+    }
+    // the EOCD has to follow the central directory right away and hold the 32 bit offset
+    if (eocd_offset + 22 > file_size || file_size - eocd_offset > 22 + UINT16_MAX
+        || block->offset > UINT32_MAX) {
+        NSV_LOGE("EOCD does not follow the central directory\n");
+        err = MZ_FORMAT_ERROR;
+        goto cleanup;
+    }
+
+    eocd = statsHelperMalloc((size_t) (file_size - eocd_offset));
+    if (NULL == eocd) {
+        err = MZ_MEM_ERROR;
+        goto cleanup;
+    }
+    if (NULL != archive->base) {
+        memcpy(eocd, archive->base + eocd_offset, (size_t) (file_size - eocd_offset));
+    } else if (pread64(job.fd, eocd, (size_t) (file_size - eocd_offset), (off64_t) eocd_offset)
+               != (ssize_t) (file_size - eocd_offset)) {
+        err = MZ_STREAM_ERROR;
+        goto cleanup;
+    }
+    if (signBlockHelperGetUint32(eocd) != SIGN_BLOCK_EOCD_MAGIC
+        || signBlockHelperGetUint32(eocd + 16) != block->cd_offset) {
+        NSV_LOGE("EOCD does not point to the central directory\n");
+        err = MZ_FORMAT_ERROR;
+        goto cleanup;
+    }
+    eocd[16] = (unsigned char) block->offset;
+    eocd[17] = (unsigned char) (block->offset >> 8);
+    eocd[18] = (unsigned char) (block->offset >> 16);
+    eocd[19] = (unsigned char) (block->offset >> 24);
+
+    job.offset[0] = 0;
+    job.len[0] = block->offset;
+    job.offset[1] = block->cd_offset;
+    job.len[1] = block->cd_size;
+    job.offset[2] = eocd_offset;
+    job.len[2] = file_size - eocd_offset;
+    job.data[2] = eocd;
+    if (NULL != archive->base) {
+        job.data[0] = archive->base;
+        job.data[1] = archive->base + block->cd_offset;
+    }
+    for (size_t i = 0; i < 3; i++) {
+        job.first_chunk[i + 1] = job.first_chunk[i]
+                                 + (size_t) ((job.len[i] + SIGN_BLOCK_CHUNK_SIZE - 1) / SIGN_BLOCK_CHUNK_SIZE);
+    }
+
+    count = job.first_chunk[3];
+    job.digests = statsHelperMalloc(count * job.digest_size);
+    if (NULL == job.digests) {
+        err = MZ_MEM_ERROR;
+        goto cleanup;
+    }
+    workers = threadHelperGetWorkerCount(count);
+    NSV_LOGI("hashing %zu chunks on %zu workers\n", count, workers);
+    threadHelperRun(signBlockHelperDigestChunk, &job, count, workers);
+    if (job.failed) {
+        err = MZ_STREAM_ERROR;
+        goto cleanup;
+    }
+
+    prefix[0] = SIGN_BLOCK_TOP_PREFIX;
+    prefix[1] = (unsigned char) count;
+    prefix[2] = (unsigned char) (count >> 8);
+    prefix[3] = (unsigned char) (count >> 16);
+    prefix[4] = (unsigned char) (count >> 24);
+    hashHelperInit(&hash, algorithm);
+    hashHelperUpdate(&hash, prefix, sizeof(prefix));
+    hashHelperUpdate(&hash, job.digests, count * job.digest_size);
+    hashHelperFinal(&hash, digest);
+
+cleanup:
+    free(job.digests);
+    free(eocd);
+    if (job.fd >= 0) {
+        close(job.fd);
+    }
+    statsHelperStop(&timer, err == MZ_OK ? job.len[0] + job.len[1] + job.len[2] : 0);
+    return err;
+}
+
+/**
+ * Checks the APK contents against the content digest of scheme id (v2 or v3).
+ * The first supported digest of the first signer is computed and every signer has to agree with it.
+ * Returns MZ_CRC_ERROR if the contents do not match, MZ_FORMAT_ERROR if no digest can be checked.
+ */
+int32_t signBlockHelperVerifyDigests(unzipHelperArchive *archive, const signBlock *block, uint32_t id) {
+    signBlockSigner signers[SIGN_BLOCK_MAX_SIGNERS];
+    signBlockSpan digests;
+    signBlockSpan item;
+    signBlockSpan expected;
+    hashHelperAlgorithm algorithm = HASH_HELPER_SHA256;
+    unsigned char actual[HASH_HELPER_MAX_SIZE];
+    size_t count = 0;
+    bool found = false;
+    int32_t err = MZ_OK;
+
+    err = signBlockHelperGetSigners(block, id, signers, SIGN_BLOCK_MAX_SIGNERS, &count);
+    if (err != MZ_OK) {
+        return err;
+    }
+    digests = signers[0].digests;
+    while (!found && signBlockHelperNextItem(block, &digests, &item)) {
+        found = item.len >= 4
+                && signBlockHelperGetDigestAlgorithm(signBlockHelperGetUint32(block->data + item.offset), &algorithm);
+    }
+    if (!found) {
+        NSV_LOGE("no supported content digest in scheme 0x%08x\n", id);
+        return MZ_FORMAT_ERROR;
+    }
+
+    err = signBlockHelperComputeDigest(archive, block, algorithm, actual);
+    if (err != MZ_OK) {
+        return err;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!signBlockHelperFindDigest(block, &signers[i], algorithm, &expected)) {
+            // signers that did not use this digest have been checked through the ones that did
+            continue;
+        }
+        if (expected.len != hashHelperGetSize(algorithm)
+            || memcmp(block->data + expected.offset, actual, expected.len) != 0) {
+            NSV_LOGE("content digest of signer %zu does not match\n", i);
+            return MZ_CRC_ERROR;
+        }
+    }
+    return MZ_OK;
+}
+
+/**
+ * Maps a signature algorithm ID onto the digest the signed data is signed with.
+ * Only RSASSA-PKCS1-v1_5 and ECDSA are checked.
+ */
+static bool signBlockHelperGetSignatureAlgorithm(uint32_t signature_algorithm, hashHelperAlgorithm *algorithm) {
+    switch (signature_algorithm) {
+        case 0x0103: // RSASSA-PKCS1-v1_5 with SHA2-256
+        case 0x0201: // ECDSA with SHA2-256
+            *algorithm = HASH_HELPER_SHA256;
+            return true;
+        case 0x0104: // RSASSA-PKCS1-v1_5 with SHA2-512
+        case 0x0202: // ECDSA with SHA2-512
+            *algorithm = HASH_HELPER_SHA512;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Checks the signatures of one signer over its signed data with the key of its first certificate,
+ * which has to be the public key the signer lists. Every supported signature has to match, at least one is needed.
+ */
+static int32_t signBlockHelperVerifySigner(const signBlock *block, const signBlockSigner *signer,
+                                           signBlockSpan *certificate) {
+    signBlockSpan certificates = signer->certificates;
+    signBlockSpan signatures = signer->signatures;
+    signBlockSpan item;
+    signBlockSpan signature;
+    x509HelperCertificate cert;
+    hashHelperAlgorithm algorithm;
+    hashHelperContext ctx;
+    unsigned char digest[HASH_HELPER_MAX_SIZE];
+    statsHelperTimer timer;
+    size_t checked = 0;
+
+    if (!signBlockHelperNextItem(block, &certificates, certificate)
+        || !x509HelperParse(block->data + certificate->offset, certificate->len, &cert)) {
+        NSV_LOGE("malformed certificate\n");
+        return MZ_FORMAT_ERROR;
+    }
+    const unsigned char *public_key = block->data + certificate->offset + cert.public_key.offset;
+    size_t public_key_len = (size_t) cert.public_key.header + cert.public_key.len;
+    if (signer->public_key.len != public_key_len
+        || memcmp(block->data + signer->public_key.offset, public_key, public_key_len) != 0) {
+        NSV_LOGE("the public key is not the one of the certificate\n");
+        return MZ_CRYPT_ERROR;
+    }
+    while (signBlockHelperNextItem(block, &signatures, &item)) {
+        if (item.len < 4
+            || !signBlockHelperGetSignatureAlgorithm(signBlockHelperGetUint32(block->data + item.offset), &algorithm)) {
+            continue;
+        }
+        item.offset += 4;
+        item.len -= 4;
+        if (!signBlockHelperNextItem(block, &item, &signature)) {
+            return MZ_FORMAT_ERROR;
+        }
+        hashHelperInit(&ctx, algorithm);
+        hashHelperUpdate(&ctx, block->data + signer->signed_data.offset, signer->signed_data.len);
+        hashHelperFinal(&ctx, digest);
+        statsHelperStart(&timer, STATS_HELPER_SIGNATURE);
+        bool verified = signatureHelperVerifyDigest(public_key, public_key_len, algorithm, digest,
+                                                    block->data + signature.offset, signature.len);
+        statsHelperStop(&timer, signature.len);
+        if (!verified) {
+            NSV_LOGE("the signature over the signed data does not match\n");
+            return MZ_CRYPT_ERROR;
+        }
+        checked++;
+    }
+    if (checked == 0) {
+        NSV_LOGE("no supported signature\n");
+        return MZ_FORMAT_ERROR;
+    }
+    return MZ_OK;
+}
+
+/**
+ * Checks the signature of every signer of scheme id (v2 or v3) over its signed data, which holds the
+ * content digests, with the key of its certificate. signer, if not NULL, receives the SHA-256 of the
+ * first certificate of the first signer, the one signBlockHelperGetCertificate() returns.
+ * Returns MZ_CRYPT_ERROR if a signature does not match, MZ_FORMAT_ERROR if a signer can't be checked.
+ */
+int32_t signBlockHelperVerifySigners(const signBlock *block, uint32_t id, unsigned char *signer) {
+    signBlockSigner signers[SIGN_BLOCK_MAX_SIGNERS];
+    signBlockSpan certificate;
+    size_t count = 0;
+
+    int32_t err = signBlockHelperGetSigners(block, id, signers, SIGN_BLOCK_MAX_SIGNERS, &count);
+    for (size_t i = 0; err == MZ_OK && i < count; i++) {
+        err = signBlockHelperVerifySigner(block, &signers[i], &certificate);
+        if (err == MZ_OK && i == 0 && NULL != signer) {
+            hashHelperSha256 sha256;
+            hashHelperSha256Init(&sha256);
+            hashHelperSha256Update(&sha256, block->data + certificate.offset, certificate.len);
+            hashHelperSha256Final(&sha256, signer);
+        }
+    }
+    return err;
+}
+
+/**
+ * Checks the signers of the v3 scheme and the APK contents against its content digests, v2 if there is
+ * no v3 block. signer, if not NULL, receives the SHA-256 of the certificate of the first signer on MZ_OK.
+ * Returns MZ_EXIST_ERROR if the APK is signed with v1 scheme only.
+ */
+int32_t signBlockHelperVerify(unzipHelperArchive *archive, unsigned char *signer) {
+    signBlock block;
+    int32_t err = signBlockHelperRead(archive, &block);
+    if (err != MZ_OK) {
+        return err;
+    }
+    uint32_t id = SIGN_BLOCK_ID_V3;
+    err = signBlockHelperVerifySigners(&block, id, signer);
+    if (err == MZ_EXIST_ERROR) {
+        id = SIGN_BLOCK_ID_V2;
+        err = signBlockHelperVerifySigners(&block, id, signer);
+    }
+    if (err == MZ_OK) {
+        err = signBlockHelperVerifyDigests(archive, &block, id);
+    }
+    signBlockHelperFree(&block);
+    return err;
+}
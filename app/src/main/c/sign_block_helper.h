@@ -0,0 +1,111 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef NATIVESIGNATUREVERIFICATION_SIGN_BLOCK_HELPER_H
+#define NATIVESIGNATUREVERIFICATION_SIGN_BLOCK_HELPER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "unzip_helper.h"
+#include "hash_helper.h"
+#include "thread_helper.h"
+#include "signature_helper.h"
+#include "x509_helper.h"
+#include "stats_helper.h"
+#include "def.h"
+
+// https://source.android.com/security/apksigning/v2#apk-signing-block
+#define SIGN_BLOCK_MAGIC            "APK Sig Block 42"
+#define SIGN_BLOCK_MAGIC_LEN        16
+#define SIGN_BLOCK_FOOTER_LEN       (8 + SIGN_BLOCK_MAGIC_LEN)
+
+#define SIGN_BLOCK_ID_V2            0x7109871a
+#define SIGN_BLOCK_ID_V3            0xf05368c0
+
+#define SIGN_BLOCK_MAX_SIGNERS      8
+
+// https://source.android.com/security/apksigning/v2#integrity-protected-contents
+#define SIGN_BLOCK_CHUNK_SIZE       (1024 * 1024)
+#define SIGN_BLOCK_CHUNK_PREFIX     0xa5
+#define SIGN_BLOCK_TOP_PREFIX       0x5a
+#define SIGN_BLOCK_EOCD_MAGIC       0x06054b50
+
+typedef struct signBlockSpan {
+    size_t offset;
+    size_t len;
+} signBlockSpan;
+
+/**
+ * The APK Signing Block found right in front of the central directory.
+ * data points either into the mapped APK or into buffer, spans below are offsets in data.
+ */
+typedef struct signBlock {
+    unsigned char *buffer;
+    const unsigned char *data;
+    size_t size;
+    uint64_t offset;
+    uint64_t cd_offset;
+    uint64_t cd_size;
+} signBlock;
+
+/**
+ * Parts of one signer of a v2/v3 scheme block, every span excludes its uint32 length prefix.
+ */
+typedef struct signBlockSigner {
+    signBlockSpan signed_data;
+    signBlockSpan digests;
+    signBlockSpan certificates;
+    signBlockSpan signatures;
+    signBlockSpan public_key;
+} signBlockSigner;
+
+
+int32_t signBlockHelperRead(unzipHelperArchive *archive, signBlock *block);
+
+void signBlockHelperFree(signBlock *block);
+
+int32_t signBlockHelperFindScheme(const signBlock *block, uint32_t id, signBlockSpan *value);
+
+int32_t signBlockHelperGetSigners(const signBlock *block, uint32_t id,
+                                  signBlockSigner *signers, size_t capacity, size_t *count);
+
+bool signBlockHelperNextItem(const signBlock *block, signBlockSpan *sequence, signBlockSpan *item);
+
+int32_t signBlockHelperGetCertificates(const signBlock *block, uint32_t id,
+                                       signBlockSpan *certificates, size_t capacity, size_t *count);
+
+unsigned char *signBlockHelperGetCertificate(unzipHelperArchive *archive, size_t *len, uint32_t *id);
+
+int32_t signBlockHelperVerifyDigests(unzipHelperArchive *archive, const signBlock *block, uint32_t id);
+
+int32_t signBlockHelperVerifySigners(const signBlock *block, uint32_t id, unsigned char *signer);
+
+int32_t signBlockHelperVerify(unzipHelperArchive *archive, unsigned char *signer);
+
+#endif //NATIVESIGNATUREVERIFICATION_SIGN_BLOCK_HELPER_H
@@ -0,0 +1,588 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include "signature_helper.h"
+
+/*subjectPublicKeyInfo : SEQUENCE
+*	algorithm : SEQUENCE {algorithm : ObjectIdentifier, parameters}   #rsaEncryption, NULL or ecPublicKey, named curve
+*	subjectPublicKey : BITSTRING
+*		RSA : SEQUENCE {modulus : INTEGER, publicExponent : INTEGER}
+*		EC : 04 || x || y
+*
+*RSA PKCS#1 v1.5, RFC 8017: signature^e mod n = 00 01 FF..FF 00 || DigestInfo
+*ECDSA, FIPS 186-4: signature = SEQUENCE {r : INTEGER, s : INTEGER}, the x of (e / s) * G + (r / s) * Q is r mod n
+*/
+
+#define P256_LIMBS      BIGNUM_HELPER_P256_LIMBS
+
+// 1.2.840.113549.1.1.1
+static const unsigned char RSA_ENCRYPTION_OID[] = {0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x01, 0x01};
+// 1.2.840.10045.2.1
+static const unsigned char EC_PUBLIC_KEY_OID[] = {0x2a, 0x86, 0x48, 0xce, 0x3d, 0x02, 0x01};
+// 1.2.840.10045.3.1.7
+static const unsigned char PRIME256V1_OID[] = {0x2a, 0x86, 0x48, 0xce, 0x3d, 0x03, 0x01, 0x07};
+// 1.2.840.113549.1.9.4
+static const unsigned char MESSAGE_DIGEST_OID[] = {0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x09, 0x04};
+// the arcs of the RSA signature algorithms, 1.2.840.113549.1.1, and of the ECDSA ones, 1.2.840.10045
+static const unsigned char PKCS1_ARC[] = {0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x01};
+static const unsigned char X962_ARC[] = {0x2a, 0x86, 0x48, 0xce, 0x3d};
+
+/**
+ * The digests a signerInfo may use: the OID of digestAlgorithmId and the DigestInfo header
+ * that precedes the digest in an RSA signature.
+ */
+static const struct {
+    hashHelperAlgorithm algorithm;
+    unsigned char oid_len;
+    unsigned char oid[9];
+    unsigned char prefix_len;
+    unsigned char prefix[19];
+} DIGESTS[] = {
+        {HASH_HELPER_SHA256, 9, {0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01},
+                19, {0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01,
+                     0x05, 0x00, 0x04, 0x20}},
+        {HASH_HELPER_SHA1,   5, {0x2b, 0x0e, 0x03, 0x02, 0x1a},
+                15, {0x30, 0x21, 0x30, 0x09, 0x06, 0x05, 0x2b, 0x0e, 0x03, 0x02, 0x1a, 0x05, 0x00, 0x04, 0x14}},
+        {HASH_HELPER_SHA512, 9, {0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x03},
+                19, {0x30, 0x51, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x03,
+                     0x05, 0x00, 0x04, 0x40}}
+};
+
+// NIST P-256, big-endian
+static const unsigned char P256_P[SIGNATURE_HELPER_P256_BYTES] = {
+        0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+static const unsigned char P256_N[SIGNATURE_HELPER_P256_BYTES] = {
+        0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xbc, 0xe6, 0xfa, 0xad, 0xa7, 0x17, 0x9e, 0x84, 0xf3, 0xb9, 0xca, 0xc2, 0xfc, 0x63, 0x25, 0x51};
+static const unsigned char P256_B[SIGNATURE_HELPER_P256_BYTES] = {
+        0x5a, 0xc6, 0x35, 0xd8, 0xaa, 0x3a, 0x93, 0xe7, 0xb3, 0xeb, 0xbd, 0x55, 0x76, 0x98, 0x86, 0xbc,
+        0x65, 0x1d, 0x06, 0xb0, 0xcc, 0x53, 0xb0, 0xf6, 0x3b, 0xce, 0x3c, 0x3e, 0x27, 0xd2, 0x60, 0x4b};
+static const unsigned char P256_GX[SIGNATURE_HELPER_P256_BYTES] = {
+        0x6b, 0x17, 0xd1, 0xf2, 0xe1, 0x2c, 0x42, 0x47, 0xf8, 0xbc, 0xe6, 0xe5, 0x63, 0xa4, 0x40, 0xf2,
+        0x77, 0x03, 0x7d, 0x81, 0x2d, 0xeb, 0x33, 0xa0, 0xf4, 0xa1, 0x39, 0x45, 0xd8, 0x98, 0xc2, 0x96};
+static const unsigned char P256_GY[SIGNATURE_HELPER_P256_BYTES] = {
+        0x4f, 0xe3, 0x42, 0xe2, 0xfe, 0x1a, 0x7f, 0x9b, 0x8e, 0xe7, 0xeb, 0x4a, 0x7c, 0x0f, 0x9e, 0x16,
+        0x2b, 0xce, 0x33, 0x57, 0x6b, 0x31, 0x5e, 0xce, 0xcb, 0xb6, 0x40, 0x68, 0x37, 0xbf, 0x51, 0xf5};
+
+static const derHelperStep PATH_KEY_ALGORITHM[] = {
+        {TAG_SEQUENCE, 0},  // subjectPublicKeyInfo
+        {TAG_SEQUENCE, 0},  // algorithm
+        {TAG_OBJECTID, 0}
+};
+
+static const derHelperStep PATH_KEY_PARAMETERS[] = {
+        {TAG_SEQUENCE,    0},
+        {TAG_SEQUENCE,    0},
+        {DER_HELPER_ANY,  1}    // NULL for RSA, the curve OID for EC
+};
+
+static const derHelperStep PATH_KEY[] = {
+        {TAG_SEQUENCE,  0},
+        {TAG_BITSTRING, 0}      // subjectPublicKey
+};
+
+static const derHelperStep PATH_FIRST_INTEGER[] = {
+        {TAG_SEQUENCE, 0},
+        {TAG_INTEGER,  0}       // modulus or r
+};
+
+static const derHelperStep PATH_SECOND_INTEGER[] = {
+        {TAG_SEQUENCE, 0},
+        {TAG_INTEGER,  1}       // publicExponent or s
+};
+
+/**
+ * A point of P-256 in Jacobian coordinates, x / z^2 and y / z^3, all of them in the Montgomery domain of p.
+ * z is 0 for the point at infinity.
+ */
+typedef struct signatureHelperPoint {
+    bignumHelperLimb x[P256_LIMBS];
+    bignumHelperLimb y[P256_LIMBS];
+    bignumHelperLimb z[P256_LIMBS];
+} signatureHelperPoint;
+
+
+static bool signatureHelperIs(const unsigned char *der, const derHelperToken *token, const unsigned char *oid,
+                              size_t oid_len) {
+    return token->len == oid_len && memcmp(der + token->offset + token->header, oid, oid_len) == 0;
+}
+
+static bool signatureHelperHasPrefix(const unsigned char *der, const derHelperToken *token,
+                                     const unsigned char *prefix, size_t prefix_len) {
+    return token->len > prefix_len && memcmp(der + token->offset + token->header, prefix, prefix_len) == 0;
+}
+
+/**
+ * Finds the OID of an AlgorithmIdentifier of der, the token points into der.
+ */
+static bool signatureHelperGetOid(const unsigned char *der, const derHelperToken *algorithm, derHelperToken *oid) {
+    derHelperToken tokens[SIGNATURE_HELPER_MAX_TOKENS];
+    const derHelperStep oid_step = {TAG_OBJECTID, 0};
+    size_t count = 0;
+
+    if (!derHelperTokenize(der + algorithm->offset, (size_t) algorithm->header + algorithm->len, 1, tokens,
+                           SIGNATURE_HELPER_MAX_TOKENS, &count)) {
+        return false;
+    }
+    int index = derHelperFind(tokens, count, 0, &oid_step, 1);
+    if (index < 0) {
+        return false;
+    }
+    *oid = tokens[index];
+    oid->offset += algorithm->offset;
+    return true;
+}
+
+static int signatureHelperFindDigest(hashHelperAlgorithm algorithm) {
+    for (size_t i = 0; i < sizeof(DIGESTS) / sizeof(DIGESTS[0]); i++) {
+        if (DIGESTS[i].algorithm == algorithm) {
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Checks an RSA PKCS#1 v1.5 signature: signature^e mod n has to be exactly the padded DigestInfo of digest.
+ */
+static bool signatureHelperVerifyRsa(const unsigned char *modulus, size_t modulus_len, const unsigned char *exponent,
+                                     size_t exponent_len, hashHelperAlgorithm algorithm, const unsigned char *digest,
+                                     const unsigned char *signature, size_t signature_len) {
+    bignumHelperModulus mod;
+    bignumHelperLimb s[BIGNUM_HELPER_MAX_LIMBS];
+    bignumHelperLimb m[BIGNUM_HELPER_MAX_LIMBS];
+    unsigned char expected[BIGNUM_HELPER_MAX_BITS / 8];
+    unsigned char em[BIGNUM_HELPER_MAX_BITS / 8];
+    int index = signatureHelperFindDigest(algorithm);
+
+    if (index < 0 || !bignumHelperInitModulus(&mod, modulus, modulus_len)) {
+        NSV_LOGW("unsupported RSA key\n");
+        return false;
+    }
+    size_t digest_len = hashHelperGetSize(algorithm);
+    size_t k = mod.bytes;
+    if (signature_len != k || k < DIGESTS[index].prefix_len + digest_len + 11
+        || !bignumHelperFromBytes(&mod, signature, signature_len, s) || bignumHelperCompare(&mod, s, mod.n) >= 0) {
+        NSV_LOGW("malformed RSA signature\n");
+        return false;
+    }
+    bignumHelperModExp(&mod, s, exponent, exponent_len, m);
+    bignumHelperToBytes(&mod, m, em);
+
+    size_t padding = k - 3 - DIGESTS[index].prefix_len - digest_len;
+    expected[0] = 0x00;
+    expected[1] = 0x01;
+    memset(expected + 2, 0xff, padding);
+    expected[2 + padding] = 0x00;
+    memcpy(expected + 3 + padding, DIGESTS[index].prefix, DIGESTS[index].prefix_len);
+    memcpy(expected + 3 + padding + DIGESTS[index].prefix_len, digest, digest_len);
+    return memcmp(em, expected, k) == 0;
+}
+
+/**
+ * Doubles a point, dbl-2001-b for a = -3. out may be in.
+ */
+static void signatureHelperDouble(const bignumHelperModulus *p, const signatureHelperPoint *in,
+                                  signatureHelperPoint *out) {
+    bignumHelperLimb delta[P256_LIMBS], gamma[P256_LIMBS], beta[P256_LIMBS], alpha[P256_LIMBS];
+    bignumHelperLimb t1[P256_LIMBS], t2[P256_LIMBS];
+
+    if (bignumHelperIsZero(p, in->z)) {
+        *out = *in;
+        return;
+    }
+    bignumHelperMontMul(p, in->z, in->z, delta);
+    bignumHelperMontMul(p, in->y, in->y, gamma);
+    bignumHelperMontMul(p, in->x, gamma, beta);
+    // alpha = 3 * (x - delta) * (x + delta)
+    bignumHelperModSub(p, in->x, delta, t1);
+    bignumHelperModAdd(p, in->x, delta, t2);
+    bignumHelperMontMul(p, t1, t2, alpha);
+    bignumHelperModAdd(p, alpha, alpha, t1);
+    bignumHelperModAdd(p, t1, alpha, alpha);
+    // z3 = (y + z)^2 - gamma - delta
+    bignumHelperModAdd(p, in->y, in->z, t1);
+    bignumHelperMontMul(p, t1, t1, t1);
+    bignumHelperModSub(p, t1, gamma, t1);
+    bignumHelperModSub(p, t1, delta, out->z);
+    // x3 = alpha^2 - 8 * beta
+    bignumHelperModAdd(p, beta, beta, beta);
+    bignumHelperModAdd(p, beta, beta, beta);
+    bignumHelperModAdd(p, beta, beta, t2);
+    bignumHelperMontMul(p, alpha, alpha, t1);
+    bignumHelperModSub(p, t1, t2, out->x);
+    // y3 = alpha * (4 * beta - x3) - 8 * gamma^2
+    bignumHelperModSub(p, beta, out->x, t1);
+    bignumHelperMontMul(p, alpha, t1, t1);
+    bignumHelperMontMul(p, gamma, gamma, t2);
+    bignumHelperModAdd(p, t2, t2, t2);
+    bignumHelperModAdd(p, t2, t2, t2);
+    bignumHelperModAdd(p, t2, t2, t2);
+    bignumHelperModSub(p, t1, t2, out->y);
+}
+
+/**
+ * Adds two points, add-2007-bl. out may be a or b.
+ */
+static void signatureHelperAdd(const bignumHelperModulus *p, const signatureHelperPoint *a,
+                               const signatureHelperPoint *b, signatureHelperPoint *out) {
+    bignumHelperLimb z1z1[P256_LIMBS], z2z2[P256_LIMBS], u1[P256_LIMBS], u2[P256_LIMBS], s1[P256_LIMBS];
+    bignumHelperLimb s2[P256_LIMBS], h[P256_LIMBS], r[P256_LIMBS], i[P256_LIMBS], j[P256_LIMBS], v[P256_LIMBS];
+    bignumHelperLimb t[P256_LIMBS];
+
+    if (bignumHelperIsZero(p, a->z)) {
+        *out = *b;
+        return;
+    }
+    if (bignumHelperIsZero(p, b->z)) {
+        *out = *a;
+        return;
+    }
+    bignumHelperMontMul(p, a->z, a->z, z1z1);
+    bignumHelperMontMul(p, b->z, b->z, z2z2);
+    bignumHelperMontMul(p, a->x, z2z2, u1);
+    bignumHelperMontMul(p, b->x, z1z1, u2);
+    bignumHelperMontMul(p, a->y, b->z, s1);
+    bignumHelperMontMul(p, s1, z2z2, s1);
+    bignumHelperMontMul(p, b->y, a->z, s2);
+    bignumHelperMontMul(p, s2, z1z1, s2);
+    bignumHelperModSub(p, u2, u1, h);
+    bignumHelperModSub(p, s2, s1, r);
+    bignumHelperModAdd(p, r, r, r);
+    if (bignumHelperIsZero(p, h)) {
+        if (bignumHelperIsZero(p, r)) {
+            signatureHelperDouble(p, a, out);
+        } else {
+            memset(out, 0, sizeof(signatureHelperPoint));
+        }
+        return;
+    }
+    // z3 = ((z1 + z2)^2 - z1z1 - z2z2) * h, before out overwrites a or b
+    bignumHelperModAdd(p, a->z, b->z, t);
+    bignumHelperMontMul(p, t, t, t);
+    bignumHelperModSub(p, t, z1z1, t);
+    bignumHelperModSub(p, t, z2z2, t);
+    bignumHelperMontMul(p, t, h, out->z);
+    // i = (2 * h)^2, j = h * i, v = u1 * i
+    bignumHelperModAdd(p, h, h, i);
+    bignumHelperMontMul(p, i, i, i);
+    bignumHelperMontMul(p, h, i, j);
+    bignumHelperMontMul(p, u1, i, v);
+    // x3 = r^2 - j - 2 * v
+    bignumHelperMontMul(p, r, r, t);
+    bignumHelperModSub(p, t, j, t);
+    bignumHelperModSub(p, t, v, t);
+    bignumHelperModSub(p, t, v, out->x);
+    // y3 = r * (v - x3) - 2 * s1 * j
+    bignumHelperModSub(p, v, out->x, t);
+    bignumHelperMontMul(p, r, t, t);
+    bignumHelperMontMul(p, s1, j, s1);
+    bignumHelperModAdd(p, s1, s1, s1);
+    bignumHelperModSub(p, t, s1, out->y);
+}
+
+/**
+ * Loads an affine point given as big-endian x and y, false if it is not on the curve.
+ */
+static bool signatureHelperLoadPoint(const bignumHelperModulus *p, const unsigned char *x, const unsigned char *y,
+                                     signatureHelperPoint *point) {
+    bignumHelperLimb b[P256_LIMBS], lhs[P256_LIMBS], rhs[P256_LIMBS], t[P256_LIMBS];
+
+    memset(point, 0, sizeof(signatureHelperPoint));
+    if (!bignumHelperFromBytes(p, x, SIGNATURE_HELPER_P256_BYTES, point->x)
+        || !bignumHelperFromBytes(p, y, SIGNATURE_HELPER_P256_BYTES, point->y)
+        || bignumHelperCompare(p, point->x, p->n) >= 0 || bignumHelperCompare(p, point->y, p->n) >= 0) {
+        return false;
+    }
+    bignumHelperToMont(p, point->x, point->x);
+    bignumHelperToMont(p, point->y, point->y);
+    point->z[0] = 1;
+    bignumHelperToMont(p, point->z, point->z);
+
+    // y^2 = x^3 - 3 * x + b
+    bignumHelperFromBytes(p, P256_B, SIGNATURE_HELPER_P256_BYTES, b);
+    bignumHelperToMont(p, b, b);
+    bignumHelperMontMul(p, point->y, point->y, lhs);
+    bignumHelperMontMul(p, point->x, point->x, rhs);
+    bignumHelperMontMul(p, rhs, point->x, rhs);
+    bignumHelperModAdd(p, point->x, point->x, t);
+    bignumHelperModAdd(p, t, point->x, t);
+    bignumHelperModSub(p, rhs, t, rhs);
+    bignumHelperModAdd(p, rhs, b, rhs);
+    return bignumHelperCompare(p, lhs, rhs) == 0;
+}
+
+/**
+ * Checks an ECDSA P-256 signature of digest by the public key 04 || x || y.
+ */
+static bool signatureHelperVerifyEcdsa(const unsigned char *key, size_t key_len, const unsigned char *digest,
+                                       size_t digest_len, const unsigned char *signature, size_t signature_len) {
+    derHelperToken tokens[SIGNATURE_HELPER_MAX_TOKENS];
+    bignumHelperModulus p, n;
+    bignumHelperLimb r[P256_LIMBS], s[P256_LIMBS], e[P256_LIMBS], w[P256_LIMBS], u1[P256_LIMBS], u2[P256_LIMBS];
+    bignumHelperLimb t[P256_LIMBS], zz[P256_LIMBS];
+    signatureHelperPoint table[4];
+    signatureHelperPoint acc;
+    size_t count = 0;
+
+    if (key_len != 1 + 2 * SIGNATURE_HELPER_P256_BYTES || key[0] != 0x04
+        || !derHelperTokenize(signature, signature_len, 1, tokens, SIGNATURE_HELPER_MAX_TOKENS, &count)) {
+        NSV_LOGW("malformed ECDSA key or signature\n");
+        return false;
+    }
+    int r_index = derHelperFind(tokens, count, -1, PATH_FIRST_INTEGER,
+                                sizeof(PATH_FIRST_INTEGER) / sizeof(PATH_FIRST_INTEGER[0]));
+    int s_index = derHelperFind(tokens, count, -1, PATH_SECOND_INTEGER,
+                                sizeof(PATH_SECOND_INTEGER) / sizeof(PATH_SECOND_INTEGER[0]));
+    bignumHelperInitModulus(&p, P256_P, SIGNATURE_HELPER_P256_BYTES);
+    bignumHelperInitModulus(&n, P256_N, SIGNATURE_HELPER_P256_BYTES);
+    if (r_index < 0 || s_index < 0
+        || !bignumHelperFromBytes(&n, signature + tokens[r_index].offset + tokens[r_index].header,
+                                  tokens[r_index].len, r)
+        || !bignumHelperFromBytes(&n, signature + tokens[s_index].offset + tokens[s_index].header,
+                                  tokens[s_index].len, s)
+        || bignumHelperIsZero(&n, r) || bignumHelperIsZero(&n, s)
+        || bignumHelperCompare(&n, r, n.n) >= 0 || bignumHelperCompare(&n, s, n.n) >= 0) {
+        NSV_LOGW("malformed ECDSA signature\n");
+        return false;
+    }
+    memset(&table[0], 0, sizeof(signatureHelperPoint));
+    if (!signatureHelperLoadPoint(&p, P256_GX, P256_GY, &table[1])
+        || !signatureHelperLoadPoint(&p, key + 1, key + 1 + SIGNATURE_HELPER_P256_BYTES, &table[2])) {
+        NSV_LOGW("the public key is not on P-256\n");
+        return false;
+    }
+    signatureHelperAdd(&p, &table[1], &table[2], &table[3]);
+
+    // e is the leftmost 256 bits of the digest, u1 = e / s and u2 = r / s mod n
+    bignumHelperFromBytes(&n, digest, digest_len < SIGNATURE_HELPER_P256_BYTES ? digest_len
+                                                                                : SIGNATURE_HELPER_P256_BYTES, e);
+    bignumHelperModInverse(&n, s, w);
+    bignumHelperToMont(&n, e, t);
+    bignumHelperMontMul(&n, t, w, u1);
+    bignumHelperToMont(&n, r, t);
+    bignumHelperMontMul(&n, t, w, u2);
+
+    // u1 * G + u2 * Q, both scalars at once
+    memset(&acc, 0, sizeof(acc));
+    for (size_t bit = P256_LIMBS * BIGNUM_HELPER_LIMB_BITS; bit > 0; bit--) {
+        size_t limb = (bit - 1) / BIGNUM_HELPER_LIMB_BITS;
+        size_t shift = (bit - 1) % BIGNUM_HELPER_LIMB_BITS;
+        unsigned index = ((u1[limb] >> shift) & 1) | (((u2[limb] >> shift) & 1) << 1);
+        signatureHelperDouble(&p, &acc, &acc);
+        if (index != 0) {
+            signatureHelperAdd(&p, &acc, &table[index], &acc);
+        }
+    }
+    if (bignumHelperIsZero(&p, acc.z)) {
+        return false;
+    }
+
+    // x / z^2 mod n = r, x being below p the candidates are r and r + n: compare r * z^2 with x
+    bignumHelperMontMul(&p, acc.z, acc.z, zz);
+    bignumHelperToMont(&p, r, t);
+    bignumHelperMontMul(&p, t, zz, t);
+    if (bignumHelperCompare(&p, t, acc.x) == 0) {
+        return true;
+    }
+    bignumHelperModAdd(&p, r, n.n, t);
+    if (bignumHelperCompare(&p, t, r) < 0) {
+        // r + n wrapped around p
+        return false;
+    }
+    bignumHelperToMont(&p, t, t);
+    bignumHelperMontMul(&p, t, zz, t);
+    return bignumHelperCompare(&p, t, acc.x) == 0;
+}
+
+/**
+ * Checks signature over digest with public_key, a DER subjectPublicKeyInfo.
+ * RSA keys of up to BIGNUM_HELPER_MAX_BITS bits with PKCS#1 v1.5 signatures and P-256 keys are supported.
+ */
+bool signatureHelperVerifyDigest(const unsigned char *public_key, size_t len, hashHelperAlgorithm algorithm,
+                                 const unsigned char *digest, const unsigned char *signature, size_t signature_len) {
+    derHelperToken tokens[SIGNATURE_HELPER_MAX_TOKENS];
+    derHelperToken key_tokens[SIGNATURE_HELPER_MAX_TOKENS];
+    size_t count = 0;
+    size_t key_count = 0;
+
+    if (!derHelperTokenize(public_key, len, SIGNATURE_HELPER_DEPTH, tokens, SIGNATURE_HELPER_MAX_TOKENS, &count)) {
+        return false;
+    }
+    int algorithm_index = derHelperFind(tokens, count, -1, PATH_KEY_ALGORITHM,
+                                        sizeof(PATH_KEY_ALGORITHM) / sizeof(PATH_KEY_ALGORITHM[0]));
+    int parameters = derHelperFind(tokens, count, -1, PATH_KEY_PARAMETERS,
+                                   sizeof(PATH_KEY_PARAMETERS) / sizeof(PATH_KEY_PARAMETERS[0]));
+    int key_index = derHelperFind(tokens, count, -1, PATH_KEY, sizeof(PATH_KEY) / sizeof(PATH_KEY[0]));
+    if (algorithm_index < 0 || key_index < 0 || tokens[key_index].len < 1
+        || public_key[tokens[key_index].offset + tokens[key_index].header] != 0) {
+        NSV_LOGW("malformed public key\n");
+        return false;
+    }
+    // the BITSTRING starts with the count of unused bits, 0
+    const unsigned char *key = public_key + tokens[key_index].offset + tokens[key_index].header + 1;
+    size_t key_len = tokens[key_index].len - 1;
+
+    if (signatureHelperIs(public_key, &tokens[algorithm_index], RSA_ENCRYPTION_OID, sizeof(RSA_ENCRYPTION_OID))) {
+        if (!derHelperTokenize(key, key_len, 1, key_tokens, SIGNATURE_HELPER_MAX_TOKENS, &key_count)) {
+            return false;
+        }
+        int modulus = derHelperFind(key_tokens, key_count, -1, PATH_FIRST_INTEGER,
+                                    sizeof(PATH_FIRST_INTEGER) / sizeof(PATH_FIRST_INTEGER[0]));
+        int exponent = derHelperFind(key_tokens, key_count, -1, PATH_SECOND_INTEGER,
+                                     sizeof(PATH_SECOND_INTEGER) / sizeof(PATH_SECOND_INTEGER[0]));
+        if (modulus < 0 || exponent < 0) {
+            NSV_LOGW("malformed RSA key\n");
+            return false;
+        }
+        return signatureHelperVerifyRsa(key + key_tokens[modulus].offset + key_tokens[modulus].header,
+                                        key_tokens[modulus].len,
+                                        key + key_tokens[exponent].offset + key_tokens[exponent].header,
+                                        key_tokens[exponent].len, algorithm, digest, signature, signature_len);
+    }
+    if (signatureHelperIs(public_key, &tokens[algorithm_index], EC_PUBLIC_KEY_OID, sizeof(EC_PUBLIC_KEY_OID))
+        && parameters >= 0 && signatureHelperIs(public_key, &tokens[parameters], PRIME256V1_OID,
+                                                sizeof(PRIME256V1_OID))) {
+        return signatureHelperVerifyEcdsa(key, key_len, digest, hashHelperGetSize(algorithm), signature,
+                                          signature_len);
+    }
+    NSV_LOGW("unsupported public key\n");
+    return false;
+}
+
+/**
+ * Checks one signerInfo over content: the signature covers the digest of content or, if there are
+ * authenticatedAttributes, the digest of those, which carry the digest of content as messageDigest.
+ */
+static int32_t signatureHelperVerifySignerInfo(const unsigned char *certrsa, const pkcs7HelperContents *contents,
+                                               const pkcs7HelperSpan *span, const unsigned char *content,
+                                               size_t content_len, pkcs7HelperSpan *signer_span) {
+    const unsigned char *signer_info = certrsa + span->offset;
+    unsigned char digest[HASH_HELPER_MAX_SIZE];
+    pkcs7HelperSignerInfo info;
+    x509HelperCertificate cert;
+    hashHelperContext ctx;
+    statsHelperTimer timer;
+    int index = -1;
+
+    if (!pkcs7HelperParseSignerInfo(signer_info, span->len, &info)) {
+        return MZ_FORMAT_ERROR;
+    }
+    derHelperToken digest_oid;
+    if (signatureHelperGetOid(signer_info, &info.digest_algorithm, &digest_oid)) {
+        for (size_t i = 0; i < sizeof(DIGESTS) / sizeof(DIGESTS[0]); i++) {
+            if (signatureHelperIs(signer_info, &digest_oid, DIGESTS[i].oid, DIGESTS[i].oid_len)) {
+                index = (int) i;
+                break;
+            }
+        }
+    }
+    if (index < 0) {
+        NSV_LOGW("unsupported digest algorithm\n");
+        return MZ_FORMAT_ERROR;
+    }
+    const pkcs7HelperSpan *signer = pkcs7HelperFindSigner(certrsa, contents, signer_info, &info, &cert);
+    if (NULL == signer) {
+        NSV_LOGW("the certificate of the signer is missing\n");
+        return MZ_FORMAT_ERROR;
+    }
+    const unsigned char *certificate = certrsa + signer->offset;
+    // the key decides how the signature is checked, digestEncryptionAlgorithmId only has to be RSA or ECDSA
+    derHelperToken encryption_oid;
+    if (!signatureHelperGetOid(signer_info, &info.digest_encryption_algorithm, &encryption_oid)) {
+        return MZ_FORMAT_ERROR;
+    }
+    bool rsa = signatureHelperHasPrefix(signer_info, &encryption_oid, PKCS1_ARC, sizeof(PKCS1_ARC));
+    bool ecdsa = signatureHelperHasPrefix(signer_info, &encryption_oid, X962_ARC, sizeof(X962_ARC));
+    if (!rsa && !ecdsa) {
+        NSV_LOGW("unsupported signature algorithm\n");
+        return MZ_FORMAT_ERROR;
+    }
+
+    hashHelperAlgorithm algorithm = DIGESTS[index].algorithm;
+    size_t digest_len = hashHelperGetSize(algorithm);
+    hashHelperInit(&ctx, algorithm);
+    hashHelperUpdate(&ctx, content, content_len);
+    hashHelperFinal(&ctx, digest);
+    if (info.authenticated_attributes.tag != 0) {
+        derHelperToken message_digest;
+        if (!pkcs7HelperFindAttribute(signer_info, &info.authenticated_attributes, MESSAGE_DIGEST_OID,
+                                      sizeof(MESSAGE_DIGEST_OID), &message_digest)
+            || message_digest.tag != TAG_OCTETSTRING || message_digest.len != digest_len
+            || memcmp(signer_info + message_digest.offset + message_digest.header, digest, digest_len) != 0) {
+            NSV_LOGW("messageDigest does not match\n");
+            return MZ_CRYPT_ERROR;
+        }
+        // the attributes are signed as the SET OF they are, not with their [0] IMPLICIT tag
+        const unsigned char set_tag = TAG_SET;
+        hashHelperInit(&ctx, algorithm);
+        hashHelperUpdate(&ctx, &set_tag, 1);
+        hashHelperUpdate(&ctx, signer_info + info.authenticated_attributes.offset + 1,
+                         (size_t) info.authenticated_attributes.header + info.authenticated_attributes.len - 1);
+        hashHelperFinal(&ctx, digest);
+    }
+    const unsigned char *signature = signer_info + info.encrypted_digest.offset + info.encrypted_digest.header;
+    statsHelperStart(&timer, STATS_HELPER_SIGNATURE);
+    bool verified = signatureHelperVerifyDigest(certificate + cert.public_key.offset,
+                                                (size_t) cert.public_key.header + cert.public_key.len, algorithm,
+                                                digest, signature, info.encrypted_digest.len);
+    statsHelperStop(&timer, info.encrypted_digest.len);
+    if (!verified) {
+        NSV_LOGW("the signature does not match\n");
+        return MZ_CRYPT_ERROR;
+    }
+    *signer_span = *signer;
+    return MZ_OK;
+}
+
+/**
+ * Checks every signerInfo of the PKCS#7 signedData certrsa, e.g. META-INF/CERT.RSA, over content,
+ * e.g. META-INF/CERT.SF, with the certificate it names. Returns MZ_OK if all of them match,
+ * MZ_CRYPT_ERROR if one does not and MZ_FORMAT_ERROR if one can't be checked.
+ * On MZ_OK signer, if not NULL, is set to the certificate the first signerInfo was checked with.
+ */
+int32_t signatureHelperVerifySignedData(const unsigned char *certrsa, size_t len, const unsigned char *content,
+                                        size_t content_len, pkcs7HelperSpan *signer) {
+    derHelperToken tokens[PKCS7_HELPER_MAX_TOKENS];
+    pkcs7HelperContext pkcs7;
+    pkcs7HelperContents contents;
+    pkcs7HelperSpan first;
+    pkcs7HelperSpan span;
+
+    pkcs7HelperInit(&pkcs7, tokens, PKCS7_HELPER_MAX_TOKENS);
+    if (!pkcs7HelperGetContents(&pkcs7, certrsa, len, &contents) || contents.signer_info_count == 0) {
+        return MZ_FORMAT_ERROR;
+    }
+    for (size_t i = 0; i < contents.signer_info_count; i++) {
+        int32_t err = signatureHelperVerifySignerInfo(certrsa, &contents, &contents.signer_infos[i], content,
+                                                      content_len, i == 0 ? &first : &span);
+        if (err != MZ_OK) {
+            return err;
+        }
+    }
+    if (NULL != signer) {
+        *signer = first;
+    }
+    return MZ_OK;
+}
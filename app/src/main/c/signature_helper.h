@@ -0,0 +1,52 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef NATIVESIGNATUREVERIFICATION_SIGNATURE_HELPER_H
+#define NATIVESIGNATUREVERIFICATION_SIGNATURE_HELPER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "third/minizip/mz.h"
+#include "pkcs7_helper.h"
+#include "x509_helper.h"
+#include "hash_helper.h"
+#include "bignum_helper.h"
+#include "stats_helper.h"
+#include "def.h"
+
+// subjectPublicKeyInfo/subjectPublicKey, RSAPublicKey/modulus and ECDSA-Sig-Value/r
+#define SIGNATURE_HELPER_DEPTH      2
+#define SIGNATURE_HELPER_MAX_TOKENS 16
+#define SIGNATURE_HELPER_P256_BYTES 32
+
+
+bool signatureHelperVerifyDigest(const unsigned char *public_key, size_t len, hashHelperAlgorithm algorithm,
+                                 const unsigned char *digest, const unsigned char *signature, size_t signature_len);
+
+int32_t signatureHelperVerifySignedData(const unsigned char *certrsa, size_t len, const unsigned char *content,
+                                        size_t content_len, pkcs7HelperSpan *signer);
+
+#endif //NATIVESIGNATUREVERIFICATION_SIGNATURE_HELPER_H
@@ -0,0 +1,143 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+/*
+ * Checks every APK of an App Bundle install, base.apk and its split APKs, each on a thread of its own.
+ * A split is verified like the base: its contents against the v3/v2 content digest, or against its v1
+ * signature when it has no APK Signing Block. Its signer has to be the one of base.apk, like the
+ * package manager requires it.
+ */
+
+#include "split_helper.h"
+
+
+typedef struct splitHelperJob {
+    const pathHelperMapping *mappings;
+    splitHelperResult *results;
+} splitHelperJob;
+
+
+static uint64_t splitHelperNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * Takes the signer of the APK and checks its contents: the v3/v2 content digest, the v1 signature otherwise.
+ */
+static int32_t splitHelperCheck(unzipHelperArchive *archive, splitHelperResult *result) {
+    size_t len = 0;
+    uint32_t id = 0;
+    unsigned char *certificate = signBlockHelperGetCertificate(archive, &len, &id);
+    if (NULL != certificate) {
+        result->scheme = id;
+        free(certificate);
+        return signBlockHelperVerify(archive, result->signer);
+    }
+
+    // the signer is the certificate the v1 signature was checked with
+    jarHelperReport jar;
+    int32_t err = jarHelperVerify(archive, &jar);
+    if (err != MZ_EXIST_ERROR) {
+        result->scheme = SPLIT_HELPER_SCHEME_V1;
+        memcpy(result->signer, jar.signer, sizeof(result->signer));
+    }
+    return err;
+}
+
+static void splitHelperVerifyOne(void *ctx, size_t index, size_t worker) {
+    splitHelperJob *job = ctx;
+    const pathHelperMapping *mapping = &job->mappings[index];
+    splitHelperResult *result = &job->results[index];
+    unzipHelperArchive archive;
+    struct stat st;
+    uint64_t start = splitHelperNow();
+    (void) worker;
+
+    result->path = mapping->path;
+    int32_t err = MZ_STREAM_ERROR;
+    if (NULL != mapping->base) {
+        err = unzipHelperOpenMemory(&archive, mapping->base, mapping->size);
+    }
+    if (err != MZ_OK) {
+        err = unzipHelperOpen(&archive, mapping->path);
+    }
+    if (err == MZ_OK) {
+        err = splitHelperCheck(&archive, result);
+        unzipHelperClose(&archive);
+    }
+    if (NULL != mapping->base) {
+        result->bytes = mapping->size;
+    } else if (stat(mapping->path, &st) == 0) {
+        result->bytes = (uint64_t) st.st_size;
+    }
+    result->err = err;
+    result->nanos = splitHelperNow() - start;
+    NSV_LOGI("split %s: %d in %" PRIu64 " ns\n", mapping->path, err, result->nanos);
+}
+
+/**
+ * Verifies the APKs of mappings (see pathHelperGetMappings()) all at once, one worker each as far as the cores go,
+ * so the check takes about as long as the slowest of them rather than their sum. The content digests of every APK
+ * are computed on the same pool, by whichever threads are idle. Every signer has to be the one of mappings[0], base.apk.
+ * Returns MZ_OK when every APK is fine, the error of the first one that is not otherwise:
+ * MZ_CRYPT_ERROR for a signer other than the one of base.apk, MZ_EXIST_ERROR for no APK at all.
+ * report is filled in either way, free it with splitHelperFreeReport().
+ */
+int32_t splitHelperVerify(const pathHelperMapping *mappings, size_t count, splitHelperReport *report) {
+    uint64_t start = splitHelperNow();
+    memset(report, 0, sizeof(splitHelperReport));
+    if (count == 0) {
+        return MZ_EXIST_ERROR;
+    }
+    report->results = statsHelperCalloc(count, sizeof(splitHelperResult));
+    if (NULL == report->results) {
+        return MZ_MEM_ERROR;
+    }
+    report->count = count;
+
+    splitHelperJob job = {mappings, report->results};
+    threadHelperRun(splitHelperVerifyOne, &job, count, count);
+
+    int32_t err = MZ_OK;
+    const splitHelperResult *base = &report->results[0];
+    for (size_t i = 0; i < count; i++) {
+        splitHelperResult *result = &report->results[i];
+        if (result->err == MZ_OK && i > 0 && base->scheme != 0 && memcmp(result->signer, base->signer, sizeof(base->signer)) != 0) {
+            NSV_LOGW("split %s is signed by another certificate\n", result->path);
+            result->err = MZ_CRYPT_ERROR;
+        }
+        if (result->err != MZ_OK) {
+            report->failed++;
+            err = err == MZ_OK ? result->err : err;
+        }
+    }
+    report->nanos = splitHelperNow() - start;
+    return err;
+}
+
+void splitHelperFreeReport(splitHelperReport *report) {
+    free(report->results);
+    memset(report, 0, sizeof(splitHelperReport));
+}
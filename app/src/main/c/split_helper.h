@@ -0,0 +1,76 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef NATIVESIGNATUREVERIFICATION_SPLIT_HELPER_H
+#define NATIVESIGNATUREVERIFICATION_SPLIT_HELPER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "path_helper.h"
+#include "unzip_helper.h"
+#include "sign_block_helper.h"
+#include "jar_helper.h"
+#include "pkcs7_helper.h"
+#include "hash_helper.h"
+#include "thread_helper.h"
+#include "stats_helper.h"
+#include "def.h"
+
+// scheme of an APK that has no APK Signing Block and was checked against its v1 signature
+#define SPLIT_HELPER_SCHEME_V1      1
+
+/**
+ * How one APK of the package was checked. err is MZ_OK when its contents match its signature and its
+ * signer is the one of the first APK (base.apk). scheme is SIGN_BLOCK_ID_V3/V2, SPLIT_HELPER_SCHEME_V1
+ * or 0 when no signer was found, signer is the SHA-256 of the certificate then.
+ */
+typedef struct splitHelperResult {
+    const char *path;
+    int32_t err;
+    uint32_t scheme;
+    unsigned char signer[HASH_HELPER_SHA256_SIZE];
+    uint64_t bytes;
+    uint64_t nanos;
+} splitHelperResult;
+
+/**
+ * What splitHelperVerify() has checked: results holds count entries in the order of the mappings,
+ * nanos is the time the whole check took, which is about the time of the slowest APK.
+ */
+typedef struct splitHelperReport {
+    size_t count;
+    size_t failed;
+    uint64_t nanos;
+    splitHelperResult *results;
+} splitHelperReport;
+
+
+int32_t splitHelperVerify(const pathHelperMapping *mappings, size_t count, splitHelperReport *report);
+
+void splitHelperFreeReport(splitHelperReport *report);
+
+#endif //NATIVESIGNATUREVERIFICATION_SPLIT_HELPER_H
@@ -0,0 +1,152 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+/*
+ * Always-on counters of where the verification spends its time and its memory, unlike NSV_LOG* they stay
+ * in release builds. A measured stage costs two clock_gettime() and a few relaxed atomic adds.
+ * An allocation is counted for the stage running on the thread making it: the ones of this library,
+ * of minizip (MZ_CUSTOM_ALLOC) and of zlib inflating for minizip.
+ */
+
+#include "stats_helper.h"
+
+
+typedef struct statsHelperCounters {
+    uint64_t count;
+    uint64_t nanos;
+    uint64_t max_nanos;
+    uint64_t bytes;
+    uint64_t allocations;
+    uint64_t allocated;
+    uint64_t buckets[STATS_HELPER_BUCKETS];
+} statsHelperCounters;
+
+static const char *const stageNames[STATS_HELPER_STAGE_COUNT] = {
+        "path", "zip_open", "cd_scan", "inflate", "asn1_parse", "digest", "signature"
+};
+
+// one slot per stage, the last one takes the allocations made outside any stage
+static statsHelperCounters counters[STATS_HELPER_STAGE_COUNT + 1];
+
+// the stage running on this thread, STATS_HELPER_STAGE_COUNT when there is none
+static __thread int currentStage = STATS_HELPER_STAGE_COUNT;
+
+
+uint64_t statsHelperNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+void statsHelperStart(statsHelperTimer *timer, statsHelperStage stage) {
+    timer->stage = stage;
+    timer->outer = currentStage;
+    currentStage = stage;
+    timer->start = statsHelperNow();
+}
+
+static size_t statsHelperGetBucket(uint64_t nanos) {
+    uint64_t units = nanos >> STATS_HELPER_FIRST_BUCKET_SHIFT;
+    size_t bucket = units == 0 ? 0 : (size_t) (64 - __builtin_clzll(units));
+    return bucket < STATS_HELPER_BUCKETS ? bucket : STATS_HELPER_BUCKETS - 1;
+}
+
+/**
+ * Ends the measurement started by statsHelperStart(), bytes is what the stage has processed.
+ */
+void statsHelperStop(const statsHelperTimer *timer, uint64_t bytes) {
+    uint64_t nanos = statsHelperNow() - timer->start;
+    statsHelperCounters *stage = &counters[timer->stage];
+
+    currentStage = timer->outer;
+    __atomic_fetch_add(&stage->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stage->nanos, nanos, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stage->bytes, bytes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stage->buckets[statsHelperGetBucket(nanos)], 1, __ATOMIC_RELAXED);
+    uint64_t max = __atomic_load_n(&stage->max_nanos, __ATOMIC_RELAXED);
+    while (nanos > max && !__atomic_compare_exchange_n(&stage->max_nanos, &max, nanos, false,
+                                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static void *statsHelperCount(void *ptr, size_t size) {
+    if (NULL != ptr) {
+        statsHelperCounters *stage = &counters[currentStage];
+        __atomic_fetch_add(&stage->allocations, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&stage->allocated, size, __ATOMIC_RELAXED);
+    }
+    return ptr;
+}
+
+/**
+ * malloc(), calloc() and realloc() counted for the stage running on the calling thread, the memory is released by free().
+ */
+void *statsHelperMalloc(size_t size) {
+    return statsHelperCount(malloc(size), size);
+}
+
+void *statsHelperCalloc(size_t count, size_t size) {
+    return statsHelperCount(calloc(count, size), count * size);
+}
+
+void *statsHelperRealloc(void *ptr, size_t size) {
+    return statsHelperCount(realloc(ptr, size), size);
+}
+
+static int64_t statsHelperRead(uint64_t *counter, bool reset) {
+    return (int64_t) (reset ? __atomic_exchange_n(counter, 0, __ATOMIC_RELAXED)
+                            : __atomic_load_n(counter, __ATOMIC_RELAXED));
+}
+
+/**
+ * Copies the counters into values in the STATS_HELPER_HEADER_FIELDS/STATS_HELPER_STAGE_FIELDS layout and
+ * zeroes them if reset is set, so that every snapshot holds what has happened since the previous one.
+ * Stages finishing meanwhile may be split across two snapshots. Returns the number of values, 0 if capacity is short.
+ */
+size_t statsHelperSnapshot(int64_t *values, size_t capacity, bool reset) {
+    if (capacity < STATS_HELPER_SNAPSHOT_SIZE) {
+        return 0;
+    }
+    values[0] = STATS_HELPER_STAGE_COUNT;
+    values[1] = STATS_HELPER_STAGE_FIELDS;
+    values[2] = statsHelperRead(&counters[STATS_HELPER_STAGE_COUNT].allocations, reset);
+    values[3] = statsHelperRead(&counters[STATS_HELPER_STAGE_COUNT].allocated, reset);
+    for (size_t i = 0; i < STATS_HELPER_STAGE_COUNT; i++) {
+        statsHelperCounters *stage = &counters[i];
+        int64_t *out = values + STATS_HELPER_HEADER_FIELDS + i * STATS_HELPER_STAGE_FIELDS;
+        out[0] = statsHelperRead(&stage->count, reset);
+        out[1] = statsHelperRead(&stage->nanos, reset);
+        out[2] = statsHelperRead(&stage->max_nanos, reset);
+        out[3] = statsHelperRead(&stage->bytes, reset);
+        out[4] = statsHelperRead(&stage->allocations, reset);
+        out[5] = statsHelperRead(&stage->allocated, reset);
+        for (size_t b = 0; b < STATS_HELPER_BUCKETS; b++) {
+            out[6 + b] = statsHelperRead(&stage->buckets[b], reset);
+        }
+    }
+    return STATS_HELPER_SNAPSHOT_SIZE;
+}
+
+const char *statsHelperGetStageName(statsHelperStage stage) {
+    return stage < STATS_HELPER_STAGE_COUNT ? stageNames[stage] : "unknown";
+}
@@ -0,0 +1,86 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef NATIVESIGNATUREVERIFICATION_STATS_HELPER_H
+#define NATIVESIGNATUREVERIFICATION_STATS_HELPER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "def.h"
+
+// latency histogram: bucket i counts the durations below 1024 << i ns, the last one everything longer
+#define STATS_HELPER_BUCKETS            20
+#define STATS_HELPER_FIRST_BUCKET_SHIFT 10
+
+// statsHelperSnapshot(): {stages, fields per stage, allocations and bytes allocated outside any stage},
+// then count, nanoseconds, longest nanoseconds, bytes, allocations, bytes allocated and the histogram of every stage
+#define STATS_HELPER_HEADER_FIELDS      4
+#define STATS_HELPER_STAGE_FIELDS       (6 + STATS_HELPER_BUCKETS)
+#define STATS_HELPER_SNAPSHOT_SIZE      (STATS_HELPER_HEADER_FIELDS + STATS_HELPER_STAGE_COUNT * STATS_HELPER_STAGE_FIELDS)
+
+/**
+ * The measured stages, their order is the order of the snapshot.
+ * Stages may nest, the time of a stage includes the time of the stages it has called.
+ */
+typedef enum statsHelperStage {
+    STATS_HELPER_PATH = 0,      // finding the APK (and its splits) in /proc/self/maps
+    STATS_HELPER_ZIP_OPEN,      // opening the archive, the end of central directory included
+    STATS_HELPER_CD_SCAN,       // walking the central directory, bytes is its size
+    STATS_HELPER_INFLATE,       // reading entries: signature files, v1 entries while they are hashed
+    STATS_HELPER_ASN1_PARSE,    // tokenizing PKCS#7, signer infos and certificates
+    STATS_HELPER_DIGEST,        // the v2/v3 content digest
+    STATS_HELPER_SIGNATURE,     // RSA/ECDSA signature checks
+    STATS_HELPER_STAGE_COUNT
+} statsHelperStage;
+
+/**
+ * A running measurement, on the stack of the thread that has started it.
+ */
+typedef struct statsHelperTimer {
+    uint64_t start;
+    int stage;
+    int outer;
+} statsHelperTimer;
+
+
+uint64_t statsHelperNow();
+
+void statsHelperStart(statsHelperTimer *timer, statsHelperStage stage);
+
+void statsHelperStop(const statsHelperTimer *timer, uint64_t bytes);
+
+void *statsHelperMalloc(size_t size);
+
+void *statsHelperCalloc(size_t count, size_t size);
+
+void *statsHelperRealloc(void *ptr, size_t size);
+
+size_t statsHelperSnapshot(int64_t *values, size_t capacity, bool reset);
+
+const char *statsHelperGetStageName(statsHelperStage stage);
+
+#endif //NATIVESIGNATUREVERIFICATION_STATS_HELPER_H
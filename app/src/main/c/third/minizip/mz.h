@@ -46,6 +46,7 @@ extern "C" {
 #define MZ_OPEN_MODE_APPEND             (0x04)
 #define MZ_OPEN_MODE_CREATE             (0x08)
 #define MZ_OPEN_MODE_EXISTING           (0x10)
+#define MZ_OPEN_MODE_LOAD_CD            (0x20)  // zip read mode: the central dir is read at once
 
 // MZ_SEEK
 #define MZ_SEEK_SET                     (0)
@@ -96,6 +97,10 @@ extern "C" {
 
 #ifndef MZ_CUSTOM_ALLOC
 #define MZ_ALLOC(SIZE)                  (malloc(SIZE))
+#else
+// MZ_CUSTOM_ALLOC names a malloc() replacement, the memory is still released by free()
+extern void *MZ_CUSTOM_ALLOC(size_t size);
+#define MZ_ALLOC(SIZE)                  (MZ_CUSTOM_ALLOC(SIZE))
 #endif
 #ifndef MZ_CUSTOM_FREE
 #define MZ_FREE(PTR)                    (free(PTR))
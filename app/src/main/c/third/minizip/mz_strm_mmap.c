@@ -0,0 +1,254 @@
+/* mz_strm_mmap.c -- Stream for read-only memory-mapped file access
+   Version 2.3.3, June 10, 2018
+   part of the MiniZip project
+
+   Copyright (C) 2010-2018 Nathan Moinvaziri
+     https://github.com/nmoinvaz/minizip
+
+   This program is distributed under the terms of the same license as zlib.
+   See the accompanying LICENSE file for the full text of the license.
+
+   The file is mapped once when it is opened, reads and seeks are served from the
+   mapping without a system call, and mz_stream_mmap_get_buffer_at lends a pointer
+   into it so that nothing needs to be copied at all. The file must not shrink while
+   it is mapped, reading the pages past its end would raise SIGBUS.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mz.h"
+#include "mz_strm.h"
+#include "mz_strm_mmap.h"
+
+/***************************************************************************/
+
+static mz_stream_vtbl mz_stream_mmap_vtbl = {
+    mz_stream_mmap_open,
+    mz_stream_mmap_is_open,
+    mz_stream_mmap_read,
+    mz_stream_mmap_write,
+    mz_stream_mmap_tell,
+    mz_stream_mmap_seek,
+    mz_stream_mmap_close,
+    mz_stream_mmap_error,
+    mz_stream_mmap_create,
+    mz_stream_mmap_delete,
+    NULL,
+    NULL
+};
+
+/***************************************************************************/
+
+typedef struct mz_stream_mmap_s
+{
+    mz_stream   stream;
+    int32_t     error;
+    int32_t     opened;
+    uint8_t     *buffer;    // the mapping, NULL for an empty file
+    int64_t     size;       // of the file
+    int64_t     position;   // current position in the file
+} mz_stream_mmap;
+
+/***************************************************************************/
+
+int32_t mz_stream_mmap_open(void *stream, const char *path, int32_t mode)
+{
+    mz_stream_mmap *mmap_stream = (mz_stream_mmap *)stream;
+    struct stat st;
+    void *buffer = NULL;
+    int fd = -1;
+
+    if (path == NULL || (mode & MZ_OPEN_MODE_READWRITE) != MZ_OPEN_MODE_READ)
+        return MZ_STREAM_ERROR;
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        mmap_stream->error = errno;
+        return MZ_STREAM_ERROR;
+    }
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || (uint64_t)st.st_size > SIZE_MAX)
+    {
+        mmap_stream->error = (errno != 0) ? errno : EINVAL;
+        close(fd);
+        return MZ_STREAM_ERROR;
+    }
+    // an empty file can't be mapped, it reads as end of file right away
+    if (st.st_size > 0)
+    {
+        buffer = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (buffer == MAP_FAILED)
+        {
+            mmap_stream->error = errno;
+            close(fd);
+            return MZ_STREAM_ERROR;
+        }
+    }
+    // the mapping keeps the file, the descriptor is not needed any more
+    close(fd);
+
+    mmap_stream->buffer = (uint8_t *)buffer;
+    mmap_stream->size = (int64_t)st.st_size;
+    mmap_stream->position = 0;
+    mmap_stream->opened = 1;
+    return MZ_OK;
+}
+
+int32_t mz_stream_mmap_is_open(void *stream)
+{
+    mz_stream_mmap *mmap_stream = (mz_stream_mmap *)stream;
+    if (!mmap_stream->opened)
+        return MZ_STREAM_ERROR;
+    return MZ_OK;
+}
+
+int32_t mz_stream_mmap_read(void *stream, void *buf, int32_t size)
+{
+    mz_stream_mmap *mmap_stream = (mz_stream_mmap *)stream;
+    int64_t left = mmap_stream->size - mmap_stream->position;
+
+    if (!mmap_stream->opened || size < 0)
+        return MZ_STREAM_ERROR;
+    if (left <= 0)
+        return 0;
+    if (size > left)
+        size = (int32_t)left;
+
+    memcpy(buf, mmap_stream->buffer + mmap_stream->position, (size_t)size);
+    mmap_stream->position += size;
+    return size;
+}
+
+int32_t mz_stream_mmap_write(void *stream, const void *buf, int32_t size)
+{
+    MZ_UNUSED(stream);
+    MZ_UNUSED(buf);
+    MZ_UNUSED(size);
+    return MZ_STREAM_ERROR;
+}
+
+int64_t mz_stream_mmap_tell(void *stream)
+{
+    mz_stream_mmap *mmap_stream = (mz_stream_mmap *)stream;
+    if (!mmap_stream->opened)
+        return MZ_STREAM_ERROR;
+    return mmap_stream->position;
+}
+
+int32_t mz_stream_mmap_seek(void *stream, int64_t offset, int32_t origin)
+{
+    mz_stream_mmap *mmap_stream = (mz_stream_mmap *)stream;
+    int64_t new_pos = 0;
+
+    if (!mmap_stream->opened)
+        return MZ_STREAM_ERROR;
+
+    switch (origin)
+    {
+        case MZ_SEEK_CUR:
+            new_pos = mmap_stream->position + offset;
+            break;
+        case MZ_SEEK_END:
+            new_pos = mmap_stream->size + offset;
+            break;
+        case MZ_SEEK_SET:
+            new_pos = offset;
+            break;
+        default:
+            return MZ_STREAM_ERROR;
+    }
+
+    // like lseek, a position past the end is fine and reads nothing
+    if (new_pos < 0)
+        return MZ_STREAM_ERROR;
+
+    mmap_stream->position = new_pos;
+    return MZ_OK;
+}
+
+int32_t mz_stream_mmap_close(void *stream)
+{
+    mz_stream_mmap *mmap_stream = (mz_stream_mmap *)stream;
+    int32_t err = MZ_OK;
+
+    if (mmap_stream->buffer != NULL && munmap(mmap_stream->buffer, (size_t)mmap_stream->size) != 0)
+    {
+        mmap_stream->error = errno;
+        err = MZ_STREAM_ERROR;
+    }
+    mmap_stream->buffer = NULL;
+    mmap_stream->size = 0;
+    mmap_stream->position = 0;
+    mmap_stream->opened = 0;
+    return err;
+}
+
+int32_t mz_stream_mmap_error(void *stream)
+{
+    mz_stream_mmap *mmap_stream = (mz_stream_mmap *)stream;
+    return mmap_stream->error;
+}
+
+int32_t mz_stream_mmap_get_buffer(void *stream, const void **buf, int64_t *size)
+{
+    mz_stream_mmap *mmap_stream = (mz_stream_mmap *)stream;
+    if (buf == NULL || size == NULL || !mmap_stream->opened)
+        return MZ_STREAM_ERROR;
+    *buf = mmap_stream->buffer;
+    *size = mmap_stream->size;
+    return MZ_OK;
+}
+
+int32_t mz_stream_mmap_get_buffer_at(void *stream, int64_t position, int32_t size, const void **buf)
+{
+    // lends size bytes at position without copying them, valid until the stream is closed
+    mz_stream_mmap *mmap_stream = (mz_stream_mmap *)stream;
+    if (buf == NULL || !mmap_stream->opened || position < 0 || size < 0 ||
+        position > mmap_stream->size || size > mmap_stream->size - position)
+        return MZ_STREAM_ERROR;
+    *buf = mmap_stream->buffer + position;
+    return MZ_OK;
+}
+
+void *mz_stream_mmap_create(void **stream)
+{
+    mz_stream_mmap *mmap_stream = NULL;
+
+    mmap_stream = (mz_stream_mmap *)MZ_ALLOC(sizeof(mz_stream_mmap));
+    if (mmap_stream != NULL)
+    {
+        memset(mmap_stream, 0, sizeof(mz_stream_mmap));
+        mmap_stream->stream.vtbl = &mz_stream_mmap_vtbl;
+    }
+    if (stream != NULL)
+        *stream = mmap_stream;
+
+    return mmap_stream;
+}
+
+void mz_stream_mmap_delete(void **stream)
+{
+    mz_stream_mmap *mmap_stream = NULL;
+    if (stream == NULL)
+        return;
+    mmap_stream = (mz_stream_mmap *)*stream;
+    if (mmap_stream != NULL)
+    {
+        mz_stream_mmap_close(mmap_stream);
+        MZ_FREE(mmap_stream);
+    }
+    *stream = NULL;
+}
+
+void *mz_stream_mmap_get_interface(void)
+{
+    return (void *)&mz_stream_mmap_vtbl;
+}
@@ -0,0 +1,46 @@
+/* mz_strm_mmap.h -- Stream for read-only memory-mapped file access
+   Version 2.3.3, June 10, 2018
+   part of the MiniZip project
+
+   Copyright (C) 2010-2018 Nathan Moinvaziri
+     https://github.com/nmoinvaz/minizip
+
+   This program is distributed under the terms of the same license as zlib.
+   See the accompanying LICENSE file for the full text of the license.
+*/
+
+#ifndef MZ_STREAM_MMAP_H
+#define MZ_STREAM_MMAP_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************/
+
+int32_t mz_stream_mmap_open(void *stream, const char *path, int32_t mode);
+int32_t mz_stream_mmap_is_open(void *stream);
+int32_t mz_stream_mmap_read(void *stream, void *buf, int32_t size);
+int32_t mz_stream_mmap_write(void *stream, const void *buf, int32_t size);
+int64_t mz_stream_mmap_tell(void *stream);
+int32_t mz_stream_mmap_seek(void *stream, int64_t offset, int32_t origin);
+int32_t mz_stream_mmap_close(void *stream);
+int32_t mz_stream_mmap_error(void *stream);
+
+int32_t mz_stream_mmap_get_buffer(void *stream, const void **buf, int64_t *size);
+int32_t mz_stream_mmap_get_buffer_at(void *stream, int64_t position, int32_t size, const void **buf);
+
+void*   mz_stream_mmap_create(void **stream);
+void    mz_stream_mmap_delete(void **stream);
+
+void*   mz_stream_mmap_get_interface(void);
+
+/***************************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,304 @@
+/* mz_strm_pread.c -- Stream for positional file access shared between threads
+   Version 2.3.3, June 10, 2018
+   part of the MiniZip project
+
+   Copyright (C) 2010-2018 Nathan Moinvaziri
+     https://github.com/nmoinvaz/minizip
+
+   This program is distributed under the terms of the same license as zlib.
+   See the accompanying LICENSE file for the full text of the license.
+
+   Every stream is a cursor with a position and a read buffer of its own over a descriptor
+   shared by its clones. The file is only read with pread64, which leaves the offset of the
+   descriptor alone, so the cursors can be read on different threads at once without a lock.
+   The descriptor is closed with the last of them.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "mz.h"
+#include "mz_strm.h"
+#include "mz_strm_pread.h"
+
+/***************************************************************************/
+
+static mz_stream_vtbl mz_stream_pread_vtbl = {
+    mz_stream_pread_open,
+    mz_stream_pread_is_open,
+    mz_stream_pread_read,
+    mz_stream_pread_write,
+    mz_stream_pread_tell,
+    mz_stream_pread_seek,
+    mz_stream_pread_close,
+    mz_stream_pread_error,
+    mz_stream_pread_create,
+    mz_stream_pread_delete,
+    NULL,
+    NULL
+};
+
+/***************************************************************************/
+
+typedef struct mz_stream_pread_file_s
+{
+    int         fd;
+    int64_t     size;       // of the file when it was opened
+    int32_t     refs;       // cursors sharing the descriptor
+} mz_stream_pread_file;
+
+typedef struct mz_stream_pread_s
+{
+    mz_stream   stream;
+    int32_t     error;
+    mz_stream_pread_file *file;
+    int64_t     position;   // current position in the file
+    int64_t     buffer_pos; // position of the buffer in the file
+    int32_t     buffer_len; // bytes in the buffer
+    uint8_t     buffer[MZ_STREAM_PREAD_BUF_SIZE];
+} mz_stream_pread;
+
+/***************************************************************************/
+
+static void mz_stream_pread_release(mz_stream_pread_file *file)
+{
+    if (__atomic_sub_fetch(&file->refs, 1, __ATOMIC_ACQ_REL) > 0)
+        return;
+    close(file->fd);
+    MZ_FREE(file);
+}
+
+static int32_t mz_stream_pread_fill(mz_stream_pread *pread_stream, uint8_t *buf, int32_t size)
+{
+    ssize_t read = 0;
+
+    do
+    {
+        read = pread64(pread_stream->file->fd, buf, (size_t)size, (off64_t)pread_stream->position);
+    }
+    while (read < 0 && errno == EINTR);
+
+    if (read < 0)
+    {
+        pread_stream->error = errno;
+        return MZ_STREAM_ERROR;
+    }
+    return (int32_t)read;
+}
+
+int32_t mz_stream_pread_open(void *stream, const char *path, int32_t mode)
+{
+    mz_stream_pread *pread_stream = (mz_stream_pread *)stream;
+    mz_stream_pread_file *file = NULL;
+    struct stat st;
+    int fd = -1;
+
+    if (path == NULL || pread_stream->file != NULL || (mode & MZ_OPEN_MODE_READWRITE) != MZ_OPEN_MODE_READ)
+        return MZ_STREAM_ERROR;
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        pread_stream->error = errno;
+        return MZ_STREAM_ERROR;
+    }
+    if (fstat(fd, &st) != 0)
+    {
+        pread_stream->error = errno;
+        close(fd);
+        return MZ_STREAM_ERROR;
+    }
+    file = (mz_stream_pread_file *)MZ_ALLOC(sizeof(mz_stream_pread_file));
+    if (file == NULL)
+    {
+        close(fd);
+        return MZ_MEM_ERROR;
+    }
+    file->fd = fd;
+    file->size = (int64_t)st.st_size;
+    file->refs = 1;
+
+    pread_stream->file = file;
+    pread_stream->position = 0;
+    pread_stream->buffer_len = 0;
+    return MZ_OK;
+}
+
+int32_t mz_stream_pread_is_open(void *stream)
+{
+    mz_stream_pread *pread_stream = (mz_stream_pread *)stream;
+    if (pread_stream->file == NULL)
+        return MZ_STREAM_ERROR;
+    return MZ_OK;
+}
+
+int32_t mz_stream_pread_read(void *stream, void *buf, int32_t size)
+{
+    mz_stream_pread *pread_stream = (mz_stream_pread *)stream;
+    int64_t offset = 0;
+    int32_t read = 0;
+    int32_t copy = 0;
+
+    if (pread_stream->file == NULL || size < 0)
+        return MZ_STREAM_ERROR;
+
+    // a large read goes straight to the caller, a small one through the buffer
+    offset = pread_stream->position - pread_stream->buffer_pos;
+    if (offset < 0 || offset >= pread_stream->buffer_len)
+    {
+        if (size >= MZ_STREAM_PREAD_BUF_SIZE)
+        {
+            read = mz_stream_pread_fill(pread_stream, (uint8_t *)buf, size);
+            if (read > 0)
+                pread_stream->position += read;
+            return read;
+        }
+        read = mz_stream_pread_fill(pread_stream, pread_stream->buffer, MZ_STREAM_PREAD_BUF_SIZE);
+        if (read < 0)
+            return read;
+        pread_stream->buffer_pos = pread_stream->position;
+        pread_stream->buffer_len = read;
+        offset = 0;
+    }
+
+    copy = pread_stream->buffer_len - (int32_t)offset;
+    if (copy > size)
+        copy = size;
+    memcpy(buf, pread_stream->buffer + offset, (size_t)copy);
+    pread_stream->position += copy;
+
+    // the rest of a read straddling the end of the buffer
+    if (copy < size && copy > 0)
+    {
+        read = mz_stream_pread_read(stream, (uint8_t *)buf + copy, size - copy);
+        if (read < 0)
+            return read;
+        copy += read;
+    }
+    return copy;
+}
+
+int32_t mz_stream_pread_write(void *stream, const void *buf, int32_t size)
+{
+    MZ_UNUSED(stream);
+    MZ_UNUSED(buf);
+    MZ_UNUSED(size);
+    return MZ_STREAM_ERROR;
+}
+
+int64_t mz_stream_pread_tell(void *stream)
+{
+    mz_stream_pread *pread_stream = (mz_stream_pread *)stream;
+    if (pread_stream->file == NULL)
+        return MZ_STREAM_ERROR;
+    return pread_stream->position;
+}
+
+int32_t mz_stream_pread_seek(void *stream, int64_t offset, int32_t origin)
+{
+    mz_stream_pread *pread_stream = (mz_stream_pread *)stream;
+    int64_t new_pos = 0;
+
+    if (pread_stream->file == NULL)
+        return MZ_STREAM_ERROR;
+
+    switch (origin)
+    {
+        case MZ_SEEK_CUR:
+            new_pos = pread_stream->position + offset;
+            break;
+        case MZ_SEEK_END:
+            new_pos = pread_stream->file->size + offset;
+            break;
+        case MZ_SEEK_SET:
+            new_pos = offset;
+            break;
+        default:
+            return MZ_STREAM_ERROR;
+    }
+
+    if (new_pos < 0)
+        return MZ_STREAM_ERROR;
+
+    // the buffer stays, a seek back into it is free
+    pread_stream->position = new_pos;
+    return MZ_OK;
+}
+
+int32_t mz_stream_pread_close(void *stream)
+{
+    mz_stream_pread *pread_stream = (mz_stream_pread *)stream;
+
+    if (pread_stream->file != NULL)
+        mz_stream_pread_release(pread_stream->file);
+    pread_stream->file = NULL;
+    pread_stream->position = 0;
+    pread_stream->buffer_len = 0;
+    return MZ_OK;
+}
+
+int32_t mz_stream_pread_error(void *stream)
+{
+    mz_stream_pread *pread_stream = (mz_stream_pread *)stream;
+    return pread_stream->error;
+}
+
+int32_t mz_stream_pread_clone(void *stream, void **clone)
+{
+    mz_stream_pread *pread_stream = (mz_stream_pread *)stream;
+    mz_stream_pread *clone_stream = NULL;
+
+    if (clone == NULL)
+        return MZ_PARAM_ERROR;
+    *clone = NULL;
+    if (pread_stream->file == NULL)
+        return MZ_STREAM_ERROR;
+
+    if (mz_stream_pread_create((void **)&clone_stream) == NULL)
+        return MZ_MEM_ERROR;
+    __atomic_add_fetch(&pread_stream->file->refs, 1, __ATOMIC_RELAXED);
+    clone_stream->file = pread_stream->file;
+    *clone = clone_stream;
+    return MZ_OK;
+}
+
+void *mz_stream_pread_create(void **stream)
+{
+    mz_stream_pread *pread_stream = NULL;
+
+    pread_stream = (mz_stream_pread *)MZ_ALLOC(sizeof(mz_stream_pread));
+    if (pread_stream != NULL)
+    {
+        memset(pread_stream, 0, sizeof(mz_stream_pread));
+        pread_stream->stream.vtbl = &mz_stream_pread_vtbl;
+    }
+    if (stream != NULL)
+        *stream = pread_stream;
+
+    return pread_stream;
+}
+
+void mz_stream_pread_delete(void **stream)
+{
+    mz_stream_pread *pread_stream = NULL;
+    if (stream == NULL)
+        return;
+    pread_stream = (mz_stream_pread *)*stream;
+    if (pread_stream != NULL)
+    {
+        mz_stream_pread_close(pread_stream);
+        MZ_FREE(pread_stream);
+    }
+    *stream = NULL;
+}
+
+void *mz_stream_pread_get_interface(void)
+{
+    return (void *)&mz_stream_pread_vtbl;
+}
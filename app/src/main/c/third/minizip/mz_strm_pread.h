@@ -0,0 +1,50 @@
+/* mz_strm_pread.h -- Stream for positional file access shared between threads
+   Version 2.3.3, June 10, 2018
+   part of the MiniZip project
+
+   Copyright (C) 2010-2018 Nathan Moinvaziri
+     https://github.com/nmoinvaz/minizip
+
+   This program is distributed under the terms of the same license as zlib.
+   See the accompanying LICENSE file for the full text of the license.
+*/
+
+#ifndef MZ_STREAM_PREAD_H
+#define MZ_STREAM_PREAD_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************/
+
+#define MZ_STREAM_PREAD_BUF_SIZE        (4096)
+
+/***************************************************************************/
+
+int32_t mz_stream_pread_open(void *stream, const char *path, int32_t mode);
+int32_t mz_stream_pread_is_open(void *stream);
+int32_t mz_stream_pread_read(void *stream, void *buf, int32_t size);
+int32_t mz_stream_pread_write(void *stream, const void *buf, int32_t size);
+int64_t mz_stream_pread_tell(void *stream);
+int32_t mz_stream_pread_seek(void *stream, int64_t offset, int32_t origin);
+int32_t mz_stream_pread_close(void *stream);
+int32_t mz_stream_pread_error(void *stream);
+
+int32_t mz_stream_pread_clone(void *stream, void **clone);
+// Creates an opened cursor over the file of stream, at position 0, to be used by another thread
+
+void*   mz_stream_pread_create(void **stream);
+void    mz_stream_pread_delete(void **stream);
+
+void*   mz_stream_pread_get_interface(void);
+
+/***************************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -60,6 +60,7 @@ typedef struct mz_stream_zlib_s {
     int64_t     total_out;
     int64_t     max_total_in;
     int8_t      initialized;
+    int8_t      inflate_kept;
     int16_t     level;
     int32_t     mode;
     int32_t     error;
@@ -67,16 +68,38 @@ typedef struct mz_stream_zlib_s {
 
 /***************************************************************************/
 
+#ifdef MZ_CUSTOM_ALLOC
+static voidpf mz_stream_zlib_alloc(voidpf opaque, uInt items, uInt size)
+{
+    MZ_UNUSED(opaque);
+    return MZ_ALLOC((size_t)items * size);
+}
+#endif
+
 int32_t mz_stream_zlib_open(void *stream, const char *path, int32_t mode)
 {
     mz_stream_zlib *zlib = (mz_stream_zlib *)stream;
 
     MZ_UNUSED(path);
 
+    // A kept inflate state is only reused for reading, zlib wants its own allocators left in place
+    if (zlib->inflate_kept && (mode & MZ_OPEN_MODE_WRITE))
+    {
+        inflateEnd(&zlib->zstream);
+        zlib->inflate_kept = 0;
+    }
+    if (!zlib->inflate_kept)
+    {
+#ifdef MZ_CUSTOM_ALLOC
+        zlib->zstream.zalloc = mz_stream_zlib_alloc;
+#else
+        zlib->zstream.zalloc = Z_NULL;
+#endif
+        zlib->zstream.zfree = Z_NULL;
+        zlib->zstream.opaque = Z_NULL;
+    }
+
     zlib->zstream.data_type = Z_BINARY;
-    zlib->zstream.zalloc = Z_NULL;
-    zlib->zstream.zfree = Z_NULL;
-    zlib->zstream.opaque = Z_NULL;
     zlib->zstream.total_in = 0;
     zlib->zstream.total_out = 0;
 
@@ -95,7 +118,13 @@ int32_t mz_stream_zlib_open(void *stream, const char *path, int32_t mode)
         zlib->zstream.next_in = zlib->buffer;
         zlib->zstream.avail_in = 0;
 
-        zlib->error = inflateInit2(&zlib->zstream, -MAX_WBITS);
+        // Reuse the inflate state and window kept by a previous close
+        if (zlib->inflate_kept)
+            zlib->error = inflateReset(&zlib->zstream);
+        else
+            zlib->error = inflateInit2(&zlib->zstream, -MAX_WBITS);
+        if (zlib->error == Z_OK)
+            zlib->inflate_kept = 1;
     }
 
     if (zlib->error != Z_OK)
@@ -295,10 +324,7 @@ int32_t mz_stream_zlib_close(void *stream)
 
         deflateEnd(&zlib->zstream);
     }
-    else if (zlib->mode & MZ_OPEN_MODE_READ)
-    {
-        inflateEnd(&zlib->zstream);
-    }
+    // In read mode the inflate state is kept for the next open, delete ends it
 
     zlib->initialized = 0;
 
@@ -370,7 +396,11 @@ void mz_stream_zlib_delete(void **stream)
         return;
     zlib = (mz_stream_zlib *)*stream;
     if (zlib != NULL)
+    {
+        if (zlib->inflate_kept)
+            inflateEnd(&zlib->zstream);
         MZ_FREE(zlib);
+    }
     *stream = NULL;
 }
 
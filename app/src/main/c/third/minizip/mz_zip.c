@@ -54,6 +54,9 @@
 
 #define MZ_ZIP_SIZE_CD_ITEM             (0x2e)
 #define MZ_ZIP_SIZE_CD_LOCATOR64        (0x14)
+#define MZ_ZIP_SIZE_EOCD                (0x16)
+
+#define MZ_ZIP_EOCD_FIRST_READ          (1024)
 
 #define MZ_ZIP_EXTENSION_ZIP64          (0x0001)
 #define MZ_ZIP_EXTENSION_NTFS           (0x000a)
@@ -61,6 +64,40 @@
 
 /***************************************************************************/
 
+typedef struct mz_zip_index_entry_s
+{
+    const char *filename;           // points into mz_zip_index.filenames
+    uint64_t cd_pos;                // pos of the entry in the central dir
+    uint32_t hash;                  // of the filename
+} mz_zip_index_entry;
+
+typedef struct mz_zip_index_s
+{
+    mz_zip_index_entry *entries;    // sorted by filename ignoring case, then by cd_pos
+    int64_t  count;
+    int32_t  *slots;                // hash table over entries, -1 if empty
+    uint32_t slot_mask;
+    char     *filenames;
+    int32_t  refs;                  // handles sharing the index, see mz_zip_open_clone
+} mz_zip_index;
+
+typedef struct mz_zip_match_s
+{
+    uint64_t *cd_pos;               // of the entries matching query, in central dir order
+    int64_t  count;
+    int64_t  capacity;
+    int64_t  next;                  // the match following the current entry
+    char     *prefix;               // query: prefix and suffix in one allocation, suffix NULL if none
+    char     *suffix;
+    uint8_t  ignore_case;
+} mz_zip_match;
+
+typedef struct mz_zip_cd_buffer_s
+{
+    uint8_t  *data;                 // the central dir, cd_size bytes from cd_start_pos
+    int32_t  refs;                  // handles sharing the buffer, see mz_zip_open_clone
+} mz_zip_cd_buffer;
+
 typedef struct mz_zip_s
 {
     mz_zip_file file_info;
@@ -70,6 +107,7 @@ typedef struct mz_zip_s
     void *cd_stream;                // pointer to the stream with the cd
     void *cd_mem_stream;            // memory stream for central directory
     void *compress_stream;          // compression stream
+    void *inflate_stream;           // deflate read stream kept between entries
     void *crc32_stream;             // crc32 stream
     void *crypt_stream;             // encryption stream
     void *file_info_stream;         // memory stream for storing file info
@@ -94,20 +132,100 @@ typedef struct mz_zip_s
 
     uint16_t version_madeby;
     char     *comment;
+
+    mz_zip_index *index;            // filename index, see mz_zip_build_index
+    mz_zip_match match;             // walk of mz_zip_locate_first_match over the index
+    mz_zip_cd_buffer *cd_buffer;    // central dir in memory, see MZ_OPEN_MODE_LOAD_CD
+    uint32_t cd_dos_date;           // last date decoded from cd_buffer, entries mostly share it
+    time_t   cd_modified_date;      // and its mktime, 0 if none yet
 } mz_zip;
 
 /***************************************************************************/
 
+static void mz_zip_index_delete(mz_zip_index **index)
+{
+    if (*index == NULL)
+        return;
+    if (__atomic_sub_fetch(&(*index)->refs, 1, __ATOMIC_ACQ_REL) > 0)
+    {
+        *index = NULL;
+        return;
+    }
+
+    MZ_FREE((*index)->entries);
+    MZ_FREE((*index)->slots);
+    MZ_FREE((*index)->filenames);
+    MZ_FREE(*index);
+    *index = NULL;
+}
+
+static void mz_zip_cd_buffer_delete(mz_zip_cd_buffer **cd_buffer)
+{
+    if (*cd_buffer == NULL)
+        return;
+    if (__atomic_sub_fetch(&(*cd_buffer)->refs, 1, __ATOMIC_ACQ_REL) == 0)
+    {
+        MZ_FREE((*cd_buffer)->data);
+        MZ_FREE(*cd_buffer);
+    }
+    *cd_buffer = NULL;
+}
+
+static uint16_t mz_zip_get_uint16(const uint8_t *buf)
+{
+    return (uint16_t)(buf[0] | (buf[1] << 8));
+}
+
+static uint32_t mz_zip_get_uint32(const uint8_t *buf)
+{
+    return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+static uint64_t mz_zip_get_uint64(const uint8_t *buf)
+{
+    return (uint64_t)mz_zip_get_uint32(buf) | ((uint64_t)mz_zip_get_uint32(buf + 4) << 32);
+}
+
+/***************************************************************************/
+
+// Find the last end of central dir record in buf, which holds the file from read_pos, whose comment ends the file.
+// The last one whose comment fits in the file is kept in fallback, for files with data after the comment
+static int64_t mz_zip_scan_eocd(const uint8_t *buf, int32_t size, int64_t read_pos, int64_t file_size, int64_t *fallback)
+{
+    const uint8_t *p = NULL;
+    size_t left = 0;
+    int64_t end = 0;
+
+    // the record has to be in the buffer
+    if (size < MZ_ZIP_SIZE_EOCD)
+        return -1;
+    left = (size_t)(size - MZ_ZIP_SIZE_EOCD + 1);
+
+    while (left > 0 && (p = (const uint8_t *)memrchr(buf, MZ_ZIP_MAGIC_ENDHEADER & 0xff, left)) != NULL)
+    {
+        left = (size_t)(p - buf);
+        if (mz_zip_get_uint32(p) != MZ_ZIP_MAGIC_ENDHEADER)
+            continue;
+
+        end = read_pos + (p - buf) + MZ_ZIP_SIZE_EOCD + mz_zip_get_uint16(p + 20);
+        if (end == file_size)
+            return read_pos + (p - buf);
+        if (end < file_size && *fallback < 0)
+            *fallback = read_pos + (p - buf);
+    }
+    return -1;
+}
+
 // Locate the central directory of a zip file (at the end, just before the global comment)
 static int32_t mz_zip_search_eocd(void *stream, uint64_t *central_pos)
 {
-    uint8_t buf[1024 + 4];
+    uint8_t buf[MZ_ZIP_EOCD_FIRST_READ];
+    uint8_t *tail = NULL;
     int64_t file_size = 0;
-    int64_t back_read = 0;
-    int64_t max_back = UINT16_MAX; // maximum size of global comment
-    int32_t read_size = sizeof(buf);
     int64_t read_pos = 0;
-    int32_t i = 0;
+    int64_t found = -1;
+    int64_t fallback = -1;
+    int32_t read_size = 0;
 
     *central_pos = 0;
 
@@ -115,42 +233,39 @@ static int32_t mz_zip_search_eocd(void *stream, uint64_t *central_pos)
         return MZ_STREAM_ERROR;
 
     file_size = mz_stream_tell(stream);
+    if (file_size < MZ_ZIP_SIZE_EOCD)
+        return MZ_EXIST_ERROR;
 
-    if (max_back > file_size)
-        max_back = file_size;
+    // Most archives have no global comment, the end of the file holds the record
+    read_size = (int32_t)((file_size < (int64_t)sizeof(buf)) ? file_size : (int64_t)sizeof(buf));
+    read_pos = file_size - read_size;
+    if (mz_stream_seek(stream, read_pos, MZ_SEEK_SET) == MZ_OK &&
+        mz_stream_read(stream, buf, read_size) == read_size)
+        found = mz_zip_scan_eocd(buf, read_size, read_pos, file_size, &fallback);
 
-    while (back_read < max_back)
+    // Otherwise the whole range a comment may take is read at once
+    if (found < 0 && file_size > read_size)
     {
-        back_read += (sizeof(buf) - 4);
-        if (back_read > max_back)
-            back_read = max_back;
-
-        read_pos = file_size - back_read;
-        if (read_size > (file_size - read_pos))
-            read_size = (uint32_t)(file_size - read_pos);
-
-        if (mz_stream_seek(stream, read_pos, MZ_SEEK_SET) != MZ_OK)
-            break;
-        if (mz_stream_read(stream, buf, read_size) != read_size)
-            break;
-
-        for (i = read_size - 3; (i--) > 0;)
+        read_size = (int32_t)((file_size < MZ_ZIP_SIZE_EOCD + UINT16_MAX) ? file_size : MZ_ZIP_SIZE_EOCD + UINT16_MAX);
+        read_pos = file_size - read_size;
+        tail = (uint8_t *)MZ_ALLOC((size_t)read_size);
+        if (tail != NULL && mz_stream_seek(stream, read_pos, MZ_SEEK_SET) == MZ_OK &&
+            mz_stream_read(stream, tail, read_size) == read_size)
         {
-            if (((*(buf + i))     == (MZ_ZIP_MAGIC_ENDHEADER & 0xff)) &&
-                ((*(buf + i + 1)) == (MZ_ZIP_MAGIC_ENDHEADER >> 8 & 0xff)) &&
-                ((*(buf + i + 2)) == (MZ_ZIP_MAGIC_ENDHEADER >> 16 & 0xff)) &&
-                ((*(buf + i + 3)) == (MZ_ZIP_MAGIC_ENDHEADER >> 24 & 0xff)))
-            {
-                *central_pos = read_pos + i;
-                return MZ_OK;
-            }
+            fallback = -1;
+            found = mz_zip_scan_eocd(tail, read_size, read_pos, file_size, &fallback);
         }
-
-        if (*central_pos != 0)
-            break;
+        if (tail != NULL)
+            MZ_FREE(tail);
     }
 
-    return MZ_EXIST_ERROR;
+    if (found < 0)
+        found = fallback;
+    if (found < 0)
+        return MZ_EXIST_ERROR;
+
+    *central_pos = (uint64_t)found;
+    return MZ_OK;
 }
 
 // Locate the central directory 64 of a zip file (at the end, just before the global comment)
@@ -449,6 +564,228 @@ static int32_t mz_zip_write_cd(void *handle)
     return err;
 }
 
+static int32_t mz_zip_load_cd(void *handle)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    mz_zip_cd_buffer *cd_buffer = NULL;
+    int32_t err = MZ_OK;
+
+    // mz_stream_read takes an int32_t, a larger central dir is still read entry by entry
+    if (zip->cd_size == 0 || zip->cd_size > INT32_MAX)
+        return MZ_PARAM_ERROR;
+
+    cd_buffer = (mz_zip_cd_buffer *)MZ_ALLOC(sizeof(mz_zip_cd_buffer));
+    if (cd_buffer == NULL)
+        return MZ_MEM_ERROR;
+    cd_buffer->refs = 1;
+    cd_buffer->data = (uint8_t *)MZ_ALLOC((size_t)zip->cd_size);
+    if (cd_buffer->data == NULL)
+        err = MZ_MEM_ERROR;
+
+    mz_stream_set_prop_int64(zip->cd_stream, MZ_STREAM_PROP_DISK_NUMBER, -1);
+
+    if (err == MZ_OK)
+        err = mz_stream_seek(zip->cd_stream, zip->cd_start_pos, MZ_SEEK_SET);
+    if (err == MZ_OK && mz_stream_read(zip->cd_stream, cd_buffer->data, (int32_t)zip->cd_size) != (int32_t)zip->cd_size)
+        err = MZ_STREAM_ERROR;
+
+    if (err != MZ_OK)
+    {
+        mz_zip_cd_buffer_delete(&cd_buffer);
+        return err;
+    }
+    zip->cd_buffer = cd_buffer;
+    return MZ_OK;
+}
+
+// Parses the extra field of a header read by mz_zip_entry_read_header or mz_zip_entry_decode_header.
+// Every block is kept within its own size and one running past the extra field is a format error.
+// Trailing bytes too short for a block header are ignored, zipalign pads the local extra field with up to 3 zeros.
+// A ZIP64 block only replaces the fields that are UINT32_MAX (UINT16_MAX for the disk number), the others keep
+// the values of the header.
+static int32_t mz_zip_entry_parse_extrafield(mz_zip_file *file_info)
+{
+    const uint8_t *extra = NULL;
+    uint32_t extra_pos = 0;
+    uint32_t attrib_pos = 0;
+    uint32_t field_end = 0;
+    uint16_t extra_header_id = 0;
+    uint16_t extra_data_size = 0;
+    uint16_t ntfs_attrib_id = 0;
+    uint16_t ntfs_attrib_size = 0;
+
+    extra = file_info->extrafield;
+    while (extra_pos + 4 <= file_info->extrafield_size)
+    {
+        extra_header_id = mz_zip_get_uint16(extra + extra_pos);
+        extra_data_size = mz_zip_get_uint16(extra + extra_pos + 2);
+        extra_pos += 4;
+        field_end = extra_pos + extra_data_size;
+        if (field_end > file_info->extrafield_size)
+            return MZ_FORMAT_ERROR;
+
+        // ZIP64 extra field
+        if (extra_header_id == MZ_ZIP_EXTENSION_ZIP64)
+        {
+            if (file_info->uncompressed_size == UINT32_MAX && extra_pos + 8 <= field_end)
+            {
+                file_info->uncompressed_size = mz_zip_get_uint64(extra + extra_pos);
+                extra_pos += 8;
+            }
+            if (file_info->compressed_size == UINT32_MAX && extra_pos + 8 <= field_end)
+            {
+                file_info->compressed_size = mz_zip_get_uint64(extra + extra_pos);
+                extra_pos += 8;
+            }
+            if (file_info->disk_offset == UINT32_MAX && extra_pos + 8 <= field_end)
+            {
+                file_info->disk_offset = mz_zip_get_uint64(extra + extra_pos);
+                extra_pos += 8;
+            }
+            if (file_info->disk_number == UINT16_MAX && extra_pos + 4 <= field_end)
+                file_info->disk_number = mz_zip_get_uint32(extra + extra_pos);
+        }
+        // NTFS extra field
+        else if (extra_header_id == MZ_ZIP_EXTENSION_NTFS)
+        {
+            // Reserved
+            attrib_pos = extra_pos + 4;
+
+            while (attrib_pos + 4 <= field_end)
+            {
+                ntfs_attrib_id = mz_zip_get_uint16(extra + attrib_pos);
+                ntfs_attrib_size = mz_zip_get_uint16(extra + attrib_pos + 2);
+                attrib_pos += 4;
+
+                if ((ntfs_attrib_id == 0x01) && (ntfs_attrib_size == 24) && (attrib_pos + 24 <= field_end))
+                {
+                    mz_zip_ntfs_to_unix_time(mz_zip_get_uint64(extra + attrib_pos), &file_info->modified_date);
+                    mz_zip_ntfs_to_unix_time(mz_zip_get_uint64(extra + attrib_pos + 8), &file_info->accessed_date);
+                    mz_zip_ntfs_to_unix_time(mz_zip_get_uint64(extra + attrib_pos + 16), &file_info->creation_date);
+                }
+                attrib_pos += ntfs_attrib_size;
+            }
+        }
+#ifdef HAVE_AES
+        // AES extra field
+        else if (extra_header_id == MZ_ZIP_EXTENSION_AES)
+        {
+            // Support AE-1 and AE-2, then the encryption strength and actual compression method
+            if (extra_data_size < 7)
+                return MZ_FORMAT_ERROR;
+            file_info->aes_version = mz_zip_get_uint16(extra + extra_pos);
+            if (file_info->aes_version != 1 && file_info->aes_version != 2)
+                return MZ_FORMAT_ERROR;
+            if (extra[extra_pos + 2] != 'A' || extra[extra_pos + 3] != 'E')
+                return MZ_FORMAT_ERROR;
+            file_info->aes_encryption_mode = extra[extra_pos + 4];
+            file_info->compression_method = mz_zip_get_uint16(extra + extra_pos + 5);
+        }
+#endif
+
+        extra_pos = field_end;
+    }
+
+    return MZ_OK;
+}
+
+// The same as mz_zip_entry_read_header for the central dir entry at cd_current_pos, decoded from cd_buffer
+static int32_t mz_zip_entry_decode_header(void *handle, mz_zip_file *file_info, void *file_info_stream)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    const uint8_t *header = NULL;
+    uint8_t *buf = NULL;
+    uint64_t pos = 0;
+    uint64_t left = 0;
+    uint32_t magic = 0;
+    uint32_t dos_date = 0;
+    int64_t max_seek = 0;
+    int32_t err = MZ_OK;
+
+
+    memset(file_info, 0, sizeof(mz_zip_file));
+
+    // The central dir ends where the end of central dir records begin
+    if (zip->cd_current_pos < zip->cd_start_pos)
+        return MZ_PARAM_ERROR;
+    pos = zip->cd_current_pos - zip->cd_start_pos;
+    if (pos + 4 > zip->cd_size)
+        return MZ_END_OF_LIST;
+    header = zip->cd_buffer->data + pos;
+    left = zip->cd_size - pos;
+
+    magic = mz_zip_get_uint32(header);
+    if (magic == MZ_ZIP_MAGIC_ENDHEADER || magic == MZ_ZIP_MAGIC_ENDHEADER64)
+        return MZ_END_OF_LIST;
+    if (magic != MZ_ZIP_MAGIC_CENTRALHEADER || left < MZ_ZIP_SIZE_CD_ITEM)
+        return MZ_FORMAT_ERROR;
+
+    file_info->version_madeby = mz_zip_get_uint16(header + 4);
+    file_info->version_needed = mz_zip_get_uint16(header + 6);
+    file_info->flag = mz_zip_get_uint16(header + 8);
+    file_info->compression_method = mz_zip_get_uint16(header + 10);
+    dos_date = mz_zip_get_uint32(header + 12);
+    if (zip->cd_modified_date == 0 || dos_date != zip->cd_dos_date)
+    {
+        zip->cd_modified_date = mz_zip_dosdate_to_time_t(dos_date);
+        zip->cd_dos_date = dos_date;
+    }
+    file_info->modified_date = zip->cd_modified_date;
+    file_info->crc = mz_zip_get_uint32(header + 16);
+    file_info->compressed_size = mz_zip_get_uint32(header + 20);
+    file_info->uncompressed_size = mz_zip_get_uint32(header + 24);
+    file_info->filename_size = mz_zip_get_uint16(header + 28);
+    file_info->extrafield_size = mz_zip_get_uint16(header + 30);
+    file_info->comment_size = mz_zip_get_uint16(header + 32);
+    file_info->disk_number = mz_zip_get_uint16(header + 34);
+    file_info->internal_fa = mz_zip_get_uint16(header + 36);
+    file_info->external_fa = mz_zip_get_uint32(header + 38);
+    file_info->disk_offset = mz_zip_get_uint32(header + 42);
+
+    if ((uint64_t)MZ_ZIP_SIZE_CD_ITEM + file_info->filename_size + file_info->extrafield_size +
+        file_info->comment_size > left)
+        return MZ_FORMAT_ERROR;
+
+    // Filename, extra field and comment are copied at once, each followed by a terminator
+    max_seek = file_info->filename_size + file_info->extrafield_size + file_info->comment_size + 3;
+    err = mz_stream_seek(file_info_stream, max_seek, MZ_SEEK_SET);
+    if (err == MZ_OK)
+        err = mz_stream_seek(file_info_stream, 0, MZ_SEEK_SET);
+    // The memory stream has grown to max_seek unless it ran out of memory
+    if (err == MZ_OK)
+        err = mz_stream_mem_get_buffer_at(file_info_stream, max_seek, (const void **)&buf);
+    if (err == MZ_OK)
+        err = mz_stream_mem_get_buffer(file_info_stream, (const void **)&buf);
+    if (err != MZ_OK)
+        return err;
+
+    header += MZ_ZIP_SIZE_CD_ITEM;
+    if (file_info->filename_size > 0)
+    {
+        file_info->filename = (const char *)buf;
+        memcpy(buf, header, file_info->filename_size);
+        buf[file_info->filename_size] = 0;
+        buf += file_info->filename_size + 1;
+        header += file_info->filename_size;
+    }
+    if (file_info->extrafield_size > 0)
+    {
+        file_info->extrafield = buf;
+        memcpy(buf, header, file_info->extrafield_size);
+        buf[file_info->extrafield_size] = 0;
+        buf += file_info->extrafield_size + 1;
+        header += file_info->extrafield_size;
+    }
+    if (file_info->comment_size > 0)
+    {
+        file_info->comment = (const char *)buf;
+        memcpy(buf, header, file_info->comment_size);
+        buf[file_info->comment_size] = 0;
+    }
+
+    return mz_zip_entry_parse_extrafield(file_info);
+}
+
 extern void* mz_zip_open(void *stream, int32_t mode)
 {
     mz_zip *zip = NULL;
@@ -500,6 +837,9 @@ extern void* mz_zip_open(void *stream, int32_t mode)
         {
             zip->cd_start_pos = zip->cd_offset;
         }
+
+        if ((err == MZ_OK) && (mode & MZ_OPEN_MODE_LOAD_CD) && !(mode & MZ_OPEN_MODE_WRITE))
+            mz_zip_load_cd(zip);
     }
 
     if (err == MZ_OK)
@@ -521,6 +861,65 @@ extern void* mz_zip_open(void *stream, int32_t mode)
     return zip;
 }
 
+extern void* mz_zip_open_clone(void *handle, void *stream)
+{
+    mz_zip *source = (mz_zip *)handle;
+    mz_zip *zip = NULL;
+
+    if (source == NULL || stream == NULL || (source->open_mode & MZ_OPEN_MODE_READWRITE) != MZ_OPEN_MODE_READ ||
+        (source->open_mode & MZ_OPEN_MODE_APPEND))
+        return NULL;
+
+    zip = (mz_zip *)MZ_ALLOC(sizeof(mz_zip));
+    if (zip == NULL)
+        return NULL;
+
+    memset(zip, 0, sizeof(mz_zip));
+
+    zip->stream = stream;
+    zip->cd_stream = stream;
+
+    // what mz_zip_read_cd found, the entries are read again through the new stream
+    zip->disk_number_with_cd = source->disk_number_with_cd;
+    zip->cd_start_pos = source->cd_start_pos;
+    zip->cd_offset = source->cd_offset;
+    zip->cd_size = source->cd_size;
+    zip->number_entry = source->number_entry;
+    zip->version_madeby = source->version_madeby;
+
+    if (source->comment != NULL)
+    {
+        zip->comment = (char *)MZ_ALLOC(strlen(source->comment) + 1);
+        if (zip->comment == NULL)
+        {
+            mz_zip_close(zip);
+            return NULL;
+        }
+        strcpy(zip->comment, source->comment);
+    }
+
+    // the index and the central dir buffer are never changed once built, the handles only read them
+    if (source->index != NULL)
+    {
+        __atomic_add_fetch(&source->index->refs, 1, __ATOMIC_RELAXED);
+        zip->index = source->index;
+    }
+    if (source->cd_buffer != NULL)
+    {
+        __atomic_add_fetch(&source->cd_buffer->refs, 1, __ATOMIC_RELAXED);
+        zip->cd_buffer = source->cd_buffer;
+    }
+
+    mz_stream_mem_create(&zip->file_info_stream);
+    mz_stream_mem_open(zip->file_info_stream, NULL, MZ_OPEN_MODE_CREATE);
+    mz_stream_mem_create(&zip->local_file_info_stream);
+    mz_stream_mem_open(zip->local_file_info_stream, NULL, MZ_OPEN_MODE_CREATE);
+
+    zip->open_mode = source->open_mode;
+
+    return zip;
+}
+
 extern int32_t mz_zip_close(void *handle)
 {
     mz_zip *zip = (mz_zip *)handle;
@@ -559,6 +958,12 @@ extern int32_t mz_zip_close(void *handle)
     if (zip->comment)
         MZ_FREE(zip->comment);
 
+    mz_zip_index_delete(&zip->index);
+    MZ_FREE(zip->match.cd_pos);
+    MZ_FREE(zip->match.prefix);
+    mz_zip_cd_buffer_delete(&zip->cd_buffer);
+    mz_stream_delete(&zip->inflate_stream);
+
     MZ_FREE(zip);
 
     return err;
@@ -610,19 +1015,10 @@ extern int32_t mz_zip_set_version_madeby(void *handle, uint16_t version_madeby)
 // Get info about the current file in the zip file
 static int32_t mz_zip_entry_read_header(void *stream, uint8_t local, mz_zip_file *file_info, void *file_info_stream)
 {
-    uint64_t ntfs_time = 0;
-    uint32_t reserved = 0;
     uint32_t magic = 0;
     uint32_t dos_date = 0;
-    uint32_t extra_pos = 0;
-    uint32_t extra_data_size_read = 0;
-    uint16_t extra_header_id = 0;
-    uint16_t extra_data_size = 0;
-    uint16_t ntfs_attrib_id = 0;
-    uint16_t ntfs_attrib_size = 0;
     uint16_t value16 = 0;
     uint32_t value32 = 0;
-    uint64_t value64 = 0;
     int64_t max_seek = 0;
     int64_t seek = 0;
     int32_t err = MZ_OK;
@@ -711,104 +1107,10 @@ static int32_t mz_zip_entry_read_header(void *stream, uint8_t local, mz_zip_file
         if (err == MZ_OK)
             err = mz_stream_write_uint8(file_info_stream, 0);
 
-        // Seek back and parse the extra field
         if (err == MZ_OK)
-            err = mz_stream_seek(file_info_stream, seek, MZ_SEEK_SET);
+            err = mz_zip_entry_parse_extrafield(file_info);
 
         seek += file_info->extrafield_size + 1;
-
-        while ((err == MZ_OK) && (extra_pos < file_info->extrafield_size))
-        {
-            err = mz_stream_read_uint16(file_info_stream, &extra_header_id);
-            if (err == MZ_OK)
-                err = mz_stream_read_uint16(file_info_stream, &extra_data_size);
-
-            // ZIP64 extra field
-            if (extra_header_id == MZ_ZIP_EXTENSION_ZIP64)
-            {
-                if ((err == MZ_OK) && (file_info->uncompressed_size == UINT32_MAX))
-                    err = mz_stream_read_uint64(file_info_stream, &file_info->uncompressed_size);
-                if ((err == MZ_OK) && (file_info->compressed_size == UINT32_MAX))
-                    err = mz_stream_read_uint64(file_info_stream, &file_info->compressed_size);
-                if ((err == MZ_OK) && (file_info->disk_offset == UINT32_MAX))
-                    err = mz_stream_read_uint64(file_info_stream, &value64);
-                file_info->disk_offset = value64;
-                if ((err == MZ_OK) && (file_info->disk_number == UINT16_MAX))
-                    err = mz_stream_read_uint32(file_info_stream, &file_info->disk_number);
-            }
-            // NTFS extra field
-            else if (extra_header_id == MZ_ZIP_EXTENSION_NTFS)
-            {
-                if (err == MZ_OK)
-                    err = mz_stream_read_uint32(file_info_stream, &reserved);
-                extra_data_size_read = 4;
-
-                while ((err == MZ_OK) && (extra_data_size_read < extra_data_size))
-                {
-                    err = mz_stream_read_uint16(file_info_stream, &ntfs_attrib_id);
-                    if (err == MZ_OK)
-                        err = mz_stream_read_uint16(file_info_stream, &ntfs_attrib_size);
-
-                    if ((err == MZ_OK) && (ntfs_attrib_id == 0x01) && (ntfs_attrib_size == 24))
-                    {
-                        err = mz_stream_read_uint64(file_info_stream, &ntfs_time);
-                        mz_zip_ntfs_to_unix_time(ntfs_time, &file_info->modified_date);
-
-                        if (err == MZ_OK)
-                        {
-                            err = mz_stream_read_uint64(file_info_stream, &ntfs_time);
-                            mz_zip_ntfs_to_unix_time(ntfs_time, &file_info->accessed_date);
-                        }
-                        if (err == MZ_OK)
-                        {
-                            err = mz_stream_read_uint64(file_info_stream, &ntfs_time);
-                            mz_zip_ntfs_to_unix_time(ntfs_time, &file_info->creation_date);
-                        }
-                    }
-                    else
-                    {
-                        if (err == MZ_OK)
-                            err = mz_stream_seek(file_info_stream, ntfs_attrib_size, MZ_SEEK_CUR);
-                    }
-
-                    extra_data_size_read += ntfs_attrib_size + 4;
-                }
-            }
-#ifdef HAVE_AES
-            // AES extra field
-            else if (extra_header_id == MZ_ZIP_EXTENSION_AES)
-            {
-                uint8_t value8 = 0;
-                // Verify version info
-                err = mz_stream_read_uint16(file_info_stream, &value16);
-                // Support AE-1 and AE-2
-                if (value16 != 1 && value16 != 2)
-                    err = MZ_FORMAT_ERROR;
-                file_info->aes_version = value16;
-                if (err == MZ_OK)
-                    err = mz_stream_read_uint8(file_info_stream, &value8);
-                if ((char)value8 != 'A')
-                    err = MZ_FORMAT_ERROR;
-                if (err == MZ_OK)
-                    err = mz_stream_read_uint8(file_info_stream, &value8);
-                if ((char)value8 != 'E')
-                    err = MZ_FORMAT_ERROR;
-                // Get AES encryption strength and actual compression method
-                if (err == MZ_OK)
-                    err = mz_stream_read_uint8(file_info_stream, &value8);
-                file_info->aes_encryption_mode = value8;
-                if (err == MZ_OK)
-                    err = mz_stream_read_uint16(file_info_stream, &value16);
-                file_info->compression_method = value16;
-            }
-#endif
-            else
-            {
-                err = mz_stream_seek(file_info_stream, extra_data_size, MZ_SEEK_CUR);
-            }
-
-            extra_pos += 4 + extra_data_size;
-        }
     }
 
     if ((err == MZ_OK) && (file_info->comment_size > 0))
@@ -1159,6 +1461,12 @@ static int32_t mz_zip_entry_open_int(void *handle, int16_t compression_method, i
         if (zip->compression_method == MZ_COMPRESS_METHOD_RAW)
             mz_stream_raw_create(&zip->compress_stream);
 #ifdef HAVE_ZLIB
+        else if (zip->compression_method == MZ_COMPRESS_METHOD_DEFLATE && zip->inflate_stream != NULL &&
+            (zip->open_mode & MZ_OPEN_MODE_WRITE) == 0 && (zip->file_info.flag & MZ_ZIP_FLAG_ENCRYPTED) == 0)
+        {
+            zip->compress_stream = zip->inflate_stream;
+            zip->inflate_stream = NULL;
+        }
         else if (zip->compression_method == MZ_COMPRESS_METHOD_DEFLATE)
             mz_stream_zlib_create(&zip->compress_stream);
 #endif
@@ -1421,6 +1729,16 @@ extern int32_t mz_zip_entry_close_raw(void *handle, uint64_t uncompressed_size,
 
     mz_stream_delete(&zip->crypt_stream);
 
+#ifdef HAVE_ZLIB
+    // Keep the inflater of a plain deflate entry, opening the next one resets it instead of
+    // allocating a new zlib state and window. Encrypted entries set TOTAL_IN_MAX so are not kept.
+    if (zip->compression_method == MZ_COMPRESS_METHOD_DEFLATE && zip->inflate_stream == NULL &&
+        (zip->open_mode & MZ_OPEN_MODE_WRITE) == 0 && (zip->file_info.flag & MZ_ZIP_FLAG_ENCRYPTED) == 0)
+    {
+        zip->inflate_stream = zip->compress_stream;
+        zip->compress_stream = NULL;
+    }
+#endif
     mz_stream_delete(&zip->compress_stream);
     mz_stream_crc32_delete(&zip->crc32_stream);
 
@@ -1477,6 +1795,14 @@ static int32_t mz_zip_goto_next_entry_int(void *handle)
 
     zip->entry_scanned = 0;
 
+    if (zip->cd_buffer != NULL)
+    {
+        err = mz_zip_entry_decode_header(zip, &zip->file_info, zip->file_info_stream);
+        if (err == MZ_OK)
+            zip->entry_scanned = 1;
+        return err;
+    }
+
     mz_stream_set_prop_int64(zip->cd_stream, MZ_STREAM_PROP_DISK_NUMBER, -1);
 
     err = mz_stream_seek(zip->cd_stream, zip->cd_current_pos, MZ_SEEK_SET);
@@ -1505,6 +1831,24 @@ extern int32_t mz_zip_get_disk_number_with_cd(void *handle, uint32_t *disk_numbe
     return MZ_OK;
 }
 
+extern int32_t mz_zip_get_cd_offset(void *handle, uint64_t *cd_offset)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL || cd_offset == NULL)
+        return MZ_PARAM_ERROR;
+    *cd_offset = zip->cd_offset;
+    return MZ_OK;
+}
+
+extern int32_t mz_zip_get_cd_size(void *handle, uint64_t *cd_size)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL || cd_size == NULL)
+        return MZ_PARAM_ERROR;
+    *cd_size = zip->cd_size;
+    return MZ_OK;
+}
+
 extern int64_t mz_zip_get_entry(void *handle)
 {
     mz_zip *zip = (mz_zip *)handle;
@@ -1555,15 +1899,353 @@ extern int32_t mz_zip_goto_next_entry(void *handle)
     return mz_zip_goto_next_entry_int(handle);
 }
 
+static uint32_t mz_zip_index_hash(const char *filename)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+
+    while (*filename != 0)
+        hash = (hash ^ (uint8_t)*filename++) * 16777619u;
+
+    return hash;
+}
+
+static int32_t mz_zip_fold(int32_t c)
+{
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+static int32_t mz_zip_compare_ignore_case(const char *filename1, const char *filename2, size_t size)
+{
+    size_t i = 0;
+
+    for (i = 0; i < size; i += 1)
+    {
+        int32_t c1 = mz_zip_fold((uint8_t)filename1[i]);
+        int32_t c2 = mz_zip_fold((uint8_t)filename2[i]);
+
+        if (c1 != c2)
+            return c1 - c2;
+        if (c1 == 0)
+            break;
+    }
+    return 0;
+}
+
+static int mz_zip_index_compare(const void *a, const void *b)
+{
+    const mz_zip_index_entry *entry1 = (const mz_zip_index_entry *)a;
+    const mz_zip_index_entry *entry2 = (const mz_zip_index_entry *)b;
+    int32_t result = mz_zip_compare_ignore_case(entry1->filename, entry2->filename, SIZE_MAX);
+
+    if (result == 0)
+        result = strcmp(entry1->filename, entry2->filename);
+    if (result == 0)
+        result = (entry1->cd_pos > entry2->cd_pos) - (entry1->cd_pos < entry2->cd_pos);
+    return result;
+}
+
+static int64_t mz_zip_index_find(mz_zip_index *index, const char *filename)
+{
+    uint32_t hash = mz_zip_index_hash(filename);
+    uint32_t slot = hash & index->slot_mask;
+
+    while (index->slots[slot] >= 0)
+    {
+        mz_zip_index_entry *entry = &index->entries[index->slots[slot]];
+        if (entry->hash == hash && strcmp(entry->filename, filename) == 0)
+            return index->slots[slot];
+        slot = (slot + 1) & index->slot_mask;
+    }
+    return -1;
+}
+
+extern int32_t mz_zip_build_index(void *handle)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    mz_zip_index *index = NULL;
+    uint64_t cd_pos = 0;
+    uint64_t filenames_size = 0;
+    uint32_t slot_count = 1;
+    uint16_t entry_scanned = 0;
+    int64_t i = 0;
+    int32_t err = MZ_OK;
+
+    if (zip == NULL || (zip->open_mode & MZ_OPEN_MODE_WRITE))
+        return MZ_PARAM_ERROR;
+    if (zip->index != NULL)
+        return MZ_OK;
+    // every entry takes at least MZ_ZIP_SIZE_CD_ITEM bytes of the central dir
+    if (zip->number_entry < 0 || (uint64_t)zip->number_entry > zip->cd_size / MZ_ZIP_SIZE_CD_ITEM ||
+        zip->number_entry > INT32_MAX / 2)
+        return MZ_FORMAT_ERROR;
+
+    while (slot_count < 2 * (uint64_t)zip->number_entry)
+        slot_count *= 2;
+
+    index = (mz_zip_index *)MZ_ALLOC(sizeof(mz_zip_index));
+    if (index == NULL)
+        return MZ_MEM_ERROR;
+    memset(index, 0, sizeof(mz_zip_index));
+    index->slot_mask = slot_count - 1;
+    // the filenames take less than the central dir they are stored in, their terminators included
+    index->entries = (mz_zip_index_entry *)MZ_ALLOC((size_t)zip->number_entry * sizeof(mz_zip_index_entry) + 1);
+    index->slots = (int32_t *)MZ_ALLOC(slot_count * sizeof(int32_t));
+    index->filenames = (char *)MZ_ALLOC((size_t)zip->cd_size + 1);
+    if (index->entries == NULL || index->slots == NULL || index->filenames == NULL)
+    {
+        mz_zip_index_delete(&index);
+        return MZ_MEM_ERROR;
+    }
+
+    cd_pos = zip->cd_current_pos;
+    entry_scanned = zip->entry_scanned;
+
+    err = mz_zip_goto_first_entry(handle);
+    while (err == MZ_OK)
+    {
+        const char *filename = (zip->file_info.filename != NULL) ? zip->file_info.filename : "";
+        size_t filename_size = strlen(filename);
+        mz_zip_index_entry *entry = NULL;
+
+        if (index->count == zip->number_entry || filenames_size + filename_size + 1 > zip->cd_size + 1)
+        {
+            err = MZ_FORMAT_ERROR;
+            break;
+        }
+        entry = &index->entries[index->count++];
+        entry->filename = index->filenames + filenames_size;
+        entry->cd_pos = zip->cd_current_pos;
+        entry->hash = mz_zip_index_hash(filename);
+        memcpy(index->filenames + filenames_size, filename, filename_size + 1);
+        filenames_size += filename_size + 1;
+
+        err = mz_zip_goto_next_entry(handle);
+    }
+    if (err == MZ_END_OF_LIST)
+        err = MZ_OK;
+
+    if (entry_scanned)
+        mz_zip_goto_entry(handle, cd_pos);
+    else
+        zip->cd_current_pos = cd_pos;
+
+    if (err != MZ_OK)
+    {
+        mz_zip_index_delete(&index);
+        return err;
+    }
+
+    qsort(index->entries, (size_t)index->count, sizeof(mz_zip_index_entry), mz_zip_index_compare);
+    memset(index->slots, 0xff, slot_count * sizeof(int32_t));
+    for (i = 0; i < index->count; i += 1)
+    {
+        mz_zip_index_entry *entry = &index->entries[i];
+        uint32_t slot = entry->hash & index->slot_mask;
+
+        // of entries sharing a filename the first one in the central dir is found, as by a scan
+        if (i > 0 && strcmp(index->entries[i - 1].filename, entry->filename) == 0)
+            continue;
+        while (index->slots[slot] >= 0)
+            slot = (slot + 1) & index->slot_mask;
+        index->slots[slot] = (int32_t)i;
+    }
+
+    index->refs = 1;
+    zip->index = index;
+    return MZ_OK;
+}
+
+static int32_t mz_zip_filename_match(const char *filename, const char *prefix, const char *suffix,
+    uint8_t ignore_case)
+{
+    size_t filename_size = strlen(filename);
+    size_t size = 0;
+
+    if (prefix != NULL)
+    {
+        size = strlen(prefix);
+        if (size > filename_size)
+            return 0;
+        if ((ignore_case ? mz_zip_compare_ignore_case(filename, prefix, size) : strncmp(filename, prefix, size)) != 0)
+            return 0;
+    }
+    if (suffix != NULL)
+    {
+        size = strlen(suffix);
+        if (size > filename_size)
+            return 0;
+        filename += filename_size - size;
+        if ((ignore_case ? mz_zip_compare_ignore_case(filename, suffix, size) : strcmp(filename, suffix)) != 0)
+            return 0;
+    }
+    return 1;
+}
+
+static int mz_zip_compare_cd_pos(const void *a, const void *b)
+{
+    uint64_t cd_pos1 = *(const uint64_t *)a;
+    uint64_t cd_pos2 = *(const uint64_t *)b;
+    return (cd_pos1 > cd_pos2) - (cd_pos1 < cd_pos2);
+}
+
+static int32_t mz_zip_match_is_query(mz_zip_match *match, const char *prefix, const char *suffix,
+    uint8_t ignore_case)
+{
+    if (match->prefix == NULL || match->ignore_case != ignore_case || strcmp(match->prefix, prefix) != 0)
+        return 0;
+    if (suffix == NULL || match->suffix == NULL)
+        return suffix == match->suffix;
+    return strcmp(match->suffix, suffix) == 0;
+}
+
+static int32_t mz_zip_match_set_query(mz_zip_match *match, const char *prefix, const char *suffix,
+    uint8_t ignore_case)
+{
+    size_t prefix_size = strlen(prefix);
+    size_t suffix_size = (suffix != NULL) ? strlen(suffix) : 0;
+    char *query = NULL;
+
+    if (mz_zip_match_is_query(match, prefix, suffix, ignore_case))
+        return MZ_OK;
+    query = (char *)MZ_ALLOC(prefix_size + suffix_size + 2);
+    if (query == NULL)
+        return MZ_MEM_ERROR;
+    memcpy(query, prefix, prefix_size + 1);
+    if (suffix != NULL)
+        memcpy(query + prefix_size + 1, suffix, suffix_size + 1);
+    MZ_FREE(match->prefix);
+    match->prefix = query;
+    match->suffix = (suffix != NULL) ? query + prefix_size + 1 : NULL;
+    match->ignore_case = ignore_case;
+    return MZ_OK;
+}
+
+// goes to the matching entry of the lowest cd_pos after the current entry, of any cd_pos if first.
+// The matches are collected in central dir order once, the next matches of that walk just step through them.
+static int32_t mz_zip_index_locate_match(void *handle, uint8_t first, const char *prefix, const char *suffix,
+    uint8_t ignore_case)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    mz_zip_index *index = zip->index;
+    mz_zip_match *match = &zip->match;
+    size_t prefix_size = strlen(prefix);
+    uint64_t after = zip->cd_current_pos;
+    int64_t low = 0;
+    int64_t high = index->count;
+    int64_t end = 0;
+    int32_t err = MZ_OK;
+
+    if (!first && match->next > 0 && match->cd_pos[match->next - 1] == zip->cd_current_pos &&
+        mz_zip_match_is_query(match, prefix, suffix, ignore_case))
+    {
+        if (match->next == match->count)
+            return MZ_END_OF_LIST;
+        return mz_zip_goto_entry(handle, match->cd_pos[match->next++]);
+    }
+
+    match->count = 0;
+    match->next = 0;
+    err = mz_zip_match_set_query(match, prefix, suffix, ignore_case);
+    if (err != MZ_OK)
+        return err;
+
+    // the filenames starting with prefix ignoring case follow each other in the index
+    while (low < high)
+    {
+        int64_t middle = low + (high - low) / 2;
+        if (mz_zip_compare_ignore_case(index->entries[middle].filename, prefix, prefix_size) < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    for (end = low; end < index->count; end += 1)
+    {
+        if (mz_zip_compare_ignore_case(index->entries[end].filename, prefix, prefix_size) != 0)
+            break;
+    }
+    if (end - low > match->capacity)
+    {
+        uint64_t *cd_pos = (uint64_t *)MZ_ALLOC((size_t)(end - low) * sizeof(uint64_t));
+        if (cd_pos == NULL)
+            return MZ_MEM_ERROR;
+        MZ_FREE(match->cd_pos);
+        match->cd_pos = cd_pos;
+        match->capacity = end - low;
+    }
+    for (; low < end; low += 1)
+    {
+        mz_zip_index_entry *entry = &index->entries[low];
+        if ((first || entry->cd_pos > after) && mz_zip_filename_match(entry->filename, prefix, suffix, ignore_case))
+            match->cd_pos[match->count++] = entry->cd_pos;
+    }
+    if (match->count == 0)
+        return MZ_END_OF_LIST;
+    qsort(match->cd_pos, (size_t)match->count, sizeof(uint64_t), mz_zip_compare_cd_pos);
+
+    return mz_zip_goto_entry(handle, match->cd_pos[match->next++]);
+}
+
+static int32_t mz_zip_scan_match(void *handle, int32_t err, const char *prefix, const char *suffix,
+    uint8_t ignore_case)
+{
+    mz_zip *zip = (mz_zip *)handle;
+
+    while (err == MZ_OK)
+    {
+        if (zip->file_info.filename != NULL &&
+            mz_zip_filename_match(zip->file_info.filename, prefix, suffix, ignore_case))
+            return MZ_OK;
+        err = mz_zip_goto_next_entry(handle);
+    }
+    return err;
+}
+
+extern int32_t mz_zip_locate_first_match(void *handle, const char *prefix, const char *suffix, uint8_t ignore_case)
+{
+    mz_zip *zip = (mz_zip *)handle;
+
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+
+    if (zip->index != NULL)
+        return mz_zip_index_locate_match(handle, 1, (prefix != NULL) ? prefix : "", suffix, ignore_case);
+
+    return mz_zip_scan_match(handle, mz_zip_goto_first_entry(handle), prefix, suffix, ignore_case);
+}
+
+extern int32_t mz_zip_locate_next_match(void *handle, const char *prefix, const char *suffix, uint8_t ignore_case)
+{
+    mz_zip *zip = (mz_zip *)handle;
+
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+
+    if (zip->index != NULL)
+        return mz_zip_index_locate_match(handle, 0, (prefix != NULL) ? prefix : "", suffix, ignore_case);
+
+    return mz_zip_scan_match(handle, mz_zip_goto_next_entry(handle), prefix, suffix, ignore_case);
+}
+
 extern int32_t mz_zip_locate_entry(void *handle, const char *filename, mz_filename_compare_cb filename_compare_cb)
 {
     mz_zip *zip = (mz_zip *)handle;
     int32_t err = MZ_OK;
     int32_t result = 0;
+    int64_t i = 0;
 
     if (zip == NULL)
         return MZ_PARAM_ERROR;
 
+    // a compare callback may match names the hash of filename doesn't lead to
+    if (zip->index != NULL && filename_compare_cb == NULL)
+    {
+        i = mz_zip_index_find(zip->index, filename);
+        if (i < 0)
+            return MZ_END_OF_LIST;
+        return mz_zip_goto_entry(handle, zip->index->entries[i].cd_pos);
+    }
+
     err = mz_zip_goto_first_entry(handle);
     while (err == MZ_OK)
     {
@@ -64,6 +64,10 @@ typedef struct mz_zip_file_s
 extern void *  mz_zip_open(void *stream, int32_t mode);
 // Create a zip file, no delete file in zip functionality
 
+extern void *  mz_zip_open_clone(void *handle, void *stream);
+// Open another handle on a zip file opened for reading, read through stream, e.g. a clone of its stream.
+// The central directory is not parsed again and the index is shared, so either handle can be used on another thread
+
 extern int32_t mz_zip_close(void *handle);
 // Close the zip file
 
@@ -112,6 +116,12 @@ extern int32_t mz_zip_get_number_entry(void *handle, int64_t *number_entry);
 extern int32_t mz_zip_get_disk_number_with_cd(void *handle, uint32_t *disk_number_with_cd);
 // Get the the disk number containing the central directory record
 
+extern int32_t mz_zip_get_cd_offset(void *handle, uint64_t *cd_offset);
+// Get the offset of the start of the central directory
+
+extern int32_t mz_zip_get_cd_size(void *handle, uint64_t *cd_size);
+// Get the size of the central directory
+
 extern int64_t mz_zip_get_entry(void *handle);
 // Return offset of the current entry in the zip file
 
@@ -129,6 +139,17 @@ extern int32_t mz_zip_locate_entry(void *handle, const char *filename,
     mz_filename_compare_cb filename_compare_cb);
 // Locate the file with the specified name in the zip file or MZ_END_LIST if not found
 
+extern int32_t mz_zip_build_index(void *handle);
+// Index the central directory by filename in one pass, so that mz_zip_locate_entry (without compare callback)
+// and the match functions go straight to the entry instead of reading every header before it
+
+extern int32_t mz_zip_locate_first_match(void *handle, const char *prefix, const char *suffix, uint8_t ignore_case);
+// Go to the first entry, in central directory order, whose name starts with prefix and ends with suffix,
+// either may be NULL, or MZ_END_OF_LIST if there is none
+
+extern int32_t mz_zip_locate_next_match(void *handle, const char *prefix, const char *suffix, uint8_t ignore_case);
+// Go to the next matching entry after the current one or MZ_END_OF_LIST if there is none
+
 /***************************************************************************/
 
 int32_t  mz_zip_attrib_is_dir(int32_t attributes, int32_t version_madeby);
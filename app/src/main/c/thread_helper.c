@@ -0,0 +1,171 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include "thread_helper.h"
+
+/**
+ * A threadHelperRun() call. Pool threads join it while it is listed in the pool and has tasks left,
+ * each as the next worker number; active counts the ones still running a task of it.
+ */
+typedef struct threadHelperJob {
+    threadHelperTask task;
+    void *ctx;
+    size_t count;
+    size_t next;
+    size_t workers;
+    size_t joined;
+    size_t active;
+    struct threadHelperJob *link;
+} threadHelperJob;
+
+/**
+ * The threads shared by every threadHelperRun() call, started as calls ask for more workers than there are and
+ * kept for the life of the process. A task may itself call threadHelperRun(): the pool threads that are idle
+ * then join the inner job, so there are never more threads than the pool and the callers.
+ */
+typedef struct threadHelperPool {
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t idle;
+    threadHelperJob *jobs;
+    size_t threads;
+} threadHelperPool;
+
+static threadHelperPool pool = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER,
+                                NULL, 0};
+
+
+size_t threadHelperGetWorkerCount(size_t count) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t workers = cores > 0 ? (size_t) cores : 1;
+    if (workers > THREAD_HELPER_MAX_WORKERS) {
+        workers = THREAD_HELPER_MAX_WORKERS;
+    }
+    if (workers > count) {
+        workers = count;
+    }
+    return workers ? workers : 1;
+}
+
+/**
+ * Takes tasks of job off its shared counter until none are left.
+ */
+static void threadHelperLoop(threadHelperJob *job, size_t worker) {
+    for (;;) {
+        size_t index = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+        if (index >= job->count) {
+            break;
+        }
+        job->task(job->ctx, index, worker);
+    }
+}
+
+/**
+ * The first listed job that has tasks left and room for another worker, NULL if there is none.
+ * Called with the pool locked.
+ */
+static threadHelperJob *threadHelperFindJob() {
+    for (threadHelperJob *job = pool.jobs; NULL != job; job = job->link) {
+        if (job->joined + 1 < job->workers && __atomic_load_n(&job->next, __ATOMIC_RELAXED) < job->count) {
+            return job;
+        }
+    }
+    return NULL;
+}
+
+static void *threadHelperPoolLoop(void *arg) {
+    (void) arg;
+    pthread_mutex_lock(&pool.lock);
+    for (;;) {
+        threadHelperJob *job = threadHelperFindJob();
+        if (NULL == job) {
+            pthread_cond_wait(&pool.work, &pool.lock);
+            continue;
+        }
+        size_t worker = ++job->joined;
+        job->active++;
+        pthread_mutex_unlock(&pool.lock);
+
+        threadHelperLoop(job, worker);
+
+        pthread_mutex_lock(&pool.lock);
+        if (--job->active == 0) {
+            pthread_cond_broadcast(&pool.idle);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Starts pool threads until there are threads of them, the caller of threadHelperRun() being one more worker.
+ * Called with the pool locked.
+ */
+static void threadHelperGrowPool(size_t threads) {
+    pthread_attr_t attr;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    while (pool.threads < threads) {
+        pthread_t thread;
+        if (pthread_create(&thread, &attr, threadHelperPoolLoop, NULL) != 0) {
+            // whatever did not get a thread is picked up by the ones that did and the callers
+            NSV_LOGW("threadHelperGrowPool: could not start thread %zu\n", pool.threads);
+            break;
+        }
+        pool.threads++;
+    }
+    pthread_attr_destroy(&attr);
+}
+
+void threadHelperRun(threadHelperTask task, void *ctx, size_t count, size_t workers) {
+    threadHelperJob job = {task, ctx, count, 0, workers, 0, 0, NULL};
+
+    if (workers > THREAD_HELPER_MAX_WORKERS) {
+        job.workers = THREAD_HELPER_MAX_WORKERS;
+    }
+    bool shared = job.workers > 1 && count > 1;
+    if (shared) {
+        pthread_mutex_lock(&pool.lock);
+        threadHelperGrowPool(job.workers - 1);
+        job.link = pool.jobs;
+        pool.jobs = &job;
+        pthread_cond_broadcast(&pool.work);
+        pthread_mutex_unlock(&pool.lock);
+    }
+
+    threadHelperLoop(&job, 0);
+
+    if (shared) {
+        // no one joins once it is unlisted, the ones that did are on their last task
+        pthread_mutex_lock(&pool.lock);
+        threadHelperJob **link = &pool.jobs;
+        while (*link != &job) {
+            link = &(*link)->link;
+        }
+        *link = job.link;
+        while (job.active > 0) {
+            pthread_cond_wait(&pool.idle, &pool.lock);
+        }
+        pthread_mutex_unlock(&pool.lock);
+    }
+}
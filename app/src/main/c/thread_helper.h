@@ -0,0 +1,56 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef NATIVESIGNATUREVERIFICATION_THREAD_HELPER_H
+#define NATIVESIGNATUREVERIFICATION_THREAD_HELPER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "def.h"
+
+#define THREAD_HELPER_MAX_WORKERS   32
+
+/**
+ * A unit of work. index is the task number in [0, count), worker is the number of the thread
+ * running it in [0, workers) so that tasks can use per-worker scratch buffers.
+ */
+typedef void (*threadHelperTask)(void *ctx, size_t index, size_t worker);
+
+/**
+ * Number of workers worth starting for count tasks: the online cores, but never more than
+ * count or THREAD_HELPER_MAX_WORKERS.
+ */
+size_t threadHelperGetWorkerCount(size_t count);
+
+/**
+ * Runs task for every index in [0, count) on up to workers threads, the calling thread is
+ * worker 0 and the others come from a pool of threads shared by every call, grown to workers - 1
+ * threads when a call asks for more. Returns once every task has finished. A task may call
+ * threadHelperRun() itself.
+ */
+void threadHelperRun(threadHelperTask task, void *ctx, size_t count, size_t workers);
+
+#endif //NATIVESIGNATUREVERIFICATION_THREAD_HELPER_H
@@ -0,0 +1,536 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+/*
+ * nsv_bench: times every stage of the signature pipeline separately, e.g. over the corpus of nsv_bench_corpus.py.
+ *
+ * Usage: nsv_bench [-t milliseconds] [-n iterations] [-s stage,...] <apk> ...
+ *     every stage runs at least n times (3) and until it took t milliseconds (200) per APK
+ *
+ * Stages:
+ *     path        pathHelperFindMappings() with the APK mapped, the scan pathHelperGetMappings() caches. It finds
+ *                 the APK only when argv[0] is part of its path, like the package name is part of the install path
+ *                 of an app (exec -a <name>)
+ *     unzip       unzipHelperGetCertificateDetails(), open the APK and inflate the v1 signature file
+ *     pkcs7       pkcs7HelperGetSignature() over the signature file inflated once beforehand
+ *     stream      unzipHelperReadCertificates(), open the APK and inflate the signature file up to its certificates
+ *     sign_block  signBlockHelperGetCertificate(), open the APK and take the v2/v3 certificate
+ *     verify      signBlockHelperVerify(), open the APK and check the v2/v3 signers and content digest
+ *     jar         jarHelperVerify(), open the APK and check every entry against the v1 signature on all cores
+ *     signer      signatureHelperVerifySignedData(), the signature block over the .SF file, both inflated beforehand
+ *     locate      open the APK and mz_zip_locate_entry() BENCH_LOCATE_COUNT names spread over the central directory
+ *     index       the same after unzipHelperBuildIndex(), the names are found through the hashed index
+ *
+ * One JSON object per APK and stage on stdout:
+ *     {"apk":..., "size":..., "stage":..., "ok":..., "iterations":..., "ns_per_op":..., "ns_min":...,
+ *      "allocs_per_op":..., "alloc_bytes_per_op":..., "syscalls_per_op":...}
+ * allocs count every malloc, calloc and realloc of the process (glibc only, -1 otherwise),
+ * syscalls are the read and write class system calls the kernel counts in /proc/self/io (-1 if it is missing).
+ * ok is false if the stage found nothing, e.g. pkcs7 and unzip on an APK without a v1 signature.
+ */
+
+#include <time.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/mman.h>
+
+#include "../unzip_helper.h"
+#include "../path_helper.h"
+#include "../pkcs7_helper.h"
+#include "../sign_block_helper.h"
+#include "../jar_helper.h"
+#include "../signature_helper.h"
+
+#define BENCH_STAGE_COUNT       10
+#define BENCH_LOCATE_COUNT      64
+#define BENCH_DEFAULT_MILLIS    200
+#define BENCH_DEFAULT_MIN_OPS   3
+
+typedef bool (*benchStageFunction)(void *ctx);
+
+typedef struct benchStage {
+    const char *name;
+    benchStageFunction run;
+} benchStage;
+
+/**
+ * What the stages of one APK work on.
+ */
+typedef struct benchApk {
+    const char *path;
+    char *real_path;
+    const unsigned char *base;
+    size_t size;
+    unsigned char *signature;
+    size_t signature_len;
+    unsigned char *signature_file;
+    size_t signature_file_len;
+    char *names[BENCH_LOCATE_COUNT];
+    size_t name_count;
+} benchApk;
+
+typedef struct benchCounters {
+    uint64_t allocs;
+    uint64_t alloc_bytes;
+    int64_t syscalls;
+} benchCounters;
+
+static uint64_t benchAllocs = 0;
+static uint64_t benchAllocBytes = 0;
+
+#ifdef __GLIBC__
+
+// every allocation of the process, including the ones inside libc, is counted before it is passed on to glibc
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static void benchCountAlloc(size_t size) {
+    __atomic_fetch_add(&benchAllocs, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&benchAllocBytes, (uint64_t) size, __ATOMIC_RELAXED);
+}
+
+void *malloc(size_t size) {
+    benchCountAlloc(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    benchCountAlloc(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    benchCountAlloc(size);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+    __libc_free(ptr);
+}
+
+#define BENCH_COUNTS_ALLOCS true
+
+#else
+
+#define BENCH_COUNTS_ALLOCS false
+
+#endif //__GLIBC__
+
+
+static uint64_t benchNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * syscr + syscw of /proc/self/io, -1 if the kernel doesn't account task I/O.
+ */
+static int64_t benchSyscalls() {
+    char buffer[512];
+    int fd = open("/proc/self/io", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    ssize_t r = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    if (r <= 0) {
+        return -1;
+    }
+    buffer[r] = '\0';
+    const char *syscr = strstr(buffer, "syscr:");
+    const char *syscw = strstr(buffer, "syscw:");
+    if (NULL == syscr || NULL == syscw) {
+        return -1;
+    }
+    return strtoll(syscr + 6, NULL, 10) + strtoll(syscw + 6, NULL, 10);
+}
+
+static void benchSnapshot(benchCounters *counters) {
+    counters->syscalls = benchSyscalls();
+    counters->allocs = __atomic_load_n(&benchAllocs, __ATOMIC_RELAXED);
+    counters->alloc_bytes = __atomic_load_n(&benchAllocBytes, __ATOMIC_RELAXED);
+}
+
+static bool benchPath(void *ctx) {
+    benchApk *apk = ctx;
+    pathHelperMapping *mappings = NULL;
+    size_t count = pathHelperFindMappings(&mappings);
+    bool found = count > 0 && NULL != apk->real_path && strcmp(mappings[0].path, apk->real_path) == 0;
+    pathHelperFreeMappings(mappings, count);
+    return found;
+}
+
+static bool benchUnzip(void *ctx) {
+    benchApk *apk = ctx;
+    size_t len = 0;
+    unsigned char *content = unzipHelperGetCertificateDetails(apk->path, &len);
+    free(content);
+    return NULL != content;
+}
+
+static bool benchPkcs7(void *ctx) {
+    benchApk *apk = ctx;
+    derHelperToken tokens[PKCS7_HELPER_MAX_TOKENS];
+    pkcs7HelperContext pkcs7;
+    size_t len = 0;
+
+    if (NULL == apk->signature) {
+        return false;
+    }
+    pkcs7HelperInit(&pkcs7, tokens, PKCS7_HELPER_MAX_TOKENS);
+    return NULL != pkcs7HelperGetSignature(&pkcs7, apk->signature, apk->signature_len, &len);
+}
+
+static bool benchStream(void *ctx) {
+    benchApk *apk = ctx;
+    unzipHelperArchive archive;
+    unsigned char *certificates = NULL;
+    size_t len = 0;
+
+    if (unzipHelperOpen(&archive, apk->path) == MZ_OK) {
+        certificates = unzipHelperReadCertificates(&archive, &len);
+        unzipHelperClose(&archive);
+    }
+    bool found = NULL != certificates && NULL != pkcs7HelperGetSignerCertificate(certificates, len, &len);
+    free(certificates);
+    return found;
+}
+
+static bool benchSignBlock(void *ctx) {
+    benchApk *apk = ctx;
+    unzipHelperArchive archive;
+    unsigned char *certificate = NULL;
+    size_t len = 0;
+
+    if (unzipHelperOpen(&archive, apk->path) == MZ_OK) {
+        certificate = signBlockHelperGetCertificate(&archive, &len, NULL);
+        unzipHelperClose(&archive);
+    }
+    free(certificate);
+    return NULL != certificate;
+}
+
+static bool benchVerify(void *ctx) {
+    benchApk *apk = ctx;
+    unzipHelperArchive archive;
+    int32_t err = MZ_STREAM_ERROR;
+
+    if (unzipHelperOpen(&archive, apk->path) == MZ_OK) {
+        err = signBlockHelperVerify(&archive, NULL);
+        unzipHelperClose(&archive);
+    }
+    return err == MZ_OK;
+}
+
+static bool benchJar(void *ctx) {
+    benchApk *apk = ctx;
+    unzipHelperArchive archive;
+    jarHelperReport report;
+    int32_t err = MZ_STREAM_ERROR;
+
+    if (unzipHelperOpen(&archive, apk->path) == MZ_OK) {
+        err = jarHelperVerify(&archive, &report);
+        unzipHelperClose(&archive);
+    }
+    return err == MZ_OK;
+}
+
+static bool benchSigner(void *ctx) {
+    benchApk *apk = ctx;
+
+    if (NULL == apk->signature || NULL == apk->signature_file) {
+        return false;
+    }
+    return signatureHelperVerifySignedData(apk->signature, apk->signature_len, apk->signature_file,
+                                           apk->signature_file_len, NULL) == MZ_OK;
+}
+
+static bool benchLocateNames(const benchApk *apk, bool indexed) {
+    unzipHelperArchive archive;
+    bool found = apk->name_count > 0;
+
+    if (unzipHelperOpen(&archive, apk->path) != MZ_OK) {
+        return false;
+    }
+    if (indexed && unzipHelperBuildIndex(&archive) != MZ_OK) {
+        found = false;
+    }
+    for (size_t i = 0; i < apk->name_count && found; i++) {
+        found = mz_zip_locate_entry(archive.handle, apk->names[i], NULL) == MZ_OK;
+    }
+    unzipHelperClose(&archive);
+    return found;
+}
+
+static bool benchLocate(void *ctx) {
+    return benchLocateNames(ctx, false);
+}
+
+static bool benchIndex(void *ctx) {
+    return benchLocateNames(ctx, true);
+}
+
+static const benchStage STAGES[BENCH_STAGE_COUNT] = {
+        {"path",       benchPath},
+        {"unzip",      benchUnzip},
+        {"pkcs7",      benchPkcs7},
+        {"stream",     benchStream},
+        {"sign_block", benchSignBlock},
+        {"verify",     benchVerify},
+        {"jar",        benchJar},
+        {"signer",     benchSigner},
+        {"locate",     benchLocate},
+        {"index",      benchIndex}
+};
+
+/**
+ * Inflates the first .SF file under META-INF/ of the APK, NULL if there is none.
+ */
+static unsigned char *benchReadSignatureFile(const char *path, size_t *len) {
+    unzipHelperArchive archive;
+    mz_zip_file *file_info = NULL;
+    unsigned char *content = NULL;
+
+    if (unzipHelperOpen(&archive, path) != MZ_OK) {
+        return NULL;
+    }
+    for (int32_t err = mz_zip_goto_first_entry(archive.handle); err == MZ_OK && NULL == content;
+         err = mz_zip_goto_next_entry(archive.handle)) {
+        if (mz_zip_entry_get_info(archive.handle, &file_info) != MZ_OK
+            || strncmp(file_info->filename, "META-INF/", 9) != 0 || strlen(file_info->filename) < 3
+            || strcasecmp(file_info->filename + strlen(file_info->filename) - 3, ".SF") != 0
+            || mz_zip_entry_read_open(archive.handle, 0, NULL) != MZ_OK) {
+            continue;
+        }
+        content = malloc((size_t) file_info->uncompressed_size + 1);
+        int32_t read = NULL == content ? -1 : mz_zip_entry_read(archive.handle, content,
+                                                                  (uint32_t) file_info->uncompressed_size);
+        if (read < 0 || (uint64_t) read != (uint64_t) file_info->uncompressed_size) {
+            free(content);
+            content = NULL;
+        }
+        *len = (size_t) file_info->uncompressed_size;
+        mz_zip_entry_close(archive.handle);
+    }
+    unzipHelperClose(&archive);
+    return content;
+}
+
+/**
+ * Takes BENCH_LOCATE_COUNT names spread evenly over the central directory, the last entry included.
+ */
+static void benchCollectNames(benchApk *apk) {
+    unzipHelperArchive archive;
+    mz_zip_file *file_info = NULL;
+    int64_t count = 0;
+    int64_t index = 0;
+
+    if (unzipHelperOpen(&archive, apk->path) != MZ_OK) {
+        return;
+    }
+    mz_zip_get_number_entry(archive.handle, &count);
+    for (int32_t err = mz_zip_goto_first_entry(archive.handle); err == MZ_OK && apk->name_count < BENCH_LOCATE_COUNT;
+         err = mz_zip_goto_next_entry(archive.handle), index++) {
+        // entry index is taken when it is the last one before the next of BENCH_LOCATE_COUNT marks
+        if ((index + 1) * BENCH_LOCATE_COUNT / count != index * BENCH_LOCATE_COUNT / count
+            && mz_zip_entry_get_info(archive.handle, &file_info) == MZ_OK) {
+            apk->names[apk->name_count] = strdup(file_info->filename);
+            if (NULL != apk->names[apk->name_count]) {
+                apk->name_count++;
+            }
+        }
+    }
+    unzipHelperClose(&archive);
+}
+
+static void benchPrintString(const char *s) {
+    putchar('"');
+    for (; *s; s++) {
+        unsigned char c = (unsigned char) *s;
+        if (c == '"' || c == '\\') {
+            printf("\\%c", c);
+        } else if (c < 0x20) {
+            printf("\\u%04x", c);
+        } else {
+            putchar(c);
+        }
+    }
+    putchar('"');
+}
+
+/**
+ * Runs one stage at least min_ops times and for at least millis, then prints its line.
+ * The counters are taken around the whole loop, the cost of reading /proc/self/io once is subtracted.
+ */
+static void benchRun(const benchStage *stage, benchApk *apk, uint64_t millis, uint64_t min_ops,
+                     int64_t syscalls_overhead) {
+    benchCounters before, after;
+    uint64_t ops = 0, total = 0, best = UINT64_MAX;
+    bool ok = true;
+
+    // warm up the page cache and the allocator
+    stage->run(apk);
+
+    benchSnapshot(&before);
+    while (ops < min_ops || total < millis * 1000000ULL) {
+        uint64_t start = benchNow();
+        ok = stage->run(apk) && ok;
+        uint64_t elapsed = benchNow() - start;
+        total += elapsed;
+        best = elapsed < best ? elapsed : best;
+        ops++;
+    }
+    benchSnapshot(&after);
+
+    printf("{\"apk\":");
+    benchPrintString(apk->path);
+    printf(",\"size\":%zu,\"stage\":\"%s\",\"ok\":%s,\"iterations\":%" PRIu64 ",\"ns_per_op\":%.1f,"
+           "\"ns_min\":%" PRIu64 ",", apk->size, stage->name, ok ? "true" : "false", ops,
+           (double) total / (double) ops, best);
+    if (BENCH_COUNTS_ALLOCS) {
+        printf("\"allocs_per_op\":%.2f,\"alloc_bytes_per_op\":%.1f,",
+               (double) (after.allocs - before.allocs) / (double) ops,
+               (double) (after.alloc_bytes - before.alloc_bytes) / (double) ops);
+    } else {
+        printf("\"allocs_per_op\":-1,\"alloc_bytes_per_op\":-1,");
+    }
+    if (before.syscalls >= 0 && after.syscalls >= 0) {
+        printf("\"syscalls_per_op\":%.2f}\n",
+               (double) (after.syscalls - before.syscalls - syscalls_overhead) / (double) ops);
+    } else {
+        printf("\"syscalls_per_op\":-1}\n");
+    }
+    fflush(stdout);
+}
+
+static bool benchSelectStages(const char *list, bool *selected) {
+    char *copy = strdup(list);
+    char *saveptr = NULL;
+    bool valid = NULL != copy;
+
+    memset(selected, 0, BENCH_STAGE_COUNT * sizeof(bool));
+    for (char *name = valid ? strtok_r(copy, ",", &saveptr) : NULL; NULL != name;
+         name = strtok_r(NULL, ",", &saveptr)) {
+        size_t i = 0;
+        while (i < BENCH_STAGE_COUNT && strcmp(STAGES[i].name, name) != 0) {
+            i++;
+        }
+        if (i == BENCH_STAGE_COUNT) {
+            fprintf(stderr, "nsv_bench: unknown stage %s\n", name);
+            valid = false;
+            break;
+        }
+        selected[i] = true;
+    }
+    free(copy);
+    return valid;
+}
+
+static void benchUsage() {
+    fprintf(stderr, "usage: nsv_bench [-t milliseconds] [-n iterations] [-s stage,...] <apk> ...\n"
+                    "stages: path,unzip,pkcs7,stream,sign_block,verify,jar,signer,locate,index\n");
+}
+
+int main(int argc, char **argv) {
+    bool selected[BENCH_STAGE_COUNT];
+    uint64_t millis = BENCH_DEFAULT_MILLIS;
+    uint64_t min_ops = BENCH_DEFAULT_MIN_OPS;
+    benchCounters before, after;
+    int failed = 0;
+    int opt;
+
+    memset(selected, 1, sizeof(selected));
+    while ((opt = getopt(argc, argv, "t:n:s:h")) != -1) {
+        switch (opt) {
+            case 't':
+                millis = strtoull(optarg, NULL, 10);
+                break;
+            case 'n':
+                min_ops = strtoull(optarg, NULL, 10);
+                break;
+            case 's':
+                if (!benchSelectStages(optarg, selected)) {
+                    benchUsage();
+                    return 2;
+                }
+                break;
+            default:
+                benchUsage();
+                return 2;
+        }
+    }
+    if (optind == argc) {
+        benchUsage();
+        return 2;
+    }
+    min_ops = min_ops ? min_ops : 1;
+
+    benchSnapshot(&before);
+    benchSnapshot(&after);
+    int64_t syscalls_overhead = after.syscalls - before.syscalls;
+
+    for (int i = optind; i < argc; i++) {
+        benchApk apk;
+        struct stat st;
+        void *base = MAP_FAILED;
+
+        memset(&apk, 0, sizeof(apk));
+        apk.path = argv[i];
+        int fd = open(apk.path, O_RDONLY | O_CLOEXEC);
+        if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) {
+            base = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+        if (base == MAP_FAILED) {
+            fprintf(stderr, "nsv_bench: can't map %s: %s\n", apk.path, strerror(errno));
+            failed = 1;
+            continue;
+        }
+        apk.base = base;
+        apk.size = (size_t) st.st_size;
+        apk.real_path = realpath(apk.path, NULL);
+        apk.signature = unzipHelperGetCertificateDetails(apk.path, &apk.signature_len);
+        apk.signature_file = benchReadSignatureFile(apk.path, &apk.signature_file_len);
+        benchCollectNames(&apk);
+
+        for (size_t s = 0; s < BENCH_STAGE_COUNT; s++) {
+            if (selected[s]) {
+                benchRun(&STAGES[s], &apk, millis, min_ops, syscalls_overhead);
+            }
+        }
+        free(apk.signature);
+        free(apk.signature_file);
+        for (size_t n = 0; n < apk.name_count; n++) {
+            free(apk.names[n]);
+        }
+        free(apk.real_path);
+        munmap(base, apk.size);
+    }
+    return failed;
+}
@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+#
+# The MIT License (MIT)
+#
+# Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+#
+# Generates the APK corpus for nsv_bench: the layouts the signature pipeline meets in the wild,
+# signed with throwaway keys made by openssl.
+#
+# Usage: nsv_bench_corpus.py <output directory> [--huge-mb 64] [--many 20000]
+#
+#     small.apk          v1 + v2, a handful of entries
+#     huge.apk           v2 + v3, one big stored entry
+#     many_entries.apk   v1 + v2, tens of thousands of entries: a long central directory and MANIFEST.MF
+#     v1_only.apk        v1 only, the signature file has to be found and inflated
+#     v1_sha1.apk        v1 only with SHA-1 digests, like APKs built before 2017
+#     multi_signer.apk   v1 + v2 signed by an RSA and an EC key
+#     long_comment.apk   v2 with the longest ZIP comment, the EOCD is 64 KiB away from the end
+#     timestamped.apk    v1 only, the PKCS#7 carries signed attributes and a second certificate
+#     duplicate_entry.apk v1 only with a second, unsigned copy of a signed entry: has to fail
+
+import argparse
+import base64
+import hashlib
+import io
+import os
+import random
+import struct
+import subprocess
+import tempfile
+import zipfile
+
+V2_ID = 0x7109871a
+V3_ID = 0xf05368c0
+CHUNK = 1 << 20
+
+
+def openssl(*args, data=None):
+    return subprocess.run(["openssl"] + list(args), input=data, stdout=subprocess.PIPE,
+                          stderr=subprocess.DEVNULL, check=True).stdout
+
+
+def make_key(directory, name, ec=False):
+    key = os.path.join(directory, name + ".key")
+    pem = os.path.join(directory, name + ".pem")
+    if not os.path.exists(pem):
+        if ec:
+            openssl("ecparam", "-name", "prime256v1", "-genkey", "-noout", "-out", key)
+        else:
+            openssl("genrsa", "-out", key, "2048")
+        openssl("req", "-new", "-x509", "-key", key, "-out", pem, "-days", "10000", "-subj", "/CN=nsv bench " + name)
+    return pem, key
+
+
+def build_zip(files, comment=b""):
+    buf = io.BytesIO()
+    with zipfile.ZipFile(buf, "w") as z:
+        for name, data, stored in files:
+            info = zipfile.ZipInfo(name, (2018, 1, 1, 0, 0, 0))
+            info.compress_type = zipfile.ZIP_STORED if stored else zipfile.ZIP_DEFLATED
+            z.writestr(info, data)
+        z.comment = comment
+    return buf.getvalue()
+
+
+def manifest_section(name, alg, digest):
+    line = "Name: " + name
+    out = ""
+    while len(line.encode()) > 70:
+        out += line[:70] + "\r\n"
+        line = " " + line[70:]
+    return out + line + "\r\n%s-Digest: %s\r\n\r\n" % (alg, base64.b64encode(digest).decode())
+
+
+def v1_sign(files, signers, sha1=False, extra_certs=(), attributes=False):
+    alg, h, md = ("SHA1", hashlib.sha1, "sha1") if sha1 else ("SHA-256", hashlib.sha256, "sha256")
+    mf = "Manifest-Version: 1.0\r\nCreated-By: 1.0 (Android)\r\n\r\n"
+    sections = []
+    for name, data, _ in files:
+        section = manifest_section(name, alg, h(data).digest())
+        sections.append((name, section))
+        mf += section
+    out = list(files) + [("META-INF/MANIFEST.MF", mf.encode(), False)]
+    for index, (pem, key) in enumerate(signers):
+        base = "CERT" if index == 0 else "SIGNER%d" % index
+        sf = "Signature-Version: 1.0\r\n%s-Digest-Manifest: %s\r\nCreated-By: 1.0 (Android)\r\n\r\n" % (
+            alg, base64.b64encode(h(mf.encode()).digest()).decode())
+        for name, section in sections:
+            sf += "Name: %s\r\n%s-Digest: %s\r\n\r\n" % (name, alg, base64.b64encode(h(section.encode()).digest()).decode())
+        with tempfile.NamedTemporaryFile(delete=False) as t:
+            t.write(sf.encode())
+        args = ["cms", "-sign", "-binary", "-outform", "DER", "-nosmimecap", "-md", md,
+                "-in", t.name, "-signer", pem, "-inkey", key]
+        for cert in extra_certs:
+            args += ["-certfile", cert]
+        if not attributes:
+            args.append("-noattr")
+        signature = openssl(*args)
+        os.unlink(t.name)
+        ext = "EC" if "ec" in os.path.basename(key) else "RSA"
+        out.append(("META-INF/%s.SF" % base, sf.encode(), False))
+        out.append(("META-INF/%s.%s" % (base, ext), signature, False))
+    return out
+
+
+def lp(b):
+    return struct.pack("<I", len(b)) + b
+
+
+def content_digest(sections):
+    digests = b""
+    count = 0
+    for section in sections:
+        for i in range(0, len(section), CHUNK):
+            chunk = section[i:i + CHUNK]
+            digests += hashlib.sha256(b"\xa5" + struct.pack("<I", len(chunk)) + chunk).digest()
+            count += 1
+    return hashlib.sha256(b"\x5a" + struct.pack("<I", count) + digests).digest()
+
+
+def v2_sign(apk, signers, scheme_ids):
+    eocd = apk.rfind(b"PK\x05\x06")
+    cd_size, cd_offset = struct.unpack("<II", apk[eocd + 12:eocd + 20])
+    contents, cd, eocd_bytes = apk[:cd_offset], apk[cd_offset:cd_offset + cd_size], apk[eocd:]
+    digest = content_digest([contents, cd, eocd_bytes])
+    pairs = b""
+    for scheme_id in scheme_ids:
+        blobs = b""
+        for pem, key in signers:
+            alg = 0x0201 if "ec" in os.path.basename(key) else 0x0103
+            certs = lp(lp(openssl("x509", "-outform", "DER", "-in", pem)))
+            digests = lp(lp(struct.pack("<I", alg) + lp(digest)))
+            sdk = struct.pack("<II", 24, 0x7fffffff) if scheme_id == V3_ID else b""
+            signed = digests + certs + sdk + lp(b"")
+            with tempfile.NamedTemporaryFile(delete=False) as t:
+                t.write(signed)
+            signature = openssl("dgst", "-sha256", "-sign", key, t.name)
+            os.unlink(t.name)
+            public_key = openssl("pkey", "-in", key, "-pubout", "-outform", "DER")
+            blobs += lp(lp(signed) + sdk + lp(lp(struct.pack("<I", alg) + lp(signature))) + lp(public_key))
+        value = struct.pack("<I", scheme_id) + lp(blobs)
+        pairs += struct.pack("<Q", len(value)) + value
+    size = len(pairs) + 8 + 16
+    block = struct.pack("<Q", size) + pairs + struct.pack("<Q", size) + b"APK Sig Block 42"
+    return contents + block + cd + eocd_bytes[:16] + struct.pack("<I", cd_offset + len(block)) + eocd_bytes[20:]
+
+
+def entries(count, rnd):
+    files = [("AndroidManifest.xml", b"<manifest package='com.kozhevin.signverification'/>" * 10, False),
+             ("classes.dex", bytes(rnd.getrandbits(8) for _ in range(64 * 1024)), False)]
+    for i in range(count):
+        files.append(("res/raw/f%05d.txt" % i, ("entry %d " % i).encode() * rnd.randint(1, 200), False))
+    return files
+
+
+def write(directory, name, apk):
+    with open(os.path.join(directory, name), "wb") as f:
+        f.write(apk)
+    print("%-20s %10d bytes" % (name, len(apk)))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("out")
+    parser.add_argument("--huge-mb", type=int, default=64)
+    parser.add_argument("--many", type=int, default=20000)
+    args = parser.parse_args()
+
+    os.makedirs(args.out, exist_ok=True)
+    keys = os.path.join(args.out, "keys")
+    os.makedirs(keys, exist_ok=True)
+    rsa = make_key(keys, "rsa")
+    ec = make_key(keys, "ec", ec=True)
+    ca = make_key(keys, "ca")
+    rnd = random.Random(1)
+
+    write(args.out, "small.apk", v2_sign(build_zip(v1_sign(entries(5, rnd), [rsa])), [rsa], [V2_ID]))
+    big = entries(5, rnd) + [("assets/huge.bin", os.urandom(args.huge_mb << 20), True)]
+    write(args.out, "huge.apk", v2_sign(build_zip(big), [rsa], [V2_ID, V3_ID]))
+    write(args.out, "many_entries.apk", v2_sign(build_zip(v1_sign(entries(args.many, rnd), [rsa])), [rsa], [V2_ID]))
+    write(args.out, "v1_only.apk", build_zip(v1_sign(entries(50, rnd), [rsa])))
+    write(args.out, "v1_sha1.apk", build_zip(v1_sign(entries(50, rnd), [rsa], sha1=True)))
+    write(args.out, "multi_signer.apk", v2_sign(build_zip(v1_sign(entries(50, rnd), [rsa, ec])), [rsa, ec], [V2_ID]))
+    write(args.out, "long_comment.apk", v2_sign(build_zip(entries(50, rnd), comment=b"c" * 0xffff), [rsa], [V2_ID]))
+    write(args.out, "timestamped.apk", build_zip(v1_sign(entries(50, rnd), [rsa], extra_certs=[ca[0]], attributes=True)))
+    signed = v1_sign(entries(5, rnd), [rsa])
+    write(args.out, "duplicate_entry.apk", build_zip(signed + [(signed[0][0], b"unsigned", False)]))
+
+
+if __name__ == "__main__":
+    main()
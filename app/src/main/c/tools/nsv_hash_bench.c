@@ -0,0 +1,193 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+/*
+ * nsv_hash_bench: SHA-256 and SHA-1 throughput of every implementation the CPU can run (portable, SHA-NI, ARMv8).
+ *
+ * Usage: nsv_hash_bench [-t milliseconds] [-s size,...]
+ *     every implementation hashes every size (64,1024,16384,1048576 bytes) for at least t milliseconds (200)
+ *
+ * One JSON object per implementation, algorithm and size on stdout:
+ *     {"implementation":..., "default":..., "algorithm":..., "size":..., "ok":..., "iterations":...,
+ *      "ns_per_op":..., "mb_per_s":...}
+ * default is true for the implementation hashHelper picks on this CPU, ok is false if its digest differs from
+ * the portable one. An implementation the CPU can't run gets {"implementation":..., "supported":false}.
+ */
+
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+#include "../hash_helper.h"
+
+#define HASH_BENCH_DEFAULT_MILLIS   200
+#define HASH_BENCH_MAX_SIZES        16
+
+static const size_t DEFAULT_SIZES[] = {64, 1024, 16384, 1048576};
+
+static const hashHelperAlgorithm ALGORITHMS[] = {HASH_HELPER_SHA256, HASH_HELPER_SHA1};
+
+static const char *ALGORITHM_NAMES[] = {"sha256", "sha1"};
+
+static uint64_t benchNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static void benchDigest(hashHelperAlgorithm algorithm, const unsigned char *data, size_t len, unsigned char *digest) {
+    hashHelperContext ctx;
+    hashHelperInit(&ctx, algorithm);
+    hashHelperUpdate(&ctx, data, len);
+    hashHelperFinal(&ctx, digest);
+}
+
+/**
+ * Hashes data with the implementation in use until millis have passed, then prints its line.
+ * expected is the digest of the portable implementation, returns whether the digest matches it.
+ */
+static bool benchRun(hashHelperImplementation implementation, bool is_default, size_t algorithm,
+                     const unsigned char *data, size_t len, const unsigned char *expected, uint64_t millis) {
+    unsigned char digest[HASH_HELPER_MAX_SIZE];
+    uint64_t ops = 0, total = 0;
+
+    // warm up the caches and check the result
+    benchDigest(ALGORITHMS[algorithm], data, len, digest);
+    bool ok = memcmp(digest, expected, hashHelperGetSize(ALGORITHMS[algorithm])) == 0;
+
+    uint64_t start = benchNow();
+    while (total < millis * 1000000ULL) {
+        // batches keep the clock out of the numbers of the small sizes
+        for (int i = 0; i < 16; i++) {
+            benchDigest(ALGORITHMS[algorithm], data, len, digest);
+        }
+        ops += 16;
+        total = benchNow() - start;
+    }
+
+    double ns_per_op = (double) total / (double) ops;
+    printf("{\"implementation\":\"%s\",\"default\":%s,\"algorithm\":\"%s\",\"size\":%zu,\"ok\":%s,"
+           "\"iterations\":%" PRIu64 ",\"ns_per_op\":%.1f,\"mb_per_s\":%.1f}\n",
+           hashHelperGetImplementationName(implementation), is_default ? "true" : "false",
+           ALGORITHM_NAMES[algorithm], len, ok ? "true" : "false", ops, ns_per_op,
+           (double) len * 1000.0 / ns_per_op);
+    fflush(stdout);
+    return ok;
+}
+
+static size_t benchParseSizes(char *list, size_t *sizes) {
+    size_t count = 0;
+    char *saveptr = NULL;
+    for (char *item = strtok_r(list, ",", &saveptr); NULL != item; item = strtok_r(NULL, ",", &saveptr)) {
+        char *end;
+        unsigned long long size = strtoull(item, &end, 10);
+        if (*end != '\0' || size == 0 || count == HASH_BENCH_MAX_SIZES) {
+            return 0;
+        }
+        sizes[count++] = (size_t) size;
+    }
+    return count;
+}
+
+static void benchUsage() {
+    fprintf(stderr, "usage: nsv_hash_bench [-t milliseconds] [-s size,...]\n");
+}
+
+int main(int argc, char **argv) {
+    size_t sizes[HASH_BENCH_MAX_SIZES];
+    size_t size_count = sizeof(DEFAULT_SIZES) / sizeof(DEFAULT_SIZES[0]);
+    uint64_t millis = HASH_BENCH_DEFAULT_MILLIS;
+    size_t max_size = 0;
+    int failed = 0;
+    int opt;
+
+    memcpy(sizes, DEFAULT_SIZES, sizeof(DEFAULT_SIZES));
+    while ((opt = getopt(argc, argv, "t:s:h")) != -1) {
+        switch (opt) {
+            case 't':
+                millis = strtoull(optarg, NULL, 10);
+                break;
+            case 's':
+                size_count = benchParseSizes(optarg, sizes);
+                if (size_count == 0) {
+                    benchUsage();
+                    return 2;
+                }
+                break;
+            default:
+                benchUsage();
+                return 2;
+        }
+    }
+    if (optind != argc) {
+        benchUsage();
+        return 2;
+    }
+    for (size_t i = 0; i < size_count; i++) {
+        max_size = sizes[i] > max_size ? sizes[i] : max_size;
+    }
+
+    unsigned char *data = malloc(max_size);
+    unsigned char *expected = malloc(size_count * HASH_HELPER_MAX_SIZE * 2);
+    if (NULL == data || NULL == expected) {
+        fprintf(stderr, "nsv_hash_bench: out of memory\n");
+        free(data);
+        free(expected);
+        return 1;
+    }
+    uint32_t seed = 0x6e7376;
+    for (size_t i = 0; i < max_size; i++) {
+        seed = seed * 1103515245 + 12345;
+        data[i] = (unsigned char) (seed >> 16);
+    }
+
+    hashHelperImplementation picked = hashHelperGetImplementation();
+    hashHelperSetImplementation(HASH_HELPER_PORTABLE);
+    for (size_t s = 0; s < size_count; s++) {
+        for (size_t a = 0; a < 2; a++) {
+            benchDigest(ALGORITHMS[a], data, sizes[s], expected + (s * 2 + a) * HASH_HELPER_MAX_SIZE);
+        }
+    }
+
+    for (int i = 0; i < HASH_HELPER_IMPLEMENTATION_COUNT; i++) {
+        hashHelperImplementation implementation = (hashHelperImplementation) i;
+        if (!hashHelperSetImplementation(implementation)) {
+            printf("{\"implementation\":\"%s\",\"supported\":false}\n", hashHelperGetImplementationName(implementation));
+            continue;
+        }
+        for (size_t a = 0; a < 2; a++) {
+            for (size_t s = 0; s < size_count; s++) {
+                if (!benchRun(implementation, implementation == picked, a, data, sizes[s],
+                              expected + (s * 2 + a) * HASH_HELPER_MAX_SIZE, millis)) {
+                    failed = 1;
+                }
+            }
+        }
+    }
+    hashHelperSetImplementation(picked);
+    free(data);
+    free(expected);
+    return failed;
+}
@@ -0,0 +1,246 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+/*
+ * nsv_scan: finds and fingerprints the signers of many APKs at once, e.g. in a distribution pipeline.
+ *
+ * Usage: nsv_scan [-j threads] <apk | directory | -> ...
+ *     a directory is searched for *.apk recursively, '-' reads one path per line from stdin
+ *
+ * One line per APK on stdout, tab separated:
+ *     path  scheme(v3|v2|v1|-)  SHA-256 of the signer certificate  bytes  milliseconds  MB/s
+ * A summary goes to stderr. The exit code is 1 if a signer was not found in some APK.
+ */
+
+#include <ftw.h>
+#include <time.h>
+#include <errno.h>
+#include <strings.h>
+#include <sys/mman.h>
+
+#include "../unzip_helper.h"
+#include "../pkcs7_helper.h"
+#include "../sign_block_helper.h"
+#include "../hash_helper.h"
+#include "../thread_helper.h"
+
+typedef struct scanPaths {
+    char **items;
+    size_t count;
+    size_t capacity;
+} scanPaths;
+
+typedef struct scanJob {
+    scanPaths *paths;
+    uint64_t bytes;
+    size_t failed;
+} scanJob;
+
+static scanPaths *nftwPaths = NULL;
+
+
+static uint64_t scanNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static bool scanAddPath(scanPaths *paths, const char *path) {
+    if (paths->count == paths->capacity) {
+        size_t capacity = paths->capacity ? paths->capacity * 2 : 256;
+        char **items = realloc(paths->items, capacity * sizeof(char *));
+        if (NULL == items) {
+            return false;
+        }
+        paths->items = items;
+        paths->capacity = capacity;
+    }
+    paths->items[paths->count] = strdup(path);
+    if (NULL == paths->items[paths->count]) {
+        return false;
+    }
+    paths->count++;
+    return true;
+}
+
+static int scanVisit(const char *path, const struct stat *st, int type, struct FTW *ftw) {
+    size_t len = strlen(path);
+    (void) st;
+    (void) ftw;
+    if (type == FTW_F && len > 4 && strcasecmp(path + len - 4, ".apk") == 0) {
+        return scanAddPath(nftwPaths, path) ? 0 : -1;
+    }
+    return 0;
+}
+
+static bool scanCollect(scanPaths *paths, const char *arg) {
+    struct stat st;
+
+    if (strcmp(arg, "-") == 0) {
+        char *line = NULL;
+        size_t size = 0;
+        ssize_t len;
+        while ((len = getline(&line, &size, stdin)) > 0) {
+            while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+                line[--len] = '\0';
+            }
+            if (len > 0 && !scanAddPath(paths, line)) {
+                free(line);
+                return false;
+            }
+        }
+        free(line);
+        return true;
+    }
+    if (stat(arg, &st) == 0 && S_ISDIR(st.st_mode)) {
+        nftwPaths = paths;
+        return nftw(arg, scanVisit, 32, FTW_PHYS) == 0;
+    }
+    return scanAddPath(paths, arg);
+}
+
+/**
+ * Takes the certificate from the APK Signing Block, from the v1 signature otherwise.
+ * The result points into *content, which the caller frees.
+ */
+static unsigned char *scanGetCertificate(unzipHelperArchive *archive, unsigned char **content, size_t *len,
+                                         const char **scheme) {
+    uint32_t id = 0;
+    size_t len_in = 0;
+
+    *content = signBlockHelperGetCertificate(archive, len, &id);
+    if (NULL != *content) {
+        *scheme = id == SIGN_BLOCK_ID_V3 ? "v3" : "v2";
+        return *content;
+    }
+    *content = unzipHelperReadCertificates(archive, &len_in);
+    if (NULL == *content) {
+        return NULL;
+    }
+    *scheme = "v1";
+    return pkcs7HelperGetSignerCertificate(*content, len_in, len);
+}
+
+static void scanApk(void *ctx, size_t index, size_t worker) {
+    scanJob *job = ctx;
+    const char *path = job->paths->items[index];
+    unsigned char fingerprints[HASH_HELPER_FINGERPRINTS_SIZE];
+    char hex[HASH_HELPER_SHA256_SIZE * 2 + 1] = "-";
+    const char *scheme = "-";
+    unsigned char *content = NULL;
+    unsigned char *certificate = NULL;
+    unzipHelperArchive archive;
+    size_t len = 0;
+    void *base = MAP_FAILED;
+    struct stat st;
+    uint64_t start = scanNow();
+    (void) worker;
+
+    memset(&st, 0, sizeof(st));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) {
+        base = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    int32_t err = base != MAP_FAILED ? unzipHelperOpenMemory(&archive, base, (size_t) st.st_size) : MZ_PARAM_ERROR;
+    if (err != MZ_OK) {
+        // too big for a memory stream or could not be mapped
+        err = unzipHelperOpen(&archive, path);
+    }
+    if (err == MZ_OK) {
+        certificate = scanGetCertificate(&archive, &content, &len, &scheme);
+        unzipHelperClose(&archive);
+    }
+    if (base != MAP_FAILED) {
+        munmap(base, (size_t) st.st_size);
+    }
+    if (NULL != certificate) {
+        hashHelperFingerprints(certificate, len, HASH_HELPER_FINGERPRINT_SHA256, fingerprints);
+        for (size_t i = 0; i < HASH_HELPER_SHA256_SIZE; i++) {
+            snprintf(hex + i * 2, 3, "%02x", fingerprints[i]);
+        }
+    } else {
+        scheme = "-";
+        __atomic_fetch_add(&job->failed, 1, __ATOMIC_RELAXED);
+    }
+    free(content);
+    __atomic_fetch_add(&job->bytes, (uint64_t) st.st_size, __ATOMIC_RELAXED);
+
+    double ms = (double) (scanNow() - start) / 1e6;
+    double mbps = ms > 0 ? (double) st.st_size / (1024.0 * 1024.0) / (ms / 1000.0) : 0;
+    flockfile(stdout);
+    printf("%s\t%s\t%s\t%lld\t%.3f\t%.1f\n", path, scheme, hex, (long long) st.st_size, ms, mbps);
+    funlockfile(stdout);
+}
+
+static void scanUsage() {
+    fprintf(stderr, "usage: nsv_scan [-j threads] <apk | directory | -> ...\n");
+}
+
+int main(int argc, char **argv) {
+    scanPaths paths = {NULL, 0, 0};
+    scanJob job = {&paths, 0, 0};
+    size_t workers = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "j:h")) != -1) {
+        switch (opt) {
+            case 'j':
+                workers = (size_t) strtoul(optarg, NULL, 10);
+                break;
+            default:
+                scanUsage();
+                return 2;
+        }
+    }
+    if (optind == argc) {
+        scanUsage();
+        return 2;
+    }
+    for (int i = optind; i < argc; i++) {
+        if (!scanCollect(&paths, argv[i])) {
+            fprintf(stderr, "nsv_scan: can't read %s: %s\n", argv[i], strerror(errno));
+            return 2;
+        }
+    }
+    if (workers == 0) {
+        workers = threadHelperGetWorkerCount(paths.count);
+    }
+
+    uint64_t start = scanNow();
+    threadHelperRun(scanApk, &job, paths.count, workers);
+    double seconds = (double) (scanNow() - start) / 1e9;
+
+    fprintf(stderr, "%zu APKs, %zu without a signer, %.1f MB in %.3f s on %zu threads: %.1f MB/s, %.1f APKs/s\n",
+            paths.count, job.failed, (double) job.bytes / (1024.0 * 1024.0), seconds, workers,
+            seconds > 0 ? (double) job.bytes / (1024.0 * 1024.0) / seconds : 0,
+            seconds > 0 ? (double) paths.count / seconds : 0);
+
+    for (size_t i = 0; i < paths.count; i++) {
+        free(paths.items[i]);
+    }
+    free(paths.items);
+    return job.failed ? 1 : 0;
+}
@@ -0,0 +1,53 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include "trust_helper.h"
+#include "trusted_signers.h"
+
+
+/**
+ * Number of certificates built in with NSV_TRUSTED_SIGNERS.
+ */
+size_t trustHelperGetCount() {
+    return TRUSTED_SIGNERS_COUNT;
+}
+
+/**
+ * Checks digest, the SHA-256 of the certificate an APK signature was verified with, against every built-in digest.
+ * The whole table is always compared byte by byte, so the time taken does not tell
+ * which digest or how many bytes matched.
+ */
+bool trustHelperIsTrustedDigest(const unsigned char *digest) {
+    unsigned int found = 0;
+
+    // the padding row is left out
+    for (size_t i = 0; i + 1 < sizeof(TRUSTED_SIGNERS) / sizeof(TRUSTED_SIGNERS[0]); i++) {
+        unsigned int diff = 0;
+        for (size_t j = 0; j < HASH_HELPER_SHA256_SIZE; j++) {
+            diff |= digest[j] ^ TRUSTED_SIGNERS[i][j];
+        }
+        // 1 when diff is 0, without a branch
+        found |= 1 & ((diff - 1) >> 8);
+    }
+    return found != 0;
+}
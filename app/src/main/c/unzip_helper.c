@@ -42,42 +42,27 @@ int string_ends_with(const char *str, const char *suffix){
 
 
 //return MZ_ERROR
-static int32_t unzipHelperGetCertFileInfo(void *handle, mz_zip_file **file_info) {
-
-    int32_t err = MZ_OK;
+static int32_t unzipHelperFindCertFile(void *handle, mz_zip_file **file_info) {
 
-    err = mz_zip_goto_first_entry(handle);
-
-    if (err != MZ_OK && err != MZ_END_OF_LIST) {
-        NSV_LOGE("Error %d going to first entry in zip file\n", err);
-        return err;
-    }
+    // only the META-INF/ entries are visited, straight from the index if the archive has one
+    int32_t err = mz_zip_locate_first_match(handle, "META-INF/", NULL, 1);
 
     while (err == MZ_OK) {
         err = mz_zip_entry_get_info(handle, file_info);
 
         if (err != MZ_OK) {
             NSV_LOGE("Error %d getting entry info in zip file\n", err);
-            *file_info = NULL;
             break;
         }
 
         //Return MZ_OK if is a certificate file
-        if (NULL != (*file_info)->filename && string_starts_with((*file_info)->filename, "META-INF/")) {
-            if(string_ends_with((*file_info)->filename, ".RSA")
-               || string_ends_with((*file_info)->filename, ".DSA")
-               || string_ends_with((*file_info)->filename, ".EC")){
-                return MZ_OK;
-            }
+        if (string_ends_with((*file_info)->filename, ".RSA")
+            || string_ends_with((*file_info)->filename, ".DSA")
+            || string_ends_with((*file_info)->filename, ".EC")) {
+            return MZ_OK;
         }
 
-        err = mz_zip_goto_next_entry(handle);
-
-        if (err != MZ_OK && err != MZ_END_OF_LIST) {
-            *file_info = NULL;
-            NSV_LOGE("Error %d going to next entry in zip file\n", err);
-            return err;
-        }
+        err = mz_zip_locate_next_match(handle, "META-INF/", NULL, 1);
     }
 
     *file_info = NULL;
@@ -85,6 +70,18 @@ static int32_t unzipHelperGetCertFileInfo(void *handle, mz_zip_file **file_info)
     if (err == MZ_END_OF_LIST) {
         return MZ_OK;
     }
+    NSV_LOGE("Error %d looking for the signature file in zip file\n", err);
+    return err;
+}
+
+static int32_t unzipHelperGetCertFileInfo(void *handle, mz_zip_file **file_info) {
+    statsHelperTimer timer;
+    uint64_t cd_size = 0;
+
+    statsHelperStart(&timer, STATS_HELPER_CD_SCAN);
+    int32_t err = unzipHelperFindCertFile(handle, file_info);
+    mz_zip_get_cd_size(handle, &cd_size);
+    statsHelperStop(&timer, cd_size);
     return err;
 }
 
@@ -134,85 +131,337 @@ static void unzipHelperPrintFileInfo(const mz_zip_file *file_info) {
 
 }
 
-unsigned char *unzipHelperGetCertificateDetails(const char *fullApkPath, size_t *len) {
+static int32_t unzipHelperOpenPread(unzipHelperArchive *archive, const char *fullApkPath) {
 
-    unsigned char *result = NULL;
     int32_t err = 0;
-    int32_t read_file = 0;
 
-    void *handle = NULL;
-    void *file_stream = NULL;
-    void *split_stream = NULL;
-    void *buf_stream = NULL;
-    char *password = NULL;
+    mz_stream_pread_create(&archive->pread_stream);
+    if (NULL == archive->pread_stream) {
+        return MZ_MEM_ERROR;
+    }
+    err = mz_stream_pread_open(archive->pread_stream, fullApkPath, MZ_OPEN_MODE_READ);
+    if (err != MZ_OK) {
+        NSV_LOGE("Error opening file %s\n", fullApkPath);
+        unzipHelperClose(archive);
+        return err;
+    }
+    archive->stream = archive->pread_stream;
+    return MZ_OK;
+}
 
-    int64_t disk_size = 0;
+static int32_t unzipHelperOpenFile(unzipHelperArchive *archive, const char *fullApkPath) {
+
+    int32_t err = 0;
+    int64_t size = 0;
     int16_t mode = MZ_OPEN_MODE_READ;
-    int32_t err_close = 0;
+
+    memset(archive, 0, sizeof(unzipHelperArchive));
+    archive->name = fullApkPath;
 
     if (mz_os_file_exists(fullApkPath) != MZ_OK) {
         NSV_LOGE("file %s doesn't exit\n", fullApkPath);
 
     }
-    mz_stream_os_create(&file_stream);
-    mz_stream_buffered_create(&buf_stream);
-    mz_stream_split_create(&split_stream);
+    // mapped, the reads are pointer arithmetic and the readers needing whole ranges borrow them through base
+    mz_stream_mmap_create(&archive->mmap_stream);
+    if (NULL != archive->mmap_stream
+        && mz_stream_mmap_open(archive->mmap_stream, fullApkPath, mode) == MZ_OK
+        && mz_stream_mmap_get_buffer(archive->mmap_stream, (const void **) &archive->base, &size) == MZ_OK
+        && NULL != archive->base) {
+        archive->size = (size_t) size;
+        archive->stream = archive->mmap_stream;
+    } else {
+        // can't be mapped (or is empty), read with pread then
+        mz_stream_mmap_delete(&archive->mmap_stream);
+        archive->base = NULL;
+        err = unzipHelperOpenPread(archive, fullApkPath);
+        if (err != MZ_OK) {
+            return err;
+        }
+    }
 
-    mz_stream_set_base(split_stream, file_stream);
+    // the central directory is read at once and its headers decoded from memory
+    archive->handle = mz_zip_open(archive->stream, mode | MZ_OPEN_MODE_LOAD_CD);
+    if (archive->handle == NULL) {
+        NSV_LOGE("Error opening zip %s\n", fullApkPath);
+        unzipHelperClose(archive);
+        return MZ_FORMAT_ERROR;
+    }
+    return MZ_OK;
+}
 
-    mz_stream_split_set_prop_int64(split_stream, MZ_STREAM_PROP_DISK_SIZE, disk_size);
+int32_t unzipHelperOpen(unzipHelperArchive *archive, const char *fullApkPath) {
+    statsHelperTimer timer;
+    statsHelperStart(&timer, STATS_HELPER_ZIP_OPEN);
+    int32_t err = unzipHelperOpenFile(archive, fullApkPath);
+    statsHelperStop(&timer, 0);
+    return err;
+}
 
-    err = mz_stream_open(split_stream, fullApkPath, mode);
-    mz_zip_file *file_info = NULL;
-    if (err != MZ_OK) {
-        NSV_LOGE("Error opening file %s\n", fullApkPath);
+static int32_t unzipHelperOpenBuffer(unzipHelperArchive *archive, const void *base, size_t size) {
+
+    memset(archive, 0, sizeof(unzipHelperArchive));
+    archive->name = "<mapped apk>";
+
+    // mz_stream_mem keeps its size in int32_t
+    if (NULL == base || size == 0 || size > INT32_MAX) {
+        return MZ_PARAM_ERROR;
+    }
+    mz_stream_mem_create(&archive->mem_stream);
+    if (NULL == archive->mem_stream) {
+        return MZ_MEM_ERROR;
+    }
+    mz_stream_mem_set_buffer(archive->mem_stream, (void *) base, (int32_t) size);
+
+    if (mz_stream_mem_open(archive->mem_stream, NULL, MZ_OPEN_MODE_READ) != MZ_OK) {
+        NSV_LOGE("Error opening memory stream\n");
+        unzipHelperClose(archive);
+        return MZ_STREAM_ERROR;
+    }
+    archive->stream = archive->mem_stream;
+    archive->base = base;
+    archive->size = size;
+
+    archive->handle = mz_zip_open(archive->stream, MZ_OPEN_MODE_READ | MZ_OPEN_MODE_LOAD_CD);
+    if (archive->handle == NULL) {
+        NSV_LOGE("Error opening zip %s\n", archive->name);
+        unzipHelperClose(archive);
+        return MZ_FORMAT_ERROR;
+    }
+    return MZ_OK;
+}
+
+/**
+ * The same as unzipHelperOpen() but the APK is read from memory,
+ * e.g. from the mapping the runtime has already made, so no file is opened and nothing is read(2).
+ */
+int32_t unzipHelperOpenMemory(unzipHelperArchive *archive, const void *base, size_t size) {
+    statsHelperTimer timer;
+    statsHelperStart(&timer, STATS_HELPER_ZIP_OPEN);
+    int32_t err = unzipHelperOpenBuffer(archive, base, size);
+    statsHelperStop(&timer, 0);
+    return err;
+}
+
+/**
+ * Indexes the central directory by name in one pass, see mz_zip_build_index(). Worth it on archives of many
+ * entries before several lookups: they jump to their entry instead of reading every header before it.
+ */
+int32_t unzipHelperBuildIndex(unzipHelperArchive *archive) {
+    statsHelperTimer timer;
+    uint64_t cd_size = 0;
+
+    statsHelperStart(&timer, STATS_HELPER_CD_SCAN);
+    int32_t err = mz_zip_build_index(archive->handle);
+    mz_zip_get_cd_size(archive->handle, &cd_size);
+    statsHelperStop(&timer, cd_size);
+    return err;
+}
+
+static int32_t unzipHelperCloneArchive(const unzipHelperArchive *source, unzipHelperArchive *archive) {
+
+    int32_t err = MZ_OK;
+
+    memset(archive, 0, sizeof(unzipHelperArchive));
+    archive->name = source->name;
+
+    if (NULL == source->handle) {
+        return MZ_PARAM_ERROR;
+    }
+    if (NULL != source->base && source->size <= INT32_MAX) {
+        // a cursor over the same mapping or buffer
+        mz_stream_mem_create(&archive->mem_stream);
+        if (NULL == archive->mem_stream) {
+            return MZ_MEM_ERROR;
+        }
+        mz_stream_mem_set_buffer(archive->mem_stream, (void *) source->base, (int32_t) source->size);
+        err = mz_stream_mem_open(archive->mem_stream, NULL, MZ_OPEN_MODE_READ);
+        archive->stream = archive->mem_stream;
+        archive->base = source->base;
+        archive->size = source->size;
+    } else if (NULL != source->pread_stream) {
+        // a cursor over the same descriptor
+        err = mz_stream_pread_clone(source->pread_stream, &archive->pread_stream);
+        archive->stream = archive->pread_stream;
     } else {
-        handle = mz_zip_open(split_stream, mode);
+        // mapped but too large for mz_stream_mem, the file is opened once more
+        err = unzipHelperOpenPread(archive, source->name);
+    }
+    if (err != MZ_OK) {
+        unzipHelperClose(archive);
+        return err;
+    }
+
+    archive->handle = mz_zip_open_clone(source->handle, archive->stream);
+    if (archive->handle == NULL) {
+        NSV_LOGE("Error cloning zip %s\n", archive->name);
+        unzipHelperClose(archive);
+        return MZ_MEM_ERROR;
+    }
+    return MZ_OK;
+}
+
+/**
+ * Opens another handle on an opened APK for another thread, see mz_zip_open_clone(): it reads through
+ * a cursor of its own over the mapping or descriptor of source, and shares its central directory and index.
+ * source must stay open until archive is closed.
+ */
+int32_t unzipHelperClone(const unzipHelperArchive *source, unzipHelperArchive *archive) {
+    statsHelperTimer timer;
+    statsHelperStart(&timer, STATS_HELPER_ZIP_OPEN);
+    int32_t err = unzipHelperCloneArchive(source, archive);
+    statsHelperStop(&timer, 0);
+    return err;
+}
+
+void unzipHelperClose(unzipHelperArchive *archive) {
+
+    int32_t err_close = 0;
+
+    if (archive->handle != NULL) {
+        err_close = mz_zip_close(archive->handle);
+
+        if (err_close != MZ_OK) {
+            NSV_LOGE("Error in closing %s (%d)\n", archive->name, err_close);
+        }
+    }
+    if (archive->stream != NULL) {
+        mz_stream_close(archive->stream);
+    }
+    if (archive->pread_stream != NULL) {
+        mz_stream_pread_delete(&archive->pread_stream);
+    }
+    if (archive->mem_stream != NULL) {
+        mz_stream_mem_delete(&archive->mem_stream);
+    }
+    if (archive->mmap_stream != NULL) {
+        mz_stream_mmap_delete(&archive->mmap_stream);
+    }
+    memset(archive, 0, sizeof(unzipHelperArchive));
+}
+
+/**
+ * Extracts the first signature file (META-INF .RSA, .DSA or .EC) of an opened archive.
+ */
+unsigned char *unzipHelperReadCertificate(unzipHelperArchive *archive, size_t *len) {
+
+    unsigned char *result = NULL;
+    int32_t err = 0;
+    int32_t err_close = 0;
+    int32_t read_file = 0;
+    statsHelperTimer timer;
+
+    void *handle = archive->handle;
+    char *password = NULL;
 
-        if (handle == NULL) {
-            NSV_LOGE("Error opening zip %s\n", fullApkPath);
-            err = MZ_FORMAT_ERROR;
+    mz_zip_file *file_info = NULL;
+    err = unzipHelperGetCertFileInfo(handle, &file_info);
+    if (err == MZ_OK && NULL != file_info) {
+        unzipHelperPrintFileInfo(file_info);
+        //unzip
+        statsHelperStart(&timer, STATS_HELPER_INFLATE);
+        err = mz_zip_entry_read_open(handle, 0, password);
+        if (err != MZ_OK) {
+            NSV_LOGW("Error %d opening entry in zip file\n", err);
         } else {
-            err = unzipHelperGetCertFileInfo(handle, &file_info);
-            if (err == MZ_OK && NULL != file_info) {
-                unzipHelperPrintFileInfo(file_info);
-                //unzip
-                err = mz_zip_entry_read_open(handle, 0, password);
-                if (err != MZ_OK) {
-                    NSV_LOGW("Error %d opening entry in zip file\n", err);
+            result = statsHelperCalloc(file_info->uncompressed_size, sizeof(unsigned char));
+            if (NULL != result) {
+                read_file = mz_zip_entry_read(handle, result,
+                                              (uint32_t) (file_info->uncompressed_size));
+                if (read_file < 0) {
+                    free(result);
+                    result = NULL;
+                    err = read_file;
+                    NSV_LOGW("Error %d reading entry in zip file\n", err);
                 } else {
-                    result = calloc(file_info->uncompressed_size, sizeof(unsigned char));
-                    if (NULL != result) {
-                        read_file = mz_zip_entry_read(handle, result,
-                                                      (uint32_t) (file_info->uncompressed_size));
-                        if (read_file < 0) {
-                            free(result);
-                            result = NULL;
-                            err = read_file;
-                            NSV_LOGW("Error %d reading entry in zip file\n", err);
-                        } else {
-                            NSV_LOGI("read %d from zip file\n", read_file);
-                            *len = (size_t) read_file;
-                        }
-                    }
+                    NSV_LOGI("read %d from zip file\n", read_file);
+                    *len = (size_t) read_file;
                 }
             }
+            // the CRC is checked when the entry is closed, a signature file failing it is not returned
+            err_close = mz_zip_entry_close(handle);
+            if (err_close != MZ_OK) {
+                NSV_LOGE("Error in closing %s (%d)\n", file_info->filename, err_close);
+                err = err_close;
+            }
         }
+        statsHelperStop(&timer, read_file > 0 ? (uint64_t) read_file : 0);
+    }
+    if (err != MZ_OK && NULL != result) {
+        free(result);
+        result = NULL;
+        *len = 0;
+    }
+    return result;
+}
 
-        err_close = mz_zip_close(handle);
+/**
+ * Like unzipHelperReadCertificate() but only the certificates element of the signature file is returned,
+ * followed by the signerInfos if it holds a chain, see pkcs7HelperGetSignerCertificate().
+ * The entry is inflated UNZIP_HELPER_CHUNK_SIZE bytes at a time and no further than the end of what is kept,
+ * so behind a single certificate timestamps and the signerInfos are never inflated.
+ */
+unsigned char *unzipHelperReadCertificates(unzipHelperArchive *archive, size_t *len) {
 
-        if (err_close != MZ_OK) {
-            NSV_LOGE("Error in closing %s (%d)\n", fullApkPath, err_close);
-            err = err_close;
-        }
+    unsigned char chunk[UNZIP_HELPER_CHUNK_SIZE];
+    unsigned char *result = NULL;
+    pkcs7HelperStream stream;
+    int32_t read_file = 0;
+    statsHelperTimer timer;
 
-        mz_stream_close(split_stream);
+    void *handle = archive->handle;
 
+    mz_zip_file *file_info = NULL;
+    int32_t err = unzipHelperGetCertFileInfo(handle, &file_info);
+    if (err != MZ_OK || NULL == file_info) {
+        return NULL;
+    }
+    unzipHelperPrintFileInfo(file_info);
+    statsHelperStart(&timer, STATS_HELPER_INFLATE);
+    err = mz_zip_entry_read_open(handle, 0, NULL);
+    if (err != MZ_OK) {
+        NSV_LOGW("Error %d opening entry in zip file\n", err);
+        statsHelperStop(&timer, 0);
+        return NULL;
+    }
+    pkcs7HelperStreamInit(&stream, (size_t) file_info->uncompressed_size);
+    while (!stream.done && (read_file = mz_zip_entry_read(handle, chunk, sizeof(chunk))) > 0) {
+        if (!pkcs7HelperStreamWrite(&stream, chunk, (size_t) read_file)) {
+            break;
+        }
     }
-    mz_stream_split_delete(&split_stream);
-    mz_stream_buffered_delete(&buf_stream);
-    mz_stream_os_delete(&file_stream);
+    if (read_file < 0) {
+        NSV_LOGW("Error %d reading entry in zip file\n", read_file);
+    }
+    NSV_LOGI("read %" PRIu64 " of %" PRIu64 " from zip file\n", stream.pos, file_info->uncompressed_size);
+    // the rest of the entry is not inflated, so its CRC can't be checked on close
+    mz_zip_entry_close(handle);
+    statsHelperStop(&timer, stream.pos);
+    result = pkcs7HelperStreamTake(&stream, len);
+    pkcs7HelperStreamFree(&stream);
+    return result;
+}
+
+unsigned char *unzipHelperGetCertificateDetails(const char *fullApkPath, size_t *len) {
+
+    unsigned char *result = NULL;
+    unzipHelperArchive archive;
 
+    if (unzipHelperOpen(&archive, fullApkPath) == MZ_OK) {
+        result = unzipHelperReadCertificate(&archive, len);
+        unzipHelperClose(&archive);
+    }
     return result;
 }
 
+unsigned char *unzipHelperGetCertificateDetailsFromMemory(const void *base, size_t size, size_t *len) {
+
+    unsigned char *result = NULL;
+    unzipHelperArchive archive;
+
+    if (unzipHelperOpenMemory(&archive, base, size) == MZ_OK) {
+        result = unzipHelperReadCertificate(&archive, len);
+        unzipHelperClose(&archive);
+    }
+    return result;
+}
@@ -36,15 +36,54 @@ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 #include "third/minizip/mz_os.h"
 #include "third/minizip/mz_strm.h"
 #include "third/minizip/mz_strm_mem.h"
+#include "third/minizip/mz_strm_mmap.h"
+#include "third/minizip/mz_strm_pread.h"
 #include "third/minizip/mz_strm_bzip.h"
 #include "third/minizip/mz_strm_zlib.h"
 #include "third/minizip/mz_zip.h"
 #include "third/minizip/mz_strm_split.h"
 #include "third/minizip/mz_strm_buf.h"
 
+#include "pkcs7_helper.h"
+#include "stats_helper.h"
 #include "def.h"
 
+// the signature file is inflated in pieces of this size until its certificates are complete
+#define UNZIP_HELPER_CHUNK_SIZE     4096
+
+
+/**
+ * An opened APK: the mz_zip handle and the streams it is read through.
+ * base/size are set when the APK is read from memory or mapped.
+ */
+typedef struct unzipHelperArchive {
+    void *handle;
+    void *stream;
+    void *pread_stream;
+    void *mem_stream;
+    void *mmap_stream;
+    const unsigned char *base;
+    size_t size;
+    const char *name;
+} unzipHelperArchive;
+
+
+int32_t unzipHelperOpen(unzipHelperArchive * archive, const char * fullApkPath);
+
+int32_t unzipHelperOpenMemory(unzipHelperArchive * archive, const void * base, size_t size);
+
+int32_t unzipHelperBuildIndex(unzipHelperArchive * archive);
+
+int32_t unzipHelperClone(const unzipHelperArchive * source, unzipHelperArchive * archive);
+
+void unzipHelperClose(unzipHelperArchive * archive);
+
+unsigned char * unzipHelperReadCertificate(unzipHelperArchive * archive, size_t * len);
+
+unsigned char * unzipHelperReadCertificates(unzipHelperArchive * archive, size_t * len);
 
 unsigned char * unzipHelperGetCertificateDetails(const char * fullApkPath, size_t * len);
 
+unsigned char * unzipHelperGetCertificateDetailsFromMemory(const void * base, size_t size, size_t * len);
+
 #endif //NATIVESIGNATUREVERIFICATION_UNZIP_HELPER_H
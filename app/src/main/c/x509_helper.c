@@ -0,0 +1,473 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include "x509_helper.h"
+
+/*Certificate structure, RFC 5280
+*certificate : SEQUENCE
+*	tbsCertificate : SEQUENCE
+*		version[optional] : [0] INTEGER
+*		serialNumber : INTEGER
+*		signature : SEQUENCE : AlgorithmIdentifier
+*		issuer : SEQUENCE OF RelativeDistinguishedName : SET OF SEQUENCE {type : ObjectIdentifier, value}
+*		validity : SEQUENCE {notBefore : Time, notAfter : Time}	#UTCTime or GeneralizedTime
+*		subject : SEQUENCE OF RelativeDistinguishedName
+*		subjectPublicKeyInfo : SEQUENCE
+*		...
+*	signatureAlgorithm : SEQUENCE : AlgorithmIdentifier
+*	signatureValue : BITSTRING
+*/
+
+// string types of attribute values
+#define TAG_UTF8STRING          0x0c
+#define TAG_PRINTABLESTRING     0x13
+#define TAG_TELETEXSTRING       0x14
+#define TAG_IA5STRING           0x16
+#define TAG_UNIVERSALSTRING     0x1c
+#define TAG_BMPSTRING           0x1e
+
+// name/RDN/attribute/type and value
+#define X509_HELPER_NAME_DEPTH  3
+
+static const derHelperStep PATH_TBS[] = {
+        {TAG_SEQUENCE, 0},
+        {TAG_SEQUENCE, 0}
+};
+
+static const derHelperStep PATH_SIGNATURE_ALGORITHM[] = {
+        {TAG_SEQUENCE, 0},
+        {TAG_SEQUENCE, 1}
+};
+
+static const derHelperStep PATH_SIGNATURE[] = {
+        {TAG_SEQUENCE,  0},
+        {TAG_BITSTRING, 0}
+};
+
+/**
+ * The keywords RFC 2253 has for attribute types, the encoded OID without tag and length.
+ * The others are printed as dotted OIDs, their values in hex.
+ */
+static const struct {
+    const char *name;
+    unsigned char len;
+    unsigned char oid[10];
+} ATTRIBUTE_TYPES[] = {
+        {"CN",           3,  {0x55, 0x04, 0x03}},
+        {"C",            3,  {0x55, 0x04, 0x06}},
+        {"L",            3,  {0x55, 0x04, 0x07}},
+        {"ST",           3,  {0x55, 0x04, 0x08}},
+        {"STREET",       3,  {0x55, 0x04, 0x09}},
+        {"O",            3,  {0x55, 0x04, 0x0a}},
+        {"OU",           3,  {0x55, 0x04, 0x0b}},
+        {"DC",           10, {0x09, 0x92, 0x26, 0x89, 0x93, 0xf2, 0x2c, 0x64, 0x01, 0x19}},
+        {"UID",          10, {0x09, 0x92, 0x26, 0x89, 0x93, 0xf2, 0x2c, 0x64, 0x01, 0x01}}
+};
+
+/**
+ * Appends to a string of bounded size, overflow is set once something did not fit.
+ */
+typedef struct x509HelperWriter {
+    char *out;
+    size_t size;
+    size_t len;
+    bool overflow;
+} x509HelperWriter;
+
+
+static void x509HelperPut(x509HelperWriter *writer, const char *s, size_t n) {
+    if (writer->overflow || n >= writer->size - writer->len) {
+        writer->overflow = true;
+        return;
+    }
+    memcpy(writer->out + writer->len, s, n);
+    writer->len += n;
+    writer->out[writer->len] = '\0';
+}
+
+static void x509HelperPutCodePoint(x509HelperWriter *writer, uint32_t c) {
+    char utf8[4];
+    size_t n;
+
+    if (c < 0x80) {
+        utf8[0] = (char) c;
+        n = 1;
+    } else if (c < 0x800) {
+        utf8[0] = (char) (0xc0 | (c >> 6));
+        utf8[1] = (char) (0x80 | (c & 0x3f));
+        n = 2;
+    } else if (c < 0x10000) {
+        utf8[0] = (char) (0xe0 | (c >> 12));
+        utf8[1] = (char) (0x80 | ((c >> 6) & 0x3f));
+        utf8[2] = (char) (0x80 | (c & 0x3f));
+        n = 3;
+    } else if (c < 0x110000) {
+        utf8[0] = (char) (0xf0 | (c >> 18));
+        utf8[1] = (char) (0x80 | ((c >> 12) & 0x3f));
+        utf8[2] = (char) (0x80 | ((c >> 6) & 0x3f));
+        utf8[3] = (char) (0x80 | (c & 0x3f));
+        n = 4;
+    } else {
+        // not a code point, U+FFFD
+        utf8[0] = (char) 0xef;
+        utf8[1] = (char) 0xbf;
+        utf8[2] = (char) 0xbd;
+        n = 3;
+    }
+    x509HelperPut(writer, utf8, n);
+}
+
+static void x509HelperPutOid(x509HelperWriter *writer, const unsigned char *oid, size_t len) {
+    char number[48];
+    uint64_t value = 0;
+    bool first = true;
+
+    for (size_t i = 0; i < len; i++) {
+        if (value > (UINT64_MAX >> 7)) {
+            writer->overflow = true;
+            return;
+        }
+        value = (value << 7) | (oid[i] & 0x7f);
+        if (oid[i] & 0x80) {
+            continue;
+        }
+        int n;
+        if (first) {
+            // the first subidentifier holds the first two arcs
+            unsigned top = value < 80 ? (unsigned) (value / 40) : 2;
+            n = snprintf(number, sizeof(number), "%u.%" PRIu64, top, value - top * 40);
+            first = false;
+        } else {
+            n = snprintf(number, sizeof(number), ".%" PRIu64, value);
+        }
+        x509HelperPut(writer, number, (size_t) n);
+        value = 0;
+    }
+}
+
+/**
+ * Appends the keyword of an attribute type, its dotted OID if it has none. Returns whether it had a keyword.
+ */
+static bool x509HelperPutType(x509HelperWriter *writer, const unsigned char *oid, size_t len) {
+    for (size_t i = 0; i < sizeof(ATTRIBUTE_TYPES) / sizeof(ATTRIBUTE_TYPES[0]); i++) {
+        if (ATTRIBUTE_TYPES[i].len == len && memcmp(ATTRIBUTE_TYPES[i].oid, oid, len) == 0) {
+            x509HelperPut(writer, ATTRIBUTE_TYPES[i].name, strlen(ATTRIBUTE_TYPES[i].name));
+            return true;
+        }
+    }
+    x509HelperPutOid(writer, oid, len);
+    return false;
+}
+
+/**
+ * Appends one character of a value, escaped as RFC 2253 asks.
+ */
+static void x509HelperPutEscaped(x509HelperWriter *writer, uint32_t c, bool first, bool last) {
+    if (c == ',' || c == '+' || c == '"' || c == '\\' || c == '<' || c == '>' || c == ';'
+        || (first && (c == '#' || c == ' ')) || (last && c == ' ')) {
+        x509HelperPut(writer, "\\", 1);
+    }
+    x509HelperPutCodePoint(writer, c);
+}
+
+/**
+ * Appends an attribute value: strings as UTF-8, anything else, or any value when hex is set,
+ * as '#' and the hex of its DER encoding.
+ */
+static void x509HelperPutValue(x509HelperWriter *writer, const unsigned char *der, const derHelperToken *value,
+                               bool hex) {
+    const unsigned char *p = der + value->offset + value->header;
+    size_t len = value->len;
+    size_t unit;
+
+    switch (hex ? DER_HELPER_ANY : value->tag) {
+        case TAG_UTF8STRING:
+        case TAG_PRINTABLESTRING:
+        case TAG_IA5STRING:
+        case TAG_TELETEXSTRING:
+            unit = 1;
+            break;
+        case TAG_BMPSTRING:
+            unit = 2;
+            break;
+        case TAG_UNIVERSALSTRING:
+            unit = 4;
+            break;
+        default: {
+            char hex[3];
+            x509HelperPut(writer, "#", 1);
+            for (size_t i = 0; i < (size_t) value->header + len; i++) {
+                snprintf(hex, sizeof(hex), "%02x", der[value->offset + i]);
+                x509HelperPut(writer, hex, 2);
+            }
+            return;
+        }
+    }
+    for (size_t i = 0; i + unit <= len;) {
+        uint32_t c = 0;
+        size_t start = i;
+        if (value->tag == TAG_UTF8STRING && p[i] >= 0x80) {
+            // already UTF-8, only the ASCII characters may need escaping
+            size_t n = 1;
+            while (i + n < len && (p[i + n] & 0xc0) == 0x80) {
+                n++;
+            }
+            x509HelperPut(writer, (const char *) p + i, n);
+            i += n;
+            continue;
+        }
+        if (unit == 1) {
+            // TeletexString is taken as Latin-1
+            c = p[i];
+        } else if (unit == 2) {
+            c = ((uint32_t) p[i] << 8) | p[i + 1];
+            if (c >= 0xd800 && c < 0xdc00 && i + 4 <= len) {
+                uint32_t low = ((uint32_t) p[i + 2] << 8) | p[i + 3];
+                if (low >= 0xdc00 && low < 0xe000) {
+                    c = 0x10000 + ((c - 0xd800) << 10) + (low - 0xdc00);
+                    i += 2;
+                }
+            }
+        } else {
+            c = ((uint32_t) p[i] << 24) | ((uint32_t) p[i + 1] << 16) | ((uint32_t) p[i + 2] << 8) | p[i + 3];
+        }
+        i += unit;
+        x509HelperPutEscaped(writer, c, start == 0, i + unit > len);
+    }
+}
+
+/**
+ * Picks the fields out of a DER certificate. Nothing is copied, the tokens point into der.
+ */
+bool x509HelperParse(const unsigned char *der, size_t len, x509HelperCertificate *cert) {
+    derHelperToken tokens[X509_HELPER_MAX_TOKENS];
+    uint8_t tag, header;
+    uint32_t content_len;
+    size_t count = 0;
+
+    memset(cert, 0, sizeof(x509HelperCertificate));
+    if (!derHelperReadHeader(der, len, &tag, &header, &content_len) || tag != TAG_SEQUENCE) {
+        NSV_LOGE("not a certificate\n");
+        return false;
+    }
+    if (!derHelperTokenize(der, (size_t) header + content_len, X509_HELPER_DEPTH, tokens, X509_HELPER_MAX_TOKENS,
+                           &count)) {
+        return false;
+    }
+    int tbs = derHelperFind(tokens, count, -1, PATH_TBS, sizeof(PATH_TBS) / sizeof(PATH_TBS[0]));
+    int algorithm = derHelperFind(tokens, count, -1, PATH_SIGNATURE_ALGORITHM,
+                                  sizeof(PATH_SIGNATURE_ALGORITHM) / sizeof(PATH_SIGNATURE_ALGORITHM[0]));
+    int signature = derHelperFind(tokens, count, -1, PATH_SIGNATURE, sizeof(PATH_SIGNATURE) / sizeof(PATH_SIGNATURE[0]));
+    const derHelperStep serial_step = {TAG_INTEGER, 0};
+    const derHelperStep issuer_step = {TAG_SEQUENCE, 1};
+    const derHelperStep validity_step = {TAG_SEQUENCE, 2};
+    const derHelperStep subject_step = {TAG_SEQUENCE, 3};
+    const derHelperStep public_key_step = {TAG_SEQUENCE, 4};
+    const derHelperStep time_steps[] = {{DER_HELPER_ANY, 0}, {DER_HELPER_ANY, 1}};
+    int serial = derHelperFind(tokens, count, tbs, &serial_step, 1);
+    int issuer = derHelperFind(tokens, count, tbs, &issuer_step, 1);
+    int validity = derHelperFind(tokens, count, tbs, &validity_step, 1);
+    int subject = derHelperFind(tokens, count, tbs, &subject_step, 1);
+    int public_key = derHelperFind(tokens, count, tbs, &public_key_step, 1);
+    int not_before = derHelperFind(tokens, count, validity, &time_steps[0], 1);
+    int not_after = derHelperFind(tokens, count, validity, &time_steps[1], 1);
+    if (tbs < 0 || algorithm < 0 || signature < 0 || serial < 0 || issuer < 0 || validity < 0 || subject < 0
+        || public_key < 0 || not_before < 0 || not_after < 0) {
+        NSV_LOGE("not a certificate\n");
+        return false;
+    }
+    cert->tbs = tokens[tbs];
+    cert->serial = tokens[serial];
+    cert->issuer = tokens[issuer];
+    cert->not_before = tokens[not_before];
+    cert->not_after = tokens[not_after];
+    cert->subject = tokens[subject];
+    cert->public_key = tokens[public_key];
+    cert->signature_algorithm = tokens[algorithm];
+    cert->signature = tokens[signature];
+    return true;
+}
+
+/**
+ * Writes a Name as an RFC 2253 string, the way X500Principal.getName(X500Principal.RFC2253) does,
+ * e.g. "CN=Android Debug,O=Android,C=US": the last RDN first, RDNs joined with ',' and the attributes of one RDN
+ * with '+', no spaces around either. A type without an RFC 2253 keyword is written as its dotted OID,
+ * e.g. "1.2.840.113549.1.9.1=#16...", its value as '#' and the hex of its DER encoding.
+ * Returns false if the name is malformed or does not fit in size bytes.
+ */
+bool x509HelperGetName(const unsigned char *der, const derHelperToken *name, char *out, size_t size) {
+    derHelperToken tokens[X509_HELPER_MAX_TOKENS];
+    uint8_t rdns[X509_HELPER_MAX_TOKENS];
+    size_t count = 0;
+    size_t rdn_count = 0;
+    x509HelperWriter writer = {out, size, 0, size == 0};
+
+    if (size > 0) {
+        out[0] = '\0';
+    }
+    if (!derHelperTokenize(der + name->offset, (size_t) name->header + name->len, X509_HELPER_NAME_DEPTH,
+                           tokens, X509_HELPER_MAX_TOKENS, &count)) {
+        return false;
+    }
+    for (int i = derHelperFirstChild(tokens, count, 0); i >= 0;
+         i = tokens[i].next == DER_HELPER_NONE ? -1 : tokens[i].next) {
+        if (tokens[i].tag != TAG_SET) {
+            return false;
+        }
+        rdns[rdn_count++] = (uint8_t) i;
+    }
+    while (rdn_count > 0) {
+        int rdn = rdns[--rdn_count];
+        for (int attribute = derHelperFirstChild(tokens, count, rdn); attribute >= 0;
+             attribute = tokens[attribute].next == DER_HELPER_NONE ? -1 : tokens[attribute].next) {
+            int type = derHelperFirstChild(tokens, count, attribute);
+            if (tokens[attribute].tag != TAG_SEQUENCE || type < 0 || tokens[type].tag != TAG_OBJECTID
+                || tokens[type].next == DER_HELPER_NONE) {
+                return false;
+            }
+            if (attribute != derHelperFirstChild(tokens, count, rdn)) {
+                x509HelperPut(&writer, "+", 1);
+            }
+            bool keyword = x509HelperPutType(&writer, der + name->offset + tokens[type].offset + tokens[type].header,
+                                             tokens[type].len);
+            x509HelperPut(&writer, "=", 1);
+            derHelperToken value = tokens[tokens[type].next];
+            value.offset += name->offset;
+            x509HelperPutValue(&writer, der, &value, !keyword);
+        }
+        if (rdn_count > 0) {
+            x509HelperPut(&writer, ",", 1);
+        }
+    }
+    return !writer.overflow;
+}
+
+/**
+ * Writes a serial number in decimal, the way BigInteger.toString() does.
+ */
+bool x509HelperGetSerial(const unsigned char *der, const derHelperToken *serial, char *out, size_t size) {
+    uint8_t magnitude[X509_HELPER_MAX_SERIAL];
+    char digits[X509_HELPER_SERIAL_SIZE];
+    const unsigned char *p = der + serial->offset + serial->header;
+    size_t len = serial->len;
+    size_t n = 0;
+
+    if (len == 0 || len > X509_HELPER_MAX_SERIAL) {
+        return false;
+    }
+    bool negative = (p[0] & 0x80) != 0;
+    memcpy(magnitude, p, len);
+    if (negative) {
+        // two's complement
+        int carry = 1;
+        for (size_t i = len; i-- > 0;) {
+            int v = (uint8_t) ~magnitude[i] + carry;
+            magnitude[i] = (uint8_t) v;
+            carry = v >> 8;
+        }
+    }
+    size_t start = 0;
+    do {
+        // divide the big-endian magnitude by 10, the remainder is the next digit
+        unsigned remainder = 0;
+        for (size_t i = start; i < len; i++) {
+            unsigned v = (remainder << 8) | magnitude[i];
+            magnitude[i] = (uint8_t) (v / 10);
+            remainder = v % 10;
+        }
+        digits[n++] = (char) ('0' + remainder);
+        while (start < len && magnitude[start] == 0) {
+            start++;
+        }
+    } while (start < len);
+    if (n + (negative ? 2 : 1) > size) {
+        return false;
+    }
+    size_t pos = 0;
+    if (negative) {
+        out[pos++] = '-';
+    }
+    while (n > 0) {
+        out[pos++] = digits[--n];
+    }
+    out[pos] = '\0';
+    return true;
+}
+
+static bool x509HelperReadDigits(const unsigned char *p, size_t n, int *value) {
+    *value = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (p[i] < '0' || p[i] > '9') {
+            return false;
+        }
+        *value = *value * 10 + (p[i] - '0');
+    }
+    return true;
+}
+
+/**
+ * Days from 1970-01-01 to the given date of the proleptic Gregorian calendar.
+ */
+static int64_t x509HelperDaysFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yoe = year - era * 400;
+    int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+/**
+ * Converts a UTCTime (YYMMDDHHMMSSZ) or a GeneralizedTime (YYYYMMDDHHMMSSZ) to seconds since the epoch.
+ * As RFC 5280 asks, UTCTime years below 50 are 20YY, the others 19YY.
+ */
+bool x509HelperGetTime(const unsigned char *der, const derHelperToken *time, int64_t *epoch) {
+    const unsigned char *p = der + time->offset + time->header;
+    size_t year_digits;
+    int year, month, day, hour, minute, second;
+
+    if (time->tag == TAG_UTCTIME && time->len == 13) {
+        year_digits = 2;
+    } else if (time->tag == TAG_GENERALIZEDTIME && time->len == 15) {
+        year_digits = 4;
+    } else {
+        return false;
+    }
+    if (p[time->len - 1] != 'Z'
+        || !x509HelperReadDigits(p, year_digits, &year)
+        || !x509HelperReadDigits(p + year_digits, 2, &month)
+        || !x509HelperReadDigits(p + year_digits + 2, 2, &day)
+        || !x509HelperReadDigits(p + year_digits + 4, 2, &hour)
+        || !x509HelperReadDigits(p + year_digits + 6, 2, &minute)
+        || !x509HelperReadDigits(p + year_digits + 8, 2, &second)) {
+        return false;
+    }
+    if (year_digits == 2) {
+        year += year < 50 ? 2000 : 1900;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+    *epoch = x509HelperDaysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+    return true;
+}
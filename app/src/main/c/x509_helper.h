@@ -0,0 +1,71 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef NATIVESIGNATUREVERIFICATION_X509_HELPER_H
+#define NATIVESIGNATUREVERIFICATION_X509_HELPER_H
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "der_helper.h"
+#include "def.h"
+
+// certificate/tbsCertificate/validity/time
+#define X509_HELPER_DEPTH           3
+// A certificate takes about 30 tokens at that depth, one more for every RDN of its names
+#define X509_HELPER_MAX_TOKENS      64
+// the longest serial number accepted, RFC 5280 allows 20 bytes
+#define X509_HELPER_MAX_SERIAL      64
+// enough for the decimal string of the longest serial number with its sign
+#define X509_HELPER_SERIAL_SIZE     160
+#define X509_HELPER_NAME_SIZE       1024
+
+/**
+ * The fields of one DER certificate we read, as tokens of the certificate.
+ */
+typedef struct x509HelperCertificate {
+    derHelperToken tbs;
+    derHelperToken serial;
+    derHelperToken issuer;
+    derHelperToken not_before;
+    derHelperToken not_after;
+    derHelperToken subject;
+    derHelperToken public_key;
+    derHelperToken signature_algorithm;
+    derHelperToken signature;
+} x509HelperCertificate;
+
+
+bool x509HelperParse(const unsigned char *der, size_t len, x509HelperCertificate *cert);
+
+bool x509HelperGetName(const unsigned char *der, const derHelperToken *name, char *out, size_t size);
+
+bool x509HelperGetSerial(const unsigned char *der, const derHelperToken *serial, char *out, size_t size);
+
+bool x509HelperGetTime(const unsigned char *der, const derHelperToken *time, int64_t *epoch);
+
+#endif //NATIVESIGNATUREVERIFICATION_X509_HELPER_H
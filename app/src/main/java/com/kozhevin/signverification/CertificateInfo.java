@@ -0,0 +1,35 @@
+package com.kozhevin.signverification;
+
+import java.nio.charset.StandardCharsets;
+
+/**
+ * The fields of an X.509 certificate decoded by the native library, see MainActivity.certificateInfoFromJNI.
+ */
+public final class CertificateInfo {
+
+    /**
+     * RFC 2253 names as X500Principal.getName(X500Principal.RFC2253) has them, e.g. "CN=Android Debug,O=Android,C=US".
+     */
+    public final String subject;
+    public final String issuer;
+
+    /**
+     * The serial number in decimal.
+     */
+    public final String serialNumber;
+
+    /**
+     * The validity in seconds since the epoch.
+     */
+    public final long notBefore;
+    public final long notAfter;
+
+    // called from native code, the names come as UTF-8
+    CertificateInfo(byte[] subject, byte[] issuer, String serialNumber, long notBefore, long notAfter) {
+        this.subject = new String(subject, StandardCharsets.UTF_8);
+        this.issuer = new String(issuer, StandardCharsets.UTF_8);
+        this.serialNumber = serialNumber;
+        this.notBefore = notBefore;
+        this.notAfter = notAfter;
+    }
+}
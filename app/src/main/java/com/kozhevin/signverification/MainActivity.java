@@ -6,16 +6,23 @@ import android.os.Bundle;
 import android.support.v7.app.AppCompatActivity;
 import android.widget.TextView;
 
-import java.io.ByteArrayInputStream;
-import java.io.InputStream;
-import java.security.MessageDigest;
-import java.security.NoSuchAlgorithmException;
-import java.security.cert.CertificateException;
-import java.security.cert.CertificateFactory;
-import java.security.cert.X509Certificate;
+import java.util.Arrays;
+import java.util.Date;
 
 public class MainActivity extends AppCompatActivity {
 
+    // Fingerprints selected in fingerprintsFromJNI, the result holds them in this order
+    private static final int FINGERPRINT_SHA256 = 0x01;
+    private static final int FINGERPRINT_SHA1 = 0x02;
+    private static final int FINGERPRINT_MD5 = 0x04;
+    private static final int SHA256_SIZE = 32;
+    private static final int SHA1_SIZE = 20;
+    private static final int MD5_SIZE = 16;
+    // statsFromJNI: stages, fields per stage, allocations and bytes allocated outside any stage, then the stages
+    private static final int STATS_HEADER_FIELDS = 4;
+    private static final String[] STATS_STAGES = {"path", "zip open", "cd scan", "inflate", "asn1 parse", "digest",
+            "signature"};
+
     // Used to load the 'native-lib' library on application startup.
     static {
         System.loadLibrary("native-lib");
@@ -27,7 +34,7 @@ public class MainActivity extends AppCompatActivity {
         setContentView(R.layout.activity_main);
 
         // Example of a call to a native method
-        TextView tv = (TextView) findViewById(R.id.sample_text);
+        final TextView tv = (TextView) findViewById(R.id.sample_text);
         PackageInfo info = null;
         try {
             info = getPackageManager().getPackageInfo(getPackageName(), PackageManager.GET_SIGNATURES);
@@ -35,64 +42,109 @@ public class MainActivity extends AppCompatActivity {
             e.printStackTrace();
         }
         if (null != info && info.signatures.length > 0) {
-            byte[] rawCertJava = info.signatures[0].toByteArray();
-            byte[] rawCertNative = bytesFromJNI();
-            String str = "From Java:\n"+getInfoFromBytes(rawCertJava) + "From native:\n"+getInfoFromBytes(rawCertNative);
-            tv.setText(str);
+            final byte[] rawCertJava = info.signatures[0].toByteArray();
+            // the native library has started verifying when it was loaded, show the result once it is ready
+            registerVerificationCallback(new VerificationCallback() {
+                @Override
+                public void onVerified(final byte[] rawCertNative, final boolean contentVerified) {
+                    // fingerprints of the native certificate, the Java one shows them when it is the same
+                    final byte[] fingerprints = fingerprintsFromJNI(FINGERPRINT_SHA256 | FINGERPRINT_SHA1
+                            | FINGERPRINT_MD5);
+                    final String str = "From Java:\n" + getInfoFromBytes(rawCertJava,
+                            Arrays.equals(rawCertJava, rawCertNative) ? fingerprints : null)
+                            + "From native:\n" + getInfoFromBytes(rawCertNative, fingerprints)
+                            + "Certificates: " + getCertificateCountFromNative() + "\n"
+                            + "Contents verified: " + contentVerified + "\n"
+                            + getJarVerificationFromNative()
+                            + getSplitVerificationFromNative()
+                            + "Trusted signer: " + isTrustedSigner() + "\n"
+                            + getStatsFromNative();
+                    runOnUiThread(new Runnable() {
+                        @Override
+                        public void run() {
+                            tv.setText(str);
+                        }
+                    });
+                }
+            });
         } else {
             tv.setText("No data");
         }
 
     }
 
-    private String getInfoFromBytes(byte[] bytes) {
+    private String getInfoFromBytes(byte[] bytes, byte[] fingerprints) {
         if(null == bytes) {
             return "null";
         }
 
-        /*
-         * Get the X.509 certificate.
-         */
-        InputStream certStream = new ByteArrayInputStream(bytes);
         StringBuilder sb = new StringBuilder();
-        try {
-            CertificateFactory certFactory = CertificateFactory.getInstance("X509");
-            X509Certificate x509Cert = (X509Certificate) certFactory.generateCertificate(certStream);
-
-            sb.append("Certificate subject: ").append(x509Cert.getSubjectDN()).append("\n");
-            sb.append("Certificate issuer: ").append(x509Cert.getIssuerDN()).append("\n");
-            sb.append("Certificate serial number: ").append(x509Cert.getSerialNumber()).append("\n");
-            MessageDigest md;
-            try {
-                md = MessageDigest.getInstance("MD5");
-                md.update(bytes);
-                byte[] byteArray = md.digest();
-                //String hash_key = new String(Base64.encode(md.digest(), 0));
-                sb.append("MD5: ").append(bytesToString(byteArray)).append("\n");
-                md.reset();
-                md = MessageDigest.getInstance("SHA");
-                md.update(bytes);
-                byteArray = md.digest();
-                //String hash_key = new String(Base64.encode(md.digest(), 0));
-                sb.append("SHA1: ").append(bytesToString(byteArray)).append("\n");
-                md.reset();
-                md = MessageDigest.getInstance("SHA256");
-                md.update(bytes);
-                byteArray = md.digest();
-                sb.append("SHA256: ").append(bytesToString(byteArray)).append("\n");
-            } catch (NoSuchAlgorithmException e) {
-                e.printStackTrace();
+        // decoded natively, CertificateFactory stays off the startup path
+        CertificateInfo info = certificateInfoFromJNI(bytes);
+        if (null != info) {
+            sb.append("Certificate subject: ").append(info.subject).append("\n");
+            sb.append("Certificate issuer: ").append(info.issuer).append("\n");
+            sb.append("Certificate serial number: ").append(info.serialNumber).append("\n");
+            sb.append("Certificate valid: ").append(new Date(info.notBefore * 1000)).append(" - ")
+                    .append(new Date(info.notAfter * 1000)).append("\n");
+            if (null != fingerprints) {
+                sb.append("MD5: ").append(bytesToString(Arrays.copyOfRange(fingerprints, SHA256_SIZE + SHA1_SIZE,
+                        SHA256_SIZE + SHA1_SIZE + MD5_SIZE))).append("\n");
+                sb.append("SHA1: ").append(bytesToString(Arrays.copyOfRange(fingerprints, SHA256_SIZE,
+                        SHA256_SIZE + SHA1_SIZE))).append("\n");
+                sb.append("SHA256: ").append(bytesToString(Arrays.copyOfRange(fingerprints, 0, SHA256_SIZE)))
+                        .append("\n");
+            } else {
+                sb.append("Fingerprints: not the certificate read natively\n");
             }
-
-
             sb.append("\n");
-        } catch (CertificateException e) {
-            // e.printStackTrace();
         }
         return sb.toString();
     }
 
 
+    private int getCertificateCountFromNative() {
+        byte[][] certificates = certificatesFromJNI();
+        return null == certificates ? 0 : certificates.length;
+    }
+
+    private String getJarVerificationFromNative() {
+        long[] report = verifyJarFromJNI();
+        if (null == report) {
+            return "v1 entries: null\n";
+        }
+        return "v1 entries verified: " + (report[0] == 0) + " (" + report[1] + " entries, " + report[2]
+                + " mismatches, " + report[3] + " bytes in " + report[4] / 1000000 + " ms)\n";
+    }
+
+    private String getSplitVerificationFromNative() {
+        long[] report = verifySplitsFromJNI();
+        if (null == report) {
+            return "APKs: null\n";
+        }
+        long slowest = 0;
+        for (int i = 3; i + 3 < report.length; i += 4) {
+            slowest = Math.max(slowest, report[i + 3]);
+        }
+        return "APKs verified: " + (report[0] == 0) + " (" + report[1] + " APKs in " + report[2] / 1000000
+                + " ms, slowest " + slowest / 1000000 + " ms)\n";
+    }
+
+    private String getStatsFromNative() {
+        long[] stats = statsFromJNI(false);
+        if (null == stats || stats.length < STATS_HEADER_FIELDS) {
+            return "Stats: null\n";
+        }
+        StringBuilder sb = new StringBuilder("Stats:");
+        long allocations = stats[2];
+        for (int i = 0; i < stats[0] && i < STATS_STAGES.length; i++) {
+            int stage = STATS_HEADER_FIELDS + i * (int) stats[1];
+            sb.append(" ").append(STATS_STAGES[i]).append(" ").append(stats[stage + 1] / 1000).append(" us,");
+            allocations += stats[stage + 4];
+        }
+        return sb.append(" ").append(allocations).append(" allocations\n").toString();
+    }
+
     private String bytesToString(byte[] bytes) {
         StringBuilder md5StrBuff = new StringBuilder();
         for (int i = 0; i < bytes.length; i++) {
@@ -113,4 +165,69 @@ public class MainActivity extends AppCompatActivity {
      * which is packaged with this application.
      */
     private native byte[] bytesFromJNI();
+
+    /**
+     * Checks the APK Signature Scheme v2/v3 signers, their signatures with their certificates, and the APK
+     * contents against their content digest.
+     */
+    private native boolean verifyContentFromJNI();
+
+    /**
+     * Checks the v1 (JAR) signature: the RSA or ECDSA signature of CERT.SF with the certificate of the signer,
+     * then every APK entry against its digest, the entries are digested on all cores.
+     * Returns {result, entries, mismatches, bytes, nanoseconds}, result is 0 when everything matches.
+     */
+    private native long[] verifyJarFromJNI();
+
+    /**
+     * Checks base.apk and every split APK of an App Bundle install at once, one thread each: the contents of each
+     * against its v3/v2 signature (v1 if it has no APK Signing Block), and that they share the signer of base.apk.
+     * Returns {result, apks, nanoseconds, then result, scheme, bytes, nanoseconds of every APK}, base.apk first,
+     * result is 0 when every APK is fine.
+     */
+    private native long[] verifySplitsFromJNI();
+
+    /**
+     * Returns what the native library has measured since it was loaded, or since the last reset: per stage
+     * (path, zip open, cd scan, inflate, asn1 parse, digest, signature) the count, total and longest nanoseconds,
+     * bytes, allocations, bytes allocated and a histogram of the durations, bucket i counting those below
+     * 1024 << i ns. The array starts with {stages, fields per stage, allocations and bytes allocated outside any stage}.
+     */
+    public static native long[] statsFromJNI(boolean reset);
+
+    /**
+     * Returns SHA-256, SHA-1 and MD5 of the signer certificate computed natively in one pass,
+     * the fingerprints not selected by mask are zeroed.
+     */
+    private native byte[] fingerprintsFromJNI(int mask);
+
+    /**
+     * Returns every certificate of every signer found by the native parser, in the order they are stored.
+     */
+    private native byte[][] certificatesFromJNI();
+
+    /**
+     * Decodes subject, issuer, serial number and validity of a DER certificate natively, null if it can't be parsed.
+     */
+    public static native CertificateInfo certificateInfoFromJNI(byte[] certificate);
+
+    /**
+     * Whether the APK is signed with one of the certificates built into the native library
+     * (NSV_TRUSTED_SIGNERS in CMakeLists.txt): true only when the v2/v3 signature, or the v1 one if there is
+     * no APK Signing Block, and the contents verify with that certificate. Comparing the certificate alone
+     * would trust a repackaged APK that carries a copy of it.
+     */
+    private native boolean isTrustedSigner();
+
+    /**
+     * Waits for the verification started in JNI_OnLoad, forever if timeoutMillis is negative.
+     * Returns whether it has finished; the other native methods are answered from its results then.
+     */
+    public static native boolean awaitVerificationFromJNI(long timeoutMillis);
+
+    /**
+     * Calls callback once the verification started in JNI_OnLoad has finished, always on a background thread:
+     * onVerified may call the slower checks directly but has to post to the UI thread itself.
+     */
+    public static native void registerVerificationCallback(VerificationCallback callback);
 }
@@ -0,0 +1,16 @@
+package com.kozhevin.signverification;
+
+/**
+ * Receives the result of the verification the native library starts when it is loaded.
+ */
+public interface VerificationCallback {
+
+    /**
+     * Called on a native background thread, or on the registering thread if the verification
+     * had already finished.
+     *
+     * @param certificate     the signer certificate (DER), null if none was found
+     * @param contentVerified whether the APK contents match the v2/v3 content digest
+     */
+    void onVerified(byte[] certificate, boolean contentVerified);
+}
@@ -0,0 +1,297 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+/*
+ * Tests of bignum_helper.c: 64-bit moduli against plain arithmetic, and identities that have to hold
+ * for moduli of every size up to BIGNUM_HELPER_MAX_BITS.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bignum_helper.h"
+#include "test_helper.h"
+
+#define MAX_BYTES   (BIGNUM_HELPER_MAX_BITS / 8)
+
+// 2^64 - 59, the largest 64-bit prime, and the field of P-256
+static const unsigned char PRIME_64[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc5};
+static const unsigned char P256_P[] = {0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+                                       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff,
+                                       0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+
+static uint64_t state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t nextRandom() {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+static void randomBytes(unsigned char *out, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        out[i] = (unsigned char) nextRandom();
+    }
+}
+
+/**
+ * A random number below the modulus, as limbs.
+ */
+static void randomBelow(const bignumHelperModulus *mod, bignumHelperLimb *out) {
+    unsigned char bytes[MAX_BYTES];
+
+    do {
+        randomBytes(bytes, mod->bytes);
+        bignumHelperFromBytes(mod, bytes, mod->bytes, out);
+    } while (bignumHelperCompare(mod, out, mod->n) >= 0);
+}
+
+static uint64_t addMod(uint64_t a, uint64_t b, uint64_t n) {
+    uint64_t sum = a + b;
+    return sum < a || sum >= n ? sum - n : sum;
+}
+
+static uint64_t mulMod(uint64_t a, uint64_t b, uint64_t n) {
+    uint64_t product = 0;
+    for (int bit = 63; bit >= 0; bit--) {
+        product = addMod(product, product, n);
+        if ((b >> bit) & 1) {
+            product = addMod(product, a, n);
+        }
+    }
+    return product;
+}
+
+static uint64_t powMod(uint64_t a, uint64_t e, uint64_t n) {
+    uint64_t power = 1;
+    for (int bit = 63; bit >= 0; bit--) {
+        power = mulMod(power, power, n);
+        if ((e >> bit) & 1) {
+            power = mulMod(power, a, n);
+        }
+    }
+    return power;
+}
+
+static void fromUint64(const bignumHelperModulus *mod, uint64_t value, bignumHelperLimb *out) {
+    unsigned char bytes[8];
+    for (size_t i = 0; i < 8; i++) {
+        bytes[i] = (unsigned char) (value >> (56 - 8 * i));
+    }
+    bignumHelperFromBytes(mod, bytes, sizeof(bytes), out);
+}
+
+static uint64_t toUint64(const bignumHelperModulus *mod, const bignumHelperLimb *in) {
+    unsigned char bytes[8];
+    uint64_t value = 0;
+    bignumHelperToBytes(mod, in, bytes);
+    for (size_t i = 0; i < 8; i++) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+/**
+ * out = a * b mod n, b reduced.
+ */
+static void multiply(const bignumHelperModulus *mod, const bignumHelperLimb *a, const bignumHelperLimb *b,
+                     bignumHelperLimb *out) {
+    bignumHelperLimb t[BIGNUM_HELPER_MAX_LIMBS];
+    bignumHelperToMont(mod, a, t);
+    bignumHelperMontMul(mod, t, b, out);
+}
+
+/**
+ * Every operation modulo 2^64 - 59 against the same on uint64_t.
+ */
+static void testSmall() {
+    bignumHelperModulus mod;
+    bignumHelperLimb a[BIGNUM_HELPER_MAX_LIMBS], b[BIGNUM_HELPER_MAX_LIMBS], out[BIGNUM_HELPER_MAX_LIMBS];
+    const uint64_t n = 0xffffffffffffffc5ULL;
+
+    if (!TEST_HELPER_CHECK(bignumHelperInitModulus(&mod, PRIME_64, sizeof(PRIME_64)) && mod.bytes == 8)) {
+        return;
+    }
+    for (int i = 0; i < 200; i++) {
+        uint64_t x = nextRandom() % n, y = nextRandom() % n, e = nextRandom();
+        if (i == 0) {
+            x = n - 1;
+            y = n - 1;
+        }
+        fromUint64(&mod, x, a);
+        fromUint64(&mod, y, b);
+        TEST_HELPER_CHECK(toUint64(&mod, a) == x);
+        bignumHelperModAdd(&mod, a, b, out);
+        TEST_HELPER_CHECK(toUint64(&mod, out) == addMod(x, y, n));
+        bignumHelperModSub(&mod, a, b, out);
+        TEST_HELPER_CHECK(toUint64(&mod, out) == addMod(x, y == 0 ? 0 : n - y, n));
+        multiply(&mod, a, b, out);
+        TEST_HELPER_CHECK(toUint64(&mod, out) == mulMod(x, y, n));
+
+        unsigned char exp[8];
+        for (size_t j = 0; j < 8; j++) {
+            exp[j] = (unsigned char) (e >> (56 - 8 * j));
+        }
+        bignumHelperModExp(&mod, a, exp, sizeof(exp), out);
+        TEST_HELPER_CHECK(toUint64(&mod, out) == powMod(x, e, n));
+        if (x != 0) {
+            bignumHelperModInverse(&mod, a, out);
+            TEST_HELPER_CHECK(mulMod(toUint64(&mod, out), x, n) == 1);
+        }
+    }
+}
+
+/**
+ * Products are associative and distribute over sums, a^65537 is 16 squarings and a product, n itself is
+ * reduced to 0 on its way into the Montgomery domain and a comes back out of it unchanged.
+ */
+static void checkIdentities(const bignumHelperModulus *mod) {
+    bignumHelperLimb a[BIGNUM_HELPER_MAX_LIMBS], b[BIGNUM_HELPER_MAX_LIMBS], c[BIGNUM_HELPER_MAX_LIMBS];
+    bignumHelperLimb x[BIGNUM_HELPER_MAX_LIMBS], y[BIGNUM_HELPER_MAX_LIMBS], t[BIGNUM_HELPER_MAX_LIMBS];
+    const unsigned char f4[] = {0x01, 0x00, 0x01};
+
+    randomBelow(mod, a);
+    randomBelow(mod, b);
+    randomBelow(mod, c);
+
+    multiply(mod, a, b, t);
+    multiply(mod, t, c, x);
+    multiply(mod, b, c, t);
+    multiply(mod, a, t, y);
+    TEST_HELPER_CHECK(bignumHelperCompare(mod, x, y) == 0);
+
+    bignumHelperModAdd(mod, b, c, t);
+    multiply(mod, a, t, x);
+    multiply(mod, a, b, t);
+    multiply(mod, a, c, y);
+    bignumHelperModAdd(mod, t, y, y);
+    TEST_HELPER_CHECK(bignumHelperCompare(mod, x, y) == 0);
+
+    bignumHelperModSub(mod, a, b, t);
+    bignumHelperModAdd(mod, t, b, t);
+    TEST_HELPER_CHECK(bignumHelperCompare(mod, t, a) == 0);
+
+    bignumHelperModExp(mod, a, f4, sizeof(f4), x);
+    memcpy(y, a, mod->limbs * sizeof(bignumHelperLimb));
+    for (int i = 0; i < 16; i++) {
+        multiply(mod, y, y, y);
+    }
+    multiply(mod, y, a, y);
+    TEST_HELPER_CHECK(bignumHelperCompare(mod, x, y) == 0);
+
+    bignumHelperToMont(mod, mod->n, x);
+    TEST_HELPER_CHECK(bignumHelperIsZero(mod, x));
+    bignumHelperToMont(mod, a, x);
+    bignumHelperFromMont(mod, x, y);
+    TEST_HELPER_CHECK(bignumHelperCompare(mod, y, a) == 0);
+}
+
+/**
+ * Random odd moduli of every length, the unrolled P-256 size among them, up to BIGNUM_HELPER_MAX_BITS.
+ */
+static void testLarge() {
+    unsigned char n[MAX_BYTES + 1];
+    bignumHelperModulus mod;
+
+    for (size_t len = 1; len <= MAX_BYTES; len += len < 40 ? 1 : 37) {
+        randomBytes(n, len);
+        n[0] |= 0x80;
+        n[len - 1] |= 0x01;
+        if (TEST_HELPER_CHECK(bignumHelperInitModulus(&mod, n, len) && mod.bytes == len)) {
+            checkIdentities(&mod);
+        }
+    }
+    randomBytes(n, MAX_BYTES);
+    n[0] |= 0x80;
+    n[MAX_BYTES - 1] |= 0x01;
+    TEST_HELPER_CHECK(bignumHelperInitModulus(&mod, n, MAX_BYTES) && mod.limbs == BIGNUM_HELPER_MAX_LIMBS);
+    checkIdentities(&mod);
+}
+
+/**
+ * a^(p - 1) is 1 and a^-1 * a too in the field of P-256.
+ */
+static void testPrime() {
+    unsigned char p_minus_1[sizeof(P256_P)];
+    bignumHelperModulus mod;
+    bignumHelperLimb a[BIGNUM_HELPER_MAX_LIMBS], one[BIGNUM_HELPER_MAX_LIMBS], out[BIGNUM_HELPER_MAX_LIMBS];
+
+    if (!TEST_HELPER_CHECK(bignumHelperInitModulus(&mod, P256_P, sizeof(P256_P))
+                           && mod.limbs == BIGNUM_HELPER_P256_LIMBS)) {
+        return;
+    }
+    memcpy(p_minus_1, P256_P, sizeof(P256_P));
+    p_minus_1[sizeof(P256_P) - 1] -= 1;
+    fromUint64(&mod, 1, one);
+    for (int i = 0; i < 20; i++) {
+        randomBelow(&mod, a);
+        if (bignumHelperIsZero(&mod, a)) {
+            continue;
+        }
+        bignumHelperModExp(&mod, a, p_minus_1, sizeof(p_minus_1), out);
+        TEST_HELPER_CHECK(bignumHelperCompare(&mod, out, one) == 0);
+        bignumHelperModInverse(&mod, a, out);
+        multiply(&mod, out, a, out);
+        TEST_HELPER_CHECK(bignumHelperCompare(&mod, out, one) == 0);
+    }
+}
+
+/**
+ * Moduli that are even, 1 or too long are refused, leading zeros are not counted, and numbers longer than
+ * the modulus don't fit.
+ */
+static void testLimits() {
+    unsigned char n[MAX_BYTES + 2];
+    bignumHelperModulus mod;
+    bignumHelperLimb a[BIGNUM_HELPER_MAX_LIMBS];
+    const unsigned char even[] = {0x01, 0x00};
+    const unsigned char one[] = {0x00, 0x01};
+
+    TEST_HELPER_CHECK(!bignumHelperInitModulus(&mod, even, sizeof(even)));
+    TEST_HELPER_CHECK(!bignumHelperInitModulus(&mod, one, sizeof(one)));
+    TEST_HELPER_CHECK(!bignumHelperInitModulus(&mod, one, 0));
+
+    memset(n, 0xff, sizeof(n));
+    n[0] = 0x00;
+    n[1] = 0x01;
+    TEST_HELPER_CHECK(!bignumHelperInitModulus(&mod, n, MAX_BYTES + 2));
+    TEST_HELPER_CHECK(bignumHelperInitModulus(&mod, n + 1, MAX_BYTES) && mod.bytes == MAX_BYTES);
+    n[1] = 0x00;
+    TEST_HELPER_CHECK(bignumHelperInitModulus(&mod, n, MAX_BYTES + 2) && mod.bytes == MAX_BYTES);
+
+    TEST_HELPER_CHECK(bignumHelperInitModulus(&mod, PRIME_64, sizeof(PRIME_64)));
+    memset(n, 0, sizeof(n));
+    n[sizeof(n) - 1] = 0x05;
+    TEST_HELPER_CHECK(bignumHelperFromBytes(&mod, n, sizeof(n), a) && !bignumHelperIsZero(&mod, a));
+    n[sizeof(n) - 1 - mod.limbs * sizeof(bignumHelperLimb)] = 0x01;
+    TEST_HELPER_CHECK(!bignumHelperFromBytes(&mod, n, sizeof(n), a));
+}
+
+int main(int argc, char **argv) {
+    testHelperInit(argc, argv);
+    testSmall();
+    testLarge();
+    testPrime();
+    testLimits();
+    return testHelperFinish();
+}
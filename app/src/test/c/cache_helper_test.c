@@ -0,0 +1,205 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+/*
+ * Tests of cache_helper.c: cached results are served for the file they were computed from and dropped once
+ * it is touched, replaced, or changed before they were put.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "cache_helper.h"
+#include "test_helper.h"
+
+static const unsigned char certificate[] = {0x30, 0x03, 0x02, 0x01, 0x2a};
+
+/**
+ * Creates a file from the template holding len bytes of content, returns it open for reading and writing.
+ */
+static int createFile(char *path, const char *content, size_t len) {
+    int fd = mkstemp(path);
+    if (fd >= 0 && write(fd, content, len) != (ssize_t) len) {
+        close(fd);
+        unlink(path);
+        fd = -1;
+    }
+    return fd;
+}
+
+/**
+ * Caches both results under the file open at fd, whether they are served back is left to the caller.
+ */
+static bool putResults(int fd) {
+    cacheHelperKey key;
+    if (!cacheHelperGetKey(fd, &key)) {
+        return false;
+    }
+    cacheHelperPutCertificate(fd, &key, certificate, sizeof(certificate));
+    cacheHelperPutContentResult(fd, &key, 7);
+    return true;
+}
+
+/**
+ * Whether the certificate and the content result put by putResults() are served.
+ */
+static bool isCached() {
+    unsigned char *cached = NULL;
+    size_t len = 0;
+    int32_t result = 0;
+    bool has_certificate = cacheHelperGetCertificate(&cached, &len);
+    bool has_result = cacheHelperGetContentResult(&result);
+
+    if (has_certificate) {
+        TEST_HELPER_CHECK(len == sizeof(certificate) && memcmp(cached, certificate, len) == 0);
+        free(cached);
+    }
+    if (has_result) {
+        TEST_HELPER_CHECK(result == 7);
+    }
+    TEST_HELPER_CHECK(has_certificate == has_result);
+    return has_certificate && has_result;
+}
+
+/**
+ * Results are served while the file is unchanged, and not after its modification time moves, even though
+ * its content and size stay the same. Nothing is served for an invalid descriptor.
+ */
+static void testTouched() {
+    char path[] = "/tmp/nsv_cache_XXXXXX";
+    const struct timespec times[2] = {{1000, 0}, {1000, 0}};
+    cacheHelperKey key;
+
+    TEST_HELPER_CHECK(!cacheHelperGetKey(-1, &key));
+    cacheHelperPutContentResult(-1, &key, 7);
+    TEST_HELPER_CHECK(!isCached());
+
+    int fd = createFile(path, "content", 7);
+    if (!TEST_HELPER_CHECK(fd >= 0)) {
+        return;
+    }
+    if (TEST_HELPER_CHECK(putResults(fd))) {
+        TEST_HELPER_CHECK(isCached());
+        TEST_HELPER_CHECK(isCached());
+        TEST_HELPER_CHECK(futimens(fd, times) == 0);
+        TEST_HELPER_CHECK(!isCached());
+    }
+    cacheHelperClear();
+    close(fd);
+    unlink(path);
+}
+
+/**
+ * A file of the same size renamed over the cached one, as an update installs an APK, is not served the results
+ * of the old one.
+ */
+static void testReplaced() {
+    char path[] = "/tmp/nsv_cache_XXXXXX";
+    char update[] = "/tmp/nsv_cache_XXXXXX";
+
+    int fd = createFile(path, "content", 7);
+    if (!TEST_HELPER_CHECK(fd >= 0)) {
+        return;
+    }
+    if (TEST_HELPER_CHECK(putResults(fd))) {
+        close(fd);
+        TEST_HELPER_CHECK(isCached());
+        int update_fd = createFile(update, "updated", 7);
+        if (TEST_HELPER_CHECK(update_fd >= 0)) {
+            TEST_HELPER_CHECK(rename(update, path) == 0);
+            TEST_HELPER_CHECK(!isCached());
+            close(update_fd);
+        }
+    } else {
+        close(fd);
+    }
+    cacheHelperClear();
+    unlink(path);
+}
+
+/**
+ * A file that changes between the key being taken and the results being put, i.e. while it is verified,
+ * does not get the results served: they belong to what was read, not to what is there now.
+ */
+static void testChangedBeforePut() {
+    char path[] = "/tmp/nsv_cache_XXXXXX";
+    cacheHelperKey key;
+
+    int fd = createFile(path, "content", 7);
+    if (!TEST_HELPER_CHECK(fd >= 0)) {
+        return;
+    }
+    if (TEST_HELPER_CHECK(cacheHelperGetKey(fd, &key))) {
+        TEST_HELPER_CHECK(write(fd, " and more", 9) == 9);
+        cacheHelperPutCertificate(fd, &key, certificate, sizeof(certificate));
+        cacheHelperPutContentResult(fd, &key, 7);
+        TEST_HELPER_CHECK(!isCached());
+    }
+    cacheHelperClear();
+    close(fd);
+    unlink(path);
+}
+
+/**
+ * Putting results for another file replaces what was cached, and cacheHelperClear() drops everything.
+ */
+static void testOtherFile() {
+    char first[] = "/tmp/nsv_cache_XXXXXX";
+    char second[] = "/tmp/nsv_cache_XXXXXX";
+    cacheHelperKey key;
+    int32_t result = 0;
+
+    int first_fd = createFile(first, "first", 5);
+    int second_fd = createFile(second, "second", 6);
+    if (TEST_HELPER_CHECK(first_fd >= 0 && second_fd >= 0)) {
+        TEST_HELPER_CHECK(putResults(first_fd));
+        TEST_HELPER_CHECK(cacheHelperGetKey(second_fd, &key));
+        cacheHelperPutContentResult(second_fd, &key, 9);
+        TEST_HELPER_CHECK(cacheHelperGetContentResult(&result) && result == 9);
+        unsigned char *cached = NULL;
+        size_t len = 0;
+        TEST_HELPER_CHECK(!cacheHelperGetCertificate(&cached, &len));
+        cacheHelperClear();
+        TEST_HELPER_CHECK(!cacheHelperGetContentResult(&result));
+    }
+    if (first_fd >= 0) {
+        close(first_fd);
+        unlink(first);
+    }
+    if (second_fd >= 0) {
+        close(second_fd);
+        unlink(second);
+    }
+}
+
+int main(int argc, char **argv) {
+    testHelperInit(argc, argv);
+    testTouched();
+    testReplaced();
+    testChangedBeforePut();
+    testOtherFile();
+    return testHelperFinish();
+}
@@ -0,0 +1,176 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+/*
+ * Tests of der_helper.c: headers, the tokenizer and tag paths over DER built by hand.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "der_helper.h"
+#include "test_helper.h"
+
+#define CAPACITY    32
+
+// SEQUENCE {INTEGER 1, SEQUENCE {OID 1.2.3.4, NULL}, [0] {INTEGER 2}, SET {}}
+static const unsigned char NESTED[] = {0x30, 0x13, 0x02, 0x01, 0x01, 0x30, 0x07, 0x06, 0x03, 0x2a, 0x03, 0x04,
+                                       0x05, 0x00, 0xa0, 0x03, 0x02, 0x01, 0x02, 0x31, 0x00};
+
+static int readPartialHeader(const unsigned char *data, size_t len, uint32_t *content_len) {
+    uint8_t tag = 0;
+    return derHelperReadPartialHeader(data, len, &tag, content_len);
+}
+
+/**
+ * Short and long lengths, headers cut short and the encodings DER has no use for.
+ */
+static void testHeader() {
+    const unsigned char short_form[] = {0x02, 0x01, 0x05};
+    const unsigned char long_1[] = {0x04, 0x81, 0x80};
+    const unsigned char long_2[] = {0x04, 0x82, 0x01, 0x00};
+    const unsigned char long_4[] = {0x04, 0x84, 0x01, 0x02, 0x03, 0x04};
+    const unsigned char long_5[] = {0x04, 0x85, 0x00, 0x00, 0x00, 0x00, 0x01};
+    const unsigned char indefinite[] = {0x30, 0x80};
+    const unsigned char long_tag[] = {0x1f, 0x81, 0x01};
+    const unsigned char huge[] = {0x04, 0x84, 0xff, 0xff, 0xff, 0xff};
+    uint32_t len = 0;
+    uint8_t tag = 0;
+    uint8_t header = 0;
+
+    TEST_HELPER_CHECK(readPartialHeader(short_form, sizeof(short_form), &len) == 2 && len == 1);
+    TEST_HELPER_CHECK(readPartialHeader(long_1, sizeof(long_1), &len) == 3 && len == 0x80);
+    TEST_HELPER_CHECK(readPartialHeader(long_2, sizeof(long_2), &len) == 4 && len == 0x100);
+    TEST_HELPER_CHECK(readPartialHeader(long_4, sizeof(long_4), &len) == 6 && len == 0x01020304);
+    TEST_HELPER_CHECK(readPartialHeader(long_5, sizeof(long_5), &len) == -1);
+    TEST_HELPER_CHECK(readPartialHeader(indefinite, sizeof(indefinite), &len) == -1);
+    TEST_HELPER_CHECK(readPartialHeader(long_tag, sizeof(long_tag), &len) == -1);
+    TEST_HELPER_CHECK(readPartialHeader(long_tag, 1, &len) == -1);
+
+    // the content need not be there, the header must
+    TEST_HELPER_CHECK(readPartialHeader(long_4, 6, &len) == 6);
+    for (size_t i = 0; i < sizeof(long_4); i++) {
+        TEST_HELPER_CHECK(readPartialHeader(long_4, i, &len) == 0);
+    }
+
+    TEST_HELPER_CHECK(derHelperReadHeader(short_form, sizeof(short_form), &tag, &header, &len)
+                      && tag == 0x02 && header == 2 && len == 1);
+    TEST_HELPER_CHECK(!derHelperReadHeader(short_form, 2, &tag, &header, &len));
+    TEST_HELPER_CHECK(!derHelperReadHeader(long_1, sizeof(long_1), &tag, &header, &len));
+    TEST_HELPER_CHECK(!derHelperReadHeader(huge, sizeof(huge), &tag, &header, &len));
+}
+
+/**
+ * The tokens of NESTED in document order, with their depth and next sibling, and the paths through them.
+ */
+static void testTokenize() {
+    const derHelperToken expected[] = {
+            {0, 0x13, TAG_SEQUENCE, 2, 0, DER_HELPER_NONE},
+            {2, 1, TAG_INTEGER, 2, 1, 2},
+            {5, 7, TAG_SEQUENCE, 2, 1, 5},
+            {7, 3, TAG_OBJECTID, 2, 2, 4},
+            {12, 0, TAG_NULL, 2, 2, DER_HELPER_NONE},
+            {14, 3, TAG_CONTEXT(0), 2, 1, 7},
+            {16, 1, TAG_INTEGER, 2, 2, DER_HELPER_NONE},
+            {19, 0, TAG_SET, 2, 1, DER_HELPER_NONE}};
+    const derHelperStep null_path[] = {{TAG_SEQUENCE, 0}, {TAG_SEQUENCE, 0}, {TAG_NULL, 0}};
+    const derHelperStep third_path[] = {{TAG_SEQUENCE, 0}, {DER_HELPER_ANY, 2}};
+    const derHelperStep second_integer_path[] = {{TAG_SEQUENCE, 0}, {TAG_INTEGER, 1}};
+    const derHelperStep optional_path[] = {{TAG_SEQUENCE, 0}, {TAG_CONTEXT(0), 0}, {TAG_INTEGER, 0}};
+    const derHelperStep oid_step = {TAG_OBJECTID, 0};
+    derHelperToken tokens[CAPACITY];
+    size_t count = 0;
+
+    if (!TEST_HELPER_CHECK(derHelperTokenize(NESTED, sizeof(NESTED), DER_HELPER_MAX_DEPTH, tokens, CAPACITY, &count)
+                           && count == sizeof(expected) / sizeof(expected[0]))) {
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        TEST_HELPER_CHECK(tokens[i].offset == expected[i].offset && tokens[i].len == expected[i].len
+                          && tokens[i].tag == expected[i].tag && tokens[i].header == expected[i].header
+                          && tokens[i].depth == expected[i].depth && tokens[i].next == expected[i].next);
+    }
+    TEST_HELPER_CHECK(derHelperFind(tokens, count, -1, null_path, 3) == 4);
+    TEST_HELPER_CHECK(derHelperFind(tokens, count, -1, third_path, 2) == 5);
+    TEST_HELPER_CHECK(derHelperFind(tokens, count, -1, second_integer_path, 2) == -1);
+    TEST_HELPER_CHECK(derHelperFind(tokens, count, -1, optional_path, 3) == 6);
+    TEST_HELPER_CHECK(derHelperFind(tokens, count, 2, &oid_step, 1) == 3);
+    TEST_HELPER_CHECK(derHelperFind(tokens, count, 7, &oid_step, 1) == -1);
+    TEST_HELPER_CHECK(derHelperFind(tokens, 0, -1, null_path, 3) == -1);
+    TEST_HELPER_CHECK(derHelperFirstChild(tokens, count, 0) == 1);
+    TEST_HELPER_CHECK(derHelperFirstChild(tokens, count, 1) == -1);
+    TEST_HELPER_CHECK(derHelperFirstChild(tokens, count, 7) == -1);
+
+    // below max_depth triples stay whole
+    TEST_HELPER_CHECK(derHelperTokenize(NESTED, sizeof(NESTED), 1, tokens, CAPACITY, &count) && count == 5);
+    TEST_HELPER_CHECK(tokens[2].len == 7 && tokens[2].next == 3 && derHelperFirstChild(tokens, count, 2) == -1);
+    TEST_HELPER_CHECK(derHelperFind(tokens, count, -1, null_path, 3) == -1);
+    TEST_HELPER_CHECK(derHelperFind(tokens, count, -1, third_path, 2) == 3);
+}
+
+/**
+ * Several top level triples are siblings, children must fit their parent exactly, the capacity is kept to
+ * and nesting deeper than DER_HELPER_MAX_DEPTH stays whole.
+ */
+static void testMalformed() {
+    unsigned char data[64];
+    derHelperToken tokens[CAPACITY];
+    size_t count = 0;
+
+    memcpy(data, NESTED, sizeof(NESTED));
+    memcpy(data + sizeof(NESTED), NESTED, sizeof(NESTED));
+    TEST_HELPER_CHECK(derHelperTokenize(data, 2 * sizeof(NESTED), DER_HELPER_MAX_DEPTH, tokens, CAPACITY, &count)
+                      && count == 16 && tokens[0].next == 8 && tokens[8].offset == sizeof(NESTED));
+
+    for (size_t i = 1; i < sizeof(NESTED); i++) {
+        TEST_HELPER_CHECK(!derHelperTokenize(NESTED, i, DER_HELPER_MAX_DEPTH, tokens, CAPACITY, &count));
+    }
+    TEST_HELPER_CHECK(derHelperTokenize(NESTED, 0, DER_HELPER_MAX_DEPTH, tokens, CAPACITY, &count) && count == 0);
+
+    // the inner SEQUENCE one byte longer, the NULL runs past its end
+    memcpy(data, NESTED, sizeof(NESTED));
+    data[6] = 0x08;
+    TEST_HELPER_CHECK(!derHelperTokenize(data, sizeof(NESTED), DER_HELPER_MAX_DEPTH, tokens, CAPACITY, &count));
+    // and one byte shorter, the NULL header is cut
+    data[6] = 0x06;
+    TEST_HELPER_CHECK(!derHelperTokenize(data, sizeof(NESTED), DER_HELPER_MAX_DEPTH, tokens, CAPACITY, &count));
+
+    TEST_HELPER_CHECK(!derHelperTokenize(NESTED, sizeof(NESTED), DER_HELPER_MAX_DEPTH, tokens, 7, &count));
+    TEST_HELPER_CHECK(derHelperTokenize(NESTED, sizeof(NESTED), DER_HELPER_MAX_DEPTH, tokens, 8, &count));
+
+    // 20 SEQUENCEs one in the other
+    for (size_t i = 0; i < 20; i++) {
+        data[2 * i] = TAG_SEQUENCE;
+        data[2 * i + 1] = (unsigned char) (2 * (19 - i));
+    }
+    TEST_HELPER_CHECK(derHelperTokenize(data, 40, UINT8_MAX, tokens, CAPACITY, &count)
+                      && count == DER_HELPER_MAX_DEPTH + 1 && tokens[count - 1].depth == DER_HELPER_MAX_DEPTH
+                      && tokens[count - 1].len == 2 * (19 - DER_HELPER_MAX_DEPTH));
+}
+
+int main(int argc, char **argv) {
+    testHelperInit(argc, argv);
+    testHeader();
+    testTokenize();
+    testMalformed();
+    return testHelperFinish();
+}
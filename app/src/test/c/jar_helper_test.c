@@ -0,0 +1,193 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+/*
+ * Tests of jar_helper.c: the v1 signatures of the corpus, every signer of multi_signer.apk, and copies of them
+ * tampered with in memory.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "jar_helper.h"
+#include "sign_block_helper.h"
+#include "test_helper.h"
+
+static int32_t verifyMemory(const unsigned char *apk, size_t len, jarHelperReport *report) {
+    unzipHelperArchive archive;
+
+    int32_t err = unzipHelperOpenMemory(&archive, apk, len);
+    if (err == MZ_OK) {
+        err = jarHelperVerify(&archive, report);
+        unzipHelperClose(&archive);
+    }
+    return err;
+}
+
+/**
+ * Where the data of the entry named name starts, 0 if it is not found.
+ */
+static size_t entryDataOffset(const unsigned char *apk, size_t len, const char *name) {
+    unzipHelperArchive archive;
+    mz_zip_file *file_info = NULL;
+    size_t offset = 0;
+
+    if (unzipHelperOpenMemory(&archive, apk, len) != MZ_OK) {
+        return 0;
+    }
+    if (mz_zip_locate_entry(archive.handle, name, 0) == MZ_OK
+        && mz_zip_entry_get_info(archive.handle, &file_info) == MZ_OK && file_info->disk_offset + 30 < len) {
+        const unsigned char *local = apk + file_info->disk_offset;
+        offset = (size_t) file_info->disk_offset + 30 + (local[26] | local[27] << 8) + (local[28] | local[29] << 8);
+    }
+    unzipHelperClose(&archive);
+    return offset < len ? offset : 0;
+}
+
+/**
+ * Every v1 signed APK verifies, the signer being the certificate of CERT.RSA, which the corpus also puts first
+ * in the APK Signing Block. multi_signer.apk has a second signer, SIGNER1.EC.
+ */
+static void testCorpus() {
+    const char *names[] = {"small.apk", "many_entries.apk", "multi_signer.apk", "timestamped.apk", "v1_only.apk",
+                           "v1_sha1.apk"};
+    unsigned char expected[HASH_HELPER_SHA256_SIZE];
+    unzipHelperArchive archive;
+    jarHelperReport report;
+    hashHelperSha256 sha256;
+    size_t len = 0;
+    uint32_t id = 0;
+
+    if (!TEST_HELPER_CHECK(unzipHelperOpen(&archive, testHelperPath("small.apk")) == MZ_OK)) {
+        return;
+    }
+    unsigned char *certificate = signBlockHelperGetCertificate(&archive, &len, &id);
+    unzipHelperClose(&archive);
+    if (!TEST_HELPER_CHECK(NULL != certificate)) {
+        return;
+    }
+    hashHelperSha256Init(&sha256);
+    hashHelperSha256Update(&sha256, certificate, len);
+    hashHelperSha256Final(&sha256, expected);
+    free(certificate);
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (!TEST_HELPER_CHECK(unzipHelperOpen(&archive, testHelperPath(names[i])) == MZ_OK)) {
+            continue;
+        }
+        TEST_HELPER_CHECK(jarHelperVerify(&archive, &report) == MZ_OK);
+        TEST_HELPER_CHECK(report.signers == (i == 2 ? 2 : 1));
+        TEST_HELPER_CHECK(report.mismatches == 0 && report.entries > 0);
+        TEST_HELPER_CHECK(memcmp(report.signer, expected, sizeof(expected)) == 0);
+        unzipHelperClose(&archive);
+    }
+    TEST_HELPER_CHECK(unzipHelperOpen(&archive, testHelperPath("huge.apk")) == MZ_OK);
+    TEST_HELPER_CHECK(jarHelperVerify(&archive, &report) == MZ_EXIST_ERROR);
+    unzipHelperClose(&archive);
+}
+
+/**
+ * An entry read halfway leaves its inflater to the next one, which still inflates from the start.
+ */
+static void testPartialRead() {
+    unzipHelperArchive archive;
+    jarHelperReport report;
+    char buf[16];
+
+    if (!TEST_HELPER_CHECK(unzipHelperOpen(&archive, testHelperPath("small.apk")) == MZ_OK)) {
+        return;
+    }
+    TEST_HELPER_CHECK(mz_zip_locate_entry(archive.handle, "classes.dex", 0) == MZ_OK);
+    TEST_HELPER_CHECK(mz_zip_entry_read_open(archive.handle, 0, NULL) == MZ_OK);
+    TEST_HELPER_CHECK(mz_zip_entry_read(archive.handle, buf, sizeof(buf)) == sizeof(buf));
+    mz_zip_entry_close(archive.handle);
+    TEST_HELPER_CHECK(jarHelperVerify(&archive, &report) == MZ_OK);
+    unzipHelperClose(&archive);
+}
+
+/**
+ * A byte changed in an entry is a digest mismatch, one changed in the .SF file of the second signer or a
+ * signature block without its .SF file break the signature.
+ */
+static void testTampered() {
+    jarHelperReport report;
+    size_t len = 0;
+
+    unsigned char *apk = testHelperReadFile(testHelperPath("multi_signer.apk"), &len);
+    if (!TEST_HELPER_CHECK(NULL != apk)) {
+        return;
+    }
+    TEST_HELPER_CHECK(verifyMemory(apk, len, &report) == MZ_OK);
+
+    size_t offset = entryDataOffset(apk, len, "classes.dex");
+    if (TEST_HELPER_CHECK(offset > 0)) {
+        apk[offset] ^= 1;
+        TEST_HELPER_CHECK(verifyMemory(apk, len, &report) == MZ_CRC_ERROR);
+        TEST_HELPER_CHECK(report.mismatches == 1 && strcmp(report.first_mismatch, "classes.dex") == 0);
+        apk[offset] ^= 1;
+    }
+
+    offset = entryDataOffset(apk, len, "META-INF/SIGNER1.SF");
+    if (TEST_HELPER_CHECK(offset > 0)) {
+        apk[offset + 10] ^= 1;
+        TEST_HELPER_CHECK(verifyMemory(apk, len, &report) == MZ_CRYPT_ERROR);
+        TEST_HELPER_CHECK(report.signers == 0);
+        apk[offset + 10] ^= 1;
+    }
+
+    // renamed in the local header and the central directory, SIGNER1.EC is left without its .SF file
+    const char *name = "META-INF/SIGNER1.SF";
+    size_t renamed = 0;
+    for (size_t i = 0; i + strlen(name) <= len; i++) {
+        if (memcmp(apk + i, name, strlen(name)) == 0) {
+            memcpy(apk + i + strlen(name) - 2, "XX", 2);
+            renamed++;
+        }
+    }
+    TEST_HELPER_CHECK(renamed == 2);
+    TEST_HELPER_CHECK(verifyMemory(apk, len, &report) == MZ_CRYPT_ERROR);
+    free(apk);
+}
+
+/**
+ * duplicate_entry.apk adds an unsigned entry under the name of a signed one, whichever copy a lookup finds
+ * the APK is rejected.
+ */
+static void testDuplicateEntry() {
+    unzipHelperArchive archive;
+    jarHelperReport report;
+
+    if (!TEST_HELPER_CHECK(unzipHelperOpen(&archive, testHelperPath("duplicate_entry.apk")) == MZ_OK)) {
+        return;
+    }
+    TEST_HELPER_CHECK(jarHelperVerify(&archive, &report) == MZ_FORMAT_ERROR);
+    unzipHelperClose(&archive);
+}
+
+int main(int argc, char **argv) {
+    testHelperInit(argc, argv);
+    testCorpus();
+    testPartialRead();
+    testTampered();
+    testDuplicateEntry();
+    return testHelperFinish();
+}
@@ -0,0 +1,142 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+/*
+ * Tests of mz_strm_mmap.c: reads, seeks and borrowed ranges of the stream against the file, and archives
+ * unzipHelperOpen() reads through the mapping.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "unzip_helper.h"
+#include "test_helper.h"
+
+/**
+ * The mapping holds the file, reads and seeks of the mmap stream return what is at its position, a borrowed range
+ * points into the mapping and one past the end is refused. An empty file opens and reads as end of file.
+ */
+static void testMmapStream() {
+    const int32_t sizes[] = {1, 7, 100, 4096, 70000};
+    static unsigned char buf[70000];
+    char empty[] = "/tmp/nsv_empty_XXXXXX";
+    void *stream = NULL;
+    const void *base = NULL;
+    const void *borrowed = NULL;
+    int64_t size = 0;
+    int64_t position = 0;
+    size_t len = 0;
+
+    unsigned char *apk = testHelperReadFile(testHelperPath("small.apk"), &len);
+    if (!TEST_HELPER_CHECK(NULL != apk)) {
+        return;
+    }
+    mz_stream_mmap_create(&stream);
+    if (TEST_HELPER_CHECK(mz_stream_mmap_open(stream, testHelperPath("small.apk"), MZ_OPEN_MODE_READ) == MZ_OK)) {
+        TEST_HELPER_CHECK(mz_stream_mmap_get_buffer(stream, &base, &size) == MZ_OK && size == (int64_t) len
+                          && memcmp(base, apk, len) == 0);
+        for (size_t i = 0; i < 32; i++) {
+            int32_t piece = sizes[i % (sizeof(sizes) / sizeof(sizes[0]))];
+            int64_t left = (int64_t) len - position;
+            int32_t read = mz_stream_mmap_read(stream, buf, piece);
+            TEST_HELPER_CHECK(read == (left < piece ? left : piece)
+                              && memcmp(buf, apk + position, (size_t) read) == 0);
+            position += read > 0 ? read : 0;
+            TEST_HELPER_CHECK(mz_stream_mmap_tell(stream) == position);
+        }
+        TEST_HELPER_CHECK(mz_stream_mmap_seek(stream, -5, MZ_SEEK_END) == MZ_OK
+                          && mz_stream_mmap_seek(stream, -2, MZ_SEEK_CUR) == MZ_OK
+                          && mz_stream_mmap_read(stream, buf, 10) == 7 && memcmp(buf, apk + len - 7, 7) == 0);
+        TEST_HELPER_CHECK(mz_stream_mmap_seek(stream, 10, MZ_SEEK_END) == MZ_OK
+                          && mz_stream_mmap_read(stream, buf, 10) == 0);
+        TEST_HELPER_CHECK(mz_stream_mmap_seek(stream, -1, MZ_SEEK_SET) == MZ_STREAM_ERROR);
+
+        TEST_HELPER_CHECK(mz_stream_mmap_get_buffer_at(stream, 100, 50, &borrowed) == MZ_OK
+                          && borrowed == (const unsigned char *) base + 100);
+        TEST_HELPER_CHECK(mz_stream_mmap_get_buffer_at(stream, (int64_t) len - 50, 50, &borrowed) == MZ_OK);
+        TEST_HELPER_CHECK(mz_stream_mmap_get_buffer_at(stream, (int64_t) len - 50, 51, &borrowed) != MZ_OK);
+        TEST_HELPER_CHECK(mz_stream_mmap_get_buffer_at(stream, (int64_t) len + 1, 0, &borrowed) != MZ_OK);
+        TEST_HELPER_CHECK(mz_stream_mmap_get_buffer_at(stream, -1, 1, &borrowed) != MZ_OK);
+        TEST_HELPER_CHECK(mz_stream_mmap_get_buffer_at(stream, INT64_MAX, INT32_MAX, &borrowed) != MZ_OK);
+    }
+    mz_stream_mmap_delete(&stream);
+    free(apk);
+
+    mz_stream_mmap_create(&stream);
+    TEST_HELPER_CHECK(mz_stream_mmap_open(stream, testHelperPath("."), MZ_OPEN_MODE_READ) == MZ_STREAM_ERROR);
+    int fd = mkstemp(empty);
+    if (TEST_HELPER_CHECK(fd >= 0)) {
+        close(fd);
+        TEST_HELPER_CHECK(mz_stream_mmap_open(stream, empty, MZ_OPEN_MODE_READ) == MZ_OK
+                          && mz_stream_mmap_get_buffer(stream, &base, &size) == MZ_OK && NULL == base && size == 0
+                          && mz_stream_mmap_read(stream, buf, 10) == 0);
+        unlink(empty);
+    }
+    mz_stream_mmap_delete(&stream);
+}
+
+/**
+ * An archive opened from a file is read through the mapping: the same headers as from a copy in memory,
+ * and the same entries.
+ */
+static void testMappedArchive() {
+    unzipHelperArchive mapped;
+    unzipHelperArchive copied;
+    size_t len = 0;
+
+    unsigned char *apk = testHelperReadFile(testHelperPath("many_entries.apk"), &len);
+    if (!TEST_HELPER_CHECK(NULL != apk)) {
+        return;
+    }
+    if (TEST_HELPER_CHECK(unzipHelperOpen(&mapped, testHelperPath("many_entries.apk")) == MZ_OK)) {
+        TEST_HELPER_CHECK(NULL != mapped.mmap_stream && mapped.stream == mapped.mmap_stream
+                          && mapped.size == len && memcmp(mapped.base, apk, len) == 0);
+        if (TEST_HELPER_CHECK(unzipHelperOpenMemory(&copied, apk, len) == MZ_OK)) {
+            mz_zip_file *a = NULL;
+            mz_zip_file *b = NULL;
+            int32_t err = mz_zip_goto_first_entry(copied.handle);
+            TEST_HELPER_CHECK(mz_zip_goto_first_entry(mapped.handle) == err);
+            while (err == MZ_OK) {
+                mz_zip_entry_get_info(mapped.handle, &a);
+                mz_zip_entry_get_info(copied.handle, &b);
+                if (!TEST_HELPER_CHECK(testHelperSameFileInfo(a, b))) {
+                    break;
+                }
+                err = mz_zip_goto_next_entry(copied.handle);
+                TEST_HELPER_CHECK(mz_zip_goto_next_entry(mapped.handle) == err);
+            }
+            TEST_HELPER_CHECK(err == MZ_END_OF_LIST);
+            unzipHelperClose(&copied);
+        }
+        TEST_HELPER_CHECK(testHelperCheckEntries(mapped.handle, 0));
+        unzipHelperClose(&mapped);
+    }
+    free(apk);
+}
+
+int main(int argc, char **argv) {
+    testHelperInit(argc, argv);
+    testMmapStream();
+    testMappedArchive();
+    return testHelperFinish();
+}
@@ -0,0 +1,173 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+/*
+ * Tests of mz_strm_pread.c: reads and seeks of the stream and its clones against the file, and clones of
+ * archives read on several threads at once.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unzip_helper.h"
+#include "test_helper.h"
+
+#define CLONE_THREADS 4
+
+/**
+ * What reading the pread stream and its clones returns matches the file, whatever the size of the reads and
+ * however they are interleaved, and the descriptor stays open until the last clone is closed.
+ */
+static void testPreadStream() {
+    const int32_t sizes[] = {1, 7, 100, 4095, 4096, 4097, 70000};
+    void *streams[2] = {NULL, NULL};
+    void *source = NULL;
+    static unsigned char buf[2][70000];
+    int64_t positions[2] = {0, 0};
+    size_t len = 0;
+
+    unsigned char *apk = testHelperReadFile(testHelperPath("small.apk"), &len);
+    if (!TEST_HELPER_CHECK(NULL != apk)) {
+        return;
+    }
+    mz_stream_pread_create(&source);
+    TEST_HELPER_CHECK(mz_stream_pread_open(source, testHelperPath("small.apk"), MZ_OPEN_MODE_READ) == MZ_OK);
+    TEST_HELPER_CHECK(mz_stream_pread_clone(source, &streams[0]) == MZ_OK);
+    TEST_HELPER_CHECK(mz_stream_pread_clone(source, &streams[1]) == MZ_OK);
+    mz_stream_pread_delete(&source);
+    if (!TEST_HELPER_CHECK(NULL != streams[0] && NULL != streams[1])) {
+        mz_stream_pread_delete(&streams[0]);
+        free(apk);
+        return;
+    }
+
+    // the second one reads backwards from the end, both by pieces of every size
+    int64_t back = (int64_t) len;
+    for (size_t i = 0; i < 64; i++) {
+        int32_t size = sizes[i % (sizeof(sizes) / sizeof(sizes[0]))];
+        back = back > size ? back - size : 0;
+        positions[1] = back;
+        TEST_HELPER_CHECK(mz_stream_pread_seek(streams[1], back, MZ_SEEK_SET) == MZ_OK);
+        for (size_t j = 0; j < 2; j++) {
+            int64_t left = (int64_t) len - positions[j];
+            int32_t read = mz_stream_pread_read(streams[j], buf[j], size);
+            TEST_HELPER_CHECK(read == (left < size ? left : size)
+                              && memcmp(buf[j], apk + positions[j], (size_t) read) == 0);
+            positions[j] += read > 0 ? read : 0;
+        }
+        TEST_HELPER_CHECK(mz_stream_pread_tell(streams[0]) == positions[0]);
+    }
+    TEST_HELPER_CHECK(mz_stream_pread_seek(streams[0], 10, MZ_SEEK_END) == MZ_OK
+                      && mz_stream_pread_read(streams[0], buf[0], 10) == 0);
+    TEST_HELPER_CHECK(mz_stream_pread_seek(streams[0], -1, MZ_SEEK_SET) == MZ_STREAM_ERROR);
+    mz_stream_pread_delete(&streams[0]);
+    TEST_HELPER_CHECK(mz_stream_pread_seek(streams[1], -3, MZ_SEEK_END) == MZ_OK
+                      && mz_stream_pread_read(streams[1], buf[1], 10) == 3 && memcmp(buf[1], apk + len - 3, 3) == 0);
+    mz_stream_pread_delete(&streams[1]);
+    free(apk);
+}
+
+/**
+ * An archive read through the pread stream, the way unzipHelperOpen() falls back to when the file can't be mapped.
+ */
+static int32_t openPread(unzipHelperArchive *archive, const char *path) {
+    memset(archive, 0, sizeof(unzipHelperArchive));
+    archive->name = path;
+    mz_stream_pread_create(&archive->pread_stream);
+    archive->stream = archive->pread_stream;
+    if (mz_stream_pread_open(archive->pread_stream, path, MZ_OPEN_MODE_READ) != MZ_OK) {
+        unzipHelperClose(archive);
+        return MZ_STREAM_ERROR;
+    }
+    archive->handle = mz_zip_open(archive->stream, MZ_OPEN_MODE_READ | MZ_OPEN_MODE_LOAD_CD);
+    if (NULL == archive->handle) {
+        unzipHelperClose(archive);
+        return MZ_FORMAT_ERROR;
+    }
+    return MZ_OK;
+}
+
+typedef struct cloneReader {
+    pthread_t thread;
+    const unzipHelperArchive *source;
+    size_t first;
+    bool passed;
+} cloneReader;
+
+static void *readClone(void *arg) {
+    cloneReader *reader = arg;
+    unzipHelperArchive archive;
+
+    reader->passed = unzipHelperClone(reader->source, &archive) == MZ_OK
+                     && testHelperCheckEntries(archive.handle, reader->first);
+    unzipHelperClose(&archive);
+    return NULL;
+}
+
+/**
+ * Clones read all the entries of one archive on several threads at once, as the source does,
+ * over a mapping, a buffer or a descriptor, sharing the index or not.
+ */
+static void testClones() {
+    cloneReader readers[CLONE_THREADS];
+    size_t len = 0;
+
+    unsigned char *apk = testHelperReadFile(testHelperPath("many_entries.apk"), &len);
+    if (!TEST_HELPER_CHECK(NULL != apk)) {
+        return;
+    }
+    // a mapping, a buffer and a descriptor, then the same with the index
+    for (int kind = 0; kind < 6; kind++) {
+        unzipHelperArchive source;
+        int32_t err = kind % 3 == 0 ? unzipHelperOpen(&source, testHelperPath("many_entries.apk"))
+                      : kind % 3 == 1 ? unzipHelperOpenMemory(&source, apk, len)
+                      : openPread(&source, testHelperPath("many_entries.apk"));
+        if (!TEST_HELPER_CHECK(err == MZ_OK)) {
+            continue;
+        }
+        TEST_HELPER_CHECK((kind % 3 == 2) == (NULL == source.base));
+        if (kind >= 3) {
+            TEST_HELPER_CHECK(unzipHelperBuildIndex(&source) == MZ_OK);
+        }
+        for (size_t i = 0; i < CLONE_THREADS; i++) {
+            readers[i].source = &source;
+            readers[i].first = (i + 1) * 500;
+            readers[i].passed = false;
+            TEST_HELPER_CHECK(pthread_create(&readers[i].thread, NULL, readClone, &readers[i]) == 0);
+        }
+        TEST_HELPER_CHECK(testHelperCheckEntries(source.handle, 0));
+        for (size_t i = 0; i < CLONE_THREADS; i++) {
+            pthread_join(readers[i].thread, NULL);
+            TEST_HELPER_CHECK(readers[i].passed);
+        }
+        unzipHelperClose(&source);
+    }
+    free(apk);
+}
+
+int main(int argc, char **argv) {
+    testHelperInit(argc, argv);
+    testPreadStream();
+    testClones();
+    return testHelperFinish();
+}
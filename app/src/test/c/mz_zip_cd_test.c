@@ -0,0 +1,157 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+/*
+ * Tests of the central directory loaded with MZ_OPEN_MODE_LOAD_CD in mz_zip.c: its headers decoded from memory
+ * against the ones read through the stream, on the corpus and on zips built by hand with odd extra fields.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "unzip_helper.h"
+#include "test_helper.h"
+
+/**
+ * A zip handle reading the central directory entry by entry through the stream, the way minizip does
+ * without MZ_OPEN_MODE_LOAD_CD.
+ */
+typedef struct streamZip {
+    void *stream;
+    void *handle;
+} streamZip;
+
+static bool openStreamZip(streamZip *zip, const unsigned char *data, size_t len) {
+    mz_stream_mem_create(&zip->stream);
+    mz_stream_mem_set_buffer(zip->stream, (void *) data, (int32_t) len);
+    mz_stream_mem_open(zip->stream, NULL, MZ_OPEN_MODE_READ);
+    zip->handle = mz_zip_open(zip->stream, MZ_OPEN_MODE_READ);
+    return NULL != zip->handle;
+}
+
+static void closeStreamZip(streamZip *zip) {
+    if (NULL != zip->handle) {
+        mz_zip_close(zip->handle);
+    }
+    mz_stream_mem_delete(&zip->stream);
+}
+
+/**
+ * Walks the central directory decoded from memory and the one read through the stream side by side,
+ * returns the error both ended with, or MZ_INTERNAL_ERROR where they differ.
+ */
+static int32_t compareHeaders(const unsigned char *data, size_t len, size_t *entries) {
+    unzipHelperArchive archive;
+    streamZip zip = {NULL, NULL};
+    mz_zip_file *decoded = NULL;
+    mz_zip_file *read = NULL;
+    int32_t err = MZ_FORMAT_ERROR;
+
+    *entries = 0;
+    if (unzipHelperOpenMemory(&archive, data, len) != MZ_OK) {
+        return MZ_FORMAT_ERROR;
+    }
+    if (openStreamZip(&zip, data, len)) {
+        int32_t err_decoded = mz_zip_goto_first_entry(archive.handle);
+        int32_t err_read = mz_zip_goto_first_entry(zip.handle);
+        while (err_decoded == MZ_OK && err_read == MZ_OK) {
+            mz_zip_entry_get_info(archive.handle, &decoded);
+            mz_zip_entry_get_info(zip.handle, &read);
+            if (!testHelperSameFileInfo(decoded, read)) {
+                fprintf(stderr, "%s differs\n", decoded->filename);
+                err_decoded = MZ_INTERNAL_ERROR;
+                break;
+            }
+            (*entries)++;
+            err_decoded = mz_zip_goto_next_entry(archive.handle);
+            err_read = mz_zip_goto_next_entry(zip.handle);
+        }
+        err = err_decoded == err_read ? err_decoded : MZ_INTERNAL_ERROR;
+    }
+    closeStreamZip(&zip);
+    unzipHelperClose(&archive);
+    return err;
+}
+
+/**
+ * Every header of the corpus decodes to what the stream reads.
+ */
+static void testCorpusHeaders() {
+    const char *names[] = {"small.apk", "huge.apk", "many_entries.apk", "multi_signer.apk", "long_comment.apk",
+                           "timestamped.apk", "v1_only.apk", "v1_sha1.apk"};
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        size_t len = 0;
+        size_t entries = 0;
+        unsigned char *apk = testHelperReadFile(testHelperPath(names[i]), &len);
+        if (!TEST_HELPER_CHECK(NULL != apk)) {
+            continue;
+        }
+        TEST_HELPER_CHECK(compareHeaders(apk, len, &entries) == MZ_END_OF_LIST && entries > 0);
+        free(apk);
+    }
+}
+
+/**
+ * Both ways of reading headers parse the extra field alike: ZIP64 only replaces the sizes that are UINT32_MAX,
+ * the offset of b.txt is kept, trailing padding is ignored and a block running past the field is an error.
+ */
+static void testExtraField() {
+    unsigned char zip[TEST_HELPER_ZIP_SIZE];
+    unzipHelperArchive archive;
+    streamZip stream_zip = {NULL, NULL};
+    mz_zip_file *file_info = NULL;
+    size_t entries = 0;
+
+    size_t len = testHelperBuildZip(zip, 32, NULL, 0);
+    TEST_HELPER_CHECK(compareHeaders(zip, len, &entries) == MZ_END_OF_LIST && entries == 2);
+
+    if (TEST_HELPER_CHECK(unzipHelperOpenMemory(&archive, zip, len) == MZ_OK)) {
+        TEST_HELPER_CHECK(mz_zip_locate_entry(archive.handle, "b.txt", 0) == MZ_OK);
+        TEST_HELPER_CHECK(mz_zip_entry_get_info(archive.handle, &file_info) == MZ_OK);
+        TEST_HELPER_CHECK(file_info->uncompressed_size == 6 && file_info->compressed_size == 6);
+        TEST_HELPER_CHECK(file_info->disk_offset == 30 + 5 + 5);
+        TEST_HELPER_CHECK(file_info->modified_date == 1500000000);
+        TEST_HELPER_CHECK(strcmp(file_info->comment, "second") == 0);
+        TEST_HELPER_CHECK(testHelperCheckEntry(archive.handle, "a.txt", "hello"));
+        TEST_HELPER_CHECK(testHelperCheckEntry(archive.handle, "b.txt", "world!"));
+        unzipHelperClose(&archive);
+    }
+    // and the same through the stream, the local header of b.txt padded too
+    if (TEST_HELPER_CHECK(openStreamZip(&stream_zip, zip, len))) {
+        TEST_HELPER_CHECK(mz_zip_locate_entry(stream_zip.handle, "b.txt", 0) == MZ_OK);
+        TEST_HELPER_CHECK(mz_zip_entry_get_info(stream_zip.handle, &file_info) == MZ_OK);
+        TEST_HELPER_CHECK(strcmp(file_info->comment, "second") == 0);
+        TEST_HELPER_CHECK(testHelperCheckEntry(stream_zip.handle, "b.txt", "world!"));
+    }
+    closeStreamZip(&stream_zip);
+
+    len = testHelperBuildZip(zip, 64, NULL, 0);
+    TEST_HELPER_CHECK(compareHeaders(zip, len, &entries) == MZ_FORMAT_ERROR && entries == 1);
+}
+
+int main(int argc, char **argv) {
+    testHelperInit(argc, argv);
+    testCorpusHeaders();
+    testExtraField();
+    return testHelperFinish();
+}
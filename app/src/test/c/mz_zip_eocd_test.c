@@ -0,0 +1,127 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+/*
+ * Tests of the end of central directory search of mz_zip.c: records inside the comment, comments longer than
+ * the first read, data after the record and zips without one.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "unzip_helper.h"
+#include "test_helper.h"
+
+/**
+ * An end of central directory record that claims 7 entries and a comment of comment_len bytes.
+ */
+static void putFakeEocd(unsigned char *p, uint16_t comment_len) {
+    size_t len = 0;
+    testHelperPut32(p, &len, 0x06054b50);
+    testHelperPut32(p, &len, 0);
+    testHelperPut16(p, &len, 7);
+    testHelperPut16(p, &len, 7);
+    testHelperPut32(p, &len, 0);
+    testHelperPut32(p, &len, 0);
+    testHelperPut16(p, &len, comment_len);
+}
+
+static int64_t countEntries(const unsigned char *zip, size_t len) {
+    unzipHelperArchive archive;
+    int64_t entries = -1;
+
+    if (unzipHelperOpenMemory(&archive, zip, len) == MZ_OK) {
+        if (mz_zip_get_number_entry(archive.handle, &entries) != MZ_OK
+            || !testHelperCheckEntry(archive.handle, "a.txt", "hello")
+            || !testHelperCheckEntry(archive.handle, "b.txt", "world!")) {
+            entries = -1;
+        }
+        unzipHelperClose(&archive);
+    }
+    return entries;
+}
+
+static bool emptyZip(const unsigned char *zip, size_t len) {
+    unzipHelperArchive archive;
+    int64_t entries = -1;
+    bool empty = false;
+
+    if (unzipHelperOpenMemory(&archive, zip, len) == MZ_OK) {
+        empty = mz_zip_get_number_entry(archive.handle, &entries) == MZ_OK && entries == 0
+                && mz_zip_goto_first_entry(archive.handle) != MZ_OK;
+        unzipHelperClose(&archive);
+    }
+    return empty;
+}
+
+/**
+ * The record is the last one whose comment ends the file, records inside the comment don't count, and with data
+ * after the comment the last one whose comment fits is taken. Comments longer than the first read are found too.
+ */
+static void testEndOfCentralDirectory() {
+    unsigned char comment[2000];
+    unzipHelperArchive archive;
+    const char *found = NULL;
+    size_t len = 0;
+
+    unsigned char *zip = calloc(1, TEST_HELPER_ZIP_SIZE + 0x10000 + 100);
+    if (!TEST_HELPER_CHECK(NULL != zip)) {
+        return;
+    }
+    memset(comment, 'c', sizeof(comment));
+    // one that ends inside the comment and one that would run past the end of the file
+    putFakeEocd(comment + 100, 0);
+    putFakeEocd(comment + sizeof(comment) - 40, UINT16_MAX);
+    len = testHelperBuildZip(zip, 32, comment, sizeof(comment));
+    TEST_HELPER_CHECK(countEntries(zip, len) == 2);
+    if (TEST_HELPER_CHECK(unzipHelperOpenMemory(&archive, zip, len) == MZ_OK)) {
+        TEST_HELPER_CHECK(mz_zip_get_comment(archive.handle, &found) == MZ_OK && memcmp(found, comment, 100) == 0);
+        unzipHelperClose(&archive);
+    }
+
+    // the same within the first read
+    len = testHelperBuildZip(zip, 32, comment + sizeof(comment) - 200, 200);
+    TEST_HELPER_CHECK(countEntries(zip, len) == 2);
+
+    // data after the end of central directory record
+    len = testHelperBuildZip(zip, 32, "zip", 3);
+    memset(zip + len, 'x', 100);
+    TEST_HELPER_CHECK(countEntries(zip, len + 100) == 2);
+    // too much of it, or cut short of a record: as minizip has it, a zip without the record is empty
+    memset(zip + len, 'x', 0x10000);
+    TEST_HELPER_CHECK(countEntries(zip, len + 0x10000) == -1);
+    TEST_HELPER_CHECK(emptyZip(zip, len + 0x10000));
+    TEST_HELPER_CHECK(emptyZip(zip + len - 3 - 21, 21));
+    free(zip);
+
+    // the longest comment, its record 64 KiB away from the end
+    if (TEST_HELPER_CHECK(unzipHelperOpen(&archive, testHelperPath("long_comment.apk")) == MZ_OK)) {
+        TEST_HELPER_CHECK(mz_zip_get_comment(archive.handle, &found) == MZ_OK && strlen(found) == UINT16_MAX);
+        unzipHelperClose(&archive);
+    }
+}
+
+int main(int argc, char **argv) {
+    testHelperInit(argc, argv);
+    testEndOfCentralDirectory();
+    return testHelperFinish();
+}
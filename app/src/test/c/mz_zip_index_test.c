@@ -0,0 +1,214 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+/*
+ * Tests of the filename index of mz_zip.c: the match functions and mz_zip_locate_entry() go to the same entries
+ * with the index as by scanning the central directory.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "unzip_helper.h"
+#include "test_helper.h"
+
+// more than the entries of many_entries.apk
+#define MAX_MATCHES 4096
+
+/**
+ * The central directory positions of the entries the match functions go to, in order,
+ * or SIZE_MAX if they don't end with MZ_END_OF_LIST.
+ */
+static size_t collectMatches(void *handle, const char *prefix, const char *suffix, uint8_t ignore_case,
+                             int64_t *positions) {
+    size_t count = 0;
+    int32_t err = mz_zip_locate_first_match(handle, prefix, suffix, ignore_case);
+
+    while (err == MZ_OK && count < MAX_MATCHES) {
+        positions[count++] = mz_zip_get_entry(handle);
+        err = mz_zip_locate_next_match(handle, prefix, suffix, ignore_case);
+    }
+    return err == MZ_END_OF_LIST ? count : SIZE_MAX;
+}
+
+/**
+ * The number of entries matching, SIZE_MAX if the indexed handle goes to other entries than the scanned one.
+ */
+static size_t sameMatches(void *scanned, void *indexed, const char *prefix, const char *suffix, uint8_t ignore_case) {
+    int64_t *positions = calloc(2 * MAX_MATCHES, sizeof(int64_t));
+    size_t count = SIZE_MAX;
+
+    if (NULL != positions) {
+        count = collectMatches(scanned, prefix, suffix, ignore_case, positions);
+        if (count != collectMatches(indexed, prefix, suffix, ignore_case, positions + MAX_MATCHES)
+            || (count != SIZE_MAX && memcmp(positions, positions + MAX_MATCHES, count * sizeof(int64_t)) != 0)) {
+            fprintf(stderr, "%s*%s differs\n", NULL != prefix ? prefix : "", NULL != suffix ? suffix : "");
+            count = SIZE_MAX;
+        }
+        free(positions);
+    }
+    return count;
+}
+
+/**
+ * Every name of the central directory leads both handles to the same entry, the first of that name.
+ */
+static bool sameEntries(void *scanned, void *indexed) {
+    char name[256];
+    mz_zip_file *file_info = NULL;
+    int32_t err = mz_zip_goto_first_entry(scanned);
+
+    while (err == MZ_OK) {
+        int64_t pos = mz_zip_get_entry(scanned);
+        mz_zip_entry_get_info(scanned, &file_info);
+        snprintf(name, sizeof(name), "%s", file_info->filename);
+        if (mz_zip_locate_entry(scanned, name, NULL) != MZ_OK
+            || mz_zip_locate_entry(indexed, name, NULL) != MZ_OK
+            || mz_zip_get_entry(scanned) != mz_zip_get_entry(indexed) || mz_zip_get_entry(indexed) > pos) {
+            fprintf(stderr, "%s differs\n", name);
+            return false;
+        }
+        err = mz_zip_goto_entry(scanned, pos);
+        if (err == MZ_OK) {
+            err = mz_zip_goto_next_entry(scanned);
+        }
+    }
+    return err == MZ_END_OF_LIST;
+}
+
+static int32_t compareIgnoreCase(void *handle, const char *filename1, const char *filename2) {
+    (void) handle;
+    return strcasecmp(filename1, filename2);
+}
+
+/**
+ * Stored entries named after names, each holding its own name.
+ */
+static size_t buildNamesZip(unsigned char *zip, const char **names, uint16_t count) {
+    unsigned char cd[TEST_HELPER_ZIP_SIZE];
+    size_t len = 0;
+    size_t cd_len = 0;
+
+    for (uint16_t i = 0; i < count; i++) {
+        testHelperPutEntry(zip, &len, cd, &cd_len, names[i], names[i], NULL, 0, NULL, 0, "", false);
+    }
+    testHelperPutEnd(zip, &len, cd, cd_len, count, NULL, 0);
+    return len;
+}
+
+/**
+ * With and without the index the match functions go to the same entries in central directory order,
+ * with prefix and suffix, either or none, and ignoring case or not; a name shared by two entries leads to the
+ * first one, and a compare callback still gets every name.
+ */
+static void testIndex() {
+    const char *names[] = {"META-INF/MANIFEST.MF", "a.txt", "META-INF/CERT.SF", "Meta-Inf/cert.sf", "a.txt",
+                           "res/A.TXT", "res/b.txt"};
+    unsigned char zip[TEST_HELPER_ZIP_SIZE];
+    unzipHelperArchive scanned;
+    unzipHelperArchive indexed;
+    int64_t first = 0;
+
+    size_t len = buildNamesZip(zip, names, sizeof(names) / sizeof(names[0]));
+    if (!TEST_HELPER_CHECK(unzipHelperOpenMemory(&scanned, zip, len) == MZ_OK)) {
+        return;
+    }
+    if (TEST_HELPER_CHECK(unzipHelperOpenMemory(&indexed, zip, len) == MZ_OK)) {
+        TEST_HELPER_CHECK(unzipHelperBuildIndex(&indexed) == MZ_OK);
+        TEST_HELPER_CHECK(sameMatches(scanned.handle, indexed.handle, NULL, NULL, 0) == 7);
+        TEST_HELPER_CHECK(sameMatches(scanned.handle, indexed.handle, "", "", 0) == 7);
+        TEST_HELPER_CHECK(sameMatches(scanned.handle, indexed.handle, "META-INF/", ".SF", 0) == 1);
+        TEST_HELPER_CHECK(sameMatches(scanned.handle, indexed.handle, "meta-inf/", ".sf", 1) == 2);
+        TEST_HELPER_CHECK(sameMatches(scanned.handle, indexed.handle, "META-INF/", NULL, 0) == 2);
+        TEST_HELPER_CHECK(sameMatches(scanned.handle, indexed.handle, NULL, ".txt", 0) == 3);
+        TEST_HELPER_CHECK(sameMatches(scanned.handle, indexed.handle, NULL, ".TXT", 1) == 4);
+        TEST_HELPER_CHECK(sameMatches(scanned.handle, indexed.handle, "a.txt", NULL, 0) == 2);
+        TEST_HELPER_CHECK(sameMatches(scanned.handle, indexed.handle, "a.txt.orig", NULL, 0) == 0);
+        TEST_HELPER_CHECK(sameMatches(scanned.handle, indexed.handle, "res/a", NULL, 0) == 0);
+        TEST_HELPER_CHECK(sameMatches(scanned.handle, indexed.handle, "res/a", NULL, 1) == 1);
+        TEST_HELPER_CHECK(sameMatches(scanned.handle, indexed.handle, NULL, "zzz", 1) == 0);
+        TEST_HELPER_CHECK(sameEntries(scanned.handle, indexed.handle));
+
+        TEST_HELPER_CHECK(mz_zip_locate_first_match(indexed.handle, "a.txt", NULL, 0) == MZ_OK);
+        first = mz_zip_get_entry(indexed.handle);
+        TEST_HELPER_CHECK(testHelperCheckEntry(indexed.handle, "a.txt", "a.txt")
+                          && mz_zip_get_entry(indexed.handle) == first);
+        TEST_HELPER_CHECK(mz_zip_locate_entry(indexed.handle, "A.TXT", NULL) == MZ_END_OF_LIST);
+        TEST_HELPER_CHECK(mz_zip_locate_entry(indexed.handle, "a.tx", NULL) == MZ_END_OF_LIST);
+        TEST_HELPER_CHECK(mz_zip_locate_entry(indexed.handle, "RES/B.TXT", compareIgnoreCase) == MZ_OK
+                          && testHelperCheckEntry(indexed.handle, "res/b.txt", "res/b.txt"));
+        unzipHelperClose(&indexed);
+    }
+    unzipHelperClose(&scanned);
+}
+
+/**
+ * The same on the corpus, and the next match after an entry located through the index is the one after it,
+ * also when a walk is interrupted.
+ */
+static void testCorpusIndex() {
+    const char *names[] = {"small.apk", "many_entries.apk", "multi_signer.apk", "v1_only.apk"};
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        unzipHelperArchive scanned;
+        unzipHelperArchive indexed;
+        int64_t entries = 0;
+
+        if (!TEST_HELPER_CHECK(unzipHelperOpen(&scanned, testHelperPath(names[i])) == MZ_OK)) {
+            continue;
+        }
+        if (TEST_HELPER_CHECK(unzipHelperOpen(&indexed, testHelperPath(names[i])) == MZ_OK)) {
+            TEST_HELPER_CHECK(unzipHelperBuildIndex(&indexed) == MZ_OK);
+            TEST_HELPER_CHECK(mz_zip_get_number_entry(indexed.handle, &entries) == MZ_OK);
+            TEST_HELPER_CHECK(sameMatches(scanned.handle, indexed.handle, NULL, NULL, 0) == (size_t) entries);
+            TEST_HELPER_CHECK(sameMatches(scanned.handle, indexed.handle, "META-INF/", NULL, 0) > 0);
+            TEST_HELPER_CHECK(sameMatches(scanned.handle, indexed.handle, "meta-inf/", ".sf", 1) > 0);
+            TEST_HELPER_CHECK(sameMatches(scanned.handle, indexed.handle, "res/raw/", ".txt", 0) > 0);
+            TEST_HELPER_CHECK(sameMatches(scanned.handle, indexed.handle, NULL, ".dex", 0) == 1);
+            TEST_HELPER_CHECK(sameEntries(scanned.handle, indexed.handle));
+            unzipHelperClose(&indexed);
+        }
+        unzipHelperClose(&scanned);
+    }
+
+    unzipHelperArchive archive;
+    mz_zip_file *file_info = NULL;
+    if (TEST_HELPER_CHECK(unzipHelperOpen(&archive, testHelperPath("many_entries.apk")) == MZ_OK)) {
+        TEST_HELPER_CHECK(unzipHelperBuildIndex(&archive) == MZ_OK);
+        TEST_HELPER_CHECK(mz_zip_locate_first_match(archive.handle, "res/raw/", ".txt", 0) == MZ_OK);
+        TEST_HELPER_CHECK(mz_zip_locate_entry(archive.handle, "META-INF/MANIFEST.MF", NULL) == MZ_OK);
+        TEST_HELPER_CHECK(mz_zip_locate_next_match(archive.handle, "res/raw/", ".txt", 0) == MZ_END_OF_LIST);
+        TEST_HELPER_CHECK(mz_zip_locate_entry(archive.handle, "res/raw/f01000.txt", NULL) == MZ_OK);
+        TEST_HELPER_CHECK(mz_zip_locate_next_match(archive.handle, "res/raw/", ".txt", 0) == MZ_OK
+                          && mz_zip_entry_get_info(archive.handle, &file_info) == MZ_OK
+                          && strcmp(file_info->filename, "res/raw/f01001.txt") == 0);
+        unzipHelperClose(&archive);
+    }
+}
+
+int main(int argc, char **argv) {
+    testHelperInit(argc, argv);
+    testIndex();
+    testCorpusIndex();
+    return testHelperFinish();
+}
@@ -0,0 +1,126 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+/*
+ * Tests of path_helper.c: the APKs of the package are found in maps whose lines cross the blocks they are read
+ * in, hold paths longer than PATH_HELPER_BUFFER_SIZE, or are too long to be parsed at all.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "path_helper.h"
+#include "test_helper.h"
+
+#define PACKAGE "com.example.app"
+#define MAPS_SIZE (4 * PATH_HELPER_READ_SIZE)
+// the first read fills the whole buffer of the scan
+#define FIRST_BLOCK (PATH_HELPER_READ_SIZE + PATH_HELPER_MAX_LINE)
+
+static char maps[MAPS_SIZE];
+static char longPath[PATH_HELPER_BUFFER_SIZE + 64];
+static char longLine[FIRST_BLOCK + 1000];
+
+static void putLine(size_t *len, uint64_t start, uint64_t end, const char *perms, uint64_t offset,
+                    uint64_t inode, const char *path) {
+    int n = snprintf(maps + *len, MAPS_SIZE - *len, "%" PRIx64 "-%" PRIx64 " %s %08" PRIx64 " fd:05 %" PRIu64
+                     "                    %s\n", start, end, perms, offset, inode, path);
+    *len += n > 0 ? (size_t) n : 0;
+}
+
+/**
+ * Lines of other files up to at, the last one padded so that the next line starts exactly there.
+ */
+static void putFiller(size_t *len, size_t at) {
+    char path[256] = "/system/lib64/lib";
+
+    while (*len + 200 < at) {
+        putLine(len, 0x7f0000000000, 0x7f0000001000, "r-xp", 0, 77, "/system/lib64/libc.so");
+    }
+    size_t before = *len;
+    putLine(len, 0x7f0000002000, 0x7f0000003000, "r--p", 0, 78, "/system/lib64/libm.so");
+    size_t pad = at - *len;
+    *len = before;
+    memset(path + 17, 'm', pad + 1);
+    strcpy(path + 18 + pad, ".so");
+    putLine(len, 0x7f0000002000, 0x7f0000003000, "r--p", 0, 78, path);
+}
+
+/**
+ * base.apk is found from two contiguous lines, the first of which crosses the end of the first block read,
+ * and comes first. A split whose path is longer than PATH_HELPER_BUFFER_SIZE keeps its whole path, a line
+ * longer than the buffer of the scan is skipped and the split after it is still found.
+ */
+static void testReadMappings() {
+    char path[] = "/tmp/nsv_maps_XXXXXX";
+    pathHelperMapping *mappings = NULL;
+    size_t len = 0;
+
+    memset(longPath, 'x', sizeof(longPath) - 1);
+    memcpy(longPath, "/data/app/~~", 12);
+    strcpy(longPath + sizeof(longPath) - 1 - strlen("/" PACKAGE "-1/split_config.arm64_v8a.apk"),
+           "/" PACKAGE "-1/split_config.arm64_v8a.apk");
+    memset(longLine, 'y', sizeof(longLine) - 1);
+    memcpy(longLine, "/data/app/" PACKAGE "-1/", strlen("/data/app/" PACKAGE "-1/"));
+    memcpy(longLine + sizeof(longLine) - 5, ".apk", 5);
+
+    putLine(&len, 0x6f000000, 0x6f003000, "r--p", 0, 4243, longPath);
+    putFiller(&len, FIRST_BLOCK - 30);
+    TEST_HELPER_CHECK(len == FIRST_BLOCK - 30);
+    putLine(&len, 0x70000000, 0x70002000, "r--p", 0, 4242, "/data/app/" PACKAGE "-1/base.apk");
+    putLine(&len, 0x70002000, 0x70005000, "r--p", 0x2000, 4242, "/data/app/" PACKAGE "-1/base.apk");
+    putLine(&len, 0x70005000, 0x70006000, "---p", 0x5000, 4242, "/data/app/" PACKAGE "-1/base.apk");
+    putLine(&len, 0x71000000, 0x71001000, "r--p", 0, 4244, longLine);
+    putLine(&len, 0x72000000, 0x72001000, "r--p", 0, 4245, "/data/app/" PACKAGE "-1/split_config.en.apk");
+    putLine(&len, 0x73000000, 0x73001000, "r--p", 0, 4246, "/data/app/com.example.other-1/base.apk");
+    TEST_HELPER_CHECK(len > FIRST_BLOCK + sizeof(longLine) && len < MAPS_SIZE);
+
+    int fd = mkstemp(path);
+    if (!TEST_HELPER_CHECK(fd >= 0)) {
+        return;
+    }
+    unlink(path);
+    if (TEST_HELPER_CHECK(write(fd, maps, len) == (ssize_t) len && lseek(fd, 0, SEEK_SET) == 0)) {
+        size_t count = pathHelperReadMappings(fd, PACKAGE, &mappings);
+        if (TEST_HELPER_CHECK(count == 3)) {
+            TEST_HELPER_CHECK(strcmp(mappings[0].path, "/data/app/" PACKAGE "-1/base.apk") == 0
+                              && mappings[0].start == 0x70000000 && mappings[0].end == 0x70005000
+                              && mappings[0].inode == 4242);
+            TEST_HELPER_CHECK(strcmp(mappings[1].path, longPath) == 0 && mappings[1].start == 0x6f000000
+                              && mappings[1].end == 0x6f003000 && mappings[1].inode == 4243);
+            TEST_HELPER_CHECK(strcmp(mappings[2].path, "/data/app/" PACKAGE "-1/split_config.en.apk") == 0
+                              && mappings[2].start == 0x72000000 && mappings[2].inode == 4245);
+            // none of the paths exists here, so none of the APKs can be read from memory
+            TEST_HELPER_CHECK(NULL == mappings[0].base && NULL == mappings[1].base && NULL == mappings[2].base);
+        }
+        pathHelperFreeMappings(mappings, count);
+    }
+    close(fd);
+}
+
+int main(int argc, char **argv) {
+    testHelperInit(argc, argv);
+    testReadMappings();
+    return testHelperFinish();
+}
@@ -0,0 +1,276 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+/*
+ * Tests of pkcs7_helper.c over the corpus: every way of taking the certificate of the signer has to agree
+ * with the v2 certificate of small.apk, which the same key signs. The certificates, signerInfos and attributes
+ * found in one parse, and blobs cut short or built by hand.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash_helper.h"
+#include "pkcs7_helper.h"
+#include "sign_block_helper.h"
+#include "unzip_helper.h"
+#include "test_helper.h"
+
+static unsigned char *expected = NULL;
+static size_t expected_len = 0;
+
+static bool isSigner(const unsigned char *certificate, size_t len) {
+    return NULL != certificate && len == expected_len && memcmp(certificate, expected, len) == 0;
+}
+
+static unsigned char *readStream(const char *name, size_t *len) {
+    unzipHelperArchive archive;
+    unsigned char *certificates = NULL;
+
+    if (unzipHelperOpen(&archive, testHelperPath(name)) == MZ_OK) {
+        certificates = unzipHelperReadCertificates(&archive, len);
+        unzipHelperClose(&archive);
+    }
+    return certificates;
+}
+
+/**
+ * timestamped.apk carries the CA in front of the signer.
+ */
+static void testChain() {
+    derHelperToken tokens[PKCS7_HELPER_MAX_TOKENS];
+    pkcs7HelperContext ctx;
+    pkcs7HelperContents contents;
+    size_t len = 0, signer_len = 0;
+
+    unsigned char *certrsa = unzipHelperGetCertificateDetails(testHelperPath("timestamped.apk"), &len);
+    if (!TEST_HELPER_CHECK(NULL != certrsa)) {
+        return;
+    }
+    pkcs7HelperInit(&ctx, tokens, PKCS7_HELPER_MAX_TOKENS);
+    TEST_HELPER_CHECK(pkcs7HelperGetContents(&ctx, certrsa, len, &contents));
+    TEST_HELPER_CHECK(contents.certificate_count == 2 && contents.signer_info_count == 1);
+    TEST_HELPER_CHECK(!isSigner(certrsa + contents.certificates[0].offset, contents.certificates[0].len));
+    unsigned char *signer = pkcs7HelperGetSignature(&ctx, certrsa, len, &signer_len);
+    TEST_HELPER_CHECK(isSigner(signer, signer_len));
+
+    // fed a byte at a time the stream keeps the signerInfos behind the chain too
+    pkcs7HelperStream stream;
+    pkcs7HelperStreamInit(&stream, len);
+    bool written = true;
+    for (size_t i = 0; i < len && written && !stream.done; i++) {
+        written = pkcs7HelperStreamWrite(&stream, certrsa + i, 1);
+    }
+    TEST_HELPER_CHECK(written && stream.done);
+    size_t kept_len = 0;
+    unsigned char *kept = pkcs7HelperStreamTake(&stream, &kept_len);
+    pkcs7HelperStreamFree(&stream);
+    TEST_HELPER_CHECK(isSigner(pkcs7HelperGetSignerCertificate(kept, kept_len, &signer_len), signer_len));
+    free(kept);
+    free(certrsa);
+
+    kept = readStream("timestamped.apk", &kept_len);
+    TEST_HELPER_CHECK(isSigner(pkcs7HelperGetSignerCertificate(kept, kept_len, &signer_len), signer_len));
+    free(kept);
+}
+
+/**
+ * With a single certificate the stream stops right behind it.
+ */
+static void testSingle() {
+    size_t len = 0, signer_len = 0;
+
+    unsigned char *kept = readStream("v1_only.apk", &len);
+    TEST_HELPER_CHECK(NULL != kept);
+    unsigned char *signer = pkcs7HelperGetSignerCertificate(kept, len, &signer_len);
+    TEST_HELPER_CHECK(isSigner(signer, signer_len) && signer_len + 4 >= len);
+    free(kept);
+
+    // a chain without a signerInfo naming one of its certificates has no signer
+    unsigned char chain[] = {0xa0, 0x06, 0x30, 0x01, 0x00, 0x30, 0x01, 0x01, 0x31, 0x00};
+    TEST_HELPER_CHECK(NULL == pkcs7HelperGetSignerCertificate(chain, sizeof(chain), &signer_len));
+    TEST_HELPER_CHECK(NULL == pkcs7HelperGetSignerCertificate(chain, sizeof(chain) - 2, &signer_len));
+    chain[1] = 0x03;
+    TEST_HELPER_CHECK(chain + 2 == pkcs7HelperGetSignerCertificate(chain, 5, &signer_len) && signer_len == 3);
+}
+
+static bool spanIsTriple(const unsigned char *der, size_t len, const pkcs7HelperSpan *span, uint8_t expected_tag) {
+    uint8_t tag = 0, header = 0;
+    uint32_t content_len = 0;
+
+    return span->offset < len && span->len <= len - span->offset
+           && derHelperReadHeader(der + span->offset, span->len, &tag, &header, &content_len)
+           && tag == expected_tag && (size_t) header + content_len == span->len;
+}
+
+/**
+ * One parse of every signature block of the corpus: the spans are whole certificates and signerInfos in the blob,
+ * and each signerInfo names one of the certificates.
+ */
+static void testContents() {
+    const char *blocks[][2] = {{"v1_only.apk", "META-INF/CERT.RSA"}, {"v1_sha1.apk", "META-INF/CERT.RSA"},
+                               {"multi_signer.apk", "META-INF/CERT.RSA"}, {"multi_signer.apk", "META-INF/SIGNER1.EC"},
+                               {"timestamped.apk", "META-INF/CERT.RSA"}};
+    derHelperToken tokens[PKCS7_HELPER_MAX_TOKENS];
+    pkcs7HelperContext ctx;
+    pkcs7HelperContents contents;
+    pkcs7HelperSignerInfo info;
+    x509HelperCertificate cert;
+
+    pkcs7HelperInit(&ctx, tokens, PKCS7_HELPER_MAX_TOKENS);
+    for (size_t i = 0; i < sizeof(blocks) / sizeof(blocks[0]); i++) {
+        size_t len = 0;
+        unsigned char *block = testHelperReadEntry(blocks[i][0], blocks[i][1], &len);
+        if (!TEST_HELPER_CHECK(NULL != block)) {
+            continue;
+        }
+        bool chain = strcmp(blocks[i][0], "timestamped.apk") == 0;
+        if (TEST_HELPER_CHECK(pkcs7HelperGetContents(&ctx, block, len, &contents))) {
+            TEST_HELPER_CHECK(contents.certificate_count == (chain ? 2 : 1) && contents.signer_info_count == 1);
+            for (size_t j = 0; j < contents.certificate_count; j++) {
+                TEST_HELPER_CHECK(spanIsTriple(block, len, &contents.certificates[j], TAG_SEQUENCE));
+            }
+            TEST_HELPER_CHECK(spanIsTriple(block, len, &contents.signer_infos[0], TAG_SEQUENCE));
+            const unsigned char *signer_info = block + contents.signer_infos[0].offset;
+            TEST_HELPER_CHECK(pkcs7HelperParseSignerInfo(signer_info, contents.signer_infos[0].len, &info));
+            TEST_HELPER_CHECK(info.serial.tag == TAG_INTEGER && info.issuer.tag == TAG_SEQUENCE
+                              && info.encrypted_digest.tag == TAG_OCTETSTRING && info.encrypted_digest.len > 0);
+            TEST_HELPER_CHECK((info.authenticated_attributes.tag == TAG_OPTIONAL) == chain);
+            TEST_HELPER_CHECK(pkcs7HelperFindSigner(block, &contents, signer_info, &info, &cert)
+                              == &contents.certificates[chain ? 1 : 0]);
+
+            // another serial names no certificate
+            block[contents.signer_infos[0].offset + info.serial.offset + info.serial.header] ^= 0x01;
+            TEST_HELPER_CHECK(NULL == pkcs7HelperFindSigner(block, &contents, signer_info, &info, &cert));
+            block[contents.signer_infos[0].offset + info.serial.offset + info.serial.header] ^= 0x01;
+
+            for (size_t j = 0; j < contents.signer_infos[0].len; j++) {
+                TEST_HELPER_CHECK(!pkcs7HelperParseSignerInfo(signer_info, j, &info));
+            }
+        }
+        for (size_t j = 0; j < len; j++) {
+            TEST_HELPER_CHECK(!pkcs7HelperGetContents(&ctx, block, j, &contents));
+        }
+        free(block);
+    }
+}
+
+/**
+ * The signed attributes of timestamped.apk: the content type and the digest of CERT.SF.
+ */
+static void testAttributes() {
+    // 1.2.840.113549.1.9.3, 1.2.840.113549.1.9.4 and 1.2.840.113549.1.7.1
+    const unsigned char content_type[] = {0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x09, 0x03};
+    const unsigned char message_digest[] = {0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x09, 0x04};
+    const unsigned char data[] = {0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x07, 0x01};
+    derHelperToken tokens[PKCS7_HELPER_MAX_TOKENS];
+    unsigned char digest[HASH_HELPER_MAX_SIZE];
+    pkcs7HelperContext ctx;
+    pkcs7HelperContents contents;
+    pkcs7HelperSignerInfo info;
+    hashHelperContext hash;
+    derHelperToken value;
+    size_t len = 0, sf_len = 0;
+
+    unsigned char *block = testHelperReadEntry("timestamped.apk", "META-INF/CERT.RSA", &len);
+    unsigned char *sf = testHelperReadEntry("timestamped.apk", "META-INF/CERT.SF", &sf_len);
+    pkcs7HelperInit(&ctx, tokens, PKCS7_HELPER_MAX_TOKENS);
+    if (TEST_HELPER_CHECK(NULL != block && NULL != sf && pkcs7HelperGetContents(&ctx, block, len, &contents)
+                          && contents.signer_info_count == 1)) {
+        const unsigned char *signer_info = block + contents.signer_infos[0].offset;
+        TEST_HELPER_CHECK(pkcs7HelperParseSignerInfo(signer_info, contents.signer_infos[0].len, &info));
+        TEST_HELPER_CHECK(pkcs7HelperFindAttribute(signer_info, &info.authenticated_attributes, content_type,
+                                                   sizeof(content_type), &value)
+                          && value.tag == TAG_OBJECTID && value.len == sizeof(data)
+                          && memcmp(signer_info + value.offset + value.header, data, sizeof(data)) == 0);
+        hashHelperInit(&hash, HASH_HELPER_SHA256);
+        hashHelperUpdate(&hash, sf, sf_len);
+        hashHelperFinal(&hash, digest);
+        TEST_HELPER_CHECK(pkcs7HelperFindAttribute(signer_info, &info.authenticated_attributes, message_digest,
+                                                   sizeof(message_digest), &value)
+                          && value.tag == TAG_OCTETSTRING && value.len == 32
+                          && memcmp(signer_info + value.offset + value.header, digest, 32) == 0);
+        TEST_HELPER_CHECK(!pkcs7HelperFindAttribute(signer_info, &info.authenticated_attributes, data, sizeof(data),
+                                                    &value));
+    }
+    free(sf);
+    free(block);
+}
+
+/**
+ * A signedData built by hand with more certificates than PKCS7_HELPER_MAX_SPANS keeps the first ones, and one
+ * of another content type is refused.
+ */
+static void testBuilt() {
+    unsigned char der[128];
+    derHelperToken tokens[PKCS7_HELPER_MAX_TOKENS];
+    pkcs7HelperContext ctx;
+    pkcs7HelperContents contents;
+    size_t certificates = PKCS7_HELPER_MAX_SPANS + 2;
+    size_t len = 0;
+
+    // contentInfo {signedData, [0] {SEQUENCE {INTEGER 1, SET {}, SEQUENCE {}, [0] {certificates}, SET {}}}}
+    const unsigned char head[] = {0x30, 0x00, 0x06, 0x09, 0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x07, 0x02,
+                                  0xa0, 0x00, 0x30, 0x00, 0x02, 0x01, 0x01, 0x31, 0x00, 0x30, 0x00, 0xa0, 0x00};
+    memset(der, 0, sizeof(der));
+    memcpy(der, head, sizeof(head));
+    len = sizeof(head);
+    for (size_t i = 0; i < certificates; i++) {
+        der[len++] = TAG_SEQUENCE;
+        der[len++] = 0x00;
+    }
+    der[len++] = TAG_SET;
+    der[len++] = 0x00;
+    der[1] = (unsigned char) (len - 2);
+    der[14] = (unsigned char) (len - 15);
+    der[16] = (unsigned char) (len - 17);
+    der[25] = (unsigned char) (2 * certificates);
+
+    pkcs7HelperInit(&ctx, tokens, PKCS7_HELPER_MAX_TOKENS);
+    TEST_HELPER_CHECK(pkcs7HelperGetContents(&ctx, der, len, &contents)
+                      && contents.certificate_count == PKCS7_HELPER_MAX_SPANS && contents.signer_info_count == 0
+                      && contents.certificates[0].offset == sizeof(head) && contents.certificates[0].len == 2);
+    // trailing bytes are ignored
+    TEST_HELPER_CHECK(pkcs7HelperGetContents(&ctx, der, sizeof(der), &contents));
+    der[12] = 0x01;
+    TEST_HELPER_CHECK(!pkcs7HelperGetContents(&ctx, der, len, &contents));
+}
+
+int main(int argc, char **argv) {
+    unzipHelperArchive archive;
+
+    testHelperInit(argc, argv);
+    if (unzipHelperOpen(&archive, testHelperPath("small.apk")) == MZ_OK) {
+        expected = signBlockHelperGetCertificate(&archive, &expected_len, NULL);
+        unzipHelperClose(&archive);
+    }
+    if (TEST_HELPER_CHECK(NULL != expected)) {
+        testChain();
+        testSingle();
+        testContents();
+        testAttributes();
+        testBuilt();
+    }
+    free(expected);
+    return testHelperFinish();
+}
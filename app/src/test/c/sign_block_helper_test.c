@@ -0,0 +1,124 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+/*
+ * Tests of sign_block_helper.c: the v2/v3 signers and content digests of the corpus, and copies of them
+ * tampered with in memory.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sign_block_helper.h"
+#include "test_helper.h"
+
+static int32_t verifyMemory(const unsigned char *apk, size_t len, unsigned char *signer) {
+    unzipHelperArchive archive;
+
+    int32_t err = unzipHelperOpenMemory(&archive, apk, len);
+    if (err == MZ_OK) {
+        err = signBlockHelperVerify(&archive, signer);
+        unzipHelperClose(&archive);
+    }
+    return err;
+}
+
+/**
+ * Every APK with an APK Signing Block verifies, its signer being the certificate signBlockHelperGetCertificate()
+ * returns. multi_signer.apk has an RSA and an EC signer, huge.apk a v3 block.
+ */
+static void testCorpus() {
+    const char *names[] = {"small.apk", "huge.apk", "many_entries.apk", "multi_signer.apk", "long_comment.apk"};
+    unzipHelperArchive archive;
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        unsigned char signer[HASH_HELPER_SHA256_SIZE];
+        unsigned char expected[HASH_HELPER_SHA256_SIZE];
+        hashHelperSha256 sha256;
+        size_t len = 0;
+        uint32_t id = 0;
+
+        if (!TEST_HELPER_CHECK(unzipHelperOpen(&archive, testHelperPath(names[i])) == MZ_OK)) {
+            continue;
+        }
+        unsigned char *certificate = signBlockHelperGetCertificate(&archive, &len, &id);
+        TEST_HELPER_CHECK(NULL != certificate);
+        TEST_HELPER_CHECK(id == (i == 1 ? SIGN_BLOCK_ID_V3 : SIGN_BLOCK_ID_V2));
+        hashHelperSha256Init(&sha256);
+        hashHelperSha256Update(&sha256, certificate, len);
+        hashHelperSha256Final(&sha256, expected);
+        free(certificate);
+
+        TEST_HELPER_CHECK(signBlockHelperVerify(&archive, signer) == MZ_OK);
+        TEST_HELPER_CHECK(memcmp(signer, expected, sizeof(signer)) == 0);
+        unzipHelperClose(&archive);
+    }
+    TEST_HELPER_CHECK(unzipHelperOpen(&archive, testHelperPath("v1_only.apk")) == MZ_OK);
+    TEST_HELPER_CHECK(signBlockHelperVerify(&archive, NULL) == MZ_EXIST_ERROR);
+    unzipHelperClose(&archive);
+}
+
+/**
+ * A byte changed in an entry breaks the content digest, one changed in the signed data the signature.
+ */
+static void testTampered() {
+    signBlockSigner signers[SIGN_BLOCK_MAX_SIGNERS];
+    unzipHelperArchive archive;
+    signBlock block;
+    size_t count = 0;
+    size_t len = 0;
+
+    unsigned char *apk = testHelperReadFile(testHelperPath("small.apk"), &len);
+    if (!TEST_HELPER_CHECK(NULL != apk)) {
+        return;
+    }
+    TEST_HELPER_CHECK(verifyMemory(apk, len, NULL) == MZ_OK);
+
+    apk[100] ^= 1;
+    TEST_HELPER_CHECK(verifyMemory(apk, len, NULL) == MZ_CRC_ERROR);
+    apk[100] ^= 1;
+
+    size_t offset = 0;
+    if (TEST_HELPER_CHECK(unzipHelperOpenMemory(&archive, apk, len) == MZ_OK)) {
+        if (TEST_HELPER_CHECK(signBlockHelperRead(&archive, &block) == MZ_OK)) {
+            TEST_HELPER_CHECK(signBlockHelperGetSigners(&block, SIGN_BLOCK_ID_V2, signers, SIGN_BLOCK_MAX_SIGNERS,
+                                                        &count) == MZ_OK);
+            // the last byte of the signed data, which is not parsed
+            offset = (size_t) (block.data - apk) + signers[0].signed_data.offset + signers[0].signed_data.len - 1;
+            signBlockHelperFree(&block);
+        }
+        unzipHelperClose(&archive);
+    }
+    if (offset > 0) {
+        apk[offset] ^= 1;
+        TEST_HELPER_CHECK(verifyMemory(apk, len, NULL) == MZ_CRYPT_ERROR);
+    }
+    free(apk);
+}
+
+int main(int argc, char **argv) {
+    testHelperInit(argc, argv);
+    testCorpus();
+    testTampered();
+    return testHelperFinish();
+}
@@ -0,0 +1,211 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+/*
+ * Tests of signature_helper.c: the signature blocks of the corpus over their .SF files, changed or swapped,
+ * the RFC 6979 P-256 vector, and signatures and keys that are out of range.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "signature_helper.h"
+#include "test_helper.h"
+
+// RFC 6979 A.2.5: the P-256 key and its SHA-256 signature of "sample"
+static const unsigned char P256_KEY[] = {
+        0x30, 0x59, 0x30, 0x13, 0x06, 0x07, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x02, 0x01, 0x06, 0x08, 0x2a, 0x86, 0x48,
+        0xce, 0x3d, 0x03, 0x01, 0x07, 0x03, 0x42, 0x00, 0x04,
+        0x60, 0xfe, 0xd4, 0xba, 0x25, 0x5a, 0x9d, 0x31, 0xc9, 0x61, 0xeb, 0x74, 0xc6, 0x35, 0x6d, 0x68,
+        0xc0, 0x49, 0xb8, 0x92, 0x3b, 0x61, 0xfa, 0x6c, 0xe6, 0x69, 0x62, 0x2e, 0x60, 0xf2, 0x9f, 0xb6,
+        0x79, 0x03, 0xfe, 0x10, 0x08, 0xb8, 0xbc, 0x99, 0xa4, 0x1a, 0xe9, 0xe9, 0x56, 0x28, 0xbc, 0x64,
+        0xf2, 0xf1, 0xb2, 0x0c, 0x2d, 0x7e, 0x9f, 0x51, 0x77, 0xa3, 0xc2, 0x94, 0xd4, 0x46, 0x22, 0x99};
+static const unsigned char P256_SIGNATURE[] = {
+        0x30, 0x46, 0x02, 0x21, 0x00,
+        0xef, 0xd4, 0x8b, 0x2a, 0xac, 0xb6, 0xa8, 0xfd, 0x11, 0x40, 0xdd, 0x9c, 0xd4, 0x5e, 0x81, 0xd6,
+        0x9d, 0x2c, 0x87, 0x7b, 0x56, 0xaa, 0xf9, 0x91, 0xc3, 0x4d, 0x0e, 0xa8, 0x4e, 0xaf, 0x37, 0x16,
+        0x02, 0x21, 0x00,
+        0xf7, 0xcb, 0x1c, 0x94, 0x2d, 0x65, 0x7c, 0x41, 0xd4, 0x36, 0xc7, 0xa1, 0xb6, 0xe2, 0x9f, 0x65,
+        0xf3, 0xe9, 0x00, 0xdb, 0xb9, 0xaf, 0xf4, 0x06, 0x4d, 0xc4, 0xab, 0x2f, 0x84, 0x3a, 0xcd, 0xa8};
+// the order of P-256
+static const unsigned char P256_N[] = {
+        0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xbc, 0xe6, 0xfa, 0xad, 0xa7, 0x17, 0x9e, 0x84, 0xf3, 0xb9, 0xca, 0xc2, 0xfc, 0x63, 0x25, 0x51};
+
+#define R_OFFSET    5
+#define S_OFFSET    40
+
+static void digestOf(hashHelperAlgorithm algorithm, const void *data, size_t len, unsigned char *digest) {
+    hashHelperContext ctx;
+    hashHelperInit(&ctx, algorithm);
+    hashHelperUpdate(&ctx, data, len);
+    hashHelperFinal(&ctx, digest);
+}
+
+/**
+ * Every signature block of the corpus over its .SF file, then over another one, with a byte of the .SF file
+ * or of the signature changed.
+ */
+static void testCorpus() {
+    const char *blocks[][3] = {{"v1_only.apk",      "META-INF/CERT.RSA",   "META-INF/CERT.SF"},
+                               {"v1_sha1.apk",      "META-INF/CERT.RSA",   "META-INF/CERT.SF"},
+                               {"multi_signer.apk", "META-INF/CERT.RSA",   "META-INF/CERT.SF"},
+                               {"multi_signer.apk", "META-INF/SIGNER1.EC", "META-INF/SIGNER1.SF"},
+                               {"timestamped.apk",  "META-INF/CERT.RSA",   "META-INF/CERT.SF"}};
+    derHelperToken tokens[PKCS7_HELPER_MAX_TOKENS];
+    pkcs7HelperContext ctx;
+    pkcs7HelperContents contents;
+    pkcs7HelperSignerInfo info;
+    pkcs7HelperSpan signer;
+
+    pkcs7HelperInit(&ctx, tokens, PKCS7_HELPER_MAX_TOKENS);
+    for (size_t i = 0; i < sizeof(blocks) / sizeof(blocks[0]); i++) {
+        size_t len = 0, sf_len = 0, other_len = 0;
+        unsigned char *block = testHelperReadEntry(blocks[i][0], blocks[i][1], &len);
+        unsigned char *sf = testHelperReadEntry(blocks[i][0], blocks[i][2], &sf_len);
+        // the .SF files of multi_signer.apk are the same, the other one comes from another APK
+        unsigned char *other = testHelperReadEntry(blocks[(i + 2) % 5][0], blocks[(i + 2) % 5][2], &other_len);
+        if (TEST_HELPER_CHECK(NULL != block && NULL != sf && NULL != other
+                              && pkcs7HelperGetContents(&ctx, block, len, &contents)
+                              && pkcs7HelperParseSignerInfo(block + contents.signer_infos[0].offset,
+                                                            contents.signer_infos[0].len, &info))) {
+            size_t last = contents.certificate_count - 1;
+            TEST_HELPER_CHECK(signatureHelperVerifySignedData(block, len, sf, sf_len, &signer) == MZ_OK
+                              && signer.offset == contents.certificates[last].offset
+                              && signer.len == contents.certificates[last].len);
+            TEST_HELPER_CHECK(signatureHelperVerifySignedData(block, len, other, other_len, NULL) == MZ_CRYPT_ERROR);
+
+            sf[sf_len / 2] ^= 0x01;
+            TEST_HELPER_CHECK(signatureHelperVerifySignedData(block, len, sf, sf_len, NULL) == MZ_CRYPT_ERROR);
+            sf[sf_len / 2] ^= 0x01;
+
+            // the last byte of the RSA signature or of s
+            size_t last_byte = contents.signer_infos[0].offset + info.encrypted_digest.offset
+                               + info.encrypted_digest.header + info.encrypted_digest.len - 1;
+            block[last_byte] ^= 0x01;
+            TEST_HELPER_CHECK(signatureHelperVerifySignedData(block, len, sf, sf_len, NULL) == MZ_CRYPT_ERROR);
+            block[last_byte] ^= 0x01;
+            TEST_HELPER_CHECK(signatureHelperVerifySignedData(block, len, sf, sf_len, NULL) == MZ_OK);
+        }
+        free(other);
+        free(sf);
+        free(block);
+    }
+}
+
+/**
+ * The RSA key of v1_only.apk straight over the digest of CERT.SF: only a signature of exactly the length
+ * of the modulus, below it, and of the right digest algorithm is taken.
+ */
+static void testRsa() {
+    unsigned char digest[HASH_HELPER_MAX_SIZE];
+    unsigned char signature[BIGNUM_HELPER_MAX_BITS / 8 + 1];
+    derHelperToken tokens[PKCS7_HELPER_MAX_TOKENS];
+    pkcs7HelperContext ctx;
+    pkcs7HelperContents contents;
+    pkcs7HelperSignerInfo info;
+    x509HelperCertificate cert;
+    size_t len = 0, sf_len = 0;
+
+    unsigned char *block = testHelperReadEntry("v1_only.apk", "META-INF/CERT.RSA", &len);
+    unsigned char *sf = testHelperReadEntry("v1_only.apk", "META-INF/CERT.SF", &sf_len);
+    pkcs7HelperInit(&ctx, tokens, PKCS7_HELPER_MAX_TOKENS);
+    if (TEST_HELPER_CHECK(NULL != block && NULL != sf && pkcs7HelperGetContents(&ctx, block, len, &contents)
+                          && pkcs7HelperParseSignerInfo(block + contents.signer_infos[0].offset,
+                                                        contents.signer_infos[0].len, &info)
+                          && x509HelperParse(block + contents.certificates[0].offset,
+                                             contents.certificates[0].len, &cert))) {
+        const unsigned char *key = block + contents.certificates[0].offset + cert.public_key.offset;
+        size_t key_len = (size_t) cert.public_key.header + cert.public_key.len;
+        size_t signature_len = info.encrypted_digest.len;
+        memcpy(signature, block + contents.signer_infos[0].offset + info.encrypted_digest.offset
+                          + info.encrypted_digest.header, signature_len);
+
+        digestOf(HASH_HELPER_SHA256, sf, sf_len, digest);
+        TEST_HELPER_CHECK(signatureHelperVerifyDigest(key, key_len, HASH_HELPER_SHA256, digest, signature,
+                                                      signature_len));
+        TEST_HELPER_CHECK(!signatureHelperVerifyDigest(key, key_len, HASH_HELPER_SHA1, digest, signature,
+                                                       signature_len));
+        TEST_HELPER_CHECK(!signatureHelperVerifyDigest(key, key_len, HASH_HELPER_SHA256, digest, signature,
+                                                       signature_len - 1));
+        // a leading zero makes it one byte too long
+        memmove(signature + 1, signature, signature_len);
+        signature[0] = 0x00;
+        TEST_HELPER_CHECK(!signatureHelperVerifyDigest(key, key_len, HASH_HELPER_SHA256, digest, signature,
+                                                       signature_len + 1));
+        memset(signature, 0xff, signature_len);
+        TEST_HELPER_CHECK(!signatureHelperVerifyDigest(key, key_len, HASH_HELPER_SHA256, digest, signature,
+                                                       signature_len));
+        TEST_HELPER_CHECK(!signatureHelperVerifyDigest(key, key_len - 1, HASH_HELPER_SHA256, digest, signature,
+                                                       signature_len));
+    }
+    free(sf);
+    free(block);
+}
+
+/**
+ * The RFC 6979 vector, then r or s zero, equal to the order or swapped, and a key off the curve.
+ */
+static void testEcdsa() {
+    unsigned char digest[HASH_HELPER_MAX_SIZE];
+    unsigned char signature[sizeof(P256_SIGNATURE)];
+    unsigned char key[sizeof(P256_KEY)];
+
+    digestOf(HASH_HELPER_SHA256, "sample", 6, digest);
+    TEST_HELPER_CHECK(signatureHelperVerifyDigest(P256_KEY, sizeof(P256_KEY), HASH_HELPER_SHA256, digest,
+                                                  P256_SIGNATURE, sizeof(P256_SIGNATURE)));
+    digest[0] ^= 0x01;
+    TEST_HELPER_CHECK(!signatureHelperVerifyDigest(P256_KEY, sizeof(P256_KEY), HASH_HELPER_SHA256, digest,
+                                                   P256_SIGNATURE, sizeof(P256_SIGNATURE)));
+    digest[0] ^= 0x01;
+
+    memcpy(signature, P256_SIGNATURE, sizeof(signature));
+    memset(signature + R_OFFSET, 0, 32);
+    TEST_HELPER_CHECK(!signatureHelperVerifyDigest(P256_KEY, sizeof(P256_KEY), HASH_HELPER_SHA256, digest,
+                                                   signature, sizeof(signature)));
+    memcpy(signature + R_OFFSET, P256_N, 32);
+    TEST_HELPER_CHECK(!signatureHelperVerifyDigest(P256_KEY, sizeof(P256_KEY), HASH_HELPER_SHA256, digest,
+                                                   signature, sizeof(signature)));
+    memcpy(signature, P256_SIGNATURE, sizeof(signature));
+    memcpy(signature + S_OFFSET, P256_N, 32);
+    TEST_HELPER_CHECK(!signatureHelperVerifyDigest(P256_KEY, sizeof(P256_KEY), HASH_HELPER_SHA256, digest,
+                                                   signature, sizeof(signature)));
+    memcpy(signature + S_OFFSET, P256_SIGNATURE + R_OFFSET, 32);
+    memcpy(signature + R_OFFSET, P256_SIGNATURE + S_OFFSET, 32);
+    TEST_HELPER_CHECK(!signatureHelperVerifyDigest(P256_KEY, sizeof(P256_KEY), HASH_HELPER_SHA256, digest,
+                                                   signature, sizeof(signature)));
+    TEST_HELPER_CHECK(!signatureHelperVerifyDigest(P256_KEY, sizeof(P256_KEY), HASH_HELPER_SHA256, digest,
+                                                   P256_SIGNATURE, sizeof(P256_SIGNATURE) - 1));
+
+    memcpy(key, P256_KEY, sizeof(key));
+    key[sizeof(key) - 1] ^= 0x01;
+    TEST_HELPER_CHECK(!signatureHelperVerifyDigest(key, sizeof(key), HASH_HELPER_SHA256, digest, P256_SIGNATURE,
+                                                   sizeof(P256_SIGNATURE)));
+}
+
+int main(int argc, char **argv) {
+    testHelperInit(argc, argv);
+    testCorpus();
+    testRsa();
+    testEcdsa();
+    return testHelperFinish();
+}
@@ -0,0 +1,78 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+/*
+ * Tests of split_helper.c: the v1 signer of a split is the certificate its signature was checked with.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "split_helper.h"
+#include "test_helper.h"
+
+static void testSigners() {
+    const char *names[] = {"small.apk", "v1_only.apk", "timestamped.apk"};
+    pathHelperMapping mappings[3];
+    splitHelperReport report;
+    unsigned char expected[HASH_HELPER_SHA256_SIZE];
+    unzipHelperArchive archive;
+    unsigned char *certificate = NULL;
+    size_t len = 0;
+
+    memset(mappings, 0, sizeof(mappings));
+    for (size_t i = 0; i < 3; i++) {
+        mappings[i].path = strdup(testHelperPath(names[i]));
+    }
+    if (unzipHelperOpen(&archive, mappings[0].path) == MZ_OK) {
+        certificate = signBlockHelperGetCertificate(&archive, &len, NULL);
+        unzipHelperClose(&archive);
+    }
+    if (TEST_HELPER_CHECK(NULL != certificate)) {
+        hashHelperSha256 sha256;
+        hashHelperSha256Init(&sha256);
+        hashHelperSha256Update(&sha256, certificate, len);
+        hashHelperSha256Final(&sha256, expected);
+        free(certificate);
+
+        TEST_HELPER_CHECK(splitHelperVerify(mappings, 3, &report) == MZ_OK);
+        TEST_HELPER_CHECK(report.count == 3 && report.failed == 0);
+        TEST_HELPER_CHECK(report.results[0].scheme == SIGN_BLOCK_ID_V2);
+        for (size_t i = 0; i < report.count; i++) {
+            TEST_HELPER_CHECK(report.results[i].err == MZ_OK);
+            TEST_HELPER_CHECK(memcmp(report.results[i].signer, expected, sizeof(expected)) == 0);
+        }
+        // timestamped.apk has the CA in front of the signer
+        TEST_HELPER_CHECK(report.results[2].scheme == SPLIT_HELPER_SCHEME_V1);
+        splitHelperFreeReport(&report);
+    }
+    for (size_t i = 0; i < 3; i++) {
+        free(mappings[i].path);
+    }
+}
+
+int main(int argc, char **argv) {
+    testHelperInit(argc, argv);
+    testSigners();
+    return testHelperFinish();
+}
@@ -0,0 +1,324 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "test_helper.h"
+#include "unzip_helper.h"
+
+static const char *corpus = ".";
+static char path[4096];
+static int checks = 0;
+static int failures = 0;
+
+/**
+ * Takes the corpus directory nsv_bench_corpus.py wrote from argv[1].
+ */
+void testHelperInit(int argc, char **argv) {
+    if (argc > 1) {
+        corpus = argv[1];
+    }
+    setvbuf(stdout, NULL, _IONBF, 0);
+}
+
+bool testHelperCheck(bool passed, const char *expression, const char *file, int line) {
+    checks++;
+    if (!passed) {
+        failures++;
+        printf("%s:%d: failed: %s\n", file, line, expression);
+    }
+    return passed;
+}
+
+/**
+ * Returns the path of the corpus file name. The result is overwritten by the next call.
+ */
+const char *testHelperPath(const char *name) {
+    snprintf(path, sizeof(path), "%s/%s", corpus, name);
+    return path;
+}
+
+/**
+ * Reads the whole file at path into memory the caller frees, NULL if it can't.
+ */
+unsigned char *testHelperReadFile(const char *path, size_t *len) {
+    FILE *file = fopen(path, "rb");
+    unsigned char *data = NULL;
+    long size;
+
+    if (NULL == file) {
+        return NULL;
+    }
+    if (fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) >= 0 && fseek(file, 0, SEEK_SET) == 0
+        && NULL != (data = malloc(size > 0 ? (size_t) size : 1))
+        && fread(data, 1, (size_t) size, file) == (size_t) size) {
+        *len = (size_t) size;
+    } else {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    return data;
+}
+
+/**
+ * Reads the entry name of the corpus APK apk into memory the caller frees, NULL if it can't.
+ */
+unsigned char *testHelperReadEntry(const char *apk, const char *name, size_t *len) {
+    unzipHelperArchive archive;
+    mz_zip_file *file_info = NULL;
+    unsigned char *data = NULL;
+
+    if (unzipHelperOpen(&archive, testHelperPath(apk)) != MZ_OK) {
+        return NULL;
+    }
+    if (mz_zip_locate_entry(archive.handle, name, NULL) == MZ_OK
+        && mz_zip_entry_get_info(archive.handle, &file_info) == MZ_OK
+        && NULL != (data = malloc((size_t) file_info->uncompressed_size + 1))
+        && mz_zip_entry_read_open(archive.handle, 0, NULL) == MZ_OK) {
+        *len = 0;
+        int32_t read = 0;
+        while ((read = mz_zip_entry_read(archive.handle, data + *len,
+                                         (int32_t) (file_info->uncompressed_size + 1 - *len))) > 0) {
+            *len += (size_t) read;
+        }
+        if (mz_zip_entry_close(archive.handle) != MZ_OK || read < 0 || *len != file_info->uncompressed_size) {
+            free(data);
+            data = NULL;
+        }
+    } else {
+        free(data);
+        data = NULL;
+    }
+    unzipHelperClose(&archive);
+    return data;
+}
+
+void testHelperPut16(unsigned char *p, size_t *len, uint16_t v) {
+    p[(*len)++] = (unsigned char) v;
+    p[(*len)++] = (unsigned char) (v >> 8);
+}
+
+void testHelperPut32(unsigned char *p, size_t *len, uint32_t v) {
+    testHelperPut16(p, len, (uint16_t) v);
+    testHelperPut16(p, len, (uint16_t) (v >> 16));
+}
+
+void testHelperPut64(unsigned char *p, size_t *len, uint64_t v) {
+    testHelperPut32(p, len, (uint32_t) v);
+    testHelperPut32(p, len, (uint32_t) (v >> 32));
+}
+
+void testHelperPutBytes(unsigned char *p, size_t *len, const void *data, size_t n) {
+    if (n > 0) {
+        memcpy(p + *len, data, n);
+    }
+    *len += n;
+}
+
+/**
+ * One stored entry: its local header and data at *len, its central directory header appended to cd.
+ */
+void testHelperPutEntry(unsigned char *zip, size_t *len, unsigned char *cd, size_t *cd_len, const char *name,
+                        const char *data, const unsigned char *local_extra, size_t local_extra_len,
+                        const unsigned char *extra, size_t extra_len, const char *comment, bool zip64) {
+    uint32_t crc = (uint32_t) crc32(0, (const Bytef *) data, (uInt) strlen(data));
+    uint32_t offset = (uint32_t) *len;
+
+    testHelperPut32(zip, len, 0x04034b50);
+    testHelperPut16(zip, len, 10);
+    testHelperPut16(zip, len, 0);
+    testHelperPut16(zip, len, 0);
+    testHelperPut32(zip, len, 0x4c210000);
+    testHelperPut32(zip, len, crc);
+    testHelperPut32(zip, len, (uint32_t) strlen(data));
+    testHelperPut32(zip, len, (uint32_t) strlen(data));
+    testHelperPut16(zip, len, (uint16_t) strlen(name));
+    testHelperPut16(zip, len, (uint16_t) local_extra_len);
+    testHelperPutBytes(zip, len, name, strlen(name));
+    testHelperPutBytes(zip, len, local_extra, local_extra_len);
+    testHelperPutBytes(zip, len, data, strlen(data));
+
+    testHelperPut32(cd, cd_len, 0x02014b50);
+    testHelperPut16(cd, cd_len, 0x031e);
+    testHelperPut16(cd, cd_len, 10);
+    testHelperPut16(cd, cd_len, 0);
+    testHelperPut16(cd, cd_len, 0);
+    testHelperPut32(cd, cd_len, 0x4c210000);
+    testHelperPut32(cd, cd_len, crc);
+    testHelperPut32(cd, cd_len, zip64 ? UINT32_MAX : (uint32_t) strlen(data));
+    testHelperPut32(cd, cd_len, zip64 ? UINT32_MAX : (uint32_t) strlen(data));
+    testHelperPut16(cd, cd_len, (uint16_t) strlen(name));
+    testHelperPut16(cd, cd_len, (uint16_t) extra_len);
+    testHelperPut16(cd, cd_len, (uint16_t) strlen(comment));
+    testHelperPut16(cd, cd_len, 0);
+    testHelperPut16(cd, cd_len, 0);
+    testHelperPut32(cd, cd_len, 0);
+    testHelperPut32(cd, cd_len, offset);
+    testHelperPutBytes(cd, cd_len, name, strlen(name));
+    testHelperPutBytes(cd, cd_len, extra, extra_len);
+    testHelperPutBytes(cd, cd_len, comment, strlen(comment));
+}
+
+/**
+ * The central directory at *len, then the end of central directory record and comment.
+ */
+void testHelperPutEnd(unsigned char *zip, size_t *len, const unsigned char *cd, size_t cd_len, uint16_t entries,
+                      const void *comment, uint16_t comment_len) {
+    size_t cd_offset = *len;
+
+    testHelperPutBytes(zip, len, cd, cd_len);
+    testHelperPut32(zip, len, 0x06054b50);
+    testHelperPut16(zip, len, 0);
+    testHelperPut16(zip, len, 0);
+    testHelperPut16(zip, len, entries);
+    testHelperPut16(zip, len, entries);
+    testHelperPut32(zip, len, (uint32_t) cd_len);
+    testHelperPut32(zip, len, (uint32_t) cd_offset);
+    testHelperPut16(zip, len, comment_len);
+    testHelperPutBytes(zip, len, comment, comment_len);
+}
+
+/**
+ * a.txt plain, b.txt with ZIP64 sizes, an NTFS time and 3 bytes of padding in its extra fields, then the end of
+ * central directory record and comment. ntfs_size is the size the NTFS block claims, 32 when it is well-formed.
+ */
+size_t testHelperBuildZip(unsigned char *zip, uint16_t ntfs_size, const void *comment, uint16_t comment_len) {
+    unsigned char cd[TEST_HELPER_ZIP_SIZE];
+    unsigned char extra[64];
+    const unsigned char padding[3] = {0, 0, 0};
+    size_t len = 0;
+    size_t cd_len = 0;
+    size_t extra_len = 0;
+
+    testHelperPutEntry(zip, &len, cd, &cd_len, "a.txt", "hello", NULL, 0, NULL, 0, "first", false);
+
+    testHelperPut16(extra, &extra_len, 0x0001);
+    testHelperPut16(extra, &extra_len, 16);
+    testHelperPut64(extra, &extra_len, 6);
+    testHelperPut64(extra, &extra_len, 6);
+    testHelperPut16(extra, &extra_len, 0x000a);
+    testHelperPut16(extra, &extra_len, ntfs_size);
+    testHelperPut32(extra, &extra_len, 0);
+    testHelperPut16(extra, &extra_len, 0x0001);
+    testHelperPut16(extra, &extra_len, 24);
+    testHelperPut64(extra, &extra_len, TEST_HELPER_NTFS_TIME);
+    testHelperPut64(extra, &extra_len, TEST_HELPER_NTFS_TIME);
+    testHelperPut64(extra, &extra_len, TEST_HELPER_NTFS_TIME);
+    testHelperPutBytes(extra, &extra_len, padding, sizeof(padding));
+    testHelperPutEntry(zip, &len, cd, &cd_len, "b.txt", "world!", padding, sizeof(padding), extra, extra_len,
+                       "second", true);
+
+    testHelperPutEnd(zip, &len, cd, cd_len, 2, comment, comment_len);
+    return len;
+}
+
+/**
+ * Whether the entry name of the zip open at handle holds expected, a string of less than 16 bytes.
+ */
+bool testHelperCheckEntry(void *handle, const char *name, const char *expected) {
+    char buf[16];
+    int32_t read = 0;
+
+    if (mz_zip_locate_entry(handle, name, 0) != MZ_OK || mz_zip_entry_read_open(handle, 0, NULL) != MZ_OK) {
+        return false;
+    }
+    read = mz_zip_entry_read(handle, buf, sizeof(buf));
+    return mz_zip_entry_close(handle) == MZ_OK && read == (int32_t) strlen(expected)
+           && memcmp(buf, expected, (size_t) read) == 0;
+}
+
+static bool testHelperSameBytes(const void *a, const void *b, size_t len) {
+    return len == 0 || (NULL != a && NULL != b && memcmp(a, b, len) == 0);
+}
+
+/**
+ * Whether two headers hold the same fields, their filenames, extra fields and comments included.
+ */
+bool testHelperSameFileInfo(const mz_zip_file *a, const mz_zip_file *b) {
+    return a->version_madeby == b->version_madeby && a->version_needed == b->version_needed && a->flag == b->flag
+           && a->compression_method == b->compression_method && a->modified_date == b->modified_date
+           && a->accessed_date == b->accessed_date && a->creation_date == b->creation_date && a->crc == b->crc
+           && a->compressed_size == b->compressed_size && a->uncompressed_size == b->uncompressed_size
+           && a->filename_size == b->filename_size && a->extrafield_size == b->extrafield_size
+           && a->comment_size == b->comment_size && a->disk_number == b->disk_number
+           && a->disk_offset == b->disk_offset && a->internal_fa == b->internal_fa
+           && a->external_fa == b->external_fa && testHelperSameBytes(a->filename, b->filename, a->filename_size)
+           && testHelperSameBytes(a->extrafield, b->extrafield, a->extrafield_size)
+           && testHelperSameBytes(a->comment, b->comment, a->comment_size);
+}
+
+/**
+ * Reads every entry from the first-th on and around, located by name, and checks its CRC.
+ */
+bool testHelperCheckEntries(void *handle, size_t first) {
+    char name[256];
+    unsigned char buf[4096];
+    mz_zip_file *file_info = NULL;
+    int64_t entries = 0;
+    int32_t err = mz_zip_get_number_entry(handle, &entries);
+
+    if (err == MZ_OK) {
+        err = entries > 0 ? mz_zip_goto_first_entry(handle) : MZ_FORMAT_ERROR;
+    }
+    for (size_t i = 0; err == MZ_OK && i < first % (size_t) entries; i++) {
+        err = mz_zip_goto_next_entry(handle);
+    }
+    for (int64_t i = 0; err == MZ_OK && i < entries; i++) {
+        int64_t pos = mz_zip_get_entry(handle);
+        uint32_t crc = 0;
+        int32_t read = 0;
+
+        mz_zip_entry_get_info(handle, &file_info);
+        snprintf(name, sizeof(name), "%s", file_info->filename);
+        if (mz_zip_locate_entry(handle, name, NULL) != MZ_OK || mz_zip_entry_read_open(handle, 0, NULL) != MZ_OK) {
+            return false;
+        }
+        mz_zip_entry_get_info(handle, &file_info);
+        while ((read = mz_zip_entry_read(handle, buf, sizeof(buf))) > 0) {
+            crc = (uint32_t) crc32(crc, buf, (uInt) read);
+        }
+        if (mz_zip_entry_close(handle) != MZ_OK || read < 0 || crc != file_info->crc) {
+            fprintf(stderr, "%s differs\n", name);
+            return false;
+        }
+        err = mz_zip_goto_entry(handle, pos);
+        if (err == MZ_OK) {
+            err = mz_zip_goto_next_entry(handle);
+        }
+        if (err == MZ_END_OF_LIST) {
+            err = mz_zip_goto_first_entry(handle);
+        }
+    }
+    return err == MZ_OK;
+}
+
+/**
+ * Prints the summary and returns the exit code of the test.
+ */
+int testHelperFinish() {
+    printf("%d checks, %d failed\n", checks, failures);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,80 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#ifndef NATIVESIGNATUREVERIFICATION_TEST_HELPER_H
+#define NATIVESIGNATUREVERIFICATION_TEST_HELPER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "unzip_helper.h"
+
+/**
+ * Reports cond, without stopping the test, if it does not hold.
+ */
+#define TEST_HELPER_CHECK(cond) testHelperCheck((cond), #cond, __FILE__, __LINE__)
+
+// room for the zips the tests build by hand
+#define TEST_HELPER_ZIP_SIZE 4096
+// 2017-07-14T02:40:00Z as an NTFS time, see testHelperBuildZip()
+#define TEST_HELPER_NTFS_TIME ((1500000000ULL + 11644473600ULL) * 10000000ULL)
+
+
+void testHelperInit(int argc, char **argv);
+
+bool testHelperCheck(bool passed, const char *expression, const char *file, int line);
+
+const char *testHelperPath(const char *name);
+
+unsigned char *testHelperReadFile(const char *path, size_t *len);
+
+unsigned char *testHelperReadEntry(const char *apk, const char *name, size_t *len);
+
+void testHelperPut16(unsigned char *p, size_t *len, uint16_t v);
+
+void testHelperPut32(unsigned char *p, size_t *len, uint32_t v);
+
+void testHelperPut64(unsigned char *p, size_t *len, uint64_t v);
+
+void testHelperPutBytes(unsigned char *p, size_t *len, const void *data, size_t n);
+
+void testHelperPutEntry(unsigned char *zip, size_t *len, unsigned char *cd, size_t *cd_len, const char *name,
+                        const char *data, const unsigned char *local_extra, size_t local_extra_len,
+                        const unsigned char *extra, size_t extra_len, const char *comment, bool zip64);
+
+void testHelperPutEnd(unsigned char *zip, size_t *len, const unsigned char *cd, size_t cd_len, uint16_t entries,
+                      const void *comment, uint16_t comment_len);
+
+size_t testHelperBuildZip(unsigned char *zip, uint16_t ntfs_size, const void *comment, uint16_t comment_len);
+
+bool testHelperCheckEntry(void *handle, const char *name, const char *expected);
+
+bool testHelperSameFileInfo(const mz_zip_file *a, const mz_zip_file *b);
+
+bool testHelperCheckEntries(void *handle, size_t first);
+
+int testHelperFinish();
+
+#endif //NATIVESIGNATUREVERIFICATION_TEST_HELPER_H
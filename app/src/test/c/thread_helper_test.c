@@ -0,0 +1,110 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+/*
+ * Tests of thread_helper.c: every task runs once, no two threads share a worker number, and runs nested in
+ * tasks finish on the shared pool.
+ */
+
+#include <string.h>
+
+#include "thread_helper.h"
+#include "test_helper.h"
+
+#define OUTER_COUNT 16
+#define INNER_COUNT 1000
+
+typedef struct testJob {
+    size_t workers;
+    size_t runs[INNER_COUNT];
+    size_t busy[THREAD_HELPER_MAX_WORKERS];
+    size_t bad_worker;
+    size_t shared_worker;
+} testJob;
+
+static void countTask(void *ctx, size_t index, size_t worker) {
+    testJob *job = ctx;
+
+    if (worker >= job->workers) {
+        __atomic_fetch_add(&job->bad_worker, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    // a worker number in use by another thread at the same time would be seen here
+    if (__atomic_fetch_add(&job->busy[worker], 1, __ATOMIC_RELAXED) != 0) {
+        __atomic_fetch_add(&job->shared_worker, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_add(&job->runs[index], 1, __ATOMIC_RELAXED);
+    for (volatile int i = 0; i < 1000; i++) {
+    }
+    __atomic_fetch_sub(&job->busy[worker], 1, __ATOMIC_RELAXED);
+}
+
+static bool checkJob(const testJob *job, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (job->runs[i] != 1) {
+            return false;
+        }
+    }
+    return job->bad_worker == 0 && job->shared_worker == 0;
+}
+
+static testJob inner[OUTER_COUNT];
+
+static void nestedTask(void *ctx, size_t index, size_t worker) {
+    (void) ctx;
+    (void) worker;
+    inner[index].workers = threadHelperGetWorkerCount(INNER_COUNT);
+    threadHelperRun(countTask, &inner[index], INNER_COUNT, inner[index].workers);
+}
+
+static void testRun() {
+    static testJob job;
+
+    for (size_t count = 0; count <= INNER_COUNT; count = count * 10 + 1) {
+        memset(&job, 0, sizeof(job));
+        job.workers = threadHelperGetWorkerCount(count);
+        threadHelperRun(countTask, &job, count, job.workers);
+        TEST_HELPER_CHECK(checkJob(&job, count));
+    }
+    // more workers than THREAD_HELPER_MAX_WORKERS, the pool grows to the most it allows
+    memset(&job, 0, sizeof(job));
+    job.workers = THREAD_HELPER_MAX_WORKERS;
+    threadHelperRun(countTask, &job, INNER_COUNT, THREAD_HELPER_MAX_WORKERS * 2);
+    TEST_HELPER_CHECK(checkJob(&job, INNER_COUNT));
+}
+
+static void testNested() {
+    for (int round = 0; round < 20; round++) {
+        memset(inner, 0, sizeof(inner));
+        threadHelperRun(nestedTask, NULL, OUTER_COUNT, OUTER_COUNT);
+        for (size_t i = 0; i < OUTER_COUNT; i++) {
+            TEST_HELPER_CHECK(checkJob(&inner[i], INNER_COUNT));
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    testHelperInit(argc, argv);
+    testRun();
+    testNested();
+    return testHelperFinish();
+}
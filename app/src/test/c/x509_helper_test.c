@@ -0,0 +1,226 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2018  Dmitrii Kozhevin <kozhevin.dima@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the “Software”), to deal in the Software without
+restriction, including without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+/*
+ * Tests of x509_helper.c: RFC 2253 names, serial numbers and times built by hand, and the certificate of the corpus.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "x509_helper.h"
+#include "sign_block_helper.h"
+#include "test_helper.h"
+
+#define TAG_UTF8        0x0c
+#define TAG_PRINTABLE   0x13
+#define TAG_IA5         0x16
+#define TAG_BMP         0x1e
+
+static const unsigned char OID_C[] = {0x55, 0x04, 0x06};
+static const unsigned char OID_O[] = {0x55, 0x04, 0x0a};
+static const unsigned char OID_OU[] = {0x55, 0x04, 0x0b};
+static const unsigned char OID_CN[] = {0x55, 0x04, 0x03};
+static const unsigned char OID_EMAIL[] = {0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x09, 0x01};
+
+/**
+ * Appends {tag, length, content} to out at *len, the content shorter than 128 bytes.
+ */
+static void putTlv(unsigned char *out, size_t *len, uint8_t tag, const void *content, size_t content_len) {
+    out[(*len)++] = tag;
+    out[(*len)++] = (unsigned char) content_len;
+    memcpy(out + *len, content, content_len);
+    *len += content_len;
+}
+
+/**
+ * Appends the AttributeTypeAndValue SEQUENCE {oid, value}.
+ */
+static void putAttribute(unsigned char *out, size_t *len, const unsigned char *oid, size_t oid_len, uint8_t tag,
+                         const void *value, size_t value_len) {
+    unsigned char attribute[128];
+    size_t n = 0;
+    putTlv(attribute, &n, TAG_OBJECTID, oid, oid_len);
+    putTlv(attribute, &n, tag, value, value_len);
+    putTlv(out, len, TAG_SEQUENCE, attribute, n);
+}
+
+static bool getName(const unsigned char *der, size_t len, char *out, size_t size) {
+    derHelperToken name;
+    uint32_t content_len = 0;
+
+    memset(&name, 0, sizeof(name));
+    if (!derHelperReadHeader(der, len, &name.tag, &name.header, &content_len)) {
+        return false;
+    }
+    name.len = content_len;
+    return x509HelperGetName(der, &name, out, size);
+}
+
+/**
+ * RDNs last first joined with ',', a multi-valued RDN joined with '+', values escaped, and a type without an
+ * RFC 2253 keyword as its OID and the hex of its value.
+ */
+static void testName() {
+    unsigned char rdns[512];
+    unsigned char rdn[128];
+    unsigned char name[512];
+    char out[X509_HELPER_NAME_SIZE];
+    const unsigned char bmp[] = {0x00, 'D', 0x04, 0x10};
+    size_t len = 0;
+    size_t n;
+
+    n = 0;
+    putAttribute(rdn, &n, OID_C, sizeof(OID_C), TAG_PRINTABLE, "US", 2);
+    putTlv(rdns, &len, TAG_SET, rdn, n);
+    n = 0;
+    putAttribute(rdn, &n, OID_O, sizeof(OID_O), TAG_UTF8, "Android", 7);
+    putTlv(rdns, &len, TAG_SET, rdn, n);
+    n = 0;
+    putAttribute(rdn, &n, OID_OU, sizeof(OID_OU), TAG_BMP, bmp, sizeof(bmp));
+    putAttribute(rdn, &n, OID_CN, sizeof(OID_CN), TAG_UTF8, "Android Debug", 13);
+    putTlv(rdns, &len, TAG_SET, rdn, n);
+    n = 0;
+    putAttribute(rdn, &n, OID_EMAIL, sizeof(OID_EMAIL), TAG_IA5, "a@b.c", 5);
+    putTlv(rdns, &len, TAG_SET, rdn, n);
+    n = 0;
+    putAttribute(rdn, &n, OID_CN, sizeof(OID_CN), TAG_UTF8, " #x,y+z ", 8);
+    putTlv(rdns, &len, TAG_SET, rdn, n);
+
+    n = 0;
+    name[n++] = TAG_SEQUENCE;
+    name[n++] = 0x81;
+    name[n++] = (unsigned char) len;
+    memcpy(name + n, rdns, len);
+    n += len;
+
+    TEST_HELPER_CHECK(getName(name, n, out, sizeof(out)));
+    TEST_HELPER_CHECK(strcmp(out, "CN=\\ #x\\,y\\+z\\ ,1.2.840.113549.1.9.1=#16056140622e63,"
+                                  "OU=D\xd0\x90+CN=Android Debug,O=Android,C=US") == 0);
+    // it does not fit
+    TEST_HELPER_CHECK(!getName(name, n, out, strlen("CN=\\ #x\\,y\\+z\\ ,") + 1));
+
+    // an RDN that is not a SET
+    name[3] = TAG_SEQUENCE;
+    TEST_HELPER_CHECK(!getName(name, n, out, sizeof(out)));
+}
+
+static bool getSerial(const unsigned char *content, size_t content_len, char *out, size_t size) {
+    unsigned char der[32];
+    derHelperToken serial;
+    size_t len = 0;
+
+    putTlv(der, &len, TAG_INTEGER, content, content_len);
+    memset(&serial, 0, sizeof(serial));
+    serial.tag = TAG_INTEGER;
+    serial.header = 2;
+    serial.len = (uint32_t) content_len;
+    return x509HelperGetSerial(der, &serial, out, size);
+}
+
+static void testSerial() {
+    char out[X509_HELPER_SERIAL_SIZE];
+
+    TEST_HELPER_CHECK(getSerial((const unsigned char *) "\x00\xff", 2, out, sizeof(out)) && strcmp(out, "255") == 0);
+    TEST_HELPER_CHECK(getSerial((const unsigned char *) "\x01\x00", 2, out, sizeof(out)) && strcmp(out, "256") == 0);
+    TEST_HELPER_CHECK(getSerial((const unsigned char *) "\xff", 1, out, sizeof(out)) && strcmp(out, "-1") == 0);
+    TEST_HELPER_CHECK(getSerial((const unsigned char *) "\x00", 1, out, sizeof(out)) && strcmp(out, "0") == 0);
+    TEST_HELPER_CHECK(getSerial((const unsigned char *) "\xff\xff\xff\xff\xff\xff\xff\xff", 8, out, sizeof(out))
+                      && strcmp(out, "-1") == 0);
+    TEST_HELPER_CHECK(getSerial((const unsigned char *) "\x12\x34\x56\x78\x9a\xbc\xde\xf0\x12", 9, out, sizeof(out))
+                      && strcmp(out, "335812727670730321938") == 0);
+    TEST_HELPER_CHECK(!getSerial((const unsigned char *) "", 0, out, sizeof(out)));
+}
+
+static bool getTime(uint8_t tag, const char *text, int64_t *epoch) {
+    unsigned char der[32];
+    derHelperToken time;
+    size_t len = 0;
+
+    putTlv(der, &len, tag, text, strlen(text));
+    memset(&time, 0, sizeof(time));
+    time.tag = tag;
+    time.header = 2;
+    time.len = (uint32_t) strlen(text);
+    return x509HelperGetTime(der, &time, epoch);
+}
+
+/**
+ * UTCTime years below 50 are 20YY, the others 19YY.
+ */
+static void testTime() {
+    int64_t epoch = 0;
+
+    TEST_HELPER_CHECK(getTime(TAG_UTCTIME, "491231235959Z", &epoch) && epoch == 2524607999LL);
+    TEST_HELPER_CHECK(getTime(TAG_UTCTIME, "500101000000Z", &epoch) && epoch == -631152000LL);
+    TEST_HELPER_CHECK(getTime(TAG_GENERALIZEDTIME, "20380119031408Z", &epoch) && epoch == 2147483648LL);
+    TEST_HELPER_CHECK(!getTime(TAG_UTCTIME, "4912312359Z", &epoch));
+    TEST_HELPER_CHECK(!getTime(TAG_GENERALIZEDTIME, "20380119031408", &epoch));
+}
+
+/**
+ * The self-signed certificate the corpus is signed with, and its truncated copies.
+ */
+static void testCertificate() {
+    x509HelperCertificate cert;
+    unzipHelperArchive archive;
+    char subject[X509_HELPER_NAME_SIZE];
+    char issuer[X509_HELPER_NAME_SIZE];
+    char serial[X509_HELPER_SERIAL_SIZE];
+    int64_t not_before = 0;
+    int64_t not_after = 0;
+    size_t len = 0;
+    uint32_t id = 0;
+
+    if (!TEST_HELPER_CHECK(unzipHelperOpen(&archive, testHelperPath("small.apk")) == MZ_OK)) {
+        return;
+    }
+    unsigned char *der = signBlockHelperGetCertificate(&archive, &len, &id);
+    unzipHelperClose(&archive);
+    if (!TEST_HELPER_CHECK(NULL != der)) {
+        return;
+    }
+    if (TEST_HELPER_CHECK(x509HelperParse(der, len, &cert))) {
+        TEST_HELPER_CHECK(x509HelperGetName(der, &cert.subject, subject, sizeof(subject))
+                          && strcmp(subject, "CN=nsv bench rsa") == 0);
+        TEST_HELPER_CHECK(x509HelperGetName(der, &cert.issuer, issuer, sizeof(issuer))
+                          && strcmp(issuer, subject) == 0);
+        TEST_HELPER_CHECK(x509HelperGetSerial(der, &cert.serial, serial, sizeof(serial))
+                          && strspn(serial, "0123456789") == strlen(serial));
+        TEST_HELPER_CHECK(x509HelperGetTime(der, &cert.not_before, &not_before)
+                          && x509HelperGetTime(der, &cert.not_after, &not_after)
+                          && not_before > 1500000000LL && not_after > not_before + 9999LL * 86400);
+    }
+    for (size_t cut = 1; cut < len; cut += 97) {
+        TEST_HELPER_CHECK(!x509HelperParse(der, len - cut, &cert));
+    }
+    free(der);
+}
+
+int main(int argc, char **argv) {
+    testHelperInit(argc, argv);
+    testName();
+    testSerial();
+    testTime();
+    testCertificate();
+    return testHelperFinish();
+}